@@ -0,0 +1,114 @@
+/**
+ * @file BusScheduler.h
+ * @brief Arbitration of the SPI bus shared by the LCD and the SD card
+ *
+ * On the Core2, the LCD and the SD card share one SPI bus (GPIO 18/23/38).
+ * Each client takes the bus for an explicit time slot: the display for one
+ * frame push, the storage for one bounded block of SD writes. The display
+ * has priority: a storage slot never starts while a frame is waiting, so
+ * SD writes fall in the idle windows between frames, and a frame waits at
+ * most for one storage slot.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+/**
+ * @struct BusClientStats
+ * @brief Contention statistics of one bus client
+ */
+struct BusClientStats {
+    uint32_t acquisitions;      ///< Slots obtained
+    uint32_t contended;         ///< Slots that had to wait for another client
+    uint32_t timeouts;          ///< Requests abandoned after the timeout
+    uint64_t totalWaitUs;       ///< Cumulated wait time
+    uint32_t maxWaitUs;         ///< Longest wait
+    uint64_t totalHoldUs;       ///< Cumulated slot duration
+    uint32_t maxHoldUs;         ///< Longest slot
+    uint32_t waitHistogram[5];  ///< Waits < 100 us, < 1 ms, < 5 ms, < 20 ms, >= 20 ms
+};
+
+/**
+ * @class BusScheduler
+ * @brief Mutex-based slot scheduler with per-client wait instrumentation
+ */
+class BusScheduler {
+public:
+    enum Client : uint8_t {
+        CLIENT_DISPLAY = 0,   ///< Frame pushes (priority client)
+        CLIENT_STORAGE,       ///< SD card accesses
+        CLIENT_COUNT
+    };
+
+    /** Maximum bytes handed to the SD card in one storage slot (~8 sectors, a few ms) */
+    static const size_t STORAGE_SLOT_BYTES = 4096;
+
+    /** Longest time a storage slot is deferred while frames keep coming */
+    static const uint32_t STORAGE_DEFER_MAX_MS = 100;
+
+private:
+    SemaphoreHandle_t mutex_;
+    volatile uint8_t displayWaiting_;        ///< Frames waiting for the bus
+    unsigned long slotStart_[CLIENT_COUNT];  ///< Start of the current slot (micros)
+    BusClientStats stats_[CLIENT_COUNT];
+
+public:
+    BusScheduler();
+
+    /** @brief Create the mutex (call once, before the tasks start) */
+    bool begin();
+
+    /**
+     * @brief Take the bus for one slot
+     * @param client Requesting client
+     * @param timeoutMs Maximum wait (portMAX_DELAY: no timeout)
+     * @return false on timeout (the caller must not access the bus)
+     *
+     * A storage request first waits (up to STORAGE_DEFER_MAX_MS) until no
+     * frame is waiting.
+     */
+    bool acquire(Client client, uint32_t timeoutMs = 1000);
+
+    /** @brief End the current slot */
+    void release(Client client);
+
+    /** @brief Statistics of one client */
+    const BusClientStats& stats(Client client) const { return stats_[client]; }
+
+    /** @brief Reset all statistics */
+    void resetStats();
+
+    /** @brief One-line summary of wait and slot times per client */
+    String describe() const;
+};
+
+/**
+ * @class BusLock
+ * @brief Scoped bus slot; a null scheduler makes it a no-op
+ */
+class BusLock {
+private:
+    BusScheduler* bus_;
+    BusScheduler::Client client_;
+    bool locked_;
+
+public:
+    BusLock(BusScheduler* bus, BusScheduler::Client client, uint32_t timeoutMs = 1000)
+        : bus_(bus), client_(client), locked_(false) {
+        locked_ = bus_ ? bus_->acquire(client_, timeoutMs) : true;
+    }
+    ~BusLock() {
+        if (bus_ && locked_) bus_->release(client_);
+    }
+
+    /** @brief false if the slot could not be obtained */
+    bool isLocked() const { return locked_; }
+
+    BusLock(const BusLock&) = delete;
+    BusLock& operator=(const BusLock&) = delete;
+};
@@ -0,0 +1,79 @@
+/**
+ * @file CompassWidget.h
+ * @brief Compass rose with several anti-aliased needles
+ *
+ * The rose (circle, ticks, cardinal letters) is drawn once into a cached
+ * sprite. Each composition copies the sprite, then draws the needles on
+ * top, so a needle never erases the rose and no trail is left behind.
+ * Needle ends come from the FixedTrig table; the cost of a frame is one
+ * sprite copy plus a fixed number of wedges, whatever the angles.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <M5Unified.h>
+#include "Widgets.h"
+
+/**
+ * @struct CompassNeedle
+ * @brief One needle of the compass
+ */
+struct CompassNeedle {
+    uint16_t angle;     ///< FixedTrig angle units (0 = north, clockwise)
+    uint16_t color;
+    int16_t length;     ///< Pixels from the center to the tip
+    float halfWidth;    ///< Half width at the center (pixels)
+    bool visible;
+};
+
+/**
+ * @class CompassWidget
+ * @brief Cached rose + needles composited per frame
+ */
+class CompassWidget : public Widget {
+public:
+    static const int MAX_NEEDLES = 4;
+
+private:
+    int16_t radius_;
+    LGFX_Sprite rose_;
+    bool roseCached_;
+    CompassNeedle needles_[MAX_NEEDLES];
+    int needleCount_;
+
+    void drawRose(LovyanGFX& gfx, int16_t x, int16_t y);
+    void drawNeedle(LovyanGFX& gfx, int32_t cx, int32_t cy, const CompassNeedle& needle);
+
+public:
+    /**
+     * @param centerX Screen X of the rose center
+     * @param centerY Screen Y of the rose center
+     * @param radius Rose radius; the cardinal letters sit 15 px outside
+     */
+    CompassWidget(int16_t centerX, int16_t centerY, int16_t radius);
+
+    /**
+     * @brief Render the rose into its cached sprite (PSRAM when available)
+     *
+     * Call after M5.begin(). Without memory for the sprite, the rose is
+     * drawn at each composition instead.
+     */
+    void begin();
+
+    /**
+     * @brief Add a needle, hidden until its first setNeedle()
+     * @param lengthPercent Length in percent of the radius
+     * @return Needle index, or -1 if MAX_NEEDLES are already defined
+     */
+    int addNeedle(uint16_t color, uint8_t lengthPercent, float halfWidth);
+
+    /**
+     * @brief Point a needle; dirty only if its angle unit or visibility changed
+     * @param degrees Direction (0 = north, clockwise)
+     */
+    void setNeedle(int index, float degrees, bool visible = true);
+
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+};
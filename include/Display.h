@@ -3,8 +3,52 @@
 #include <esp_now.h>
 #include "Logger.h"
 #include "DisplayTypes.h"
+#include "Widgets.h"
+#include "CompassWidget.h"
+#include "FleetWidget.h"
+#include "MapWidget.h"
+#include "StripChartWidget.h"
+#include "WidgetCompositor.h"
 
+/**
+ * @struct DisplaySnapshot
+ * @brief Everything a frame shows, captured at one instant by the main loop
+ *
+ * The render task draws from its own copy, so a frame never mixes values
+ * from two loop iterations. Plain data only: copied with memcpy/memcmp.
+ */
+struct DisplaySnapshot {
+  struct_message_Boat boatData;
+  struct_message_Anemometer anemometerData;
+  unsigned long boatDataTimestamp;       // millis() de la dernière trame bateau
+  unsigned long anemometerDataTimestamp; // millis() de la dernière trame anémomètre
+  float windDirection;                   // Direction moyenne du vent (bouées)
+  unsigned long windDirTimestamp;
+  int boatCount;
+  int selectedBoatIndex;
+  uint32_t hubTotalRelayed;
+  int batteryLevel;
+  bool batteryCharging;
+  bool isRecording;
+  bool isServerActive;
+  bool hasSDError;                       // Erreur d'écriture pendant l'enregistrement
+  bool hubActive;
+  const char* sdErrorMessage;            // Carte SD absente : détail (littéral), sinon nullptr
+  FleetEntry fleet[FleetWidget::MAX_ROWS]; // Flotte, dans l'ordre de détection
+  int fleetCount;
+  MapMark buoys[MapWidget::MAX_BUOYS];     // Bouées actives avec fix GPS
+  int buoyCount;
+};
 
+// Pages de la zone principale (toucher le haut de l'écran pour changer)
+enum DisplayPage : uint8_t {
+  PAGE_DASHBOARD = 0,
+  PAGE_CHARTS,
+  PAGE_COMPASS,
+  PAGE_FLEET,
+  PAGE_MAP,
+  PAGE_COUNT
+};
 
 class Display {
 private:
@@ -12,37 +56,82 @@ private:
   bool showingServerMessage = false;
   unsigned long serverMessageStartTime = 0;
   bool serverMessageActive = false;
-  String serverMessageIP = "";
-  bool needsRefreshAfterServerMessage = false; // Flag pour indiquer qu'un refresh est nécessaire
-  
-  // Variables statiques pour l'optimisation de l'affichage
-  bool labelsDrawn = false;
-  float lastSpeedKmh = -999;
-  float lastHeading = -999;
-  uint8_t lastSatellites = 255;
-  float lastWindSpeedKmh = -999;
-  float lastWindDirection = -999;
-  bool lastIsRecording = false;
-  bool lastIsServerActive = false;
-  int lastBoatCount = 0;
-  bool lastHasSDError = false;
-  int lastBatteryPercent = -1;
-  bool lastIsCharging = false;
-  String lastBoatDisplayName = "";
-  int lastSelectedBoatIdx = -1;
-  int lastTotalBoatCount = -1;
-  bool lastHubActive = false;
-  uint32_t lastHubRelayed = 0;
-  
+
+  // Demandes de la boucle principale, appliquées par la tâche d'affichage
+  // au début de l'image suivante (seule cette tâche touche aux widgets)
+  struct Requests {
+    bool serverMessage;
+    bool serverActive;
+    String serverDetail;
+    uint8_t pageSteps;
+    bool fullRefresh;
+    uint8_t chartMinutes; // 0 : inchangé
+  };
+  SemaphoreHandle_t requestMutex = nullptr;
+  Requests pending = {false, false, String(), 0, false, 0};
+
+  // Widgets du tableau de bord : chacun garde sa zone et la valeur affichée,
+  // le compositeur ne redessine que les zones modifiées
+  WidgetCompositor compositor;
+  GlyphAtlas valueGlyphs{3, WHITE}; // Chiffres pré-rendus des valeurs numériques
+  LabelWidget boatLabel{10, 40, 72, 24, "BOAT", RED, 3};
+  LabelWidget boatSpeedUnit{240, 40, 54, 24, "KMH", WHITE, 3};
+  LabelWidget boatHeadingUnit{240, 80, 54, 24, "DEG", WHITE, 3};
+  LabelWidget windLabel{10, 120, 72, 24, "WIND", RED, 3};
+  LabelWidget windSpeedUnit{240, 120, 54, 24, "KMH", WHITE, 3};
+  LabelWidget windDirectionUnit{240, 160, 54, 24, "DEG", WHITE, 3};
+  NumberWidget boatSpeedValue{120, 40, 115, 24, "%.1f", 0.05f};
+  NumberWidget boatHeadingValue{120, 80, 115, 24, "%.0f", 0.5f};
+  NumberWidget windSpeedValue{120, 120, 115, 24, "%.1f", 0.05f};
+  NumberWidget windDirectionValue{120, 160, 115, 24, "%.0f", 0.5f};
+  BoatNameWidget boatName{0, 0, 135, 25};
+  HubWidget hubStatus{0, 26, 200, 12};
+  BatteryWidget battery{140, 0, 100, 25};
+  SatelliteWidget satellites{240, 0, 80, 20};
+  ButtonWidget recordButton{0, 200, 107, 40};
+  ButtonWidget boatButton{107, 200, 106, 40};
+  ButtonWidget serverButton{213, 200, 107, 40};
+  SpeedBarWidget speedBar{screenWidth - 20, 100, 10, 120};
+  CompassWidget compass{160, 120, arrowLength};
+  LabelWidget compassHeadingLabel{8, 60, 54, 24, "CAP", RED, 3};
+  LabelWidget compassWindLabel{246, 60, 72, 24, "VENT", CYAN, 3};
+  NumberWidget compassHeadingValue{8, 90, 70, 24, "%.0f", 0.5f};
+  NumberWidget compassWindValue{246, 90, 70, 24, "%.0f", 0.5f};
+  FleetWidget fleet{0, 40, 320, 160};
+  MapWidget map{0, 40, 320, 160};
+  StripChartWidget speedChart{0, 40, 320, 80, "VITESSE KMH", GREEN};
+  StripChartWidget windChart{0, 120, 320, 80, "VENT KMH", CYAN};
+  uint32_t chartBoatId = 0; // Bateau dont la vitesse est tracée (historique effacé au changement)
+  int headingNeedle = -1;
+  int windNeedle = -1;
+  SdErrorWidget sdError{0, 40, 320, 140};
+  MessageWidget serverMessage{0, 90, 320, 60};
+
+  volatile DisplayPage page = PAGE_DASHBOARD;
+
+  void updateButtons(bool isRecording, bool isServerActive, int boatCount, bool hasSDError);
+  void applyPage();
+  void applyRequests();
+  void updateServerMessageDisplay();
+
 public:
+  void begin();
+  void setBus(BusScheduler& bus); // Bus SPI partagé avec la carte SD
   void showSplashScreen();
+
+  // Dessin : depuis la tâche d'affichage uniquement (voir RenderTask)
+  void drawDisplay(const DisplaySnapshot& snapshot);
   void drawSpeedBar(float speedKmh);
-  void drawDisplay(const struct_message_Boat& boatData, const struct_message_Anemometer& anemometerData, bool isRecording, bool isServerActive = false, int boatCount = 0, float windDirection = 0, unsigned long windDirTimestamp = 0, bool hasSDError = false, int selectedBoatIndex = 0, bool hubActive = false, uint32_t hubTotalRelayed = 0);
   void drawCompass(float heading);
+
+  // Demandes : depuis n'importe quelle tâche, prises en compte à l'image suivante
   void showFileServerStatus(bool active, const String& ipAddress);
-  void updateServerMessageDisplay(); // Nouvelle fonction pour l'affichage non-bloquant
-  bool needsRefresh(); // Vérifie si un refresh est nécessaire après message serveur
-  void drawButtonLabels(bool isRecording, bool isServerActive, int boatCount = 0, bool hasSDError = false);
-  void showSDError(const String& errorMessage);
   void forceFullRefresh(); // Force un rafraîchissement complet de l'affichage
+  void nextPage(); // Page suivante (tableau de bord, courbes, boussole, flotte, carte)
+  void setChartWindow(int minutes); // Durée des courbes, 1 à 10 minutes
+  DisplayPage currentPage() const { return page; }
+
+  const DisplayFrameStats& getFrameStats() const { return compositor.stats(); }
+  String describeFrameStats() const;
+  String benchmarkReadouts(int iterations = 200); // Temps de dessin par valeur (texte / atlas)
 };
@@ -109,9 +109,6 @@ const int centerX = screenWidth / 2;
 const int centerY = (screenHeight / 2) + 30;
 const int arrowLength = 55;
 
-// Pour la boussole
-static float previousAngle = -1;
-
 // Conversion degrés/radian
 #ifndef DEG_TO_RAD
 #define DEG_TO_RAD 0.017453292519943295769236907684886
@@ -0,0 +1,128 @@
+/**
+ * @file DownloadBenchmark.h
+ * @brief Checks that no fleet data is lost while the file server streams a download
+ *
+ * With the file server running, the benchmark downloads a test file from
+ * the server in a loop (HTTP over the loopback interface) and, at the same
+ * time, feeds a simulated fleet into the receive path of the display:
+ * the same code as the ESP-NOW callback, sequence checks included. At the
+ * end it compares what was injected with what the receive path accepted.
+ *
+ * The simulated boats (MAC prefix 02:44:4C, see isSimulated()) never reach
+ * the pre-trigger history nor the SD queue, the benchmark is refused while
+ * recording, and the application removes them from the fleet once the run
+ * ends: no simulated data is left in real sessions or on /api/live.
+ *
+ * While the benchmark runs, real ESP-NOW frames are counted but not
+ * processed, so that the simulated fleet has the receive path to itself;
+ * their count shows that the radio kept receiving during the downloads.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "BusScheduler.h"
+
+// Forward declaration
+class Logger;
+
+/**
+ * @struct DownloadBenchProbe
+ * @brief Receive path counters over one run
+ */
+struct DownloadBenchProbe {
+    uint32_t received;     ///< Simulated packets accepted (sequence checks passed)
+    uint32_t lost;         ///< Sequence gaps seen on the simulated boats
+    uint32_t queued;       ///< Entries queued for the SD card (0 expected)
+    uint32_t queueDrops;   ///< Entries dropped because the SD queue was busy
+    uint32_t radioFrames;  ///< Real ESP-NOW frames heard during the run
+};
+
+/**
+ * @class DownloadBenchTarget
+ * @brief Receive path under test, implemented by the application
+ */
+class DownloadBenchTarget {
+public:
+    virtual ~DownloadBenchTarget() {}
+
+    /** @brief Divert real frames to a counter and start counting */
+    virtual void beginSimulation() = 0;
+
+    /** @brief Feed one simulated frame to the receive path */
+    virtual void inject(const uint8_t* mac, const uint8_t* data, int len) = 0;
+
+    /** @brief Give the receive path back to the radio and read the counters */
+    virtual void endSimulation(DownloadBenchProbe& probe) = 0;
+};
+
+/**
+ * @class DownloadBenchmark
+ * @brief Simulated fleet + looping download, run in its own task
+ */
+class DownloadBenchmark {
+public:
+    static const uint8_t SIM_BOATS = 10;
+    static const uint8_t SIM_RATE_HZ = 10;           ///< GPS rate of each simulated boat
+    static const uint32_t TICK_MS = 10;              ///< Injection period
+    static const uint16_t DEFAULT_SECONDS = 30;
+    static const uint16_t MAX_SECONDS = 600;
+    static const size_t FILE_BYTES = 1024 * 1024;    ///< Size of the downloaded test file
+    static constexpr size_t BUFFER_BYTES = 4096;
+    static const uint16_t HTTP_PORT = 80;
+    static const char* const FILE_NAME;
+
+    /** @brief True for the MAC addresses of the simulated boats */
+    static bool isSimulated(const uint8_t* mac);
+
+private:
+    Logger* logger_;
+    BusScheduler* bus_;
+    DownloadBenchTarget* target_;
+    TaskHandle_t task_;
+    volatile bool running_;
+    uint16_t seconds_;
+    uint32_t sequence_;      ///< Continues across runs: the boats may still be known
+    uint8_t buffer_[BUFFER_BYTES];
+
+    // Download loop
+    WiFiClient client_;
+    bool connected_;
+    uint32_t downloads_;     ///< Complete responses
+    uint64_t downloadBytes_;
+    uint32_t connectErrors_;
+
+    void log(const String& message);
+    static void taskEntry(void* parameter);
+    void run();
+    bool prepareFile();
+    void injectPacket(uint8_t boat, uint32_t sequence);
+    void pumpDownload();
+
+public:
+    DownloadBenchmark();
+
+    /** @brief Configure the logging system */
+    void setLogger(Logger& logger);
+
+    /** @brief Create the test file in storage slots of the shared SPI bus */
+    void setBus(BusScheduler& bus) { bus_ = &bus; }
+
+    /**
+     * @brief Start a run in the background; the result is logged at the end
+     * @param target Receive path under test
+     * @param seconds Duration, clamped to 1-MAX_SECONDS
+     * @return false if a run is already in progress or the task cannot start
+     *
+     * @warning The file server must be running. Real ESP-NOW frames are not
+     *          processed during the run.
+     */
+    bool start(DownloadBenchTarget& target, uint16_t seconds);
+
+    bool isRunning() const { return running_; }
+};
@@ -4,7 +4,74 @@
  * 
  * This class manages an HTTP web server that allows remote access to SD card files
  * through a web browser. It handles WiFi connection, HTTP requests, and file serving
- * with automatic switching between ESPNow and WiFi modes.
+ * while ESP-NOW keeps receiving the fleet.
+ * 
+ * ESP-NOW only hears the fleet on ESPNOW_CHANNEL, so the link is chosen to
+ * keep the radio there:
+ * - the configured network, if a scan of ESPNOW_CHANNEL finds it (station
+ *   sharing the channel with ESP-NOW);
+ * - otherwise an access point of the display itself on ESPNOW_CHANNEL
+ *   (soft-AP, http://192.168.4.1), the laptop joins it.
+ * The former behaviour (join the network on any channel, ESP-NOW deaf until
+ * the server stops) is only used with "mode": "station" in wifi_config.json.
+ * 
+ * startFileServer() only starts the connection: scan, association and
+ * DHCP are steps of a state machine run by the server task, so the touch
+ * screen and the display never wait on the network (connectState() tells
+ * when the server is up). The BSSID and channel of the last network joined
+ * are cached in NVS: the next connection skips the scan and goes straight
+ * to association and DHCP. The address always comes from DHCP, so a lease
+ * given to another device since is never reused. A cached link that fails
+ * is forgotten and the full connection runs at once.
+ * 
+ * The server runs in its own task: the main loop never waits on a network
+ * client. Request handlers only send the headers of a download; the body is
+ * streamed by the server task from a transfer slot, one bounded chunk per
+ * round and only when the socket can take it, so several downloads progress
+ * side by side while new requests keep being accepted.
+ * 
+ * Downloads carry a strong ETag (file size and modification time) and accept
+ * byte ranges, single or multiple (multipart/byteranges): an interrupted
+ * download resumes where it stopped, and a conditional request for an
+ * unchanged file gets a 304 without reading the file.
+ * 
+ * Whole downloads of text files (Kepler JSON, CSV) are gzip-encoded on the
+ * fly when the client accepts it, unless the request says ?gzip=0. The
+ * compressor is the deflate of the ESP32 ROM: its fixed 32 KB window and
+ * tables are allocated once in PSRAM, GZIP_STREAMS at most; without a free
+ * compressor the file is sent as is. Compression time and the useful
+ * throughput with and without gzip are part of the statistics.
+ * 
+ * The web UI (HTML, CSS, JS of web/) is gzipped at build time by
+ * scripts/embed_web.py and compiled into flash (WebAssets.h): a page is sent
+ * from flash as it is, with an ETag and cache headers, and the pages read
+ * the dynamic data from the JSON endpoints. /list is the same page as /.
+ * 
+ * Directory listings (/api/files in JSON) are paginated and
+ * streamed with chunked encoding from a small fixed buffer. A page is
+ * selected in one pass over the directory, keeping only the best
+ * LIST_PAGE_MAX entries after the cursor of the previous page, so memory
+ * does not grow with the number of files on the card.
+ * 
+ * /zip streams a ZIP archive of the files of a directory, all of them, a
+ * selection or a date range. Entries are written as they are read (sizes
+ * and CRC in data descriptors after each file): no temporary file and no
+ * pass over the data before sending. Text files are deflated with one of
+ * the gzip compressors when one is free, the others are stored; memory is
+ * one fixed table of ZIP_MAX_ENTRIES entries whatever the archive size.
+ * 
+ * /api/track returns the track of one device of a session, for a time
+ * window and decimated to a number of points, in GeoJSON or binary. The
+ * session lines are in time order: the window start is found by bisection
+ * on the file offset, then the window is read once, so the work depends on
+ * the window and not on the size of the session. Like a download, the
+ * window is streamed by the server task from a transfer slot.
+ * 
+ * /api/live streams the fleet as it is received (boats, buoys, anemometer),
+ * as Server-Sent Events or fixed-size binary records, at a rate chosen by
+ * each client. The states come from a LiveTelemetry table that only keeps
+ * the latest state of each device: a client that reads slowly gets fewer,
+ * fresher updates instead of a growing queue.
  * 
  * @author Philippe Hubert
  * @date 2025
@@ -16,9 +83,67 @@
 #include <WiFi.h>
 #include <WebServer.h>
 #include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "LiveTelemetry.h"
 
-// Forward declaration
+// Forward declarations
 class Logger;
+class BusScheduler;
+struct WebAsset;
+
+/**
+ * @struct HttpServerStats
+ * @brief Request counters and timings of the file server
+ */
+struct HttpServerStats {
+    uint32_t requests;          ///< Completed requests
+    uint32_t errors;            ///< Status >= 400, or transfer aborted
+    uint32_t rejected;          ///< 503: all transfer slots busy
+    uint64_t bytesSent;         ///< Response bodies
+    uint64_t totalDurationMs;   ///< Request received -> last byte sent
+    uint32_t maxDurationMs;
+    uint8_t activeTransfers;    ///< Downloads in progress
+    uint8_t peakTransfers;      ///< Most downloads in progress at once
+    uint32_t plainDownloads;    ///< Complete whole-file downloads without gzip
+    uint64_t plainBytes;
+    uint64_t plainMs;
+    uint32_t gzipDownloads;     ///< Complete gzip downloads
+    uint64_t gzipInputBytes;    ///< File bytes compressed
+    uint64_t gzipOutputBytes;   ///< Bytes sent (gzip header and trailer included)
+    uint64_t gzipMicros;        ///< Time spent in the compressor
+    uint64_t gzipMs;            ///< Request received -> last byte sent
+    uint32_t zipArchives;       ///< Complete ZIP downloads
+    uint32_t zipFiles;          ///< Files in them
+    uint64_t zipInputBytes;     ///< File bytes archived
+    uint64_t zipOutputBytes;    ///< Archive bytes sent
+    uint8_t liveClients;        ///< Live streams open
+    uint32_t liveRecords;       ///< Device states sent on live streams
+    uint32_t liveSkipped;       ///< Live rounds skipped: previous batch still unsent
+};
+
+/**
+ * @enum WiFiLinkMode
+ * @brief How the file server reached the network
+ */
+enum WiFiLinkMode : uint8_t {
+    WIFI_LINK_NONE = 0,
+    WIFI_LINK_SOFT_AP,         ///< Own access point on the ESP-NOW channel (ESP-NOW kept)
+    WIFI_LINK_SHARED_STATION,  ///< Configured network found on the ESP-NOW channel (ESP-NOW kept)
+    WIFI_LINK_STATION,         ///< Configured network on any channel (ESP-NOW interrupted)
+};
+
+/**
+ * @enum WiFiConnectState
+ * @brief Progress of startFileServer(), which returns before the link is up
+ */
+enum WiFiConnectState : uint8_t {
+    WIFI_STATE_IDLE = 0,       ///< Server stopped
+    WIFI_STATE_CONNECTING,     ///< Scan, association and DHCP in progress (server task)
+    WIFI_STATE_ACTIVE,         ///< Link up, server running
+    WIFI_STATE_FAILED,         ///< Last start failed, server stopped
+};
 
 /**
  * @struct WiFiConfig
@@ -30,6 +155,9 @@ class Logger;
 struct WiFiConfig {
     String ssid;        ///< WiFi network SSID
     String password;    ///< WiFi network password
+    String mode;        ///< "auto" (default), "ap" or "station"
+    String apSsid;      ///< Soft-AP network name
+    String apPassword;  ///< Soft-AP password (8 characters or more)
     bool isValid;       ///< Indicates if configuration is valid
     
     WiFiConfig() : isValid(false) {}
@@ -48,35 +176,294 @@ struct WiFiConfig {
  * - HTTP web server with file browsing interface
  * - File download capabilities
  * - Automatic WiFi connection/disconnection
- * - ESPNow/WiFi mode switching
+ * - ESP-NOW kept alive (soft-AP or station on the ESP-NOW channel)
  * - Responsive web interface with file type recognition
  * 
  * Usage workflow:
  * 1. Load WiFi credentials from SD card
- * 2. Connect to WiFi network
+ * 2. Join the network on the ESP-NOW channel, or open the soft-AP
  * 3. Start HTTP server on port 80
  * 4. Serve web interface for file access
- * 5. Disconnect WiFi and return to ESPNow mode when stopped
+ * 5. Close the link and restore the ESP-NOW radio settings when stopped
  */
 
 class FileServerManager {
+public:
+    static const int MAX_TRANSFERS = 4;              ///< Downloads streamed at the same time
+    static const size_t CHUNK_BYTES = 4096;          ///< Bytes read and sent per transfer and round
+    static const uint32_t STALL_TIMEOUT_MS = 15000;  ///< Transfer aborted without progress for this long
+    static const uint32_t IDLE_POLL_MS = 5;          ///< Server task pause when nothing is in progress
+    static const uint8_t ESPNOW_CHANNEL = 1;         ///< Channel of the fleet (ESP-NOW)
+    static const uint32_t SCAN_MS_PER_CHANNEL = 150; ///< Scan of the ESP-NOW channel only
+    static const uint8_t AP_MAX_CLIENTS = 4;
+    static const uint32_t CONNECT_POLL_MS = 20;      ///< Connection step period
+    static const uint32_t JOIN_TIMEOUT_MS = 10000;   ///< Association + DHCP
+    static const uint32_t CACHED_JOIN_TIMEOUT_MS = 3000;  ///< Association with the cached AP, then the cache is dropped
+    static const int MAX_RANGES = 8;                 ///< More ranges in a request: whole file sent
+    static const int GZIP_STREAMS = 2;               ///< Compressors (PSRAM), i.e. gzip downloads at once
+    static const int GZIP_PROBES = 16;               ///< Match search effort, greedy parsing (fast levels)
+    static const int LIST_PAGE_MAX = 50;             ///< Entries per listing page, at most
+    static const int LIST_PAGE_DEFAULT = 25;
+    static const size_t LIST_NAME_MAX = 96;          ///< Longer names are cut in listings
+    static const size_t LIST_BUFFER_BYTES = 1024;    ///< Chunk of a streamed listing
+    static const int TRACK_MAX_POINTS = 2000;        ///< Points of a track, at most
+    static const int TRACK_DEFAULT_POINTS = 500;
+    static const size_t TRACK_LINE_BYTES = 384;      ///< Longer than any session line (Storage: 320)
+    static const size_t TRACK_RECORD_BYTES = 16;     ///< Binary track point
+    static const size_t TRACK_DEVICE_MAX = 32;       ///< Longest device_name of a track request
+    static const uint32_t TRACK_TIME_SLACK_S = 5;    ///< Lines of a batch may be slightly out of order
+    static const int ZIP_MAX_ENTRIES = 200;          ///< Files in one archive, at most
+    static const int MAX_LIVE_CLIENTS = 3;           ///< Live streams at the same time
+    static const size_t LIVE_BUFFER_BYTES = 2048;    ///< Batch of one live stream (PSRAM)
+    static const uint32_t LIVE_MIN_PERIOD_MS = 100;  ///< 10 Hz at most
+    static const uint32_t LIVE_MAX_PERIOD_MS = 10000;
+    static const uint32_t LIVE_KEEPALIVE_MS = 15000; ///< Something sent at least this often
+
 private:
+    class HttpServer;   ///< WebServer that can hand its client over to a transfer slot
+    struct GzipStream;  ///< Compressor and buffers of one gzip download (PSRAM)
+    
+    /**
+     * @enum ConnectPhase
+     * @brief Step of the connection in progress
+     */
+    enum ConnectPhase : uint8_t {
+        CONNECT_START = 0,     ///< Pick the link: cache, scan, soft-AP
+        CONNECT_SCAN,          ///< Asynchronous scan of ESPNOW_CHANNEL
+        CONNECT_ASSOCIATE,     ///< WiFi.begin() sent, waiting for the access point
+        CONNECT_IP,            ///< Associated, waiting for the address
+    };
+    
+    /**
+     * @struct WiFiCache
+     * @brief Last network joined, kept in NVS
+     */
+    struct WiFiCache {
+        uint8_t version;
+        char ssid[33];
+        uint8_t bssid[6];
+        uint8_t channel;
+    };
+    struct ZipArchive;  ///< Entry table and record staging of the ZIP download (PSRAM)
+    struct TrackScan;   ///< Window state and staging of the /api/track body (PSRAM)
+    
+    /**
+     * @struct ListEntry
+     * @brief One file or directory of a listing page
+     */
+    struct ListEntry {
+        char name[LIST_NAME_MAX];
+        uint32_t size;
+        uint32_t mtime;
+        bool isDirectory;
+    };
+    
+    /**
+     * @struct ListQuery
+     * @brief Listing parameters: ?dir=&sort=date|name&limit=&after=
+     */
+    struct ListQuery {
+        String dir;
+        bool byName;        ///< false: newest first
+        int limit;
+        bool hasCursor;
+        ListEntry cursor;   ///< Last entry of the previous page ("after")
+    };
+    
+    /**
+     * @struct ListPage
+     * @brief What a listing pass found
+     */
+    struct ListPage {
+        int count;          ///< Entries in listEntries_, in order
+        int total;          ///< Entries in the directory
+        int offset;         ///< Entries before the page
+        bool more;          ///< Entries after the page
+    };
+    
+    /**
+     * @struct ByteRange
+     * @brief Part of a file requested with a Range header
+     */
+    struct ByteRange {
+        size_t start;
+        size_t length;
+    };
+    
+    /**
+     * @struct Transfer
+     * @brief Response body streamed by the server task after the handler returned
+     * 
+     * The body is a list of file ranges (the whole file is one range). A
+     * multipart/byteranges body also has a text header before each range
+     * and a closing boundary, sent from @c pending.
+     */
+    struct Transfer {
+        bool active;
+        WiFiClient client;          ///< Copy of the request client: keeps the socket open
+        File file;
+        String label;               ///< Method and URI, for the log
+        int status;                 ///< 200 or 206, for the log
+        size_t fileSize;
+        ByteRange ranges[MAX_RANGES];
+        uint8_t rangeCount;
+        uint8_t rangeIndex;         ///< Next range to start
+        size_t rangeRemaining;      ///< File bytes left in the current range
+        bool seekPending;           ///< Current range not positioned yet
+        bool multipart;
+        bool closed;                ///< Closing boundary queued
+        const char* contentType;    ///< Part header of multipart bodies
+        String pending;             ///< Text sent before the next file bytes
+        size_t pendingSent;
+        GzipStream* gzip;           ///< Compressed body, or nullptr
+        ZipArchive* zip;            ///< ZIP body (its deflated entries use gzip), or nullptr
+        TrackScan* track;           ///< Track body, or nullptr
+        size_t sent;
+        unsigned long startMs;      ///< Request received
+        unsigned long lastProgressMs;
+    };
+    
+    /**
+     * @struct LiveClient
+     * @brief One /api/live stream, fed by the server task
+     * 
+     * A new batch is only collected once the previous one was fully
+     * written: while the socket is full, updates coalesce in the telemetry
+     * table instead of in this buffer.
+     */
+    struct LiveClient {
+        bool active;
+        WiFiClient client;
+        TelemetryFormat format;
+        uint32_t periodMs;
+        LiveTelemetry::Cursor cursor;
+        char* buffer;               ///< LIVE_BUFFER_BYTES (PSRAM)
+        size_t length;
+        size_t written;
+        size_t sent;
+        uint32_t records;
+        unsigned long startMs;
+        unsigned long nextMs;       ///< Next batch due
+        unsigned long lastSendMs;
+        unsigned long lastProgressMs;
+    };
+
     Logger* logger_;           ///< Pointer to logging system
-    WebServer* webServer_;     ///< HTTP web server instance
-    bool serverActive_;        ///< Server running status
+    HttpServer* webServer_;    ///< HTTP web server instance
+    BusScheduler* bus_;        ///< SPI bus shared with the display (SD reads)
+    volatile bool serverActive_;  ///< Server running status
     bool sdInitialized_;      ///< SD card initialization status
     bool wifiConnected_;      ///< WiFi connection status
+    WiFiLinkMode linkMode_;   ///< Link in use while connected
     WiFiConfig wifiConfig_;   ///< WiFi configuration data
     
+    // Connection state machine (steps run by the server task)
+    volatile WiFiConnectState connectState_;
+    volatile bool cancelConnect_;     ///< Set by stopFileServer()
+    ConnectPhase phase_;
+    bool shareChannel_;               ///< Station attempt on ESPNOW_CHANNEL
+    bool usingCache_;                 ///< Attempt made with the cached link
+    bool cacheValid_;
+    unsigned long connectStartMs_;
+    unsigned long phaseStartMs_;
+    uint32_t scanMs_;
+    uint32_t associateMs_;
+    uint32_t ipMs_;
+    WiFiCache cache_;
+    
+    // Server task and transfer slots (only touched by the server task)
+    TaskHandle_t task_;
+    SemaphoreHandle_t stopped_;      ///< Given by the task once the server is stopped
+    SemaphoreHandle_t statsMutex_;
+    Transfer transfers_[MAX_TRANSFERS];
+    GzipStream* gzipStreams_[GZIP_STREAMS];  ///< Allocated on first use, then kept
+    ZipArchive* zip_;                        ///< One archive at a time, allocated on first use
+    TrackScan* track_;                       ///< One track at a time, allocated on first use
+    uint8_t chunk_[CHUNK_BYTES];
+    ListEntry* listEntries_;                 ///< LIST_PAGE_MAX entries (PSRAM)
+    char listBuffer_[LIST_BUFFER_BYTES];     ///< Pending text of a chunked response
+    size_t listLength_;
+    HttpServerStats stats_;
+    LiveTelemetry* telemetry_;
+    LiveClient liveClients_[MAX_LIVE_CLIENTS];
+    
+    // Current request (set by the handlers, read by timedHandler)
+    unsigned long requestStart_;
+    int responseStatus_;
+    size_t responseBytes_;
+    bool transferQueued_;
+    
+    static void taskEntry(void* parameter);
+    void serverLoop();
+    bool pumpTransfers();
+    void finishTransfer(Transfer& transfer, bool complete);
+    bool startRange(Transfer& transfer);
+    void queueTransfer(Transfer& transfer, const String& label);
+    bool pumpGzip(Transfer& transfer, size_t& written);
+    GzipStream* acquireGzip();
+    void queueGzipTransfer(Transfer& transfer, File& file, const char* contentType, const String& etag,
+                           GzipStream* stream);
+    bool pumpZip(Transfer& transfer, size_t& written);
+    bool startZipEntry(Transfer& transfer);
+    bool pumpZipData(Transfer& transfer, size_t& written);
+    ZipArchive* acquireZip();
+    static uint32_t parseDay(const String& text, bool endOfDay);
+    bool timeAt(File& file, size_t offset, bool last, uint32_t& time);
+    bool findTrackStart(File& file, size_t size, uint32_t from, size_t& offset);
+    TrackScan* acquireTrack();
+    bool pumpTrack(Transfer& transfer, size_t& written);
+    bool scanTrack(Transfer& transfer);
+    static bool acceptsGzip(const String& header);
+    static bool isCompressible(const String& filename);
+    static String partHeader(const Transfer& transfer, uint8_t index);
+    static String closingBoundary();
+    static int parseRanges(const String& header, size_t size, ByteRange* ranges);
+    static String makeETag(File& file);
+    
+    // Paginated listings, streamed with chunked encoding
+    void parseListQuery(ListQuery& query);
+    int scanDirectory(const ListQuery& query, ListPage& page);
+    static int compareEntries(const ListEntry& a, const ListEntry& b, bool byName);
+    static String cursorOf(const ListEntry& entry);
+    static String listPath(const String& dir, const char* name);
+    void beginChunked(const char* contentType);
+    void emit(const char* text);
+    void emit(const String& text) { emit(text.c_str()); }
+    void emit(const uint8_t* data, size_t length);
+    void emitf(const char* format, ...);
+    void endChunked();
+    void abortTransfers();
+    bool pumpLive();
+    void finishLive(LiveClient& live, bool complete);
+    void closeFile(File& file);
+    int freeTransferSlot() const;
+    void timedHandler(void (FileServerManager::*handler)());
+    void recordRequest(const String& label, int status, size_t bytes, unsigned long durationMs);
+    void reply(int code, const char* contentType, const String& content);
+    void reply(int code, const char* contentType, const char* content, size_t length);
+    
     // HTTP request handlers
-    void handleRoot();         ///< Handle root URL (main page)
-    void handleFileList();     ///< Handle file listing requests
+    void handleAsset();        ///< Handle the web UI pages (/, /list, scripts, styles)
+    void sendAsset(const WebAsset& asset, int code);  ///< Gzipped page from flash
+    void handleFileApi();      ///< Handle /api/files (JSON listing)
     void handleFileDownload(); ///< Handle file download requests
+    void handleZip();          ///< Handle /zip (archive of a directory)
+    void handleTrack();        ///< Handle /api/track (decimated track of a device)
+    void handleLive();         ///< Handle /api/live (telemetry stream)
     void handleNotFound();     ///< Handle 404 errors
     
     // WiFi management methods
     bool loadWiFiConfig();     ///< Load WiFi config from SD card
-    bool connectToWiFi();      ///< Connect to WiFi network
+    void connectStep();        ///< One step of the connection
+    void beginJoin(bool shareChannel, const uint8_t* bssid, uint8_t channel);  ///< Station link
+    void joinFailed();         ///< Cache dropped and retried, or soft-AP, or failure
+    void linkUp();             ///< Timings, cache and HTTP server once the link works
+    void abortConnect();       ///< Cancelled: radio back to ESP-NOW
+    void restoreEspNowRadio(); ///< Long Range only, ESPNOW_CHANNEL
+    bool loadCache();
+    void saveCache();
+    void clearCache();
+    bool startSoftAP();        ///< Access point on ESPNOW_CHANNEL
     void disconnectWiFi();     ///< Disconnect from WiFi
     
     // Static instance for callbacks
@@ -107,6 +494,18 @@ public:
      */
     void setLogger(Logger& logger);
     
+    /**
+     * @brief Share the SPI bus with the display
+     * @param bus Bus scheduler; every SD read of the server takes a storage slot
+     */
+    void setBus(BusScheduler& bus);
+    
+    /**
+     * @brief Source of the /api/live stream
+     * @param telemetry Device table published by the main loop
+     */
+    void setTelemetry(LiveTelemetry& telemetry) { telemetry_ = &telemetry; }
+    
     /**
      * @brief Initialize the file server (without starting it)
      * @return true if initialization succeeds, false otherwise
@@ -115,6 +514,7 @@ public:
      * - Verifies SD card accessibility
      * - Creates WebServer instance on port 80
      * - Registers HTTP route handlers
+     * - Creates the server task (idle until the server starts)
      * - Does NOT start the server or connect WiFi
      * 
      * @note Call this during system initialization
@@ -122,16 +522,19 @@ public:
     bool initFileServer();
     
     /**
-     * @brief Start the HTTP file server
-     * @return true if server starts successfully, false otherwise
+     * @brief Start the HTTP file server, without waiting for the network
+     * @return true if the connection started, false without configuration
+     *         or if a start is already in progress
      * 
      * This method:
      * - Loads WiFi configuration from SD card
-     * - Connects to WiFi network
-     * - Starts the HTTP server
-     * - Makes the server accessible via web browser
+     * - Hands the connection to the server task: join the network or open
+     *   the soft-AP (see WiFiLinkMode), then start the HTTP server
+     * 
+     * Follow connectState(): WIFI_STATE_ACTIVE once the server is reachable,
+     * WIFI_STATE_FAILED if no link could be made.
      * 
-     * @note Switches from ESPNow to WiFi mode
+     * @note ESP-NOW keeps receiving unless "mode": "station" is configured
      */
     bool startFileServer();
     
@@ -140,11 +543,13 @@ public:
      * @return true if server stops successfully, false otherwise
      * 
      * This method:
-     * - Stops the HTTP server
-     * - Disconnects from WiFi
-     * - Returns system to ESPNow mode
+     * - Cancels a connection in progress, or asks the server task to abort
+     *   the transfers and stop the HTTP server
+     * - Closes the WiFi link
+     * - Restores the ESP-NOW radio settings (Long Range, ESPNOW_CHANNEL)
      * 
-     * @note Allows return to normal ESPNow operation
+     * @note ESP-NOW only needs a full reinitialization if keepsEspNow() was
+     *       false before the call
      */
     bool stopFileServer();
     
@@ -160,6 +565,26 @@ public:
      */
     bool isWiFiConnected() const { return wifiConnected_; }
     
+    /**
+     * @brief Progress of the last startFileServer()
+     */
+    WiFiConnectState connectState() const { return connectState_; }
+    
+    /**
+     * @brief True while the connection runs in the background
+     */
+    bool isConnecting() const { return connectState_ == WIFI_STATE_CONNECTING; }
+    
+    /**
+     * @brief Link used by the running server
+     */
+    WiFiLinkMode linkMode() const { return linkMode_; }
+    
+    /**
+     * @brief True while the link (made or attempted) leaves ESP-NOW receiving on its channel
+     */
+    bool keepsEspNow() const { return linkMode_ != WIFI_LINK_STATION; }
+    
     /**
      * @brief Send message to logging system
      * @param message Message to log
@@ -170,21 +595,21 @@ public:
     void log(const String& message);
     
     /**
-     * @brief Handle incoming HTTP client requests
-     * 
-     * Must be called regularly in the main loop when server is active
-     * to process incoming HTTP requests and serve responses.
-     * 
-     * @note Call this in loop() when isServerActive() returns true
+     * @brief Copy of the request counters and timings
+     */
+    HttpServerStats stats() const;
+    
+    /**
+     * @brief One-line summary of the requests served
      */
-    void handleClient();
+    String describe() const;
     
     /**
      * @brief Get the server's IP address
      * @return IP address as string, or "Not connected" if WiFi disconnected
      * 
-     * Returns the local IP address assigned by the WiFi network.
-     * This address is used to access the web interface from browsers.
+     * Returns the soft-AP address, or the local IP address assigned by the
+     * WiFi network. This address is used to access the web interface from browsers.
      */
     String getServerIP();
 };
\ No newline at end of file
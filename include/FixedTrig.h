@@ -0,0 +1,83 @@
+/**
+ * @file FixedTrig.h
+ * @brief Fixed-point sine/cosine from a table generated at compile time
+ *
+ * Angles are binary angle units: one turn is ANGLE_STEPS units (1024, i.e.
+ * 0.35° per unit), so wrapping is a mask. Results are Q15 (32767 = 1.0).
+ * The table is computed by the compiler and lives in flash; no float
+ * trigonometry runs on the device.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+namespace fixed_trig_detail {
+
+constexpr double kPi = 3.14159265358979323846;
+
+/** @brief sin(x) by Taylor series, x reduced to [-pi/2, pi/2] (error < 1e-9) */
+constexpr double sinApprox(double x) {
+    if (x > kPi) x -= 2 * kPi;
+    if (x > kPi / 2) x = kPi - x;
+    if (x < -kPi / 2) x = -kPi - x;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 12; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+template <int N>
+struct SinTable {
+    int16_t values[N];
+
+    constexpr SinTable() : values() {
+        for (int i = 0; i < N; i++) {
+            double v = sinApprox(2 * kPi * i / N) * 32767.0;
+            values[i] = (int16_t)(v >= 0 ? v + 0.5 : v - 0.5);
+        }
+    }
+};
+
+} // namespace fixed_trig_detail
+
+/**
+ * @class FixedTrig
+ * @brief Table-based Q15 sine and cosine
+ */
+class FixedTrig {
+public:
+    static constexpr int ANGLE_BITS = 10;
+    static constexpr int ANGLE_STEPS = 1 << ANGLE_BITS;   ///< Angle units per turn
+    static constexpr int ANGLE_MASK = ANGLE_STEPS - 1;
+    static constexpr int32_t ONE = 32767;                 ///< Q15 value of 1.0
+
+    static constexpr fixed_trig_detail::SinTable<ANGLE_STEPS> table{};
+
+    /** @brief sin(angle) in Q15 */
+    static int16_t sin(uint16_t angle) { return table.values[angle & ANGLE_MASK]; }
+
+    /** @brief cos(angle) in Q15 */
+    static int16_t cos(uint16_t angle) { return table.values[(angle + ANGLE_STEPS / 4) & ANGLE_MASK]; }
+
+    /** @brief Degrees (any sign, any number of turns) to angle units, rounded */
+    static uint16_t fromDegrees(float degrees) {
+        int32_t units = (int32_t)lroundf(degrees * (ANGLE_STEPS / 360.0f));
+        return (uint16_t)(units & ANGLE_MASK);
+    }
+
+    /** @brief Angle units to degrees [0, 360) */
+    static float toDegrees(uint16_t angle) { return (angle & ANGLE_MASK) * (360.0f / ANGLE_STEPS); }
+};
+
+static_assert(FixedTrig::table.values[0] == 0, "sin(0)");
+static_assert(FixedTrig::table.values[FixedTrig::ANGLE_STEPS / 4] == FixedTrig::ONE, "sin(90)");
+static_assert(FixedTrig::table.values[FixedTrig::ANGLE_STEPS / 8] == 23170, "sin(45)");
+static_assert(FixedTrig::table.values[FixedTrig::ANGLE_STEPS / 2] == 0, "sin(180)");
+static_assert(FixedTrig::table.values[3 * FixedTrig::ANGLE_STEPS / 4] == -FixedTrig::ONE, "sin(270)");
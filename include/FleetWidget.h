@@ -0,0 +1,76 @@
+/**
+ * @file FleetWidget.h
+ * @brief Fleet overview table: one row per detected boat
+ *
+ * Two columns of rows (name, speed, heading, age, loss rate). The widget
+ * keeps the text of every cell; a new fleet state only dirties the cells
+ * whose text changed, and the dirty cells are reported as a few row bands,
+ * so the cost of a frame follows the number of changes, not the number of
+ * boats. Rows are sorted by name with a stable sort (ties keep the order of
+ * detection): a boat only moves when another one joins or leaves.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <M5Unified.h>
+#include "Widgets.h"
+
+/**
+ * @struct FleetEntry
+ * @brief State of one boat, as published in the display snapshot
+ */
+struct FleetEntry {
+    char name[8];               ///< Display name (6 characters max)
+    uint32_t deviceId;          ///< Last 4 bytes of the MAC address
+    int32_t latitude;           ///< 1e-7 degree (0/0: no fix)
+    int32_t longitude;          ///< 1e-7 degree
+    float speed;                ///< Knots
+    float heading;              ///< Degrees
+    unsigned long lastUpdate;   ///< millis() of the last packet
+    uint32_t receivedPackets;
+    uint32_t lostPackets;
+};
+
+/**
+ * @class FleetWidget
+ * @brief Incrementally updated fleet table
+ */
+class FleetWidget : public Widget {
+public:
+    static const int COLUMNS = 2;
+    static const int ROWS_PER_COLUMN = 15;
+    static const int MAX_ROWS = COLUMNS * ROWS_PER_COLUMN;
+    static const int CELLS = 5;              ///< Name, speed, heading, age, loss
+    static const int16_t ROW_HEIGHT = 10;
+    static const unsigned long STALE_MS = 5000;  ///< Speed/heading shown as "--" after this
+
+private:
+    char cells_[MAX_ROWS][CELLS][8];   ///< Text shown in each cell
+    uint8_t cellDirty_[MAX_ROWS];      ///< One bit per cell
+    int rowCount_;
+    int selectedRow_;
+
+    static const int16_t kCellX[CELLS];
+    static const int16_t kCellW[CELLS];
+
+    int16_t columnX(int column) const { return bounds_.x + column * (bounds_.w / COLUMNS); }
+    int16_t rowY(int row) const { return bounds_.y + ROW_HEIGHT * (1 + row % ROWS_PER_COLUMN); }
+    void setCell(int row, int cell, const char* text);
+
+public:
+    FleetWidget(int16_t x, int16_t y, int16_t w, int16_t h);
+
+    /**
+     * @param entries Boats in detection order
+     * @param count Number of entries (rows beyond MAX_ROWS are not shown)
+     * @param selected Index in entries of the selected boat (-1: none)
+     * @param now millis() of the frame, for the ages
+     */
+    void set(const FleetEntry* entries, int count, int selected, unsigned long now);
+
+    int dirtyRegion(WidgetRect* rects) const override;
+    void clearDirty() override;
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+};
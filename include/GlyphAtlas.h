@@ -0,0 +1,59 @@
+/**
+ * @file GlyphAtlas.h
+ * @brief Pre-rendered glyphs for the numeric readouts
+ *
+ * The digits, the minus sign and the decimal point are rendered once at
+ * boot with the scaled built-in font, into RGB565 cells stored one after
+ * the other. Drawing a character is then a plain image copy into the
+ * canvas instead of a pixel-scaled text rendering.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <M5Unified.h>
+
+/**
+ * @class GlyphAtlas
+ * @brief Fixed-width glyph cells of one text size and color
+ */
+class GlyphAtlas {
+public:
+    static const int GLYPH_COUNT = 12;          ///< "0123456789-."
+    static const int16_t FONT_WIDTH = 6;        ///< Built-in font cell at size 1
+    static const int16_t FONT_HEIGHT = 8;
+
+private:
+    uint8_t textSize_;
+    uint16_t color_;
+    int16_t width_;
+    int16_t height_;
+    uint16_t* pixels_;   ///< GLYPH_COUNT cells of width_ x height_ (sprite byte order)
+
+    static int indexOf(char c);
+
+public:
+    GlyphAtlas(uint8_t textSize, uint16_t color);
+    ~GlyphAtlas();
+
+    /**
+     * @brief Render the glyphs (call once after M5.begin())
+     * @return false if the cells could not be allocated (text fallback)
+     */
+    bool begin();
+
+    bool isReady() const { return pixels_ != nullptr; }
+    int16_t glyphWidth() const { return width_; }
+    int16_t glyphHeight() const { return height_; }
+    uint8_t textSize() const { return textSize_; }
+
+    /**
+     * @brief Copy one glyph into a canvas
+     * @return false if the character is not in the atlas (nothing drawn)
+     */
+    bool drawGlyph(LovyanGFX& gfx, int32_t x, int32_t y, char c) const;
+
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+};
@@ -0,0 +1,158 @@
+/**
+ * @file HistoryBuffer.h
+ * @brief Pre-trigger "black box" history of received data
+ *
+ * This class keeps a rolling in-RAM history of the last minutes of data
+ * received from every device (boats, anemometers, buoys), so that pressing
+ * RECORD also captures what happened just before the button was pressed
+ * (typically the start sequence).
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <vector>
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include "Storage.h"
+
+/**
+ * @struct HistoryRecord
+ * @brief Compact (24 bytes) representation of a StorageData entry
+ *
+ * Positions are fixed-point integers in 1e-7 degree (about 1 cm): a float
+ * only keeps about 1 m at these magnitudes, less than the double of a buoy
+ * position. Other floats that do not need full precision are stored as
+ * scaled integers, and device names are replaced by an index into a small
+ * name table.
+ */
+struct HistoryRecord {
+    uint32_t timestamp;        ///< Reception timestamp (millis)
+    uint32_t sequenceNumber;   ///< Sequence number of the packet
+    int32_t latitude;          ///< Latitude (boat, buoy), 1e-7 degree
+    int32_t longitude;         ///< Longitude (boat, buoy), 1e-7 degree
+    int16_t value1;            ///< Speed (boat) or wind speed (anemometer), x100
+    int16_t value2;            ///< Heading (boat), wind direction (anemometer) or heading command (buoy), x10
+    uint8_t dataType;          ///< DataType of the original entry
+    uint8_t deviceSlot;        ///< Name table index (boat, anemometer) or buoyId (buoy)
+    uint8_t satellites;        ///< Satellites (boat)
+    int8_t throttle;           ///< Throttle command (buoy)
+};
+
+/**
+ * @class HistoryBuffer
+ * @brief Fixed-size ring of HistoryRecord, allocated in PSRAM when available
+ *
+ * Features:
+ * - Continuous capture without any SD card access
+ * - Sized from minutes of history, data rate and number of devices
+ * - Trigger snapshot: the window preceding RECORD is frozen and drained
+ *   later by the storage task, in small batches
+ * - push() is safe to call from the ESP-NOW receive callback
+ *
+ * Memory footprint: sizeof(HistoryRecord) * rateHz * 60 bytes per minute
+ * and per device.
+ */
+class HistoryBuffer {
+private:
+    static const uint8_t NAME_SLOTS = 32;     ///< Maximum number of distinct device names
+    static const uint8_t NO_SLOT = 0xFF;      ///< Marker for an unknown device name
+
+    HistoryRecord* records_;        ///< Ring storage
+    uint32_t capacity_;             ///< Number of records in the ring
+    uint32_t writeCount_;           ///< Total number of records pushed (ring head)
+    uint32_t windowMs_;             ///< Length of the pre-trigger window
+    uint16_t minutes_;              ///< Configured history length
+    uint8_t rateHz_;                ///< Configured data rate per device
+    uint8_t maxDevices_;            ///< Configured number of devices
+    bool inPsram_;                  ///< True if the ring lives in PSRAM
+
+    char names_[NAME_SLOTS][18];    ///< Device names referenced by deviceSlot
+    uint8_t nameCount_;             ///< Number of used name slots
+
+    uint32_t drainCursor_;          ///< Next record to drain (absolute index)
+    uint32_t drainEnd_;             ///< End of the pre-trigger window (absolute index)
+    uint32_t drainCutoff_;          ///< Oldest timestamp kept in the pre-trigger window
+    uint32_t overwritten_;          ///< Records lost because the ring wrapped during drain
+
+    portMUX_TYPE lock_;             ///< Protects indexes against the receive callback
+
+    uint8_t findOrAddName(const char* name);
+    void encode(const StorageData& data, HistoryRecord& record);
+    void decode(const HistoryRecord& record, StorageData& data);
+
+public:
+    HistoryBuffer();
+    ~HistoryBuffer();
+
+    /**
+     * @brief Allocate the ring
+     * @param minutes Length of history to keep
+     * @param rateHz Expected data rate of a single device
+     * @param maxDevices Number of devices the ring is sized for
+     * @return true if the ring was allocated (possibly reduced), false otherwise
+     *
+     * The ring is placed in PSRAM when available. Without PSRAM, it is
+     * capped to a small internal-heap budget and the window is reduced
+     * accordingly.
+     */
+    bool begin(uint16_t minutes, uint8_t rateHz, uint8_t maxDevices);
+
+    /**
+     * @brief Append an entry to the history
+     * @param data Entry as it would be queued for storage
+     *
+     * Non-blocking and allocation-free; safe from the ESP-NOW callback.
+     */
+    void push(const StorageData& data);
+
+    /**
+     * @brief End of the pre-trigger window, taken when RECORD is pressed
+     *
+     * Safe from any task; nothing changes in the buffer.
+     */
+    HistoryTrigger captureTrigger();
+
+    /**
+     * @brief Freeze the pre-trigger window ending at a captured trigger
+     *
+     * Every record received during the configured minutes before the
+     * trigger becomes pending for drainPreTrigger(). Called by the task
+     * that drains, never during a drain.
+     */
+    void markTrigger(const HistoryTrigger& trigger);
+
+    /**
+     * @brief Check if pre-trigger records are waiting to be written
+     */
+    bool hasPendingPreTrigger();
+
+    /**
+     * @brief Decode up to maxRecords pending pre-trigger records
+     * @param out Vector receiving the decoded entries (appended)
+     * @param maxRecords Maximum number of records to decode
+     * @return Number of records appended
+     */
+    size_t drainPreTrigger(StorageBatch& out, size_t maxRecords);
+
+    /** @brief Bytes used per minute and per device at the configured rate */
+    uint32_t bytesPerMinutePerDevice() const { return (uint32_t)sizeof(HistoryRecord) * rateHz_ * 60; }
+
+    /** @brief Total bytes allocated for the ring */
+    uint32_t capacityBytes() const { return capacity_ * (uint32_t)sizeof(HistoryRecord); }
+
+    /** @brief Number of records the ring can hold */
+    uint32_t capacity() const { return capacity_; }
+
+    /** @brief True if the ring was allocated in PSRAM */
+    bool isInPsram() const { return inPsram_; }
+
+    /** @brief Records lost because the ring wrapped before being drained */
+    uint32_t overwrittenCount() const { return overwritten_; }
+
+    /**
+     * @brief One-line summary of the configuration and footprint
+     */
+    String describe() const;
+};
@@ -0,0 +1,142 @@
+/**
+ * @file LiveTelemetry.h
+ * @brief Latest state of every device, for the live endpoint of the file server
+ *
+ * The main loop publishes the boats, buoys and anemometer into a fixed
+ * table of MAX_DEVICES slots, one per device, each slot holding only the
+ * latest state and an update counter. A live client owns a Cursor: the
+ * update counter of each slot when it was last sent to that client.
+ *
+ * collect() writes, for one client, every device whose counter moved since
+ * its last send, in SSE or binary form. A client that reads slowly is
+ * simply asked for less often: the updates it missed in between are
+ * replaced by the latest one (coalesced per device) instead of piling up,
+ * so memory stays at one table plus one cursor per client.
+ *
+ * Binary records are RECORD_BYTES long, little endian:
+ * | Offset | Type      | Content                                           |
+ * |--------|-----------|---------------------------------------------------|
+ * | 0      | uint8     | TelemetryKind (0: keep-alive, rest of the record 0) |
+ * | 1      | uint8     | Satellites (boat), navigation mode (buoy)         |
+ * | 2      | uint16    | Age of the state in 1/10 s (65535: older)         |
+ * | 4      | uint32    | Device id                                         |
+ * | 8      | int32     | Latitude x 1e7                                    |
+ * | 12     | int32     | Longitude x 1e7                                   |
+ * | 16     | int16     | Speed x 100 (knots, wind speed for the anemometer) |
+ * | 18     | uint16    | Heading x 100 (wind direction; 65535: unknown)    |
+ * | 20     | char[12]  | Name, zero padded                                 |
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+enum TelemetryKind : uint8_t {
+    TELEMETRY_KEEPALIVE = 0,
+    TELEMETRY_BOAT,
+    TELEMETRY_BUOY,
+    TELEMETRY_WIND,
+};
+
+enum TelemetryFormat : uint8_t {
+    TELEMETRY_SSE = 0,     ///< text/event-stream, one JSON event per device
+    TELEMETRY_BINARY,      ///< Fixed-size records (see the table above)
+};
+
+/**
+ * @struct TelemetryState
+ * @brief Latest state of one device, as published by the main loop
+ */
+struct TelemetryState {
+    TelemetryKind kind;
+    uint32_t deviceId;      ///< MAC tail (boats, anemometer) or buoy id
+    uint32_t sequence;      ///< Same sequence as the stored state: nothing new
+    char name[18];
+    float latitude;
+    float longitude;
+    float speed;            ///< Knots, wind speed for the anemometer
+    float heading;          ///< Degrees, wind direction for the anemometer (-1: unknown)
+    uint8_t detail;         ///< Satellites (boat), navigation mode (buoy)
+    unsigned long receivedMs;  ///< millis() of the last packet
+};
+
+/**
+ * @class LiveTelemetry
+ * @brief Device table shared between the main loop and the server task
+ */
+class LiveTelemetry {
+public:
+    static const int MAX_DEVICES = 32;
+    static const size_t RECORD_BYTES = 32;
+    static const size_t EVENT_BYTES = 200;   ///< Longest SSE event
+
+    /**
+     * @struct Cursor
+     * @brief What one client has already received
+     */
+    struct Cursor {
+        uint32_t seen[MAX_DEVICES];  ///< Slot update counter at the last send
+        uint8_t next;                ///< Slot where the next collect() starts
+        bool more;                   ///< Last collect() stopped on a full buffer
+    };
+
+private:
+    struct Slot {
+        TelemetryState state;
+        uint32_t updates;            ///< Never reset: a reused slot is new to every cursor
+    };
+
+    Slot slots_[MAX_DEVICES];
+    SemaphoreHandle_t mutex_;
+    uint32_t published_;
+    uint32_t coalesced_;             ///< Updates replaced before a client got them
+
+    size_t format(const TelemetryState& state, TelemetryFormat format, unsigned long now, char* out) const;
+
+public:
+    LiveTelemetry();
+
+    /** @brief Create the mutex; call once from setup() */
+    bool begin();
+
+    /**
+     * @brief Store the latest state of a device
+     *
+     * A new device takes a free slot, or the slot of the device heard
+     * from the longest time ago when the table is full.
+     */
+    void publish(const TelemetryState& state);
+
+    /**
+     * @brief Forget a device; its slot is free again
+     *
+     * Clients simply stop receiving it (e.g. simulated boats at the end of
+     * a benchmark).
+     */
+    void remove(TelemetryKind kind, uint32_t deviceId);
+
+    /** @brief New cursor: every known device is sent on the first collect() */
+    void resetCursor(Cursor& cursor) const;
+
+    /**
+     * @brief Write the devices a client has not seen in their latest state
+     * @param cursor Cursor of the client, updated
+     * @param format SSE events or binary records
+     * @param buffer Output (whole events or records only)
+     * @param capacity Buffer size
+     * @param records Receives the number of devices written
+     * @return Bytes written; 0 when nothing changed. cursor.more tells
+     *         whether devices were left out because the buffer was full
+     */
+    size_t collect(Cursor& cursor, TelemetryFormat format, char* buffer, size_t capacity, uint32_t& records);
+
+    /** @brief Keep-alive for an idle stream (SSE comment or empty record) */
+    static size_t keepAlive(TelemetryFormat format, char* buffer);
+
+    uint32_t published() const { return published_; }
+    uint32_t coalesced() const { return coalesced_; }
+};
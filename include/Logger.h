@@ -1,15 +1,106 @@
 #pragma once
 #include <Arduino.h>
 #include <M5Unified.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/**
+ * @brief Severity of a log message
+ */
+enum LogLevel : uint8_t {
+    LOG_DEBUG = 0,
+    LOG_INFO,
+    LOG_WARN,
+    LOG_ERROR,
+    LOG_OFF,          ///< Threshold only: nothing is logged
+};
+
+/*
+ * Compile-time filtering
+ *
+ * LOG_LEVEL (build flag, LOG_INFO by default) is the threshold of every file.
+ * A file may use its own by defining LOG_MODULE_LEVEL before its includes,
+ * e.g. from a per-module build flag (see LOG_LEVEL_MAIN in main.cpp).
+ *
+ * A statement below the threshold is a discarded `if constexpr` branch: no
+ * call, no format string in flash, no argument evaluated. An enabled statement
+ * goes through logf(), which checks the runtime level before formatting into
+ * a stack buffer.
+ *
+ *     LOGD(logger, "Touch x=%d, y=%d", t.x, t.y);
+ */
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_INFO
+#endif
+#ifndef LOG_MODULE_LEVEL
+#define LOG_MODULE_LEVEL LOG_LEVEL
+#endif
+
+#define LOG_ENABLED(level) ((level) >= (LOG_MODULE_LEVEL))
+#define LOG_AT(logger, level, ...)                  \
+    do {                                            \
+        if constexpr (LOG_ENABLED(level)) {         \
+            (logger).logf((level), __VA_ARGS__);    \
+        }                                           \
+    } while (0)
+#define LOGD(logger, ...) LOG_AT(logger, LOG_DEBUG, __VA_ARGS__)
+#define LOGI(logger, ...) LOG_AT(logger, LOG_INFO, __VA_ARGS__)
+#define LOGW(logger, ...) LOG_AT(logger, LOG_WARN, __VA_ARGS__)
+#define LOGE(logger, ...) LOG_AT(logger, LOG_ERROR, __VA_ARGS__)
 
 /**
  * @brief Logger class for serial, screen, and SD card logging.
  *
  * This class provides logging functionalities for serial output, screen display (AtomS3),
  * and SD card file logging. Logging channels can be enabled or disabled independently.
+ *
+ * Once begin() has started the drain task, log() never writes to the serial port
+ * itself: the message is copied into a lock-free ring and a low-priority task prints
+ * it. Any number of tasks, callbacks (ESP-NOW, WiFi) and interrupts may log at the
+ * same time; a producer only claims slots with a compare-and-swap and never waits.
+ * When the ring is full the message is dropped and counted, and the drain task
+ * reports the drops with the next line it prints.
+ *
+ * A message takes one slot per SLOT_TEXT_BYTES characters, MAX_PARTS slots at most
+ * (longer messages are truncated and counted). Screen logging stays synchronous:
+ * it is only used during setup(), before the render task owns the display.
  */
 class Logger {
+public:
+    static constexpr size_t SLOTS = 64;             ///< Power of two: positions wrap with uint32_t
+    static constexpr size_t SLOT_TEXT_BYTES = 120;
+    static constexpr size_t MAX_PARTS = 8;          ///< Longest message: 960 characters
+    static constexpr size_t FORMAT_BYTES = 256;     ///< Stack buffer of logf()
+    static constexpr uint32_t DRAIN_POLL_MS = 100;  ///< Drain task wake-up without notification
+
+    /**
+     * @struct Stats
+     * @brief Counters of the ring since boot
+     */
+    struct Stats {
+        uint32_t written;      ///< Messages printed by the drain task
+        uint32_t dropped;      ///< Ring full: message lost
+        uint32_t truncated;    ///< Longer than MAX_PARTS slots, or than FORMAT_BYTES in logf()
+        uint32_t highWater;    ///< Most slots in use at once
+    };
+
 private:
+    /**
+     * @struct Slot
+     * @brief One ring cell; sequence tells whose turn it is (bounded MPMC queue)
+     *
+     * sequence == position: free for the producer of that position.
+     * sequence == position + 1: written, ready for the drain task.
+     */
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        uint8_t level;
+        uint8_t parts;         ///< Slots of the message (first slot only)
+        uint8_t length;        ///< Characters in this slot
+        char text[SLOT_TEXT_BYTES];
+    };
+
     bool sdLogging;        // Enable/disable SD card logging
     bool serialLogging;    // Enable/disable serial logging
     bool screenLogging;    // Enable/disable screen logging
@@ -17,10 +108,56 @@ private:
     static const int MAX_LINES = 8;    // Maximum lines for AtomS3 screen
     static const int LINE_HEIGHT = 16; // Height of each line on screen
 
+    LogLevel minimumLevel;             // Messages below are discarded at once
+    TaskHandle_t drainTask;
+    uint32_t reportedDrops;            // Drops already reported by the drain task
+    Slot ring[SLOTS];
+    std::atomic<uint32_t> head;        // Next position claimed by a producer
+    std::atomic<uint32_t> tail;        // Next position printed (drain task only writes it)
+    std::atomic<uint32_t> written;
+    std::atomic<uint32_t> dropped;
+    std::atomic<uint32_t> truncated;
+    std::atomic<uint32_t> highWater;
+
+    bool enqueue(LogLevel level, const char* message, size_t length);
+    bool drainOne();
+    void writeSerial(LogLevel level, const char* text, size_t length);
+    void writeScreen(const char* message);
+    static void drainEntry(void* parameter);
+
 public:
     Logger(bool enableSDLogging = false, bool enableSerialLogging = true, bool enableScreenLogging = true);
+
+    /**
+     * @brief Start the drain task; until then log() prints synchronously
+     * @return false if the task cannot be created (logging stays synchronous)
+     */
+    bool begin();
+
+    /** @brief Log an information message */
     void log(const String& message);
+    void log(LogLevel level, const String& message);
+
+    /**
+     * @brief Log a C string without any allocation
+     *
+     * Safe from interrupts and radio callbacks once begin() has run (screen
+     * logging off): the text is copied into the ring and the call returns,
+     * whether the message fits or not.
+     */
+    void log(LogLevel level, const char* message);
+
+    /** @brief printf-style message, formatted into a stack buffer (no String) */
+    void logf(LogLevel level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+    void setLevel(LogLevel level) { minimumLevel = level; }
+    LogLevel level() const { return minimumLevel; }
     void enableSerialLogging(bool enable);
     void enableScreenLogging(bool enable);
     void enableSDLogging(bool enable);
+
+    Stats stats() const;
+
+    /** @brief One line summary of the ring counters */
+    String describe() const;
 };
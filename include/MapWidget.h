@@ -0,0 +1,153 @@
+/**
+ * @file MapWidget.h
+ * @brief Minimap of the boats and buoys with short track tails
+ *
+ * Positions (1e-7 degree integers) are projected onto a local tangent plane
+ * centered on the fleet, in fixed point: one 64-bit multiply and shift per
+ * axis. The view fits the current positions automatically; the projection
+ * parameters, and therefore every stored pixel position, only change when
+ * the view zooms or moves.
+ *
+ * Track tails live in a per-device ring. They are drawn into a cached
+ * layer: a new position appends one segment to the layer and dirties that
+ * segment only. The layer is rebuilt when the view changes or when old
+ * points age out (every TRIM_INTERVAL_MS).
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <M5Unified.h>
+#include "Widgets.h"
+#include "FleetWidget.h"
+
+/**
+ * @struct MapMark
+ * @brief Buoy position, as published in the display snapshot
+ */
+struct MapMark {
+    uint8_t id;
+    int32_t latitude;    ///< 1e-7 degree
+    int32_t longitude;   ///< 1e-7 degree
+};
+
+/**
+ * @struct MapStats
+ * @brief Cost of the minimap updates
+ */
+struct MapStats {
+    uint32_t updates;          ///< Calls to set()
+    uint32_t lastUpdateMicros; ///< Projection + tail update time of the last call
+    uint32_t maxUpdateMicros;
+    uint32_t segments;         ///< Segments appended to the layer
+    uint32_t refits;           ///< View changes (full re-projection)
+    uint32_t rebuilds;         ///< Full layer redraws
+    uint32_t lastRebuildMicros;
+};
+
+/**
+ * @class MapWidget
+ * @brief Auto-fitted minimap with incremental track plotting
+ */
+class MapWidget : public Widget {
+public:
+    static const int MAX_TRACKS = FleetWidget::MAX_ROWS;
+    static const int MAX_BUOYS = 8;
+    static const int TAIL_POINTS = 64;                  ///< Points per track ring
+    static const uint32_t TAIL_MS = 60000;              ///< Length of the tails
+    static const uint32_t MIN_APPEND_MS = 1000;         ///< Minimum interval between two points
+    static const uint32_t TRIM_INTERVAL_MS = 10000;     ///< Old points removed (layer rebuilt) at this period
+    static const uint32_t ZOOM_IN_DELAY_MS = 5000;      ///< Fleet small in the view for this long: zoom in
+    static const int16_t MARGIN = 10;                   ///< Pixels kept free around the positions
+    static const int MIN_SPAN_M = 50;                   ///< Smallest distance shown across the view
+
+private:
+    struct TrackPoint {
+        int32_t latitude;
+        int32_t longitude;
+        uint32_t time;
+        int16_t x;          ///< Projected position (widget pixels)
+        int16_t y;
+    };
+
+    struct Track {
+        uint32_t deviceId;
+        bool used;
+        bool seen;
+        bool markerShown;
+        bool selected;
+        int16_t markerX;
+        int16_t markerY;
+        uint16_t head;      ///< Next write index in the ring
+        uint16_t count;
+        TrackPoint* points; ///< TAIL_POINTS entries in pool_
+    };
+
+    Track tracks_[MAX_TRACKS];
+    TrackPoint* pool_;
+    MapMark buoys_[MAX_BUOYS];
+    int16_t buoyX_[MAX_BUOYS];
+    int16_t buoyY_[MAX_BUOYS];
+    int buoyCount_;
+
+    // View: origin and Q24 pixels per 1e-7 degree on each axis
+    bool viewValid_;
+    int32_t originLat_;
+    int32_t originLon_;
+    int64_t scaleX_;
+    int64_t scaleY_;
+    float metersPerPixel_;
+    unsigned long zoomInSince_;
+
+    LGFX_Sprite layer_;
+    bool layerReady_;
+    bool rebuildPending_;
+    unsigned long lastTrim_;
+
+    WidgetRect dirtyRects_[MAX_DIRTY_RECTS];   ///< Screen coordinates
+    int dirtyRectCount_;
+
+    MapStats stats_;
+
+    void project(int32_t lat, int32_t lon, int16_t& x, int16_t& y) const;
+    void fit(int32_t minLat, int32_t maxLat, int32_t minLon, int32_t maxLon);
+    void reprojectAll();
+    void rebuildLayer();
+    void drawTrack(LovyanGFX& gfx, const Track& track, int16_t x, int16_t y);
+    void drawSegment(LovyanGFX& gfx, const TrackPoint& a, const TrackPoint& b, uint16_t color, int16_t x, int16_t y);
+    void append(Track& track, int32_t lat, int32_t lon, unsigned long now);
+    void trim(unsigned long now);
+    Track* findTrack(uint32_t deviceId, bool create);
+    void addDirty(int16_t x, int16_t y, int16_t w, int16_t h);
+    void drawScale(LovyanGFX& gfx, int16_t x, int16_t y);
+
+public:
+    MapWidget(int16_t x, int16_t y, int16_t w, int16_t h);
+
+    /**
+     * @brief Allocate the track rings and the tail layer (PSRAM when available)
+     * @return false without memory for the rings (nothing is shown)
+     */
+    bool begin();
+
+    /**
+     * @param boats Fleet entries (entries without a fix are ignored)
+     * @param boatCount Number of entries
+     * @param selected Index in boats of the selected boat (-1: none)
+     * @param buoys Buoy positions
+     * @param buoyCount Number of buoys
+     * @param now millis() of the frame
+     */
+    void set(const FleetEntry* boats, int boatCount, int selected, const MapMark* buoys, int buoyCount,
+             unsigned long now);
+
+    int dirtyRegion(WidgetRect* rects) const override;
+    void clearDirty() override;
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+
+    const MapStats& stats() const { return stats_; }
+
+    /** @brief One-line summary of the update costs */
+    String describe() const;
+};
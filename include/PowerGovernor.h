@@ -0,0 +1,136 @@
+/**
+ * @file PowerGovernor.h
+ * @brief Change-driven power states: render rate, CPU clock and loop period
+ *
+ * The governor watches what the device is actually doing: user
+ * interaction (touch, serial commands), incoming ESP-NOW packets and the
+ * frames the render task pushes (a frame is only pushed when something on
+ * screen changed). From these it picks one of three power states:
+ *
+ * - ACTIVE: full clock, full frame rate. Kept while the user interacts,
+ *   while the file server runs and while the screen changes quickly.
+ * - IDLE: packets or screen changes in the last minute, but slowly.
+ * - DEEP_IDLE: nothing received and nothing changed for a minute.
+ *
+ * Stepping up is immediate (the render task is woken at once); stepping
+ * down waits for the hold times. ESP-NOW reception runs in the WiFi task
+ * and does not depend on the loop period; the CPU clock only drops to
+ * 80 MHz when no packet arrives at all, and a loss guard keeps the full
+ * clock for good if a reduced state ever loses more packets than ACTIVE.
+ *
+ * Battery current (M5.Power) is sampled every second while discharging,
+ * per state, to report the time spent in each state and the estimated
+ * saving against the ACTIVE draw.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <Arduino.h>
+#include "RenderTask.h"
+
+// Forward declaration
+class Logger;
+
+enum PowerState : uint8_t {
+    POWER_ACTIVE = 0,
+    POWER_IDLE,
+    POWER_DEEP_IDLE,
+    POWER_STATE_COUNT
+};
+
+/**
+ * @struct PowerProfile
+ * @brief Settings applied in one power state
+ */
+struct PowerProfile {
+    uint32_t cpuMhz;
+    uint32_t frameRate;     ///< Render task frames per second
+    uint32_t loopDelayMs;   ///< Pause at the end of loop()
+};
+
+/**
+ * @struct PowerStateStats
+ * @brief Time and measured battery draw in one power state
+ */
+struct PowerStateStats {
+    uint64_t timeMs;
+    uint32_t entries;
+    int64_t currentSum;      ///< Sum of the discharge current samples (mA)
+    uint32_t currentSamples;
+    uint32_t packets;        ///< ESP-NOW packets received in this state
+    uint32_t lostPackets;    ///< Sequence gaps detected in this state
+};
+
+/**
+ * @class PowerGovernor
+ * @brief Picks the power state from activity, data rate and screen changes
+ */
+class PowerGovernor {
+public:
+    static const uint32_t INTERACTION_HOLD_MS = 30000;  ///< ACTIVE after a touch or a command
+    static const uint32_t IDLE_AFTER_MS = 10000;        ///< Screen calm this long: IDLE
+    static const uint32_t DEEP_AFTER_MS = 60000;        ///< No packet, no change this long: DEEP_IDLE
+    static const uint32_t BUSY_FRAMES_PER_SECOND = 3;   ///< Faster screen changes keep ACTIVE
+    static const uint32_t LOSS_GUARD_MIN_PACKETS = 500; ///< Packets needed before comparing loss rates
+
+private:
+    static const PowerProfile kProfiles[POWER_STATE_COUNT];
+
+    Logger* logger_;            ///< State changes and loss guard (nullptr: silent)
+    RenderTask* render_;
+    PowerState state_;
+    bool started_;
+    bool clockLocked_;          ///< Loss guard tripped: full clock in every state
+    volatile uint32_t packets_; ///< Incremented by the ESP-NOW callback
+
+    unsigned long lastInteraction_;
+    unsigned long lastBusy_;        ///< Last second with fast screen changes
+    unsigned long lastChange_;      ///< Last pushed frame or received packet
+    unsigned long lastUpdate_;
+    unsigned long windowStart_;
+    unsigned long lastCurrentSample_;
+    uint32_t windowFrames_;
+    uint32_t lastFrames_;
+    uint32_t lastPackets_;
+    uint32_t lastLost_;
+
+    PowerStateStats stats_[POWER_STATE_COUNT];
+
+    void apply(PowerState state, const char* reason);
+    void checkLossGuard();
+
+public:
+    PowerGovernor();
+
+    /** @brief Configure the logging system */
+    void setLogger(Logger& logger) { logger_ = &logger; }
+
+    /**
+     * @brief Start in ACTIVE and take control of the render rate
+     * @param render Render task whose frame rate is governed (already started)
+     */
+    void begin(RenderTask& render);
+
+    /** @brief Count one received packet (ESP-NOW callback: no lock, no log) */
+    void notePacket() { packets_++; }
+
+    /** @brief Touch, button or command: back to ACTIVE at once */
+    void noteInteraction();
+
+    /**
+     * @brief Evaluate the state; called at each loop() iteration
+     * @param lostPackets Total sequence gaps over the known boats
+     * @param keepActive True while a function needs the full clock (file server)
+     */
+    void update(uint32_t lostPackets, bool keepActive);
+
+    PowerState state() const { return state_; }
+
+    /** @brief Pause to apply at the end of loop() in the current state */
+    uint32_t loopDelayMs() const { return kProfiles[state_].loopDelayMs; }
+
+    /** @brief One-line summary: time and draw per state, estimated saving */
+    String describe() const;
+};
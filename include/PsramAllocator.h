@@ -0,0 +1,149 @@
+/**
+ * @file PsramAllocator.h
+ * @brief Allocation layer placing large buffers in PSRAM
+ *
+ * The M5Stack Core2 has 8 MB of PSRAM next to a small internal heap that
+ * is shared with WiFi, ESP-NOW and FreeRTOS. Large, latency-tolerant
+ * buffers (storage queues, history rings, HTTP responses, export working
+ * sets) are allocated from PSRAM through this layer, while small hot
+ * objects keep using the default internal heap.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <new>
+
+/**
+ * @struct MemoryRegionStats
+ * @brief Usage snapshot of one heap region
+ */
+struct MemoryRegionStats {
+    size_t totalBytes;        ///< Size of the region
+    size_t freeBytes;         ///< Currently free bytes
+    size_t largestFreeBlock;  ///< Largest block that can be allocated
+    size_t minimumFreeBytes;  ///< Low-water mark since boot
+    uint8_t fragmentation;    ///< 0-100 %, 100 - largest block / free bytes
+};
+
+/**
+ * @brief Allocate a large buffer, in PSRAM when available
+ * @param size Number of bytes
+ * @return Pointer to the buffer (PSRAM first, internal heap as fallback), or nullptr
+ */
+void* largeMalloc(size_t size);
+
+/**
+ * @brief Allocate a buffer in PSRAM only
+ * @param size Number of bytes
+ * @return Pointer to the buffer, or nullptr if PSRAM is missing or full
+ */
+void* psramMalloc(size_t size);
+
+/**
+ * @brief Resize a buffer obtained from largeMalloc()
+ */
+void* largeRealloc(void* ptr, size_t size);
+
+/**
+ * @brief Release a buffer obtained from largeMalloc(), psramMalloc() or largeRealloc()
+ */
+void largeFree(void* ptr);
+
+/**
+ * @brief Check if a pointer lives in PSRAM
+ */
+bool isPsramPointer(const void* ptr);
+
+/**
+ * @brief Usage snapshot of the internal heap
+ */
+MemoryRegionStats getInternalMemoryStats();
+
+/**
+ * @brief Usage snapshot of PSRAM (all zero if no PSRAM)
+ */
+MemoryRegionStats getPsramMemoryStats();
+
+/**
+ * @brief One-line usage and fragmentation report for both regions
+ */
+String describeMemoryUsage();
+
+/**
+ * @class PsramAllocator
+ * @brief STL allocator backed by largeMalloc()
+ *
+ * Usage: std::vector<StorageData, PsramAllocator<StorageData>>
+ */
+template <typename T>
+class PsramAllocator {
+public:
+    typedef T value_type;
+
+    PsramAllocator() {}
+    template <typename U> PsramAllocator(const PsramAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        void* ptr = largeMalloc(n * sizeof(T));
+        if (!ptr) {
+            // Same behaviour as std::allocator when memory is exhausted
+#if defined(__cpp_exceptions)
+            throw std::bad_alloc();
+#else
+            abort();
+#endif
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t) {
+        largeFree(ptr);
+    }
+
+    template <typename U> struct rebind { typedef PsramAllocator<U> other; };
+};
+
+template <typename T, typename U>
+bool operator==(const PsramAllocator<T>&, const PsramAllocator<U>&) { return true; }
+
+template <typename T, typename U>
+bool operator!=(const PsramAllocator<T>&, const PsramAllocator<U>&) { return false; }
+
+/**
+ * @class LargeBuffer
+ * @brief Growable character buffer allocated through largeMalloc()
+ *
+ * Replacement for String when building large HTTP responses: the content
+ * lives in PSRAM and grows geometrically, so building a page does not
+ * fragment the internal heap.
+ */
+class LargeBuffer {
+private:
+    char* data_;        ///< Null-terminated content
+    size_t length_;     ///< Content length (without terminator)
+    size_t capacity_;   ///< Allocated size
+
+    bool grow(size_t needed);
+
+public:
+    explicit LargeBuffer(size_t initialCapacity = 1024);
+    ~LargeBuffer();
+
+    LargeBuffer(const LargeBuffer&) = delete;
+    LargeBuffer& operator=(const LargeBuffer&) = delete;
+
+    bool append(const char* text, size_t len);
+    bool append(const char* text) { return append(text, strlen(text)); }
+    bool append(const String& text) { return append(text.c_str(), text.length()); }
+
+    LargeBuffer& operator+=(const char* text) { append(text); return *this; }
+    LargeBuffer& operator+=(const String& text) { append(text); return *this; }
+
+    void clear();
+    const char* c_str() const { return data_ ? data_ : ""; }
+    size_t length() const { return length_; }
+};
@@ -0,0 +1,95 @@
+/**
+ * @file RenderTask.h
+ * @brief Fixed-rate display task with frame pacing and frame time statistics
+ *
+ * The main loop publishes a DisplaySnapshot whenever the state changes; the
+ * render task wakes at a fixed rate, copies the latest snapshot and draws
+ * it through Display::drawDisplay, the only draw entry point. Touch
+ * handling and the file server never wait behind a frame.
+ *
+ * Frame pacing: when a frame overruns its budget, the ticks that elapsed
+ * meanwhile are dropped and counted instead of being drawn back to back.
+ * The rate can be changed at run time (PowerGovernor); a change wakes the
+ * task, so a return to the full rate is not delayed by a long idle period.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "Display.h"
+
+/**
+ * @struct RenderStats
+ * @brief Frame counters of the render task
+ */
+struct RenderStats {
+    uint32_t ticks;        ///< Render task wake-ups
+    uint32_t frames;       ///< Ticks that pushed pixels
+    uint32_t skipped;      ///< Ticks dropped after an over-budget frame
+    uint32_t overBudget;   ///< Frames longer than the budget
+    uint32_t postponed;    ///< Frames postponed because the SPI bus stayed busy
+    uint32_t snapshots;    ///< Snapshots published by the main loop
+};
+
+/**
+ * @class RenderTask
+ * @brief Owns the render loop and the shared snapshot
+ */
+class RenderTask {
+public:
+    static const uint32_t DEFAULT_FRAME_RATE = 10;  ///< Frames per second
+    static const int FRAME_SAMPLES = 128;           ///< Frame times kept for the percentiles
+
+private:
+    Display* display_;
+    TaskHandle_t task_;
+    SemaphoreHandle_t mutex_;
+    DisplaySnapshot shared_;     ///< Latest published snapshot (under mutex_)
+    volatile uint32_t periodMs_;
+    uint32_t budgetUs_;
+
+    RenderStats stats_;
+    uint32_t samples_[FRAME_SAMPLES];  ///< Durations of the last pushed frames (us)
+    int sampleCount_;
+    int sampleIndex_;
+
+    static void taskEntry(void* parameter);
+    void run();
+    void recordFrame(uint32_t elapsedUs, bool pushed, bool postponed);
+
+public:
+    RenderTask();
+
+    /**
+     * @brief Start the render task
+     * @param display Display to draw (begin() already called)
+     * @param frameRate Target frames per second
+     * @param budgetMs Per-frame time budget (0: one frame period)
+     * @return false if the task or the mutex could not be created
+     */
+    bool begin(Display& display, uint32_t frameRate = DEFAULT_FRAME_RATE, uint32_t budgetMs = 0);
+
+    /**
+     * @brief Publish the state to show from the next frame
+     *
+     * The snapshot must be fully initialized (memset before filling):
+     * unchanged snapshots are detected with memcmp and not counted.
+     */
+    void publish(const DisplaySnapshot& snapshot);
+
+    /**
+     * @brief Change the frame rate; the task is woken and draws at once
+     * @param frameRate Frames per second (0 is ignored)
+     */
+    void setFrameRate(uint32_t frameRate);
+
+    /** @brief Copy of the frame counters */
+    RenderStats stats() const;
+
+    /** @brief One-line summary: rate, skipped frames, frame time percentiles */
+    String describe() const;
+};
@@ -0,0 +1,47 @@
+/**
+ * @file SdStorageBackend.h
+ * @brief StorageBackend implementation for the SD card
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <SD.h>
+#include "StorageBackend.h"
+#include "BusScheduler.h"
+
+/**
+ * @class SdStorageBackend
+ * @brief StorageBackend writing to the SD card through the SD library
+ *
+ * Physical bytes are estimated from the sectors touched by each write,
+ * I/O time is measured (excluding the wait for the bus).
+ *
+ * With a BusScheduler, every card access runs in a storage slot and large
+ * writes are split into slots of BusScheduler::STORAGE_SLOT_BYTES, so a
+ * frame push never waits for a whole batch.
+ */
+class SdStorageBackend : public StorageBackend {
+private:
+    File file_;              ///< Currently open file
+    uint32_t position_;      ///< Current write position (for sector accounting)
+    BusScheduler* bus_;      ///< SPI bus scheduler (nullptr: direct access)
+
+public:
+    static const uint32_t SECTOR_SIZE = 512;
+
+    SdStorageBackend() : position_(0), bus_(nullptr) {}
+
+    /** @brief Run card accesses in storage slots of the shared SPI bus */
+    void setBus(BusScheduler* bus) { bus_ = bus; }
+
+    FileLookup lookup(const char* path) override;
+    bool open(const char* path, bool truncate) override;
+    size_t size() override;
+    bool seek(uint32_t position) override;
+    size_t write(const uint8_t* data, size_t len) override;
+    void close() override;
+    bool remove(const char* path) override;
+};
@@ -0,0 +1,80 @@
+/**
+ * @file SimulatedSdBackend.h
+ * @brief Simulated SD card for Storage benchmarks
+ *
+ * Models a FAT32 card behind the FatFs single-sector cache: sector-sized
+ * writes, read-modify-write of partial sectors, cluster allocation and
+ * FAT/directory updates on close. Each operation adds a configurable
+ * latency to a simulated clock instead of waiting, so a benchmark run
+ * costs only the CPU time of the writer itself.
+ *
+ * This class has no Arduino dependency and can be built on a host.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <map>
+#include <string>
+#include "StorageBackend.h"
+
+/**
+ * @struct SimulatedSdConfig
+ * @brief Geometry and latencies of the simulated card
+ *
+ * Defaults approximate a class 10 card driven over SPI at 4 MHz
+ * (about 1 ms per 512-byte sector).
+ */
+struct SimulatedSdConfig {
+    uint32_t sectorSize;       ///< Bytes per sector
+    uint32_t clusterSize;      ///< Bytes per cluster (32 KB on 16-32 GB FAT32 cards)
+    uint32_t openUs;           ///< Directory lookup on open
+    uint32_t sectorWriteUs;    ///< Write of one sector
+    uint32_t sectorReadUs;     ///< Read of one sector
+    uint32_t clusterAllocUs;   ///< Free cluster search in the FAT
+    uint32_t closeUs;          ///< Fixed cost of close/sync (excluding sector writes)
+
+    SimulatedSdConfig()
+        : sectorSize(512), clusterSize(32768), openUs(1500), sectorWriteUs(1100),
+          sectorReadUs(1000), clusterAllocUs(2500), closeUs(300) {}
+};
+
+/**
+ * @class SimulatedSdBackend
+ * @brief StorageBackend counting sectors, clusters and simulated latency
+ */
+class SimulatedSdBackend : public StorageBackend {
+private:
+    struct SimFile {
+        uint32_t size;       ///< File size in bytes
+        uint32_t clusters;   ///< Clusters allocated to the file
+    };
+
+    SimulatedSdConfig config_;
+    std::map<std::string, SimFile> files_;  ///< Simulated directory
+    SimFile* openFile_;                     ///< Currently open file, or nullptr
+    uint32_t position_;                     ///< Write position in the open file
+    int64_t cachedSector_;                  ///< Sector held in the FatFs buffer (-1 if none)
+    bool cacheDirty_;                       ///< Cached sector must be written back
+    bool fatDirty_;                         ///< FAT must be written on close
+    bool dirDirty_;                         ///< Directory entry must be written on close
+
+    void addTime(uint32_t us) { stats_.ioMicros += us; }
+    void writeSector();
+    void flushCache();
+
+public:
+    explicit SimulatedSdBackend(const SimulatedSdConfig& config = SimulatedSdConfig());
+
+    FileLookup lookup(const char* path) override;
+    bool open(const char* path, bool truncate) override;
+    size_t size() override;
+    bool seek(uint32_t position) override;
+    size_t write(const uint8_t* data, size_t len) override;
+    void close() override;
+    bool remove(const char* path) override;
+
+    /** @brief Simulated card configuration */
+    const SimulatedSdConfig& config() const { return config_; }
+};
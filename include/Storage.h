@@ -15,9 +15,12 @@
 #include <SD.h>
 #include <ArduinoJson.h>
 #include "DisplayTypes.h"
+#include "PsramAllocator.h"
+#include "SdStorageBackend.h"
 
-// Forward declaration
+// Forward declarations
 class Logger;
+class HistoryBuffer;
 
 /**
  * @enum DataType
@@ -48,6 +51,37 @@ struct StorageData {
     };
 };
 
+/**
+ * @brief Queue of entries waiting to be written, allocated in PSRAM
+ * 
+ * Batches can hold several seconds of fleet data; keeping them out of the
+ * internal heap allows longer flush intervals.
+ */
+typedef std::vector<StorageData, PsramAllocator<StorageData>> StorageBatch;
+
+/**
+ * @struct HistoryTrigger
+ * @brief Point of the history where a recording starts
+ * 
+ * Taken by HistoryBuffer::captureTrigger() when RECORD is pressed, applied
+ * later by the storage task (HistoryBuffer::markTrigger()).
+ */
+struct HistoryTrigger {
+    uint32_t end;      ///< Records pushed before the trigger (absolute index)
+    uint32_t cutoff;   ///< Oldest timestamp kept in the window (millis)
+};
+
+/**
+ * @enum NtpSyncState
+ * @brief Progress of an NTP synchronization started by Storage::beginNTPSync()
+ */
+enum NtpSyncState : uint8_t {
+    NTP_SYNC_IDLE = 0,   ///< No synchronization in progress
+    NTP_SYNC_PENDING,    ///< Waiting for the SNTP answer
+    NTP_SYNC_DONE,       ///< RTC set from NTP
+    NTP_SYNC_FAILED      ///< No answer within NTP_TIMEOUT_MS, or no local time
+};
+
 /**
  * @class Storage
  * @brief SD card data storage manager
@@ -72,8 +106,36 @@ struct StorageData {
 class Storage {
 private:
     Logger* logger_;           ///< Pointer to the logging system
+    HistoryBuffer* history_;   ///< Pre-trigger history flushed at the start of a recording
+    SdStorageBackend sdBackend_; ///< Default backend (SD card)
+    StorageBackend* backend_;  ///< Backend used by writeDataBatch() (SD card or simulation)
+    BusScheduler* bus_;        ///< SPI bus shared with the LCD (nullptr: direct access)
     String currentFileName_;   ///< Current storage file name
     bool sdInitialized_;      ///< SD card initialization status
+    bool lastWriteBusy_;       ///< Last writeDataBatch() failed because the SD was busy
+    StorageBatch preTriggerBatch_; ///< Pre-trigger entries drained but not written yet
+    uint32_t preTriggerWritten_;   ///< Pre-trigger entries written since the last trigger
+    bool ntpPending_;              ///< beginNTPSync() called, answer not received yet
+    unsigned long ntpStartMs_;     ///< millis() when the synchronization started
+    
+    static constexpr unsigned long NTP_TIMEOUT_MS = 10000; ///< Give up on NTP after this delay
+    
+    // New recording requested by loop(), applied by the storage task
+    portMUX_TYPE requestLock_;     ///< Protects the request below
+    bool recordingRequested_;
+    char requestedFileName_[64];
+    HistoryTrigger requestedTrigger_;
+    
+    /** @brief Switch to the requested recording, if any (storage task only) */
+    void applyNewRecording();
+
+    /**
+     * @brief Close the array again after a short write
+     * @param base File position where the failed batch started
+     * @param written Bytes of the batch that reached the file
+     * @return true if the file ends with "\n]" again
+     */
+    bool restoreTail(uint32_t base, size_t written);
     
 public:
     /**
@@ -93,6 +155,38 @@ public:
      */
     void setLogger(Logger& logger);
     
+    /**
+     * @brief Attach the pre-trigger history
+     * @param history Reference to the HistoryBuffer fed by the receive callback
+     * 
+     * When set, startNewRecording() freezes the history window and
+     * flushPreTrigger() writes it at the beginning of the new file.
+     */
+    void setHistory(HistoryBuffer& history);
+    
+    /**
+     * @brief Schedule SD card accesses on the SPI bus shared with the LCD
+     * @param bus Bus scheduler
+     * 
+     * Card accesses then run in storage slots, and batch writes are split
+     * into bounded blocks so that frame pushes are not delayed by a flush.
+     */
+    void setBus(BusScheduler& bus);
+    
+    /**
+     * @brief Replace the SD card by another backend
+     * @param backend Ready-to-use backend (e.g. SimulatedSdBackend for benchmarks)
+     * 
+     * The backend is considered initialized: initSD() is not needed.
+     */
+    void setBackend(StorageBackend& backend);
+    
+    /**
+     * @brief Write subsequent batches to the given file
+     * @param fileName Full path of the file
+     */
+    void setFileName(const String& fileName);
+    
     /**
      * @brief Initialize SD card with M5Stack Core2 SPI configuration
      * @return true if initialization succeeds, false otherwise
@@ -102,6 +196,8 @@ public:
      * - Attempts initialization at different frequencies (4MHz then 1MHz)
      * - Creates /replay/ directory if it doesn't exist
      * - Displays detailed diagnostic messages
+     * - Holds a storage slot of the shared bus throughout, so it can be
+     *   retried while the render task pushes frames
      * 
      * @note Requires SD card formatted as FAT32
      * @warning Card must be inserted before calling this function
@@ -125,10 +221,35 @@ public:
      * @brief Start a new recording session with a fresh file
      * 
      * Generates a new filename based on current RTC timestamp.
-     * Called each time the user presses RECORD.
+     * Called each time the user presses RECORD. If a history is attached,
+     * the end of its pre-trigger window is taken at once.
+     * 
+     * The file and the window are only switched by the next
+     * flushPreTrigger(), in the storage task: the file name and the
+     * pre-trigger state are never changed under a write in progress. A
+     * second request before then replaces the first.
      */
     void startNewRecording();
     
+    /**
+     * @brief Apply a requested recording, then write part of its pre-trigger history
+     * @param maxBatch Maximum number of entries per SD write
+     * @param maxBatches Maximum number of SD writes in this call
+     * @return true if nothing was pending or all writes succeeded
+     * 
+     * Must be called from the storage task before writing live data, so
+     * that the history appears first in the session file. A window of
+     * several minutes takes many writes: each call writes at most
+     * maxBatches of them, so the bus is released to the display between
+     * calls, and the caller holds its live data back while
+     * hasPendingPreTrigger() is true. When the SD is busy (lastWriteBusy()),
+     * the drained entries are kept and written first by the next call.
+     */
+    bool flushPreTrigger(size_t maxBatch = 200, size_t maxBatches = 4);
+    
+    /** @brief True while flushPreTrigger() has entries left to write */
+    bool hasPendingPreTrigger() const;
+    
     /**
      * @brief Write a single data entry to SD card
      * @param data Structure containing data to save
@@ -172,7 +293,17 @@ public:
      * @note More efficient than multiple writeData() calls
      * @warning Vector must not be empty
      */
-    bool writeDataBatch(const std::vector<StorageData>& dataList);
+    bool writeDataBatch(const StorageBatch& dataList);
+    
+    /**
+     * @brief Tell whether the last writeDataBatch() failure is transient
+     * @return true if the SD card could not be reached (shared bus busy)
+     * 
+     * The file then holds none of the batch entries (a partial write is
+     * blanked): the caller should keep the batch and submit it again
+     * later. Any other failure is final.
+     */
+    bool lastWriteBusy() const { return lastWriteBusy_; }
     
     /**
      * @brief Send a message to the logging system
@@ -189,30 +320,40 @@ public:
      * 
      * Uses RTC to create a human-readable filename. If RTC is not set
      * (year < 2023), falls back to session-based naming using MAC address
-     * suffix and incremental session number for uniqueness.
+     * suffix and incremental session number for uniqueness. If the card
+     * cannot be reached to find that number, millis() is used instead.
      * 
      * @example "/replay/2025-09-21_14-30-45.json" (RTC configured)
      * @example "/replay/session_A1B2_1.json" (RTC not configured)
+     * @example "/replay/session_A1B2_t81234.json" (RTC not configured, SD busy)
      */
     String generateFileName();
     
     /**
-     * @brief Synchronize RTC with NTP time server
+     * @brief Start synchronizing the RTC with an NTP time server
      * @param ntpServer NTP server address (default: "pool.ntp.org")
      * @param gmtOffset GMT offset in seconds (default: 0)
      * @param daylightOffset Daylight saving offset in seconds (default: 0)
-     * @return true if synchronization succeeds, false otherwise
+     * @return true if the request was sent, false without WiFi
      * 
-     * Attempts to synchronize the M5Stack Core2 RTC with an NTP server
-     * when WiFi is available. This ensures accurate timestamps for
-     * file naming and data logging.
+     * Only configures SNTP and returns: call pollNTPSync() from later
+     * loop() iterations until it reports NTP_SYNC_DONE or NTP_SYNC_FAILED.
      * 
-     * @note Requires active WiFi connection
      * @warning Call only when WiFi is connected
      */
-    bool syncRTCFromNTP(const char* ntpServer = "pool.ntp.org", 
-                        long gmtOffset = 0, 
-                        int daylightOffset = 0);
+    bool beginNTPSync(const char* ntpServer = "pool.ntp.org", 
+                      long gmtOffset = 0, 
+                      int daylightOffset = 0);
+    
+    /**
+     * @brief Check on the synchronization started by beginNTPSync()
+     * @return NTP_SYNC_PENDING while waiting, then NTP_SYNC_DONE (RTC set)
+     *         or NTP_SYNC_FAILED once, then NTP_SYNC_IDLE
+     * 
+     * Never waits: the system clock is read without timeout and the attempt
+     * is abandoned NTP_TIMEOUT_MS after beginNTPSync().
+     */
+    NtpSyncState pollNTPSync();
     
     /**
      * @brief Get current timestamp from RTC
@@ -0,0 +1,87 @@
+/**
+ * @file StorageBackend.h
+ * @brief File operations used by Storage, abstracted from the SD card
+ *
+ * Storage only needs a handful of operations on a single open file.
+ * Routing them through this interface lets the same writer run against
+ * the real SD card or against a simulated card for benchmarks.
+ * This header has no Arduino dependency.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @struct StorageBackendStats
+ * @brief Counters accumulated by a backend
+ */
+struct StorageBackendStats {
+    uint64_t logicalBytes;     ///< Bytes handed to write()
+    uint64_t physicalBytes;    ///< Bytes written to the medium (sector granularity)
+    uint32_t writeCalls;       ///< Number of write() calls
+    uint32_t opens;            ///< Number of open() calls
+    uint32_t sectorWrites;     ///< Sectors written to the medium
+    uint32_t sectorReads;      ///< Sectors read back (read-modify-write)
+    uint32_t clusterAllocs;    ///< Clusters allocated to grow files
+    uint64_t ioMicros;         ///< Time spent in I/O (measured or simulated)
+};
+
+/**
+ * @brief Result of StorageBackend::lookup()
+ *
+ * FILE_UNAVAILABLE means the medium could not be queried (e.g. the shared
+ * bus was not granted in time): the file may exist and must not be recreated.
+ */
+enum FileLookup : uint8_t {
+    FILE_MISSING = 0,
+    FILE_FOUND,
+    FILE_UNAVAILABLE,
+};
+
+/**
+ * @class StorageBackend
+ * @brief Minimal single-file interface used by Storage::writeDataBatch()
+ */
+class StorageBackend {
+public:
+    virtual ~StorageBackend() {}
+
+    /** @brief Check if a file exists, telling "not found" from "cannot tell" */
+    virtual FileLookup lookup(const char* path) = 0;
+
+    /**
+     * @brief Open a file for writing
+     * @param path File path
+     * @param truncate true to create/empty the file, false to update it in place
+     */
+    virtual bool open(const char* path, bool truncate) = 0;
+
+    /** @brief Size of the open file */
+    virtual size_t size() = 0;
+
+    /** @brief Move the write position of the open file */
+    virtual bool seek(uint32_t position) = 0;
+
+    /** @brief Write at the current position of the open file */
+    virtual size_t write(const uint8_t* data, size_t len) = 0;
+
+    /** @brief Flush and close the open file */
+    virtual void close() = 0;
+
+    /** @brief Remove a file */
+    virtual bool remove(const char* path) = 0;
+
+    /** @brief Accumulated counters */
+    const StorageBackendStats& stats() const { return stats_; }
+
+    /** @brief Reset accumulated counters */
+    void resetStats() { memset(&stats_, 0, sizeof(stats_)); }
+
+protected:
+    StorageBackendStats stats_ = {};
+};
@@ -0,0 +1,102 @@
+/**
+ * @file StorageBenchmark.h
+ * @brief Throughput and latency benchmark of the Storage writer
+ *
+ * Runs the real Storage::writeDataBatch() code path on synthetic fleet
+ * traffic, either against SimulatedSdBackend or against the SD card, and
+ * reports records/s, bytes per record, write amplification and flush
+ * latency percentiles.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <Arduino.h>
+#include "StorageBackend.h"
+#include "BusScheduler.h"
+
+// Forward declaration
+class Logger;
+
+/**
+ * @struct BenchmarkScenario
+ * @brief Synthetic fleet traffic replayed by the benchmark
+ */
+struct BenchmarkScenario {
+    const char* name;          ///< Short description
+    uint8_t boats;             ///< Number of boats
+    uint8_t boatRateHz;        ///< GPS rate of each boat
+    uint8_t buoys;             ///< Number of buoys (1 Hz)
+    uint8_t anemometers;       ///< Number of anemometers (1 Hz)
+    uint16_t durationSec;      ///< Amount of data generated (virtual time)
+    uint16_t flushIntervalMs;  ///< Storage task flush interval
+};
+
+/**
+ * @struct BenchmarkResult
+ * @brief Figures measured for one scenario
+ */
+struct BenchmarkResult {
+    uint32_t records;           ///< Entries written
+    uint32_t flushes;           ///< writeDataBatch() calls
+    float recordsPerSec;        ///< Entries per second of writer + I/O time
+    float logicalBytesPerRecord;  ///< JSON bytes per entry
+    float physicalBytesPerRecord; ///< Bytes written to the card per entry
+    float writeAmplification;   ///< Physical / logical bytes
+    uint32_t p50Us;             ///< Flush latency percentiles
+    uint32_t p95Us;
+    uint32_t p99Us;
+    uint32_t maxUs;
+};
+
+/**
+ * @class StorageBenchmark
+ * @brief Replays BenchmarkScenario traffic through a dedicated Storage instance
+ *
+ * The benchmark never uses the recording Storage instance: it creates its
+ * own, so a simulated run does not touch the card at all.
+ */
+class StorageBenchmark {
+private:
+    Logger* logger_;   ///< Pointer to logging system
+    BusScheduler* bus_;  ///< SPI bus used by the SD card run
+
+    void log(const String& message);
+    void report(const char* target, const BenchmarkScenario& scenario, const BenchmarkResult& result);
+
+public:
+    StorageBenchmark();
+
+    /** @brief Configure the logging system */
+    void setLogger(Logger& logger);
+
+    /** @brief Run the SD card benchmark in storage slots of the shared SPI bus */
+    void setBus(BusScheduler& bus) { bus_ = &bus; }
+
+    /**
+     * @brief Built-in scenarios (1 to 20 boats at 10 Hz, buoys, anemometers)
+     * @param count Receives the number of scenarios
+     */
+    static const BenchmarkScenario* scenarios(size_t& count);
+
+    /**
+     * @brief Run one scenario
+     * @param scenario Traffic to replay
+     * @param backend Backend written to
+     * @param simulated true if backend I/O time is simulated (not part of wall time)
+     * @param fileName File used for the run (removed afterwards)
+     * @param result Receives the measured figures
+     * @return false if a write failed
+     */
+    bool runScenario(const BenchmarkScenario& scenario, StorageBackend& backend, bool simulated,
+                     const char* fileName, BenchmarkResult& result);
+
+    /**
+     * @brief Run every built-in scenario and log the results
+     * @param onCard false for the simulated card, true for the real SD card
+     *
+     * @warning The SD card run writes to /bench/ and must not run while recording.
+     */
+    void runAll(bool onCard);
+};
@@ -0,0 +1,128 @@
+/**
+ * @file StripChartWidget.h
+ * @brief Scrolling strip chart of a value over the last minutes
+ *
+ * Two fixed-size rings back the chart: one sample per second over
+ * HISTORY_SECONDS (the source of the min/mean/max and of any redraw), and
+ * one entry per pixel column of the plot. The plot lives in a cached
+ * sprite: when a column period ends, the sprite is scrolled left by one
+ * pixel and only the new column is drawn, so a frame costs the same for a
+ * one-minute and a ten-minute window.
+ *
+ * Min and max over the window come from monotonic queues and the mean
+ * from a running sum: each new second costs O(1) amortized. Changing the
+ * window or the vertical scale redraws the plot from the rings.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <M5Unified.h>
+#include "Widgets.h"
+
+/**
+ * @class StripChartWidget
+ * @brief Strip chart with a min/mean/max header
+ */
+class StripChartWidget : public Widget {
+public:
+    static const int HISTORY_SECONDS = 600;       ///< Longest window (10 minutes)
+    static const int MIN_WINDOW_MINUTES = 1;
+    static const int MAX_WINDOW_MINUTES = HISTORY_SECONDS / 60;
+    static const int MAX_COLUMNS = 320;
+    static const int16_t HEADER_HEIGHT = 10;
+    static const uint32_t MAX_GAP_MS = 3000;      ///< Longer gaps in the data are not bridged
+
+private:
+    struct Column {
+        float min;
+        float max;
+        float last;
+        bool valid;
+    };
+
+    /// Rings, allocated in PSRAM by begin()
+    struct History {
+        float seconds[HISTORY_SECONDS];   ///< NAN: no valid data during that second
+        uint32_t minQueue[HISTORY_SECONDS];  ///< Absolute second numbers, values increasing
+        uint32_t maxQueue[HISTORY_SECONDS];  ///< Absolute second numbers, values decreasing
+        Column columns[MAX_COLUMNS];
+    };
+
+    const char* title_;
+    uint16_t color_;
+    History* history_;
+
+    // Seconds: absolute number of the next second, its end time and accumulator
+    uint32_t second_;
+    unsigned long secondEnd_;
+    float secondSum_;
+    uint16_t secondCount_;
+
+    // Window statistics (running sum, monotonic queues)
+    int windowMinutes_;
+    float windowSum_;
+    int windowCount_;
+    uint16_t minHead_, minSize_;
+    uint16_t maxHead_, maxSize_;
+
+    // Columns: newest at columnHead_ - 1, period columnMs_
+    uint16_t columnHead_;
+    uint32_t columnMs_;
+    unsigned long columnEnd_;
+    Column current_;
+    int lastDataAge_;      ///< Columns since the last one with data (-1: none)
+    float lastDataValue_;
+
+    float scaleTop_;       ///< Value at the top of the plot
+    bool started_;
+
+    LGFX_Sprite plot_;
+    bool plotReady_;
+    bool plotDirty_;
+    bool headerDirty_;
+    char header_[64];
+
+    int16_t plotWidth() const { return min<int16_t>(bounds_.w, MAX_COLUMNS); }
+    int16_t plotHeight() const { return bounds_.h - HEADER_HEIGHT; }
+    int16_t valueY(float value) const;
+    int windowSeconds() const { return windowMinutes_ * 60; }
+    float secondAt(uint32_t second) const { return history_->seconds[second % HISTORY_SECONDS]; }
+
+    void pushSecond(float value);
+    void rebuildWindow();
+    void updateScale(bool force);
+    void commitColumns(unsigned long now);
+    void drawColumn(LovyanGFX& gfx, int16_t ox, int16_t oy, int16_t x, const Column& column, unsigned long columnStart);
+    void redrawPlot(LovyanGFX& gfx, int16_t ox, int16_t oy);
+    void updateHeader();
+
+public:
+    StripChartWidget(int16_t x, int16_t y, int16_t w, int16_t h, const char* title, uint16_t color);
+
+    /**
+     * @brief Allocate the rings and the plot sprite (PSRAM when available)
+     * @return false without memory for the rings (nothing is shown)
+     */
+    bool begin();
+
+    /**
+     * @brief Add the value of the current frame
+     * @param value Value in the unit of the title
+     * @param valid False when the data timed out (gap in the chart)
+     * @param now millis() of the frame
+     */
+    void set(float value, bool valid, unsigned long now);
+
+    /** @brief Forget the history (e.g. another boat was selected) */
+    void clear();
+
+    /** @brief Length of the chart, clamped to 1-10 minutes */
+    void setWindowMinutes(int minutes);
+    int windowMinutes() const { return windowMinutes_; }
+
+    int dirtyRegion(WidgetRect* rects) const override;
+    void clearDirty() override;
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+};
@@ -0,0 +1,106 @@
+/**
+ * @file WidgetCompositor.h
+ * @brief Dirty-region compositor for the dashboard widgets
+ *
+ * Per frame, the bounding boxes of the dirty widgets are coalesced into a
+ * set of disjoint rectangles covering exactly their union. Each rectangle
+ * is composed off-screen (background, then every visible widget it
+ * intersects, in registration order) and pushed with DMA. All pushes of a
+ * frame share one SPI transaction, inside one display slot of the bus.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <M5Unified.h>
+#include "Widgets.h"
+#include "BusScheduler.h"
+
+/**
+ * @struct DisplayFrameStats
+ * @brief Rendering statistics (pixels, transfers and SPI transactions per frame)
+ */
+struct DisplayFrameStats {
+    uint32_t frames;            ///< Frames that pushed at least one rectangle
+    uint32_t postponedFrames;   ///< Frames postponed because the bus stayed busy
+    uint32_t lastDirtyWidgets;  ///< Dirty widgets in the last frame
+    uint32_t lastDirtyRects;    ///< Coalesced rectangles in the last frame
+    uint32_t lastPixels;        ///< Dirty pixels pushed by the last frame
+    uint32_t lastTransfers;     ///< DMA transfers of the last frame
+    uint32_t lastTransactions;  ///< SPI transactions of the last frame
+    uint32_t lastRenderMicros;  ///< Composition + push time of the last frame
+    uint64_t totalPixels;
+    uint32_t totalTransfers;
+    uint32_t totalTransactions;
+    uint64_t totalRenderMicros;
+};
+
+/**
+ * @class WidgetCompositor
+ * @brief Coalesces dirty widget areas and pushes them from a pixel pool
+ *
+ * The pixel pool holds two buffers of POOL_PIXELS pixels in internal
+ * DMA-capable RAM: one rectangle is drawn while the previous one is being
+ * sent. Rectangles larger than a buffer are sent in horizontal strips.
+ */
+class WidgetCompositor {
+public:
+    static const int MAX_WIDGETS = 32;
+    static const int MAX_RECTS = 48;
+    static const int32_t POOL_PIXELS = 320 * 40;   ///< Pixels per pool buffer (25.6 KB)
+    static const uint32_t FRAME_BUS_TIMEOUT_MS = 100; ///< Frame postponed if the bus stays busy longer
+
+private:
+    M5GFX* lcd_;
+    BusScheduler* bus_;             ///< SPI bus shared with the SD card (nullptr: direct access)
+    Widget* widgets_[MAX_WIDGETS];
+    int widgetCount_;
+    WidgetRect forced_[4];          ///< Areas invalidated independently of widgets
+    int forcedCount_;
+
+    uint16_t* pool_[2];             ///< Pixel buffers (RGB565, sprite byte order)
+    int poolCount_;
+    bool poolDma_;                  ///< Buffers in DMA-capable RAM
+    LGFX_Sprite canvas_[2];         ///< Canvases mapped onto the pool buffers
+
+    DisplayFrameStats stats_;
+
+    int collectDirtyRects(WidgetRect* rects, uint32_t& dirtyWidgets);
+    static int coalesce(WidgetRect* rects, int count);
+    void renderRect(const WidgetRect& rect, int& flip, uint32_t& transfers);
+
+public:
+    WidgetCompositor();
+
+    /**
+     * @brief Allocate the pixel pool
+     * @param lcd Target display
+     * @return false if no buffer could be allocated
+     */
+    bool begin(M5GFX& lcd);
+
+    /** @brief Push frames in display slots of the shared SPI bus */
+    void setBus(BusScheduler* bus) { bus_ = bus; }
+
+    /** @brief Register a widget; registration order is the drawing (z) order */
+    bool add(Widget& widget);
+
+    /** @brief Mark every widget dirty */
+    void invalidateAll();
+
+    /** @brief Redraw an area at the next frame (e.g. after a direct draw) */
+    void invalidateArea(int16_t x, int16_t y, int16_t w, int16_t h);
+
+    /**
+     * @brief Compose and push the dirty regions
+     * @return true if anything was pushed
+     */
+    bool compose();
+
+    /** @brief Rendering statistics */
+    const DisplayFrameStats& stats() const { return stats_; }
+
+    /** @brief One-line summary of the rendering statistics */
+    String describeStats() const;
+};
@@ -0,0 +1,274 @@
+/**
+ * @file Widgets.h
+ * @brief Retained-mode widgets of the dashboard
+ *
+ * Each widget owns a fixed bounding box and the value it currently shows.
+ * Setters compare the new value with the displayed one and mark the widget
+ * dirty only when the rendering would change; WidgetCompositor then redraws
+ * the dirty areas. Widgets draw relative to an origin, so the same code
+ * renders into any off-screen canvas covering part of the screen.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#pragma once
+#include <M5Unified.h>
+#include "GlyphAtlas.h"
+
+/**
+ * @struct WidgetRect
+ * @brief Screen rectangle (pixels)
+ */
+struct WidgetRect {
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+
+    int32_t area() const { return (int32_t)w * h; }
+    bool isEmpty() const { return w <= 0 || h <= 0; }
+    bool intersects(const WidgetRect& o) const {
+        return x < o.x + o.w && o.x < x + w && y < o.y + o.h && o.y < y + h;
+    }
+};
+
+/**
+ * @class Widget
+ * @brief Base class: bounding box, visibility and dirty state
+ */
+class Widget {
+protected:
+    WidgetRect bounds_;
+    bool dirty_;
+    bool fullDirty_;  ///< Whole bounding box to recompose (else only dirtyRegion())
+    bool visible_;
+    bool shown_;      ///< Visible at the last composition
+
+    /** @brief Mark the widget dirty if its rendering changed */
+    void markDirtyIf(bool changed) { if (changed) dirty_ = fullDirty_ = true; }
+
+    /** @brief Mark part of the widget dirty; dirtyRegion() tells which */
+    void markPartialDirty() { dirty_ = true; }
+
+public:
+    static const int MAX_DIRTY_RECTS = 8;
+
+    Widget(int16_t x, int16_t y, int16_t w, int16_t h);
+    virtual ~Widget() {}
+
+    const WidgetRect& bounds() const { return bounds_; }
+    bool isDirty() const { return dirty_; }
+    bool isVisible() const { return visible_; }
+
+    /** @brief True if the widget area must be recomposed (a hidden widget only once, to clear it) */
+    bool needsCompose() const { return dirty_ && (visible_ || shown_); }
+
+    /** @brief Force a redraw at the next composition */
+    void invalidate() { dirty_ = fullDirty_ = true; }
+
+    /** @brief Called by the compositor once the widget has been pushed */
+    virtual void clearDirty() { dirty_ = fullDirty_ = false; shown_ = visible_; }
+
+    /**
+     * @brief Areas to recompose when dirty (default: the bounding box)
+     * @param rects Output, at least MAX_DIRTY_RECTS entries
+     * @return Number of rectangles
+     */
+    virtual int dirtyRegion(WidgetRect* rects) const {
+        rects[0] = bounds_;
+        return 1;
+    }
+
+    /** @brief Show or hide the widget (hiding clears its area) */
+    void setVisible(bool visible);
+
+    /**
+     * @brief Draw the widget
+     * @param gfx Canvas to draw into
+     * @param originX Screen X of the canvas top-left corner
+     * @param originY Screen Y of the canvas top-left corner
+     *
+     * The background is already cleared; drawing outside the canvas is clipped.
+     */
+    virtual void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) = 0;
+};
+
+/**
+ * @class LabelWidget
+ * @brief Static text (drawn once, redrawn only when invalidated)
+ */
+class LabelWidget : public Widget {
+private:
+    const char* text_;
+    uint16_t color_;
+    uint8_t size_;
+
+public:
+    LabelWidget(int16_t x, int16_t y, int16_t w, int16_t h, const char* text, uint16_t color, uint8_t size);
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+};
+
+/**
+ * @class NumberWidget
+ * @brief Numeric readout, "---" when the data timed out
+ *
+ * Updated only when the value moves by more than the threshold or when its
+ * validity changes. Characters sit in fixed-width cells: only the cells
+ * whose character changed are recomposed (12.3 -> 12.4 pushes one glyph),
+ * copied from the glyph atlas when one is attached.
+ */
+class NumberWidget : public Widget {
+public:
+    static const int MAX_CHARS = 8;
+
+private:
+    const char* format_;
+    float threshold_;
+    float value_;
+    bool valid_;
+    char text_[MAX_CHARS + 1];      ///< Text shown (zero-padded)
+    uint16_t dirtyCells_;           ///< Cells whose character changed since the last composition
+    const GlyphAtlas* atlas_;
+
+    static const uint8_t TEXT_SIZE = 3;
+    int16_t cellWidth() const { return GlyphAtlas::FONT_WIDTH * TEXT_SIZE; }
+
+public:
+    NumberWidget(int16_t x, int16_t y, int16_t w, int16_t h, const char* format, float threshold);
+
+    /** @brief Blit characters from an atlas of the same text size (nullptr: text rendering) */
+    void setAtlas(const GlyphAtlas* atlas);
+
+    void setValue(float value, bool valid);
+    int dirtyRegion(WidgetRect* rects) const override;
+    void clearDirty() override;
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+};
+
+/**
+ * @class BoatNameWidget
+ * @brief Selected boat name and index ("NAME 2/5", or "NO BOAT")
+ */
+class BoatNameWidget : public Widget {
+private:
+    String name_;
+    int index_;
+    int total_;
+
+public:
+    BoatNameWidget(int16_t x, int16_t y, int16_t w, int16_t h);
+    void set(const String& name, int index, int total);
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+};
+
+/**
+ * @class HubWidget
+ * @brief Hub relay indicator
+ */
+class HubWidget : public Widget {
+private:
+    bool active_;
+    uint32_t relayed_;
+
+public:
+    HubWidget(int16_t x, int16_t y, int16_t w, int16_t h);
+    void set(bool active, uint32_t relayed);
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+};
+
+/**
+ * @class BatteryWidget
+ * @brief Battery icon with level, charge flash and percentage
+ */
+class BatteryWidget : public Widget {
+private:
+    int percent_;
+    bool charging_;
+
+public:
+    BatteryWidget(int16_t x, int16_t y, int16_t w, int16_t h);
+    void set(int percent, bool charging);
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+};
+
+/**
+ * @class SatelliteWidget
+ * @brief Satellite icon and number of satellites in view
+ */
+class SatelliteWidget : public Widget {
+private:
+    int count_;
+
+public:
+    SatelliteWidget(int16_t x, int16_t y, int16_t w, int16_t h);
+    void setCount(uint8_t count);
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+};
+
+/**
+ * @class ButtonWidget
+ * @brief Touch button: filled box, border and centered caption
+ */
+class ButtonWidget : public Widget {
+private:
+    const char* text_;
+    uint16_t fillColor_;
+    uint16_t borderColor_;
+    uint16_t textColor_;
+
+public:
+    ButtonWidget(int16_t x, int16_t y, int16_t w, int16_t h);
+    /** @param text Caption (string literal), or nullptr for an empty button */
+    void set(const char* text, uint16_t fillColor, uint16_t borderColor, uint16_t textColor);
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+};
+
+/**
+ * @class SpeedBarWidget
+ * @brief Vertical speed bar (max 12 km/h), green/orange/red
+ */
+class SpeedBarWidget : public Widget {
+private:
+    int barHeight_;
+    uint16_t barColor_;
+
+public:
+    SpeedBarWidget(int16_t x, int16_t y, int16_t w, int16_t h);
+    void setSpeed(float speedKmh);
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+};
+
+/**
+ * @class MessageWidget
+ * @brief File server status banner shown over the dashboard
+ */
+class MessageWidget : public Widget {
+private:
+    bool active_;
+    String detail_;
+
+public:
+    MessageWidget(int16_t x, int16_t y, int16_t w, int16_t h);
+    /**
+     * @param active Server running (red banner with URL) or stopped (navy banner)
+     * @param detail IP address, or error text when stopped
+     */
+    void set(bool active, const String& detail);
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+};
+
+/**
+ * @class SdErrorWidget
+ * @brief SD card error panel covering the main area
+ */
+class SdErrorWidget : public Widget {
+private:
+    const char* message_;
+
+public:
+    SdErrorWidget(int16_t x, int16_t y, int16_t w, int16_t h);
+    /** @param message Error detail (string literal) */
+    void set(const char* message);
+    void draw(LovyanGFX& gfx, int16_t originX, int16_t originY) override;
+};
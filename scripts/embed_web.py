@@ -0,0 +1,135 @@
+"""
+Embed the web UI (web/) into the firmware as pre-gzipped assets.
+
+PlatformIO runs this script before every build (extra_scripts = pre:...);
+it can also be run by hand: python3 scripts/embed_web.py
+
+Every file of web/ is gzipped (level 9, no timestamp: the output only
+changes when the sources do) and written as a byte array to
+include/WebAssets.h, which is generated and not versioned. The firmware
+sends these bytes as they are, straight from flash.
+
+Caching: the HTML pages refer to the other assets as "/name?v=<hash>", so
+those can be cached for a year (immutable); the HTML pages themselves are
+revalidated with their ETag (304, no body).
+"""
+
+import gzip
+import hashlib
+import os
+
+CONTENT_TYPES = {
+    ".html": "text/html; charset=utf-8",
+    ".css": "text/css; charset=utf-8",
+    ".js": "application/javascript; charset=utf-8",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+}
+
+try:
+    Import("env")  # noqa: F821 (PlatformIO / SCons)
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+WEB_DIR = os.path.join(PROJECT_DIR, "web")
+OUTPUT = os.path.join(PROJECT_DIR, "include", "WebAssets.h")
+
+
+def url_of(name):
+    return "/" if name == "index.html" else "/" + name
+
+
+def load_assets():
+    sources = {}
+    for name in sorted(os.listdir(WEB_DIR)):
+        path = os.path.join(WEB_DIR, name)
+        if os.path.isfile(path) and not name.startswith("."):
+            with open(path, "rb") as f:
+                sources[name] = f.read()
+
+    versions = {name: hashlib.sha1(data).hexdigest()[:8] for name, data in sources.items()}
+
+    # Versioned URLs for what the pages load: a new build is a new URL
+    for name, data in sources.items():
+        if not name.endswith(".html"):
+            continue
+        for other in sources:
+            if other.endswith(".html"):
+                continue
+            data = data.replace(('"%s"' % other).encode(),
+                                ('"/%s?v=%s"' % (other, versions[other])).encode())
+        sources[name] = data
+
+    assets = []
+    for name, data in sources.items():
+        extension = os.path.splitext(name)[1]
+        packed = gzip.compress(data, compresslevel=9, mtime=0)
+        assets.append({
+            "name": name,
+            "url": url_of(name),
+            "type": CONTENT_TYPES.get(extension, "application/octet-stream"),
+            "etag": hashlib.sha1(data).hexdigest()[:16],
+            "immutable": extension != ".html",
+            "raw": len(data),
+            "data": packed,
+        })
+    return assets
+
+
+def render(assets):
+    lines = [
+        "// Generated by scripts/embed_web.py from web/ - do not edit, not versioned",
+        "#pragma once",
+        "#include <Arduino.h>",
+        "",
+        "/**",
+        " * @struct WebAsset",
+        " * @brief One gzipped file of the web UI, in flash",
+        " */",
+        "struct WebAsset {",
+        "    const char* url;          ///< \"/\" for index.html",
+        "    const char* contentType;",
+        "    const char* etag;         ///< Quoted, from the uncompressed content",
+        "    bool immutable;           ///< Loaded through a versioned URL: cached for a year",
+        "    const uint8_t* data;      ///< gzip stream",
+        "    size_t length;",
+        "};",
+        "",
+    ]
+    for index, asset in enumerate(assets):
+        lines.append("// %s: %d bytes, %d gzipped" % (asset["name"], asset["raw"], len(asset["data"])))
+        lines.append("static const uint8_t kWebAsset%d[] PROGMEM = {" % index)
+        data = asset["data"]
+        for offset in range(0, len(data), 16):
+            lines.append("    " + ", ".join("0x%02x" % b for b in data[offset:offset + 16]) + ",")
+        lines.append("};")
+        lines.append("")
+    lines.append("static const WebAsset kWebAssets[] = {")
+    for index, asset in enumerate(assets):
+        lines.append('    {"%s", "%s", "\\"%s\\"", %s, kWebAsset%d, sizeof(kWebAsset%d)},' % (
+            asset["url"], asset["type"], asset["etag"], "true" if asset["immutable"] else "false",
+            index, index))
+    lines.append("};")
+    lines.append("static const size_t kWebAssetCount = sizeof(kWebAssets) / sizeof(kWebAssets[0]);")
+    lines.append("")
+    return "\n".join(lines)
+
+
+def main():
+    assets = load_assets()
+    header = render(assets)
+    # Rewritten only when it changed: no rebuild of the server otherwise
+    if os.path.exists(OUTPUT):
+        with open(OUTPUT) as f:
+            if f.read() == header:
+                return
+    with open(OUTPUT, "w") as f:
+        f.write(header)
+    total = sum(len(asset["data"]) for asset in assets)
+    print("Web UI: %d assets, %d bytes gzipped -> %s" % (len(assets), total, os.path.relpath(OUTPUT, PROJECT_DIR)))
+
+
+main()
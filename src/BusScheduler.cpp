@@ -0,0 +1,115 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file BusScheduler.cpp
+ * @brief Implementation of the SPI bus scheduler
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "BusScheduler.h"
+
+static const char* const kClientNames[BusScheduler::CLIENT_COUNT] = { "display", "storage" };
+
+BusScheduler::BusScheduler() : mutex_(nullptr), displayWaiting_(0) {
+    memset(slotStart_, 0, sizeof(slotStart_));
+    memset(stats_, 0, sizeof(stats_));
+}
+
+bool BusScheduler::begin() {
+    if (!mutex_) {
+        mutex_ = xSemaphoreCreateMutex();
+    }
+    return mutex_ != nullptr;
+}
+
+bool BusScheduler::acquire(Client client, uint32_t timeoutMs) {
+    if (!mutex_) return true;  // Not initialized yet: direct access (boot)
+
+    unsigned long requestStart = micros();
+
+    if (client == CLIENT_DISPLAY) {
+        displayWaiting_++;
+    } else {
+        // Let waiting frames go first: SD writes use the idle windows between frames
+        unsigned long deferStart = millis();
+        while (displayWaiting_ > 0 && millis() - deferStart < STORAGE_DEFER_MAX_MS) {
+            vTaskDelay(1);
+        }
+    }
+
+    bool contended = uxSemaphoreGetCount(mutex_) == 0;
+    TickType_t ticks = (timeoutMs == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+    bool taken = xSemaphoreTake(mutex_, ticks) == pdTRUE;
+
+    if (client == CLIENT_DISPLAY) {
+        displayWaiting_--;
+    }
+
+    BusClientStats& s = stats_[client];
+    if (!taken) {
+        s.timeouts++;
+        return false;
+    }
+
+    // Statistics are only updated by the bus holder
+    uint32_t waitUs = micros() - requestStart;
+    slotStart_[client] = micros();
+    s.acquisitions++;
+    if (contended) s.contended++;
+    s.totalWaitUs += waitUs;
+    if (waitUs > s.maxWaitUs) s.maxWaitUs = waitUs;
+    int bucket = waitUs < 100 ? 0 : waitUs < 1000 ? 1 : waitUs < 5000 ? 2 : waitUs < 20000 ? 3 : 4;
+    s.waitHistogram[bucket]++;
+    return true;
+}
+
+void BusScheduler::release(Client client) {
+    if (!mutex_) return;
+
+    BusClientStats& s = stats_[client];
+    uint32_t holdUs = micros() - slotStart_[client];
+    s.totalHoldUs += holdUs;
+    if (holdUs > s.maxHoldUs) s.maxHoldUs = holdUs;
+
+    xSemaphoreGive(mutex_);
+}
+
+void BusScheduler::resetStats() {
+    memset(stats_, 0, sizeof(stats_));
+}
+
+String BusScheduler::describe() const {
+    String out = "Bus SPI:";
+    for (int i = 0; i < CLIENT_COUNT; i++) {
+        const BusClientStats& s = stats_[i];
+        // Two pieces: the whole line at the widest counters exceeds one buffer
+        char line[200];
+        snprintf(line, sizeof(line), " %s %lu slots (%lu en attente, %lu timeouts), attente moy %lu us max %lu us ",
+                 kClientNames[i], (unsigned long)s.acquisitions, (unsigned long)s.contended,
+                 (unsigned long)s.timeouts,
+                 (unsigned long)(s.acquisitions ? s.totalWaitUs / s.acquisitions : 0), (unsigned long)s.maxWaitUs);
+        out += line;
+        snprintf(line, sizeof(line),
+                 "[<0.1ms %lu, <1ms %lu, <5ms %lu, <20ms %lu, >=20ms %lu], slot moy %lu us max %lu us;",
+                 (unsigned long)s.waitHistogram[0], (unsigned long)s.waitHistogram[1],
+                 (unsigned long)s.waitHistogram[2], (unsigned long)s.waitHistogram[3],
+                 (unsigned long)s.waitHistogram[4],
+                 (unsigned long)(s.acquisitions ? s.totalHoldUs / s.acquisitions : 0), (unsigned long)s.maxHoldUs);
+        out += line;
+    }
+    return out;
+}
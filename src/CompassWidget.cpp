@@ -0,0 +1,129 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file CompassWidget.cpp
+ * @brief Implementation of the compass widget
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "CompassWidget.h"
+#include "FixedTrig.h"
+
+CompassWidget::CompassWidget(int16_t centerX, int16_t centerY, int16_t radius)
+    : Widget(centerX - radius - 25, centerY - radius - 25, 2 * radius + 50, 2 * radius + 50),
+      radius_(radius), roseCached_(false), needleCount_(0) {
+    memset(needles_, 0, sizeof(needles_));
+}
+
+void CompassWidget::begin() {
+    if (roseCached_) return;
+
+    rose_.setColorDepth(16);
+    rose_.setPsram(true);
+    if (!rose_.createSprite(bounds_.w, bounds_.h)) {
+        return;  // Rose drawn at each composition instead
+    }
+    rose_.fillScreen(BLACK);
+    drawRose(rose_, 0, 0);
+    roseCached_ = true;
+    invalidate();
+}
+
+int CompassWidget::addNeedle(uint16_t color, uint8_t lengthPercent, float halfWidth) {
+    if (needleCount_ >= MAX_NEEDLES) return -1;
+    CompassNeedle& needle = needles_[needleCount_];
+    needle.angle = 0;
+    needle.color = color;
+    needle.length = (int16_t)((int32_t)radius_ * lengthPercent / 100);
+    needle.halfWidth = halfWidth;
+    needle.visible = false;
+    return needleCount_++;
+}
+
+void CompassWidget::setNeedle(int index, float degrees, bool visible) {
+    if (index < 0 || index >= needleCount_) return;
+    CompassNeedle& needle = needles_[index];
+    uint16_t angle = FixedTrig::fromDegrees(degrees);
+    markDirtyIf(visible != needle.visible || (visible && angle != needle.angle));
+    needle.angle = angle;
+    needle.visible = visible;
+}
+
+void CompassWidget::drawRose(LovyanGFX& gfx, int16_t x, int16_t y) {
+    int32_t cx = x + bounds_.w / 2;
+    int32_t cy = y + bounds_.h / 2;
+
+    // Anti-aliased 2 px ring
+    gfx.fillSmoothCircle(cx, cy, radius_, TFT_BLUE);
+    gfx.fillSmoothCircle(cx, cy, radius_ - 2, BLACK);
+
+    // Ticks every 30°, longer on the cardinal points
+    for (int deg = 0; deg < 360; deg += 30) {
+        uint16_t angle = FixedTrig::fromDegrees(deg);
+        int32_t s = FixedTrig::sin(angle);
+        int32_t c = FixedTrig::cos(angle);
+        int32_t inner = radius_ - (deg % 90 == 0 ? 12 : 7);
+        int32_t outer = radius_ - 3;
+        gfx.drawWideLine(cx + (inner * s) / 32768.0f, cy - (inner * c) / 32768.0f,
+                         cx + (outer * s) / 32768.0f, cy - (outer * c) / 32768.0f,
+                         1.5f, TFT_BLUE);
+    }
+
+    gfx.setTextSize(2);
+    gfx.setTextColor(WHITE);
+    gfx.setTextDatum(MC_DATUM);
+    gfx.drawString("N", cx, cy - radius_ - 15);
+    gfx.drawString("E", cx + radius_ + 15, cy);
+    gfx.drawString("S", cx, cy + radius_ + 15);
+    gfx.drawString("W", cx - radius_ - 15, cy);
+}
+
+void CompassWidget::drawNeedle(LovyanGFX& gfx, int32_t cx, int32_t cy, const CompassNeedle& needle) {
+    // Q15 * pixels >> 7 = Q8 offsets: sub-pixel ends for the anti-aliasing
+    int32_t s = FixedTrig::sin(needle.angle);
+    int32_t c = FixedTrig::cos(needle.angle);
+    int32_t tipDx = (needle.length * s) >> 7;
+    int32_t tipDy = -((needle.length * c) >> 7);
+    int32_t tail = needle.length / 4;
+    int32_t tailDx = -((tail * s) >> 7);
+    int32_t tailDy = (tail * c) >> 7;
+
+    float x0 = (float)cx;
+    float y0 = (float)cy;
+    gfx.drawWedgeLine(x0, y0, x0 + tipDx / 256.0f, y0 + tipDy / 256.0f, needle.halfWidth, 0.5f, needle.color);
+    gfx.drawWedgeLine(x0, y0, x0 + tailDx / 256.0f, y0 + tailDy / 256.0f, needle.halfWidth, needle.halfWidth / 2, needle.color);
+}
+
+void CompassWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    int16_t x = bounds_.x - originX;
+    int16_t y = bounds_.y - originY;
+
+    if (roseCached_) {
+        rose_.pushSprite(&gfx, x, y);
+    } else {
+        drawRose(gfx, x, y);
+    }
+
+    int32_t cx = x + bounds_.w / 2;
+    int32_t cy = y + bounds_.h / 2;
+    for (int i = 0; i < needleCount_; i++) {
+        if (needles_[i].visible) {
+            drawNeedle(gfx, cx, cy, needles_[i]);
+        }
+    }
+    gfx.fillSmoothCircle(cx, cy, 5, WHITE);
+}
@@ -23,10 +23,6 @@
  */
 #include "Display.h"
 
-// Variables globales de timestamp (définies dans main.cpp)
-extern unsigned long boatDataTimestamp;
-extern unsigned long anemometerDataTimestamp;
-
 /**
  * @brief Displays the initial splash screen with project identification
  * 
@@ -58,26 +54,167 @@ void Display::showSplashScreen() {
  */
 
 void Display::drawSpeedBar(float speedKmh) {
-    M5.Lcd.fillRect(screenWidth - 20, 100, 10, 120, BLACK);
-    float maxSpeed = 12.0;
-    int barHeight = (int)((speedKmh / maxSpeed) * 120);
-    if (barHeight > 120) barHeight = 120;
-    uint32_t barColor = GREEN;
-    if (speedKmh > 4.0 && speedKmh <= 8.0) {
-      barColor = ORANGE;
-    } else if (speedKmh > 8.0) {
-      barColor = RED;
+    speedBar.setVisible(true);
+    speedBar.setSpeed(speedKmh);
+    compositor.compose();
+}
+
+/**
+ * @brief Allocates the compositor pixel pool and registers the widgets
+ * 
+ * Registration order is the drawing order: the file server banner comes
+ * last so that it stays on top of the values it covers.
+ * Must be called after M5.begin().
+ */
+void Display::begin() {
+    if (!requestMutex) {
+        requestMutex = xSemaphoreCreateMutex();
+    }
+    if (!compositor.begin(M5.Lcd)) {
+        Serial.println("ERREUR: allocation du buffer d'affichage impossible");
+    }
+
+    Widget* widgets[] = {
+        &boatLabel, &boatSpeedUnit, &boatHeadingUnit, &windLabel, &windSpeedUnit, &windDirectionUnit,
+        &boatSpeedValue, &boatHeadingValue, &windSpeedValue, &windDirectionValue,
+        &boatName, &hubStatus, &battery, &satellites,
+        &recordButton, &boatButton, &serverButton,
+        &compass, &compassHeadingLabel, &compassWindLabel, &compassHeadingValue, &compassWindValue,
+        &fleet, &map, &speedChart, &windChart, &speedBar, &sdError, &serverMessage
+    };
+    for (Widget* widget : widgets) {
+        compositor.add(*widget);
+    }
+
+    // Valeurs numériques : glyphes pré-rendus une fois au démarrage
+    if (valueGlyphs.begin()) {
+        NumberWidget* readouts[] = {
+            &boatSpeedValue, &boatHeadingValue, &windSpeedValue, &windDirectionValue,
+            &compassHeadingValue, &compassWindValue
+        };
+        for (NumberWidget* readout : readouts) {
+            readout->setAtlas(&valueGlyphs);
+        }
+    }
+
+    // Courbes : historiques et tracés en PSRAM
+    if (!speedChart.begin() || !windChart.begin()) {
+        Serial.println("ERREUR: allocation de l'historique des courbes impossible");
+    }
+
+    // Carte : anneaux de traces et calque en PSRAM
+    if (!map.begin()) {
+        Serial.println("ERREUR: allocation des traces de la carte impossible");
+    }
+
+    // Boussole : rose mise en cache, aiguille du cap bateau et direction du vent des bouées
+    compass.begin();
+    headingNeedle = compass.addNeedle(RED, 100, 3.0f);
+    windNeedle = compass.addNeedle(CYAN, 80, 2.5f);
+
+    // Affichés uniquement à la demande
+    speedBar.setVisible(false);
+    sdError.setVisible(false);
+    serverMessage.setVisible(false);
+    applyPage();
+}
+
+/**
+ * @brief Shows the widgets of the current page and hides the others
+ *
+ * Hidden widgets clear their area once; their values keep being updated
+ * without any redraw, so switching back shows current data immediately.
+ */
+void Display::applyPage() {
+    Widget* dashboard[] = {
+        &boatLabel, &boatSpeedUnit, &boatHeadingUnit, &windLabel, &windSpeedUnit, &windDirectionUnit,
+        &boatSpeedValue, &boatHeadingValue, &windSpeedValue, &windDirectionValue
+    };
+    Widget* compassPage[] = {
+        &compass, &compassHeadingLabel, &compassWindLabel, &compassHeadingValue, &compassWindValue
+    };
+    for (Widget* widget : dashboard) {
+        widget->setVisible(page == PAGE_DASHBOARD);
     }
-    int barY = 220 - barHeight;
-    M5.Lcd.fillRect(screenWidth - 20, barY, 10, barHeight, barColor);
-    M5.Lcd.drawRect(screenWidth - 20, 100, 10, 120, WHITE);
+    for (Widget* widget : compassPage) {
+        widget->setVisible(page == PAGE_COMPASS);
+    }
+    speedChart.setVisible(page == PAGE_CHARTS);
+    windChart.setVisible(page == PAGE_CHARTS);
+    fleet.setVisible(page == PAGE_FLEET);
+    map.setVisible(page == PAGE_MAP);
+}
+
+/**
+ * @brief Requests the next page; shown at the next frame
+ */
+void Display::nextPage() {
+    if (requestMutex) xSemaphoreTake(requestMutex, portMAX_DELAY);
+    pending.pageSteps++;
+    if (requestMutex) xSemaphoreGive(requestMutex);
+}
+
+/**
+ * @brief Requests a new length for the strip charts; applied at the next frame
+ * @param minutes Window length, clamped to 1-10 minutes
+ */
+void Display::setChartWindow(int minutes) {
+    minutes = constrain(minutes, StripChartWidget::MIN_WINDOW_MINUTES, StripChartWidget::MAX_WINDOW_MINUTES);
+    if (requestMutex) xSemaphoreTake(requestMutex, portMAX_DELAY);
+    pending.chartMinutes = minutes;
+    if (requestMutex) xSemaphoreGive(requestMutex);
+}
+
+/**
+ * @brief Applies the requests made by other tasks since the last frame
+ *
+ * The requests are copied under the mutex, then applied to the widgets
+ * without holding it: a request never waits behind a frame.
+ */
+void Display::applyRequests() {
+    if (requestMutex) xSemaphoreTake(requestMutex, portMAX_DELAY);
+    Requests requests = pending;
+    pending.serverMessage = false;
+    pending.pageSteps = 0;
+    pending.fullRefresh = false;
+    pending.chartMinutes = 0;
+    if (requestMutex) xSemaphoreGive(requestMutex);
+
+    if (requests.pageSteps > 0) {
+        page = (DisplayPage)((page + requests.pageSteps) % PAGE_COUNT);
+        applyPage();
+    }
+    if (requests.chartMinutes > 0) {
+        speedChart.setWindowMinutes(requests.chartMinutes);
+        windChart.setWindowMinutes(requests.chartMinutes);
+    }
+    if (requests.serverMessage) {
+        // Démarrer l'affichage temporaire non-bloquant
+        showingServerMessage = true;
+        serverMessageStartTime = millis();
+        serverMessageActive = requests.serverActive;
+        serverMessage.set(requests.serverActive, requests.serverDetail);
+        serverMessage.setVisible(true);
+    }
+    if (requests.fullRefresh) {
+        // Tous les widgets, plus le fond de la zone principale (effacé comme avant)
+        compositor.invalidateAll();
+        compositor.invalidateArea(0, 0, screenWidth, 180);
+    }
+}
+
+/**
+ * @brief Pushes frames in display slots of the shared SPI bus
+ */
+void Display::setBus(BusScheduler& bus) {
+    compositor.setBus(&bus);
 }
 
 /**
  * @brief Main display function that renders all boat and wind data
  * 
- * @param boatData Structure containing boat telemetry (speed, heading, GPS info)
- * @param anemometerData Structure containing wind measurement data
+ * @param snapshot State captured by the main loop (boat telemetry, wind,
+ *                 recording / server / hub status, battery)
  * 
  * Displays:
  * - Boat identifier (F222) in red
@@ -86,336 +223,85 @@ void Display::drawSpeedBar(float speedKmh) {
  * - GPS satellite count
  * - Wind speed from buoy sensor
  * - GPS recording status indicator (green "RECORD" button when active)
+ * - SD card error panel when the card is missing
+ * 
+ * Single draw entry point, called by the render task at each frame.
+ * Values are handed to the widgets, which decide whether they changed;
+ * only the dirty areas are then composed and pushed.
  */
-void Display::drawDisplay(const struct_message_Boat& boatData, const struct_message_Anemometer& anemometerData, bool isRecording, bool isServerActive, int boatCount, float windDirection, unsigned long windDirTimestamp, bool hasSDError, int selectedBoatIndex, bool hubActive, uint32_t hubTotalRelayed) {
-    float speedKmh = boatData.speed * 1.852;    // knots → km/h
-    float windSpeedKmh = anemometerData.windSpeed * 3.6;
-    
-    // Toujours forcer le datum TL (top-left) car drawButtonLabels le change en MC_DATUM
-    M5.Lcd.setTextDatum(TL_DATUM);
+void Display::drawDisplay(const DisplaySnapshot& snapshot) {
+    applyRequests();
+    updateServerMessageDisplay();
     
-    // Dessiner les labels fixes une seule fois au démarrage
-    if (!labelsDrawn) {
-        M5.Lcd.fillRect(0, 0, screenWidth, 180, BLACK);
-        
-        // Ligne 1 - BOAT vitesse (police taille 3)
-        M5.Lcd.setTextDatum(TL_DATUM);
-        M5.Lcd.setTextColor(RED);
-        M5.Lcd.setTextSize(3);
-        M5.Lcd.setCursor(10, 40);
-        M5.Lcd.print("BOAT");
-        
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextSize(3);
-        M5.Lcd.setCursor(240, 40);
-        M5.Lcd.print("KMH");
-        
-        // Ligne 2 - BOAT orientation
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextSize(3);
-        M5.Lcd.setCursor(240, 80);
-        M5.Lcd.print("DEG");
-        
-        // Ligne 3 - WIND vitesse
-        M5.Lcd.setTextColor(RED);
-        M5.Lcd.setTextSize(3);
-        M5.Lcd.setCursor(10, 120);
-        M5.Lcd.print("WIND");
-        
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextSize(3);
-        M5.Lcd.setCursor(240, 120);
-        M5.Lcd.print("KMH");
-        
-        // Ligne 4 - WIND orientation
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextSize(3);
-        M5.Lcd.setCursor(240, 160);
-        M5.Lcd.print("DEG");
-        
-        // Dessiner les boutons au premier affichage
-        drawButtonLabels(isRecording, isServerActive, boatCount, hasSDError);
-        lastIsRecording = isRecording;
-        lastIsServerActive = isServerActive;
-        lastBoatCount = boatCount;
-        
-        labelsDrawn = true;
-    }
+    const struct_message_Boat& boatData = snapshot.boatData;
+    float speedKmh = boatData.speed * 1.852;    // knots → km/h
+    float windSpeedKmh = snapshot.anemometerData.windSpeed * 3.6;
     
     // Vérifier timeout des données (5 secondes)
     unsigned long currentTime = millis();
-    bool boatDataValid = (currentTime - boatDataTimestamp) < 5000;
-    bool windDataValid = (currentTime - anemometerDataTimestamp) < 5000;
-    bool windDirValid = (currentTime - windDirTimestamp) < 5000;
+    bool boatDataValid = (currentTime - snapshot.boatDataTimestamp) < 5000;
+    bool windDataValid = (currentTime - snapshot.anemometerDataTimestamp) < 5000;
+    bool windDirValid = (currentTime - snapshot.windDirTimestamp) < 5000;
     
-    // Afficher le nom du bateau sélectionné + index en haut à gauche
-    {
-        String boatDisplayName = String(boatData.name).substring(0, 6);
-        boatDisplayName.trim();
-        int totalBoats = boatCount > 0 ? boatCount : 0;
-        int boatIdx = selectedBoatIndex + 1;
-        if (boatDisplayName != lastBoatDisplayName || boatIdx != lastSelectedBoatIdx || totalBoats != lastTotalBoatCount) {
-            // Effacer la zone du nom de bateau en haut à gauche
-            M5.Lcd.fillRect(0, 0, 135, 25, BLACK);
-            if (boatDisplayName.length() > 0 && totalBoats > 0) {
-                M5.Lcd.setTextDatum(TL_DATUM);
-                M5.Lcd.setTextColor(YELLOW);
-                M5.Lcd.setTextSize(2);
-                M5.Lcd.setCursor(5, 5);
-                M5.Lcd.print(boatDisplayName);
-                M5.Lcd.setTextColor(WHITE);
-                M5.Lcd.printf(" %d/%d", boatIdx, totalBoats);
-            } else {
-                M5.Lcd.setTextDatum(TL_DATUM);
-                M5.Lcd.setTextColor(RED);
-                M5.Lcd.setTextSize(2);
-                M5.Lcd.setCursor(5, 5);
-                M5.Lcd.print("NO BOAT");
-            }
-            lastBoatDisplayName = boatDisplayName;
-            lastSelectedBoatIdx = boatIdx;
-            lastTotalBoatCount = totalBoats;
-        }
-    }
+    // Nom du bateau sélectionné + index en haut à gauche
+    String boatDisplayName = String(boatData.name).substring(0, 6);
+    boatDisplayName.trim();
+    boatName.set(boatDisplayName, snapshot.selectedBoatIndex + 1, snapshot.boatCount > 0 ? snapshot.boatCount : 0);
     
-    // Indicateur HUB (entre la barre de statut et les données, y=26)
-    if (hubActive != lastHubActive || hubTotalRelayed != lastHubRelayed) {
-        M5.Lcd.fillRect(0, 26, 200, 12, BLACK);
-        M5.Lcd.setTextDatum(TL_DATUM);
-        M5.Lcd.setTextSize(1);
-        if (hubActive) {
-            M5.Lcd.setTextColor(GREEN);
-            M5.Lcd.setCursor(2, 28);
-            M5.Lcd.printf("HUB OK  relayed:%lu", hubTotalRelayed);
-        } else {
-            M5.Lcd.setTextColor(DARKGREY);
-            M5.Lcd.setCursor(2, 28);
-            M5.Lcd.print("HUB --");
-        }
-        lastHubActive = hubActive;
-        lastHubRelayed = hubTotalRelayed;
-    }
+    hubStatus.set(snapshot.hubActive, snapshot.hubTotalRelayed);
+    satellites.setCount(boatData.satellites);
+    battery.set(snapshot.batteryLevel, snapshot.batteryCharging);
     
-    // Mettre à jour uniquement la vitesse si elle a changé ou si le timeout a changé
-    if (abs(speedKmh - lastSpeedKmh) > 0.05 || (boatDataValid != (lastSpeedKmh > -998))) {
-        // Effacer l'ancienne valeur
-        M5.Lcd.fillRect(120, 40, 115, 24, BLACK);
-        
-        // Dessiner la nouvelle valeur
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextSize(3);
-        M5.Lcd.setCursor(120, 40);
-        if (boatDataValid) {
-            M5.Lcd.printf("%.1f", speedKmh);
-            lastSpeedKmh = speedKmh;
-        } else {
-            M5.Lcd.print("---");
-            lastSpeedKmh = -998; // Valeur spéciale pour indiquer timeout
-        }
-    }
+    boatSpeedValue.setValue(speedKmh, boatDataValid);
+    boatHeadingValue.setValue(boatData.heading, boatDataValid);
+    windSpeedValue.setValue(windSpeedKmh, windDataValid);
+    windDirectionValue.setValue(snapshot.windDirection, windDirValid);
     
-    // Mettre à jour uniquement le cap si il a changé ou si le timeout a changé
-    if (abs(boatData.heading - lastHeading) > 0.5 || (boatDataValid != (lastHeading > -998))) {
-        // Effacer l'ancienne valeur
-        M5.Lcd.fillRect(120, 80, 115, 24, BLACK);
-        
-        // Dessiner la nouvelle valeur
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextSize(3);
-        M5.Lcd.setCursor(120, 80);
-        if (boatDataValid) {
-            M5.Lcd.printf("%.0f", boatData.heading);
-            lastHeading = boatData.heading;
-        } else {
-            M5.Lcd.print("---");
-            lastHeading = -998;
-        }
-    }
+    // Boussole (mise à jour même masquée : aucun coût tant que la page n'est pas affichée)
+    compass.setNeedle(headingNeedle, boatData.heading, boatDataValid);
+    compass.setNeedle(windNeedle, snapshot.windDirection, windDirValid);
+    compassHeadingValue.setValue(boatData.heading, boatDataValid);
+    compassWindValue.setValue(snapshot.windDirection, windDirValid);
     
-    // Mettre à jour uniquement les satellites si le nombre a changé
-    if (boatData.satellites != lastSatellites) {
-        // Effacer l'ancienne valeur
-        M5.Lcd.fillRect(240, 0, 80, 20, BLACK);
-        
-        // Dessiner le pictogramme de satellite
-        int satX = 245;
-        int satY = 3;
-        
-        // Panneau solaire gauche (lignes horizontales bleues)
-        M5.Lcd.drawRect(satX, satY, 4, 12, WHITE);
-        M5.Lcd.drawLine(satX + 1, satY + 2, satX + 2, satY + 2, BLUE);
-        M5.Lcd.drawLine(satX + 1, satY + 4, satX + 2, satY + 4, BLUE);
-        M5.Lcd.drawLine(satX + 1, satY + 6, satX + 2, satY + 6, BLUE);
-        M5.Lcd.drawLine(satX + 1, satY + 8, satX + 2, satY + 8, BLUE);
-        M5.Lcd.drawLine(satX + 1, satY + 10, satX + 2, satY + 10, BLUE);
-        
-        // Corps du satellite (rectangle central blanc)
-        M5.Lcd.fillRect(satX + 5, satY + 3, 4, 6, WHITE);
-        
-        // Panneau solaire droit (lignes horizontales bleues)
-        M5.Lcd.drawRect(satX + 10, satY, 4, 12, WHITE);
-        M5.Lcd.drawLine(satX + 11, satY + 2, satX + 12, satY + 2, BLUE);
-        M5.Lcd.drawLine(satX + 11, satY + 4, satX + 12, satY + 4, BLUE);
-        M5.Lcd.drawLine(satX + 11, satY + 6, satX + 12, satY + 6, BLUE);
-        M5.Lcd.drawLine(satX + 11, satY + 8, satX + 12, satY + 8, BLUE);
-        M5.Lcd.drawLine(satX + 11, satY + 10, satX + 12, satY + 10, BLUE);
-        
-        // Dessiner le nombre de satellites avec un espace
-        M5.Lcd.setCursor(265, 2);
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextSize(2);
-        M5.Lcd.printf("%d", boatData.satellites);
-        
-        lastSatellites = boatData.satellites;
+    // Courbes : un échantillon par image, historique effacé quand un autre bateau est sélectionné
+    bool hasSelection = snapshot.selectedBoatIndex >= 0 && snapshot.selectedBoatIndex < snapshot.fleetCount;
+    uint32_t boatId = hasSelection ? snapshot.fleet[snapshot.selectedBoatIndex].deviceId : 0;
+    if (boatId != chartBoatId) {
+        chartBoatId = boatId;
+        speedChart.clear();
     }
+    speedChart.set(speedKmh, boatDataValid, currentTime);
+    windChart.set(windSpeedKmh, windDataValid, currentTime);
     
-    // Mettre à jour l'affichage de la batterie (centré en haut)
-    int batteryPercent = M5.Power.getBatteryLevel();
-    bool isCharging = M5.Power.isCharging();
+    // Flotte : seules les cellules modifiées sont marquées
+    fleet.set(snapshot.fleet, snapshot.fleetCount, snapshot.selectedBoatIndex, currentTime);
     
-    if (batteryPercent != lastBatteryPercent || isCharging != lastIsCharging) {
-        // Effacer la zone batterie (décalée à droite)
-        M5.Lcd.fillRect(140, 0, 100, 25, BLACK);
-        
-        // Position décalée à droite
-        int battCenterX = 190;
-        
-        // Dessiner le picto batterie à gauche du pourcentage
-        int batteryX = battCenterX - 35;
-        int batteryY = 2;  // Remonté pour aligner avec le texte (Y plus petit = plus haut)
-        
-        // Dessiner le corps de la batterie (rectangle)
-        M5.Lcd.drawRect(batteryX, batteryY, 24, 12, WHITE);
-        M5.Lcd.fillRect(batteryX + 1, batteryY + 1, 22, 10, BLACK);
-        
-        // Dessiner la borne + de la batterie
-        M5.Lcd.fillRect(batteryX + 24, batteryY + 3, 2, 6, WHITE);
-        
-        // Remplir la batterie selon le niveau (proportionnel avec couleur)
-        int fillWidth = (batteryPercent * 20) / 100;
-        if (fillWidth > 20) fillWidth = 20;
-        
-        if (batteryPercent > 50) {
-            M5.Lcd.fillRect(batteryX + 2, batteryY + 2, fillWidth, 8, GREEN);
-        } else if (batteryPercent > 20) {
-            M5.Lcd.fillRect(batteryX + 2, batteryY + 2, fillWidth, 8, ORANGE);
-        } else {
-            M5.Lcd.fillRect(batteryX + 2, batteryY + 2, fillWidth, 8, RED);
-        }
-        
-        // Dessiner l'icône éclair si en charge
-        if (isCharging) {
-            // Éclair jaune sur la batterie
-            M5.Lcd.fillTriangle(batteryX + 14, batteryY + 2,
-                               batteryX + 10, batteryY + 7,
-                               batteryX + 12, batteryY + 7, YELLOW);
-            M5.Lcd.fillTriangle(batteryX + 10, batteryY + 7,
-                               batteryX + 14, batteryY + 12,
-                               batteryX + 12, batteryY + 7, YELLOW);
-        }
-        
-        // Dessiner le pourcentage à droite du picto (avec couleur selon niveau)
-        M5.Lcd.setCursor(batteryX + 32, 2);
-        M5.Lcd.setTextSize(2);
-        
-        if (batteryPercent > 50) {
-            M5.Lcd.setTextColor(GREEN);
-        } else if (batteryPercent > 20) {
-            M5.Lcd.setTextColor(ORANGE);
-        } else {
-            M5.Lcd.setTextColor(RED);
-        }
-        
-        M5.Lcd.printf("%d%%", batteryPercent);
-        
-        lastBatteryPercent = batteryPercent;
-        lastIsCharging = isCharging;
-    }
+    // Carte : les traces continuent d'être suivies quand la page est masquée
+    map.set(snapshot.fleet, snapshot.fleetCount, snapshot.selectedBoatIndex, snapshot.buoys, snapshot.buoyCount, currentTime);
     
-    // Mettre à jour uniquement la vitesse du vent si elle a changé ou si le timeout a changé
-    if (abs(windSpeedKmh - lastWindSpeedKmh) > 0.05 || (windDataValid != (lastWindSpeedKmh > -998))) {
-        // Effacer l'ancienne valeur
-        M5.Lcd.fillRect(120, 120, 115, 24, BLACK);
-        
-        // Dessiner la nouvelle valeur
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextSize(3);
-        M5.Lcd.setCursor(120, 120);
-        if (windDataValid) {
-            M5.Lcd.printf("%.1f", windSpeedKmh);
-            lastWindSpeedKmh = windSpeedKmh;
-        } else {
-            M5.Lcd.print("---");
-            lastWindSpeedKmh = -998;
-        }
-    }
+    // Carte SD absente : panneau d'erreur par-dessus la zone principale
+    sdError.setVisible(snapshot.sdErrorMessage != nullptr);
+    sdError.set(snapshot.sdErrorMessage);
     
-    // Mettre à jour la direction du vent si elle a changé ou si le timeout a changé
-    if (abs(windDirection - lastWindDirection) > 0.5 || (windDirValid != (lastWindDirection > -998))) {
-        // Effacer l'ancienne valeur
-        M5.Lcd.fillRect(120, 160, 115, 24, BLACK);
-        
-        // Dessiner la nouvelle valeur
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextSize(3);
-        M5.Lcd.setCursor(120, 160);
-        if (windDirValid) {
-            M5.Lcd.printf("%.0f", windDirection);
-            lastWindDirection = windDirection;
-        } else {
-            M5.Lcd.print("---");
-            lastWindDirection = -998;
-        }
-    }
+    updateButtons(snapshot.isRecording, snapshot.isServerActive, snapshot.boatCount, snapshot.hasSDError);
     
-    // Redessiner les boutons uniquement si leur état a changé
-    if (isRecording != lastIsRecording || isServerActive != lastIsServerActive || boatCount != lastBoatCount || hasSDError != lastHasSDError) {
-        drawButtonLabels(isRecording, isServerActive, boatCount, hasSDError);
-        lastIsRecording = isRecording;
-        lastIsServerActive = isServerActive;
-        lastBoatCount = boatCount;
-        lastHasSDError = hasSDError;
-    }
+    compositor.compose();
 }
 
 /**
- * @brief Draws a compass with directional arrow showing boat heading
+ * @brief Points the boat heading needle of the compass page
  * 
  * @param heading Current boat heading in degrees (0-360)
  * 
  * Features:
- * - Circular compass with N/E/S/W labels (drawn once)
- * - Red arrow pointing in current heading direction
- * - Erases previous arrow position to avoid ghosting
+ * - Cached rose with N/E/S/W labels and ticks every 30°
+ * - Anti-aliased red needle from the fixed-point trig table
+ * - The rose is copied under the needles, so no ghosting and no erased labels
  * - White center dot for reference point
  */
 void Display::drawCompass(float heading) {
-    int x0 = centerX;
-    int y0 = centerY;
-    if (previousAngle >= 0) {
-      float oldRad = (previousAngle - 90) * DEG_TO_RAD;
-      int oldX = x0 + cos(oldRad) * arrowLength;
-      int oldY = y0 + sin(oldRad) * arrowLength;
-      M5.Lcd.drawLine(x0, y0, oldX, oldY, BLACK);
-    }
-    static bool circleDrawn = false;
-    if (!circleDrawn) {
-      M5.Lcd.drawCircle(x0, y0, arrowLength, TFT_BLUE);
-      M5.Lcd.setTextSize(2);
-      M5.Lcd.setTextColor(WHITE);
-      M5.Lcd.setTextDatum(MC_DATUM);
-      M5.Lcd.drawString("N", x0, y0 - arrowLength - 15);
-      M5.Lcd.drawString("E", x0 + arrowLength + 15, y0);
-      M5.Lcd.drawString("S", x0, y0 + arrowLength + 15);
-      M5.Lcd.drawString("W", x0 - arrowLength - 15, y0);
-      circleDrawn = true;
-    }
-    float angleRad = (heading - 90) * DEG_TO_RAD;
-    int x1 = x0 + cos(angleRad) * arrowLength;
-    int y1 = y0 + sin(angleRad) * arrowLength;
-    M5.Lcd.drawLine(x0, y0, x1, y1, RED);
-    M5.Lcd.fillCircle(x0, y0, 5, WHITE);
-    previousAngle = heading;
+    compass.setNeedle(headingNeedle, heading, true);
+    compositor.compose();
 }
 
 
@@ -430,126 +316,34 @@ void Display::drawCompass(float heading) {
  * Message is displayed in the center of the screen temporarily.
  */
 void Display::showFileServerStatus(bool active, const String& ipAddress) {
-    // Démarrer l'affichage temporaire non-bloquant
-    showingServerMessage = true;
-    serverMessageStartTime = millis();
-    serverMessageActive = active;
-    serverMessageIP = ipAddress;
-    
-    // Afficher immédiatement le message une première fois
-    updateServerMessageDisplay();
+    // Affiché par-dessus le tableau de bord à l'image suivante
+    if (requestMutex) xSemaphoreTake(requestMutex, portMAX_DELAY);
+    pending.serverMessage = true;
+    pending.serverActive = active;
+    pending.serverDetail = ipAddress;
+    if (requestMutex) xSemaphoreGive(requestMutex);
 }
 
 /**
- * @brief Draws button labels at the bottom of the screen
- * 
- * @param isRecording Current GPS recording state
- * @param isServerActive Current file server state
- * 
- * Displays labeled buttons at the bottom to indicate touch zones:
- * - Left button: GPS recording control (green if recording, red if stopped)
- * - Right button: File server control (green if active, red if stopped)
- * - Middle area: Reserved/unused
+ * @brief Updates the three button widgets from the current state
  */
-void Display::drawButtonLabels(bool isRecording, bool isServerActive, int boatCount, bool hasSDError) {
-    // Debug: Afficher l'état des boutons
-    static bool lastServerActive = false;
-    static bool lastRecording = false;
-    
-    if (isServerActive != lastServerActive || isRecording != lastRecording) {
-        // Utiliser Serial.print pour éviter les dépendances circulaires
-        Serial.print("DEBUG: drawButtonLabels - Recording: ");
-        Serial.print(isRecording ? "TRUE" : "FALSE");
-        Serial.print(", ServerActive: ");
-        Serial.println(isServerActive ? "TRUE" : "FALSE");
-        
-        lastServerActive = isServerActive;
-        lastRecording = isRecording;
-    }
-    
-    int buttonY = 200;
-    int buttonHeight = 40;
-    int button1Width = 107;  // Premier tiers
-    int button2Width = 106;  // Deuxième tiers (107 à 213)
-    int button3Width = 107;  // Dernier tiers
-    int button2X = 107;      // Position X du 2ème bouton
-    int button3X = 213;      // Position X du 3ème bouton
-    
-    // Bouton 1 (gauche) - Enregistrement GPS ou Erreur SD
+void Display::updateButtons(bool isRecording, bool isServerActive, int boatCount, bool hasSDError) {
+    // Bouton 1 (gauche) - Enregistrement GPS, ou ERROR SD en rouge sur noir
     if (hasSDError && isRecording) {
-        // Erreur d'écriture SD : afficher ERROR SD en rouge sur noir
-        M5.Lcd.fillRect(0, buttonY, button1Width, buttonHeight, BLACK);
-        M5.Lcd.drawRect(0, buttonY, button1Width, buttonHeight, RED);
-        M5.Lcd.setTextColor(RED);
-        M5.Lcd.setTextDatum(MC_DATUM);
-        M5.Lcd.setTextSize(2);
-        M5.Lcd.drawString("ERROR SD", button1Width/2, buttonY + buttonHeight/2);
+        recordButton.set("ERROR SD", BLACK, RED, RED);
     } else {
-        M5.Lcd.fillRect(0, buttonY, button1Width, buttonHeight, isRecording ? RED : NAVY);
-        M5.Lcd.drawRect(0, buttonY, button1Width, buttonHeight, WHITE);
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextDatum(MC_DATUM);
-        M5.Lcd.setTextSize(2);
-        M5.Lcd.drawString(isRecording ? "STOP" : "RECORD", button1Width/2, buttonY + buttonHeight/2);
+        recordButton.set(isRecording ? "STOP" : "RECORD", isRecording ? RED : NAVY, WHITE, WHITE);
     }
     
-    // Bouton 2 (centre) - Sélection bateau
+    // Bouton 2 (centre) - Sélection bateau : "BOAT ?" en rouge si plusieurs bateaux
     if (boatCount > 1) {
-        // Plusieurs bateaux détectés : bouton rouge avec "Boat ?"
-        M5.Lcd.fillRect(button2X, buttonY, button2Width, buttonHeight, RED);
-        M5.Lcd.drawRect(button2X, buttonY, button2Width, buttonHeight, WHITE);
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextDatum(MC_DATUM);
-        M5.Lcd.setTextSize(2);
-        M5.Lcd.drawString("BOAT ?", button2X + button2Width/2, buttonY + buttonHeight/2);
+        boatButton.set("BOAT ?", RED, WHITE, WHITE);
     } else {
-        // Un seul ou aucun bateau : zone bleu marine (non utilisée)
-        M5.Lcd.fillRect(button2X, buttonY, button2Width, buttonHeight, NAVY);
-        M5.Lcd.drawRect(button2X, buttonY, button2Width, buttonHeight, WHITE);
+        boatButton.set(nullptr, NAVY, WHITE, WHITE);
     }
     
     // Bouton 3 (droite) - Serveur de fichiers
-    M5.Lcd.fillRect(button3X, buttonY, button3Width, buttonHeight, isServerActive ? RED : NAVY);
-    M5.Lcd.drawRect(button3X, buttonY, button3Width, buttonHeight, WHITE);
-    M5.Lcd.setTextColor(WHITE);
-    M5.Lcd.setTextDatum(MC_DATUM);
-    M5.Lcd.setTextSize(2);
-    M5.Lcd.drawString(isServerActive ? "STOP" : "WIFI", button3X + button3Width/2, buttonY + buttonHeight/2);
-}
-
-/**
- * @brief Affiche un message d'erreur SD au centre de l'écran
- * 
- * @param errorMessage Le message d'erreur à afficher
- * 
- * Affiche un message d'erreur centré avec un fond rouge pour indiquer
- * un problème avec la carte SD (manquante, corrompue, etc.)
- */
-void Display::showSDError(const String& errorMessage) {
-    // Constantes pour le M5Stack Core2 (320x240)
-    const int screenWidth = 320;
-    const int centerX = 160;
-    
-    // Effacer la zone d'affichage principale
-    M5.Lcd.fillRect(0, 0, screenWidth, 180, BLACK);
-    
-    // Fond rouge pour l'erreur
-    M5.Lcd.fillRect(10, 60, screenWidth - 20, 60, RED);
-    M5.Lcd.drawRect(10, 60, screenWidth - 20, 60, WHITE);
-    
-    // Texte d'erreur en blanc
-    M5.Lcd.setTextColor(WHITE);
-    M5.Lcd.setTextDatum(MC_DATUM);
-    M5.Lcd.setTextSize(2);
-    M5.Lcd.drawString("ERREUR SD", centerX, 75);
-    
-    M5.Lcd.setTextSize(1);
-    M5.Lcd.drawString(errorMessage, centerX, 95);
-    
-    // Message d'instruction
-    M5.Lcd.setTextColor(YELLOW);
-    M5.Lcd.setTextSize(2);
-    M5.Lcd.drawString("Insérer carte SD", centerX, 140);
+    serverButton.set(isServerActive ? "STOP" : "WIFI", isServerActive ? RED : NAVY, WHITE, WHITE);
 }
 
 /**
@@ -563,93 +357,123 @@ void Display::updateServerMessageDisplay() {
     if (!serverMessageActive && millis() - serverMessageStartTime >= 3000) {
         // Effacer le message et revenir à l'affichage normal
         showingServerMessage = false;
-        needsRefreshAfterServerMessage = true; // Marquer qu'un refresh est nécessaire
         
-        // Forcer un rafraîchissement complet de l'écran
-        labelsDrawn = false;
-        lastSpeedKmh = -999;
-        lastHeading = -999;
-        lastSatellites = -1;
-        lastWindSpeedKmh = -999;
-        lastWindDirection = -999;
-        lastBatteryPercent = -1;
-        lastIsCharging = false;
+        // Retirer le bandeau : sa zone est recomposée dans cette image
+        serverMessage.setVisible(false);
         
         return;
     }
     
-    // Continuer à afficher le message seulement une fois par cycle pour éviter le clignotement
-    static unsigned long lastRedraw = 0;
-    if (millis() - lastRedraw < 100) return; // Redessiner max toutes les 100ms
-    lastRedraw = millis();
-    
-    // Continuer à afficher le message
-    const int screenWidth = 320;
-    const int centerX = 160;
-    const int centerY = 120;
-    int messageY = centerY - 30;
-    int messageHeight = 60;
-    
-    if (serverMessageActive) {
-        M5.Lcd.fillRect(0, messageY, screenWidth, messageHeight, RED);
-        M5.Lcd.setTextColor(BLACK);
-        M5.Lcd.setTextDatum(MC_DATUM);
-        M5.Lcd.setTextSize(3);
-        M5.Lcd.drawString("SERVEUR ACTIF", centerX, centerY - 10);
-        M5.Lcd.setTextColor(BLACK);
-        M5.Lcd.setTextSize(2);
-        M5.Lcd.drawString("http://" + serverMessageIP, centerX, centerY + 15);
-    } else {
-        M5.Lcd.fillRect(0, messageY, screenWidth, messageHeight, NAVY);
-        M5.Lcd.setTextColor(WHITE);
-        M5.Lcd.setTextDatum(MC_DATUM);
-        M5.Lcd.setTextSize(3);
-        M5.Lcd.drawString("SERVEUR ARRETE", centerX, centerY - 10);
-        M5.Lcd.setTextSize(2);
-        if (serverMessageIP != "") {
-            M5.Lcd.drawString(serverMessageIP, centerX, centerY + 15);
-        } else {
-            M5.Lcd.drawString("Mode normal restaure", centerX, centerY + 15);
-        }
-    }
+    // Le bandeau est un widget : il reste affiché tant qu'il est visible,
+    // sans redessin périodique
 }
 
 /**
- * @brief Vérifie si un refresh de l'affichage est nécessaire après un message serveur
+ * @brief Force un rafraîchissement complet de l'affichage
+ * 
+ * Marque tous les widgets comme modifiés (et le fond de la zone principale)
+ * pour forcer le redessin complet à l'image suivante.
+ * Utile lors du changement de bateau sélectionné.
  */
-bool Display::needsRefresh() {
-    if (needsRefreshAfterServerMessage) {
-        needsRefreshAfterServerMessage = false; // Reset du flag
-        return true;
-    }
-    return false;
+void Display::forceFullRefresh() {
+    if (requestMutex) xSemaphoreTake(requestMutex, portMAX_DELAY);
+    pending.fullRefresh = true;
+    if (requestMutex) xSemaphoreGive(requestMutex);
 }
 
 /**
- * @brief Force un rafraîchissement complet de l'affichage
+ * @brief Returns a one-line summary of the rendering statistics
  * 
- * Réinitialise les variables statiques de drawDisplay pour forcer
- * le redessin complet de tous les éléments à l'écran.
- * Utile lors du changement de bateau sélectionné.
+ * Dirty widgets, coalesced areas, dirty pixels, DMA transfers and SPI
+ * transactions of the last frame, and averages per frame since boot.
  */
-void Display::forceFullRefresh() {
-    // Réinitialiser toutes les variables d'état pour forcer un redessin complet
-    labelsDrawn = false;
-    lastSpeedKmh = -999;
-    lastHeading = -999;
-    lastSatellites = 255;
-    lastWindSpeedKmh = -999;
-    lastWindDirection = -999;
-    lastIsRecording = false;
-    lastIsServerActive = false;
-    lastBoatCount = 0;
-    lastHasSDError = false;
-    lastBoatDisplayName = "";
-    lastSelectedBoatIdx = -1;
-    lastTotalBoatCount = -1;
-    lastHubActive = false;
-    lastHubRelayed = 0;
-    
-    // Effacer l'écran
-    M5.Lcd.fillRect(0, 0, screenWidth, 180, BLACK);
+String Display::describeFrameStats() const {
+    return compositor.describeStats() + "; " + map.describe();
+}
+
+/**
+ * @brief Measures the draw time of each numeric readout
+ * 
+ * @param iterations Draws per measurement
+ * 
+ * For the four dashboard values, times in an off-screen canvas (no SPI
+ * transfer, no shared widget touched):
+ * - text: fillRect + setTextSize(3) + printf, the former rendering
+ * - atlas: every character copied from the glyph atlas
+ * - change: only the cells that changed (one digit), as composed per frame
+ * 
+ * @return One line per readout
+ */
+String Display::benchmarkReadouts(int iterations) {
+    struct Readout {
+        const char* name;
+        const char* format;
+        float a;
+        float b;
+    };
+    const Readout readouts[] = {
+        {"vitesse bateau", "%.1f", 12.3f, 12.4f},
+        {"cap bateau", "%.0f", 123.0f, 124.0f},
+        {"vitesse vent", "%.1f", 18.7f, 18.8f},
+        {"direction vent", "%.0f", 271.0f, 272.0f},
+    };
+    const int16_t w = 115;
+    const int16_t h = 24;
+
+    LGFX_Sprite canvas;
+    canvas.setColorDepth(16);
+    if (!canvas.createSprite(w, h)) {
+        return "Benchmark affichage: canevas non alloué";
+    }
+    if (iterations < 1) iterations = 1;
+
+    String out = "Benchmark valeurs (" + String(iterations) + " dessins):";
+    for (const Readout& r : readouts) {
+        unsigned long start = micros();
+        for (int i = 0; i < iterations; i++) {
+            canvas.fillRect(0, 0, w, h, BLACK);
+            canvas.setTextSize(3);
+            canvas.setTextColor(WHITE);
+            canvas.setCursor(0, 0);
+            canvas.printf(r.format, (i & 1) ? r.b : r.a);
+        }
+        unsigned long textUs = micros() - start;
+
+        NumberWidget readout{0, 0, w, h, r.format, 0};
+        readout.setAtlas(valueGlyphs.isReady() ? &valueGlyphs : nullptr);
+        start = micros();
+        for (int i = 0; i < iterations; i++) {
+            readout.setValue((i & 1) ? r.b : r.a, true);
+            canvas.fillRect(0, 0, w, h, BLACK);
+            readout.draw(canvas, 0, 0);
+            readout.clearDirty();
+        }
+        unsigned long atlasUs = micros() - start;
+
+        // Comme le compositeur : seules les cellules modifiées sont recomposées
+        WidgetRect parts[Widget::MAX_DIRTY_RECTS];
+        int32_t changedPixels = 0;
+        start = micros();
+        for (int i = 0; i < iterations; i++) {
+            readout.setValue((i & 1) ? r.b : r.a, true);
+            int n = readout.dirtyRegion(parts);
+            for (int k = 0; k < n; k++) {
+                canvas.setClipRect(parts[k].x, parts[k].y, parts[k].w, parts[k].h);
+                canvas.fillRect(parts[k].x, parts[k].y, parts[k].w, parts[k].h, BLACK);
+                readout.draw(canvas, 0, 0);
+                changedPixels += parts[k].area();
+            }
+            readout.clearDirty();
+        }
+        canvas.clearClipRect();
+        unsigned long changeUs = micros() - start;
+
+        char line[160];
+        snprintf(line, sizeof(line), " %s texte %lu us, atlas %lu us, changement %lu us (%ld px);",
+                 r.name, textUs / iterations, atlasUs / iterations, changeUs / iterations,
+                 (long)(changedPixels / iterations));
+        out += line;
+    }
+    canvas.deleteSprite();
+    return out;
 }
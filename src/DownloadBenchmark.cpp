@@ -0,0 +1,234 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file DownloadBenchmark.cpp
+ * @brief Implementation of the download / reception benchmark
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "DownloadBenchmark.h"
+#include "DisplayTypes.h"
+#include "Logger.h"
+#include <SD.h>
+
+const char* const DownloadBenchmark::FILE_NAME = "/bench/download.bin";
+
+// Locally administered addresses: 02:44:4C ("DL") + boat number
+static const uint8_t kSimulatedMacPrefix[3] = {0x02, 'D', 'L'};
+
+bool DownloadBenchmark::isSimulated(const uint8_t* mac) {
+    return memcmp(mac, kSimulatedMacPrefix, sizeof(kSimulatedMacPrefix)) == 0;
+}
+
+DownloadBenchmark::DownloadBenchmark()
+    : logger_(nullptr), bus_(nullptr), target_(nullptr), task_(nullptr), running_(false), seconds_(0),
+      sequence_(1), connected_(false), downloads_(0), downloadBytes_(0), connectErrors_(0) {
+}
+
+void DownloadBenchmark::setLogger(Logger& logger) {
+    logger_ = &logger;
+}
+
+void DownloadBenchmark::log(const String& message) {
+    if (logger_) {
+        logger_->log(message);
+    }
+}
+
+bool DownloadBenchmark::start(DownloadBenchTarget& target, uint16_t seconds) {
+    if (running_) {
+        return false;
+    }
+    target_ = &target;
+    seconds_ = constrain(seconds, 1, MAX_SECONDS);
+    running_ = true;
+    if (xTaskCreatePinnedToCore(taskEntry, "DownloadBench", 6144, this, 1, &task_, 1) != pdPASS) {
+        running_ = false;
+        return false;
+    }
+    return true;
+}
+
+void DownloadBenchmark::taskEntry(void* parameter) {
+    DownloadBenchmark* bench = static_cast<DownloadBenchmark*>(parameter);
+    bench->run();
+    bench->task_ = nullptr;
+    bench->running_ = false;
+    vTaskDelete(nullptr);
+}
+
+/**
+ * @brief Create the test file once (kept in /bench/ for the next runs)
+ * @return false if the file cannot be created or the SD stays busy
+ */
+bool DownloadBenchmark::prepareFile() {
+    {
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (!lock.isLocked()) return false;
+        if (SD.exists(FILE_NAME)) {
+            File existing = SD.open(FILE_NAME, FILE_READ);
+            size_t size = existing ? existing.size() : 0;
+            existing.close();
+            if (size == FILE_BYTES) {
+                return true;
+            }
+        }
+        if (!SD.exists("/bench")) {
+            SD.mkdir("/bench");
+        }
+    }
+
+    File file;
+    {
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (!lock.isLocked()) return false;
+        file = SD.open(FILE_NAME, FILE_WRITE);
+    }
+    if (!file) {
+        return false;
+    }
+
+    for (size_t i = 0; i < BUFFER_BYTES; i++) {
+        buffer_[i] = (uint8_t)i;
+    }
+    bool ok = true;
+    for (size_t written = 0; written < FILE_BYTES && ok; written += BUFFER_BYTES) {
+        // One storage slot per chunk: the display keeps its frames
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        ok = lock.isLocked() && file.write(buffer_, BUFFER_BYTES) == BUFFER_BYTES;
+    }
+    BusLock lock(bus_, BusScheduler::CLIENT_STORAGE, portMAX_DELAY);
+    file.close();
+    return ok;  // A partial file has the wrong size: the next run writes it again
+}
+
+void DownloadBenchmark::injectPacket(uint8_t boat, uint32_t sequence) {
+    uint8_t mac[6] = {kSimulatedMacPrefix[0], kSimulatedMacPrefix[1], kSimulatedMacPrefix[2], 0, 0,
+                      (uint8_t)(boat + 1)};
+
+    struct_message_Boat packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.messageType = MSG_TYPE_BOAT_GPS;
+    snprintf(packet.name, sizeof(packet.name), "SIM-DL-%02u", boat + 1);
+    packet.sequenceNumber = sequence;
+    packet.gpsTimestamp = millis();
+    packet.latitude = 43.5f + boat * 0.0005f + (sequence % 1000) * 0.000002f;
+    packet.longitude = 3.9f + (sequence % 1000) * 0.000003f;
+    packet.speed = 3.0f + (sequence % 40) * 0.05f;
+    packet.heading = (float)((sequence + boat * 30) % 360);
+    packet.satellites = 9;
+    packet.ttl = 1;
+
+    target_->inject(mac, (const uint8_t*)&packet, sizeof(packet));
+}
+
+/**
+ * @brief Advance the looping download without blocking the injection
+ */
+void DownloadBenchmark::pumpDownload() {
+    if (!connected_) {
+        if (!client_.connect(IPAddress(127, 0, 0, 1), HTTP_PORT)) {
+            connectErrors_++;
+            return;
+        }
+        client_.print(String("GET /download?file=") + FILE_NAME +
+                      " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n");
+        connected_ = true;
+        return;
+    }
+
+    // A few buffers per tick at most: the injection period must hold
+    for (int i = 0; i < 4; i++) {
+        int available = client_.available();
+        if (available <= 0) {
+            if (!client_.connected()) {
+                client_.stop();
+                connected_ = false;
+                downloads_++;
+            }
+            return;
+        }
+        int count = client_.read(buffer_, min((size_t)available, BUFFER_BYTES));
+        if (count <= 0) {
+            return;
+        }
+        downloadBytes_ += count;
+    }
+}
+
+void DownloadBenchmark::run() {
+    char line[160];
+    snprintf(line, sizeof(line), "=== Download benchmark (%u s, %u boats x %u Hz) ===", seconds_, SIM_BOATS,
+             SIM_RATE_HZ);
+    log(line);
+
+    if (!prepareFile()) {
+        log(String("Download benchmark: unable to create ") + FILE_NAME);
+        return;
+    }
+
+    downloads_ = 0;
+    downloadBytes_ = 0;
+    connectErrors_ = 0;
+    connected_ = false;
+
+    target_->beginSimulation();
+
+    uint32_t total = (uint32_t)seconds_ * SIM_BOATS * SIM_RATE_HZ;
+    uint32_t injected = 0;
+    unsigned long start = millis();
+    TickType_t wake = xTaskGetTickCount();
+    while (injected < total) {
+        uint32_t due = min(total, (uint32_t)(millis() - start) * SIM_BOATS * SIM_RATE_HZ / 1000);
+        for (; injected < due; injected++) {
+            injectPacket(injected % SIM_BOATS, sequence_ + injected / SIM_BOATS);
+        }
+        pumpDownload();
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(TICK_MS));
+    }
+    unsigned long elapsed = millis() - start;
+    sequence_ += total / SIM_BOATS;
+    client_.stop();
+    connected_ = false;
+
+    DownloadBenchProbe probe;
+    memset(&probe, 0, sizeof(probe));
+    target_->endSimulation(probe);
+
+    float seconds = elapsed / 1000.0f;
+    snprintf(line, sizeof(line), "Downloads: %lu complete, %.0f KB in %.1f s (%.1f KB/s), %lu connect errors",
+             (unsigned long)downloads_, downloadBytes_ / 1024.0f, seconds, downloadBytes_ / 1024.0f / seconds,
+             (unsigned long)connectErrors_);
+    log(line);
+    snprintf(line, sizeof(line), "Receive path: %lu injected, %lu received, %lu lost",
+             (unsigned long)injected, (unsigned long)probe.received, (unsigned long)probe.lost);
+    log(line);
+    snprintf(line, sizeof(line), "SD queue: %lu queued, %lu dropped (simulated boats are never recorded)",
+             (unsigned long)probe.queued, (unsigned long)probe.queueDrops);
+    log(line);
+    snprintf(line, sizeof(line), "ESP-NOW radio: %lu real frames heard during the run (not processed)",
+             (unsigned long)probe.radioFrames);
+    log(line);
+
+    String failures;
+    if (downloadBytes_ == 0) failures += " no download";
+    if (probe.received != injected || probe.lost > 0) failures += " packets lost";
+    if (probe.queueDrops > 0) failures += " SD queue drops";
+    if (probe.queued > 0) failures += " simulated entries queued for the SD card";
+    log(failures.length() == 0 ? String("Result: PASS") : "Result: FAIL (" + failures.substring(1) + ")");
+    log("=== End of download benchmark ===");
+}
@@ -25,18 +25,264 @@
 
 #include "FileServerManager.h"
 #include "Logger.h"
+#include "PsramAllocator.h"
+#include "BusScheduler.h"
+#include "WebAssets.h"
+#include <lwip/sockets.h>
+#include <errno.h>
+#include <esp_wifi.h>
+#include <esp32/rom/miniz.h>
+#include <esp32/rom/crc.h>
+#include <Preferences.h>
 
 // Static instance for HTTP callbacks
 FileServerManager* FileServerManager::instance_ = nullptr;
 
+// NVS namespace and key of the WiFi cache (Preferences)
+static const char* const kCacheNamespace = "wifi";
+static const char* const kCacheKey = "link";
+static const uint8_t kCacheVersion = 2;  // 1 also held the DHCP lease
+
+// Separator of the parts of a multipart/byteranges body
+static const char* const kRangeBoundary = "OpenSailingRC_byteranges";
+
+/**
+ * @class FileServerManager::HttpServer
+ * @brief WebServer that can let go of the client of the current request
+ * 
+ * Once a handler has queued the response body in a transfer slot, the slot
+ * owns the socket. Without detachClient(), handleClient() would keep the
+ * client in HC_WAIT_CLOSE for up to HTTP_MAX_CLOSE_WAIT (2 s) and accept
+ * no other request meanwhile. The socket is shared by the WiFiClient copies:
+ * dropping this one does not close it.
+ */
+class FileServerManager::HttpServer : public WebServer {
+public:
+    explicit HttpServer(int port) : WebServer(port) {}
+    
+    /** @brief Forget the current client; handleClient() goes back to accepting */
+    void detachClient() { _currentClient = WiFiClient(); }
+};
+
+static const size_t GZIP_HEADER_BYTES = 10;
+static const size_t GZIP_TRAILER_BYTES = 8;
+
+/**
+ * @struct FileServerManager::GzipStream
+ * @brief ROM deflate compressor and the buffers of one gzip download
+ */
+struct FileServerManager::GzipStream {
+    tdefl_compressor compressor;  ///< Fixed 32 KB window + hash tables
+    bool inUse;
+    bool finished;                ///< Trailer queued in out
+    uint32_t crc;                 ///< CRC-32 of the file bytes read so far
+    uint32_t inputBytes;
+    uint32_t outputBytes;
+    uint32_t micros;              ///< Time spent in tdefl_compress()
+    size_t inLen, inPos;
+    size_t outLen, outSent;
+    uint8_t in[CHUNK_BYTES];
+    uint8_t out[CHUNK_BYTES + GZIP_TRAILER_BYTES];
+};
+
+// ZIP records (PKWARE APPNOTE), without ZIP64: archives stay under 4 GB
+static const uint32_t ZIP_LOCAL_SIGNATURE = 0x04034b50;
+static const uint32_t ZIP_DESCRIPTOR_SIGNATURE = 0x08074b50;
+static const uint32_t ZIP_CENTRAL_SIGNATURE = 0x02014b50;
+static const uint32_t ZIP_END_SIGNATURE = 0x06054b50;
+static const size_t ZIP_LOCAL_BYTES = 30;
+static const size_t ZIP_DESCRIPTOR_BYTES = 16;
+static const size_t ZIP_CENTRAL_BYTES = 46;
+static const size_t ZIP_END_BYTES = 22;
+static const uint16_t ZIP_FLAGS = 0x0808;     ///< Sizes in a data descriptor, UTF-8 names
+static const uint16_t ZIP_VERSION = 20;       ///< 2.0: deflate, data descriptors
+
+enum ZipPhase : uint8_t {
+    ZIP_ENTRY_START = 0,  ///< Open the next file and stage its local header
+    ZIP_ENTRY_DATA,       ///< File bytes, stored or deflated
+    ZIP_CENTRAL,          ///< One central directory record per round
+    ZIP_DONE,             ///< End record staged
+};
+
+/**
+ * @struct FileServerManager::ZipArchive
+ * @brief Files of the ZIP download and the record being sent
+ * 
+ * Names, dates and sizes are taken from the directory when the request
+ * arrives; CRC, compressed size and offset are filled in as each entry
+ * is streamed, for its data descriptor and the central directory.
+ */
+struct FileServerManager::ZipArchive {
+    struct Entry {
+        char name[LIST_NAME_MAX];
+        uint32_t size;
+        uint32_t mtime;
+        uint32_t crc;
+        uint32_t compressedSize;
+        uint32_t offset;          ///< Of the local header
+        bool deflate;
+    };
+    bool inUse;
+    ZipPhase phase;
+    char dir[LIST_NAME_MAX];
+    int count;
+    int index;                    ///< Entry being sent, then central record
+    uint32_t offset;              ///< Archive bytes sent so far
+    uint32_t centralStart;
+    uint32_t inputBytes;
+    uint8_t head[ZIP_CENTRAL_BYTES + LIST_NAME_MAX];  ///< Record being sent
+    size_t headLen, headSent;
+    Entry entries[ZIP_MAX_ENTRIES];
+};
+
+enum TrackPhase : uint8_t {
+    TRACK_SCAN = 0,       ///< Window lines, one file chunk per round
+    TRACK_TIMES,          ///< GeoJSON properties and point times
+    TRACK_DONE,           ///< Last bytes staged
+};
+
+/**
+ * @struct FileServerManager::TrackScan
+ * @brief Window, decimation state and staging buffers of the /api/track body
+ * 
+ * The window is found by the handler; the server task then reads it one
+ * chunk per round and stages the points in out.
+ */
+struct FileServerManager::TrackScan {
+    bool inUse;
+    bool binary;
+    TrackPhase phase;
+    char device[TRACK_DEVICE_MAX];
+    char file[LIST_NAME_MAX];
+    uint32_t from, to;
+    uint64_t span;                ///< Window length, for the time slices
+    int maxPoints;
+    int points;
+    int timesSent;
+    long lastSlice;
+    uint32_t lines;               ///< Dated lines scanned
+    size_t bytesRead;
+    size_t offset;                ///< Where the window starts (findTrackStart)
+    bool seekPending;
+    bool skipping;                ///< Partial line at the start offset
+    bool done;                    ///< Past the window or end of the session
+    char line[TRACK_LINE_BYTES];
+    size_t lineLength;
+    uint8_t in[CHUNK_BYTES];      ///< File chunk being parsed
+    size_t inLen, inPos;
+    uint8_t out[CHUNK_BYTES];     ///< Bytes staged for the client
+    size_t outLen, outSent;
+    uint32_t times[TRACK_MAX_POINTS];  ///< GeoJSON "times", sent after the coordinates
+    
+    void append(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(reinterpret_cast<char*>(out) + outLen, sizeof(out) - outLen, format, args);
+        va_end(args);
+        if (length > 0) outLen += min((size_t)length, sizeof(out) - outLen - 1);
+    }
+};
+
+static void put16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+static void put32(uint8_t* out, uint32_t value) {
+    put16(out, value & 0xFFFF);
+    put16(out + 2, value >> 16);
+}
+
+/**
+ * @brief MS-DOS time and date of a file time (1980-01-01 before 1980)
+ */
+static void dosDateTime(uint32_t mtime, uint16_t& time, uint16_t& date) {
+    time_t seconds = mtime;
+    struct tm tmInfo;
+    gmtime_r(&seconds, &tmInfo);
+    if (tmInfo.tm_year < 80) {
+        time = 0;
+        date = (1 << 5) | 1;
+        return;
+    }
+    time = (tmInfo.tm_hour << 11) | (tmInfo.tm_min << 5) | (tmInfo.tm_sec / 2);
+    date = ((tmInfo.tm_year - 80) << 9) | ((tmInfo.tm_mon + 1) << 5) | tmInfo.tm_mday;
+}
+
+static String jsonEscape(const char* text) {
+    String escaped;
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            escaped += '\\';
+            escaped += *c;
+        } else if ((uint8_t)*c < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", (uint8_t)*c);
+            escaped += code;
+        } else {
+            escaped += *c;
+        }
+    }
+    return escaped;
+}
+
+static String urlEncode(const String& text) {
+    static const char* const kHex = "0123456789ABCDEF";
+    String encoded;
+    for (unsigned int i = 0; i < text.length(); i++) {
+        uint8_t c = text[i];
+        if (isalnum(c) || c == '/' || c == '-' || c == '_' || c == '.' || c == '~') {
+            encoded += (char)c;
+        } else {
+            encoded += '%';
+            encoded += kHex[c >> 4];
+            encoded += kHex[c & 0x0f];
+        }
+    }
+    return encoded;
+}
+
+static bool isDigits(const String& text) {
+    for (unsigned int i = 0; i < text.length(); i++) {
+        if (!isdigit((unsigned char)text[i])) return false;
+    }
+    return true;
+}
+
 /**
  * @brief FileServerManager constructor
  * 
  * Initializes all member variables to their default states and sets up
  * the static instance pointer for HTTP callback functions.
  */
-FileServerManager::FileServerManager() : logger_(nullptr), webServer_(nullptr), serverActive_(false), sdInitialized_(false), wifiConnected_(false) {
+FileServerManager::FileServerManager()
+    : logger_(nullptr), webServer_(nullptr), bus_(nullptr), serverActive_(false), sdInitialized_(false),
+      wifiConnected_(false), linkMode_(WIFI_LINK_NONE),
+      connectState_(WIFI_STATE_IDLE), cancelConnect_(false), phase_(CONNECT_START), shareChannel_(false),
+      usingCache_(false), cacheValid_(false), connectStartMs_(0), phaseStartMs_(0), scanMs_(0), associateMs_(0),
+      ipMs_(0), task_(nullptr), stopped_(nullptr), statsMutex_(nullptr),
+      zip_(nullptr), track_(nullptr), listEntries_(nullptr),
+      listLength_(0), telemetry_(nullptr), requestStart_(0), responseStatus_(0),
+      responseBytes_(0), transferQueued_(false) {
     instance_ = this;
+    for (Transfer& transfer : transfers_) {
+        transfer.active = false;
+        transfer.rangeRemaining = transfer.sent = 0;
+        transfer.startMs = transfer.lastProgressMs = 0;
+        transfer.gzip = nullptr;
+        transfer.zip = nullptr;
+        transfer.track = nullptr;
+    }
+    for (GzipStream*& stream : gzipStreams_) {
+        stream = nullptr;
+    }
+    for (LiveClient& live : liveClients_) {
+        live.active = false;
+        live.buffer = nullptr;
+        live.length = live.written = live.sent = 0;
+    }
+    memset(&stats_, 0, sizeof(stats_));
+    memset(&cache_, 0, sizeof(cache_));
 }
 
 /**
@@ -49,6 +295,15 @@ FileServerManager::~FileServerManager() {
     if (webServer_) {
         delete webServer_;
     }
+    for (GzipStream* stream : gzipStreams_) {
+        largeFree(stream);
+    }
+    largeFree(zip_);
+    largeFree(track_);
+    largeFree(listEntries_);
+    for (LiveClient& live : liveClients_) {
+        largeFree(live.buffer);
+    }
 }
 
 /**
@@ -62,6 +317,14 @@ void FileServerManager::setLogger(Logger& logger) {
     logger_ = &logger;
 }
 
+/**
+ * @brief Share the SPI bus with the display
+ * @param bus Bus scheduler used for every SD access of the server
+ */
+void FileServerManager::setBus(BusScheduler& bus) {
+    bus_ = &bus;
+}
+
 /**
  * @brief Send a message to the configured logging system
  * @param message The message string to log
@@ -82,7 +345,9 @@ void FileServerManager::log(const String& message) {
  * This method sets up the web server infrastructure by:
  * - Verifying SD card accessibility
  * - Creating WebServer instance on port 80
- * - Registering HTTP route handlers for /, /list, /download, and 404 errors
+ * - Registering HTTP route handlers for /, /list, /download, /zip, /api/files, /api/track,
+ *   /api/live and 404 errors
+ * - Creating the server task, which sleeps until the server is started
  * 
  * The server is initialized but not started - call startFileServer() to begin operation.
  */
@@ -96,13 +361,47 @@ bool FileServerManager::initFileServer() {
     }
     
     // Create web server on port 80
-    webServer_ = new WebServer(80);
+    webServer_ = new HttpServer(80);
+    
+    // Listing pages: fixed size, whatever the number of files
+    listEntries_ = static_cast<ListEntry*>(largeMalloc(sizeof(ListEntry) * LIST_PAGE_MAX));
+    if (!listEntries_) {
+        log("Error: no memory for the listing pages");
+        return false;
+    }
+    
+    // Live streams: one batch buffer each, allocated once
+    for (LiveClient& live : liveClients_) {
+        live.buffer = static_cast<char*>(largeMalloc(LIVE_BUFFER_BYTES));
+        if (!live.buffer) {
+            log("Warning: no memory for a live stream buffer");
+        }
+    }
+    
+    // Register route handlers (timed: one log line per request)
+    for (size_t i = 0; i < kWebAssetCount; i++) {
+        webServer_->on(kWebAssets[i].url, [this]() { timedHandler(&FileServerManager::handleAsset); });
+    }
+    webServer_->on("/list", [this]() { timedHandler(&FileServerManager::handleAsset); });
+    webServer_->on("/download", [this]() { timedHandler(&FileServerManager::handleFileDownload); });
+    webServer_->on("/zip", [this]() { timedHandler(&FileServerManager::handleZip); });
+    webServer_->on("/api/files", [this]() { timedHandler(&FileServerManager::handleFileApi); });
+    webServer_->on("/api/track", [this]() { timedHandler(&FileServerManager::handleTrack); });
+    webServer_->on("/api/live", [this]() { timedHandler(&FileServerManager::handleLive); });
+    webServer_->onNotFound([this]() { timedHandler(&FileServerManager::handleNotFound); });
+    
+    // Request headers kept by WebServer (conditional and partial downloads)
+    const char* headers[] = {"Range", "If-Range", "If-None-Match", "Accept-Encoding"};
+    webServer_->collectHeaders(headers, sizeof(headers) / sizeof(headers[0]));
     
-    // Register route handlers
-    webServer_->on("/", [this]() { this->handleRoot(); });
-    webServer_->on("/list", [this]() { this->handleFileList(); });
-    webServer_->on("/download", [this]() { this->handleFileDownload(); });
-    webServer_->onNotFound([this]() { this->handleNotFound(); });
+    // Server task: requests and transfers never run in the main loop
+    stopped_ = xSemaphoreCreateBinary();
+    statsMutex_ = xSemaphoreCreateMutex();
+    if (!stopped_ || !statsMutex_ ||
+        xTaskCreatePinnedToCore(taskEntry, "HttpServer", 8192, this, 1, &task_, 1) != pdPASS) {
+        log("Error: unable to create the HTTP server task");
+        return false;
+    }
     
     log("HTTP file server initialized");
     sdInitialized_ = true;
@@ -110,37 +409,35 @@ bool FileServerManager::initFileServer() {
 }
 
 /**
- * @brief Start the HTTP file server with WiFi connection
- * @return true if server starts successfully, false otherwise
+ * @brief Start the HTTP file server in the background
+ * @return true if the connection started, false otherwise
  * 
- * This method performs the complete server startup sequence:
- * 1. Verifies server initialization
- * 2. Connects to WiFi using configuration from SD card
- * 3. Starts the HTTP server on port 80
- * 4. Logs the server URL for client access
+ * Only the configuration is read here (SD card); the connection and the
+ * start of the HTTP server are steps of the server task (connectStep()),
+ * so the caller returns at once. Follow connectState().
  * 
- * Note: This switches the system from ESPNow to WiFi mode.
+ * Note: ESP-NOW keeps receiving unless the link is WIFI_LINK_STATION.
  */
 bool FileServerManager::startFileServer() {
     if (!sdInitialized_) {
         log("Error: File server not initialized");
         return false;
     }
-    
-    // Connect to WiFi first
-    if (!connectToWiFi()) {
+    if (connectState_ == WIFI_STATE_CONNECTING || serverActive_) {
+        log("File server already starting or running");
+        return false;
+    }
+    if (!wifiConfig_.isValid && !loadWiFiConfig()) {
+        connectState_ = WIFI_STATE_FAILED;
         return false;
     }
     
-    log("Starting HTTP file server...");
-    
-    webServer_->begin();
-    serverActive_ = true;
-    
-    String ip = WiFi.localIP().toString();
-    log("File server active at: http://" + ip);
-    log("Access files from your web browser");
-    
+    log("Starting HTTP file server (connecting in the background)...");
+    cancelConnect_ = false;
+    phase_ = CONNECT_START;
+    connectStartMs_ = millis();
+    connectState_ = WIFI_STATE_CONNECTING;
+    xTaskNotifyGive(task_);
     return true;
 }
 
@@ -149,377 +446,2629 @@ bool FileServerManager::startFileServer() {
  * @return true if server stops successfully, false otherwise
  * 
  * This method performs a clean shutdown of the file server:
- * 1. Stops the HTTP server
- * 2. Disconnects from WiFi
- * 3. Returns the system to ESPNow mode for normal operation
+ * 1. Cancels the connection in progress, or asks the server task to abort
+ *    the transfers and stop the HTTP server (waits at most for the chunk
+ *    or the connection step in progress)
+ * 2. Closes the soft-AP or the station link
+ * 3. Restores the ESP-NOW radio settings for normal operation
  * 
  * The server can be restarted later by calling startFileServer() again.
  */
 bool FileServerManager::stopFileServer() {
-    if (!serverActive_) {
+    if (connectState_ != WIFI_STATE_CONNECTING && connectState_ != WIFI_STATE_ACTIVE) {
         return true; // Already stopped
     }
     
-    log("Stopping HTTP file server...");
+    log(connectState_ == WIFI_STATE_CONNECTING ? "Cancelling the WiFi connection..." : "Stopping HTTP file server...");
     
-    webServer_->stop();
+    cancelConnect_ = true;
     serverActive_ = false;
+    xTaskNotifyGive(task_);
+    if (xSemaphoreTake(stopped_, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        log("Warning: HTTP server task did not stop within 2 s");
+    }
     
-    // Disconnect WiFi to return to ESPNow mode
+    // Close the link and give the radio back to ESP-NOW
     disconnectWiFi();
+    connectState_ = WIFI_STATE_IDLE;
     
     log("File server stopped, returning to ESPNow mode");
     return true;
 }
 
+void FileServerManager::taskEntry(void* parameter) {
+    static_cast<FileServerManager*>(parameter)->serverLoop();
+}
+
 /**
- * @brief Handle incoming HTTP client requests
+ * @brief Body of the server task
  * 
- * This method must be called regularly in the main loop when the server
- * is active to process incoming HTTP requests and serve responses.
- * It delegates to the underlying WebServer's handleClient() method.
+ * While connecting: one connection step every CONNECT_POLL_MS. While the
+ * server is active: accept and handle at most one request, then give
+ * every transfer one chunk and every live stream its due batch, then
+ * yield. When the server is stopped (or the connection cancelled), the
+ * transfers are aborted, the HTTP server is closed and the task sleeps
+ * until the next start.
  */
-void FileServerManager::handleClient() {
-    if (serverActive_ && webServer_) {
-        webServer_->handleClient();
+void FileServerManager::serverLoop() {
+    for (;;) {
+        while (!serverActive_ && connectState_ != WIFI_STATE_CONNECTING) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        
+        if (connectState_ == WIFI_STATE_CONNECTING) {
+            if (cancelConnect_) {
+                abortConnect();
+                xSemaphoreGive(stopped_);
+            } else {
+                connectStep();
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONNECT_POLL_MS));
+            }
+            continue;
+        }
+        
+        while (serverActive_ && !cancelConnect_) {
+            webServer_->handleClient();
+            bool progressed = pumpTransfers();
+            progressed |= pumpLive();
+            
+            // Yield between rounds; sleep longer when nothing is in progress
+            vTaskDelay(progressed ? 1 : pdMS_TO_TICKS(IDLE_POLL_MS));
+        }
+        
+        serverActive_ = false;
+        abortTransfers();
+        webServer_->stop();
+        xSemaphoreGive(stopped_);
     }
 }
 
 /**
- * @brief Get the server's current IP address
- * @return IP address as string if connected, "Not connected" otherwise
- * 
- * Returns the local IP address assigned by the WiFi network.
- * This address is used by clients to access the web interface.
+ * @brief True if a send on the socket would not block
  */
-String FileServerManager::getServerIP() {
-    if (WiFi.status() == WL_CONNECTED) {
-        return WiFi.localIP().toString();
-    }
-    return "Not connected";
+static bool socketWritable(int fd) {
+    if (fd < 0) return false;
+    fd_set writeSet;
+    FD_ZERO(&writeSet);
+    FD_SET(fd, &writeSet);
+    struct timeval timeout = {0, 0};
+    return select(fd + 1, nullptr, &writeSet, nullptr, &timeout) > 0;
 }
 
 /**
- * @brief Handle HTTP requests to the root URL (/)
- * 
- * Serves the main web interface page with:
- * - Responsive HTML design for desktop and mobile
- * - CSS styling for modern appearance
- * - JavaScript for dynamic file listing
- * - File browser interface with navigation
+ * @brief Send what the socket takes right now, without waiting
+ * @return Bytes sent, 0 if the send buffer is full, -1 if the connection failed
  * 
- * The page provides a complete file management interface accessible
- * from any web browser on the same network.
+ * WiFiClient::write() retries until everything is sent, with delays between
+ * attempts: a slow client would block the server task for every transfer.
  */
-void FileServerManager::handleRoot() {
-    String html = "<!DOCTYPE html><html><head>";
-    html += "<title>M5Stack Core2 - Serveur de fichiers</title>";
-    html += "<meta charset='UTF-8'>";
-    html += "<style>body{font-family:Arial,sans-serif;margin:20px;}";
-    html += "h1{color:#333;}ul{list-style-type:none;}";
-    html += "li{margin:5px 0;}a{text-decoration:none;color:#0066cc;}";
-    html += "a:hover{text-decoration:underline;}</style>";
-    html += "</head><body>";
-    html += "<h1>🚢 M5Stack Core2 - Serveur de fichiers GPS</h1>";
-    html += "<p>Bienvenue sur le serveur de fichiers de votre M5Stack Core2.</p>";
-    html += "<p>Vous pouvez télécharger les fichiers de replay GPS stockés sur la carte SD.</p>";
-    html += "<h2>📁 Répertoires disponibles:</h2>";
-    html += "<ul>";
-    html += "<li>📂 <a href='/list?dir=/replay'>/replay</a> - Fichiers de replay GPS</li>";
-    html += "<li>📂 <a href='/list?dir=/'>/</a> - Racine de la carte SD</li>";
-    html += "</ul>";
-    html += "<hr>";
-    html += "<p><em>Généré par M5Stack Core2 - FRA222</em></p>";
-    html += "</body></html>";
-    
-    webServer_->send(200, "text/html", html);
+static int sendNow(WiFiClient& client, const uint8_t* data, size_t length) {
+    int fd = client.fd();
+    if (fd < 0) return -1;
+    int sent = send(fd, data, length, MSG_DONTWAIT);
+    if (sent >= 0) return sent;
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
 }
 
 /**
- * @brief Handle HTTP requests to /list for directory browsing
+ * @brief Give each transfer one chunk
+ * @return true if at least one transfer progressed
  * 
- * Serves a file listing page for the specified directory path.
- * Features include:
- * - Directory navigation with breadcrumb links
- * - File and folder icons
- * - File size display
- * - Download links for files
- * - Parent directory navigation
- * 
- * Query parameter: ?dir=/path/to/directory
- * Defaults to root directory (/) if no path specified.
- */
-void FileServerManager::handleFileList() {
-    String path = webServer_->arg("dir");
-    if (path == "") path = "/";
-    
-    String html = "<!DOCTYPE html><html><head>";
-    html += "<title>Fichiers - " + path + "</title>";
-    html += "<meta charset='UTF-8'>";
-    html += "<style>body{font-family:Arial,sans-serif;margin:20px;}";
-    html += "h1{color:#333;}table{border-collapse:collapse;width:100%;}";
-    html += "th,td{border:1px solid #ddd;padding:8px;text-align:left;}";
-    html += "th{background-color:#f2f2f2;}a{text-decoration:none;color:#0066cc;}";
-    html += "a:hover{text-decoration:underline;}</style>";
-    html += "</head><body>";
-    html += "<h1>📁 Contenu de: " + path + "</h1>";
-    html += "<p><a href='/'>🏠 Retour à l'accueil</a></p>";
-    
-    File dir = SD.open(path);
-    if (!dir) {
-        html += "<p style='color:red;'>❌ Erreur: Impossible d'ouvrir le répertoire</p>";
-    } else if (!dir.isDirectory()) {
-        html += "<p style='color:red;'>❌ Erreur: Ce n'est pas un répertoire</p>";
-    } else {
-        html += "<table>";
-        html += "<tr><th>📄 Nom</th><th>📏 Taille</th><th>⬇️ Action</th></tr>";
+ * A chunk is only read when the client socket can take it, and sent
+ * without waiting (sendNow()): whatever the socket does not take is sent
+ * in a later round. A slow client never holds up the other transfers or
+ * the accept of new requests.
+ */
+bool FileServerManager::pumpTransfers() {
+    bool progressed = false;
+    unsigned long now = millis();
+    
+    for (Transfer& transfer : transfers_) {
+        if (!transfer.active) continue;
         
-        File file = dir.openNextFile();
-        while (file) {
-            String fileName = file.name();
-            String fullPath = path;
-            if (!fullPath.endsWith("/")) fullPath += "/";
-            fullPath += fileName;
-            
-            html += "<tr>";
-            html += "<td>";
-            if (file.isDirectory()) {
-                html += "📂 " + fileName;
-            } else {
-                html += "📄 " + fileName;
+        if (!transfer.client.connected()) {
+            finishTransfer(transfer, false);
+            continue;
+        }
+        if (!socketWritable(transfer.client.fd())) {
+            if (now - transfer.lastProgressMs > STALL_TIMEOUT_MS) {
+                finishTransfer(transfer, false);
             }
-            html += "</td>";
-            html += "<td>";
-            if (!file.isDirectory()) {
-                html += String(file.size()) + " bytes";
-            } else {
-                html += "-";
+            continue;
+        }
+        
+        size_t written;
+        if (transfer.pendingSent < transfer.pending.length()) {
+            // Multipart: part header or closing boundary
+            const char* text = transfer.pending.c_str() + transfer.pendingSent;
+            size_t length = transfer.pending.length() - transfer.pendingSent;
+            int sent = sendNow(transfer.client, (const uint8_t*)text, length);
+            if (sent < 0) {
+                finishTransfer(transfer, false);
+                continue;
             }
-            html += "</td>";
-            html += "<td>";
-            if (file.isDirectory()) {
-                html += "<a href='/list?dir=" + fullPath + "'>📂 Ouvrir</a>";
-            } else {
-                html += "<a href='/download?file=" + fullPath + "'>⬇️ Télécharger</a>";
+            if (sent == 0) continue;  // Buffer full after all: next round
+            written = sent;
+            transfer.pendingSent += written;
+        } else if (transfer.zip) {
+            if (!pumpZip(transfer, written)) {
+                finishTransfer(transfer, false);
+                continue;
+            }
+        } else if (transfer.gzip) {
+            if (!pumpGzip(transfer, written)) {
+                finishTransfer(transfer, false);
+                continue;
+            }
+        } else if (transfer.track) {
+            if (!pumpTrack(transfer, written)) {
+                finishTransfer(transfer, false);
+                continue;
+            }
+        } else {
+            size_t length = transfer.rangeRemaining < CHUNK_BYTES ? transfer.rangeRemaining : CHUNK_BYTES;
+            int read = -1;
+            {
+                BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+                if (!lock.isLocked()) continue;  // Bus busy: next round
+                const ByteRange& range = transfer.ranges[transfer.rangeIndex - 1];
+                if (!transfer.seekPending || transfer.file.seek(range.start + range.length - transfer.rangeRemaining)) {
+                    transfer.seekPending = false;
+                    read = transfer.file.read(chunk_, length);
+                }
+            }
+            if (read <= 0) {
+                finishTransfer(transfer, false);
+                continue;
             }
-            html += "</td>";
-            html += "</tr>";
             
-            file = dir.openNextFile();
+            int sent = sendNow(transfer.client, chunk_, read);
+            if (sent < 0) {
+                finishTransfer(transfer, false);
+                continue;
+            }
+            // Part of the chunk left in the buffer: read again from the first byte not sent
+            if (sent < read) transfer.seekPending = true;
+            if (sent == 0) continue;
+            written = sent;
+            transfer.rangeRemaining -= written;
+        }
+        transfer.sent += written;
+        transfer.lastProgressMs = now;
+        progressed = true;
+        
+        if (transfer.zip) {
+            if (transfer.zip->phase == ZIP_DONE && transfer.zip->headSent == transfer.zip->headLen) {
+                finishTransfer(transfer, true);
+            }
+        } else if (transfer.gzip) {
+            if (transfer.gzip->finished && transfer.gzip->outSent == transfer.gzip->outLen) {
+                finishTransfer(transfer, true);
+            }
+        } else if (transfer.track) {
+            if (transfer.track->phase == TRACK_DONE && transfer.track->outSent == transfer.track->outLen) {
+                finishTransfer(transfer, true);
+            }
+        } else if (transfer.rangeRemaining == 0 && transfer.pendingSent == transfer.pending.length() &&
+                   !startRange(transfer)) {
+            // Range and its header sent, no next range nor closing boundary
+            finishTransfer(transfer, true);
         }
-        html += "</table>";
     }
-    dir.close();
-    
-    html += "</body></html>";
-    webServer_->send(200, "text/html", html);
+    return progressed;
 }
 
 /**
- * @brief Handle HTTP requests to /download for file downloads
- * 
- * Serves individual files from the SD card with proper MIME types.
- * Features include:
- * - MIME type detection based on file extension
- * - Streaming for large files
- * - Error handling for missing or invalid files
- * - Directory protection (prevents downloading directories)
+ * @brief Queue the next part of a transfer body
+ * @return false when the whole body was sent
  * 
- * Supported MIME types:
- * - .json → application/json
- * - .txt → text/plain  
- * - .csv → text/csv
- * - others → application/octet-stream
+ * The file position is set by the next read (seekPending), in the same
+ * bus slot.
+ */
+bool FileServerManager::startRange(Transfer& transfer) {
+    transfer.pending = String();
+    transfer.pendingSent = 0;
+    if (transfer.rangeIndex < transfer.rangeCount) {
+        if (transfer.multipart) {
+            transfer.pending = partHeader(transfer, transfer.rangeIndex);
+        }
+        transfer.rangeRemaining = transfer.ranges[transfer.rangeIndex].length;
+        transfer.seekPending = true;
+        transfer.rangeIndex++;
+        return true;
+    }
+    if (transfer.multipart && !transfer.closed) {
+        transfer.pending = closingBoundary();
+        transfer.closed = true;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief One step of a gzip body: send compressed bytes, or read and compress
+ * @param written Receives the bytes sent (0 after a compression step)
+ * @return false on a read, compression or socket error
  * 
- * Query parameter: ?file=/path/to/file
+ * A step never reads more than CHUNK_BYTES of the file nor produces more
+ * than CHUNK_BYTES of output, so a gzip download shares the server task
+ * with the others like a plain one.
  */
-void FileServerManager::handleFileDownload() {
-    String filename = webServer_->arg("file");
-    if (filename == "") {
-        webServer_->send(400, "text/plain", "Missing 'file' parameter");
-        return;
+bool FileServerManager::pumpGzip(Transfer& transfer, size_t& written) {
+    GzipStream& gz = *transfer.gzip;
+    written = 0;
+    if (gz.outSent < gz.outLen) {
+        int sent = sendNow(transfer.client, gz.out + gz.outSent, gz.outLen - gz.outSent);
+        if (sent < 0) return false;
+        written = sent;
+        gz.outSent += written;
+        gz.outputBytes += written;
+        return true;
     }
-    
-    File file = SD.open(filename);
-    if (!file) {
-        webServer_->send(404, "text/plain", "File not found");
-        return;
+    if (gz.finished) {
+        return true;
     }
     
-    if (file.isDirectory()) {
-        webServer_->send(400, "text/plain", "Cannot download a directory");
-        file.close();
-        return;
+    if (gz.inPos == gz.inLen && transfer.rangeRemaining > 0) {
+        size_t length = transfer.rangeRemaining < CHUNK_BYTES ? transfer.rangeRemaining : CHUNK_BYTES;
+        int read;
+        {
+            BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+            if (!lock.isLocked()) return true;  // Bus busy: next round
+            read = transfer.file.read(gz.in, length);
+        }
+        if (read <= 0) {
+            return false;
+        }
+        gz.crc = crc32_le(gz.crc, gz.in, read);
+        gz.inputBytes += read;
+        gz.inLen = read;
+        gz.inPos = 0;
+        transfer.rangeRemaining -= read;
     }
     
-    String contentType = "application/octet-stream";
-    if (filename.endsWith(".json")) {
-        contentType = "application/json";
-    } else if (filename.endsWith(".txt")) {
-        contentType = "text/plain";
-    } else if (filename.endsWith(".csv")) {
-        contentType = "text/csv";
+    size_t inSize = gz.inLen - gz.inPos;
+    size_t outSize = CHUNK_BYTES;
+    tdefl_flush flush = transfer.rangeRemaining == 0 ? TDEFL_FINISH : TDEFL_NO_FLUSH;
+    unsigned long start = micros();
+    tdefl_status status = tdefl_compress(&gz.compressor, gz.in + gz.inPos, &inSize, gz.out, &outSize, flush);
+    gz.micros += micros() - start;
+    if (status < TDEFL_STATUS_OKAY) {
+        return false;
     }
+    gz.inPos += inSize;
+    gz.outLen = outSize;
+    gz.outSent = 0;
     
-    webServer_->streamFile(file, contentType);
-    file.close();
-    
-    log("File downloaded: " + filename);
+    if (status == TDEFL_STATUS_DONE) {
+        if (!transfer.zip) {
+            // Trailer: CRC-32 and length of the file, little endian
+            uint32_t trailer[2] = {gz.crc, gz.inputBytes};
+            memcpy(gz.out + gz.outLen, trailer, GZIP_TRAILER_BYTES);
+            gz.outLen += GZIP_TRAILER_BYTES;
+        }
+        gz.finished = true;
+    }
+    return true;
 }
 
 /**
- * @brief Handle HTTP 404 errors for invalid URLs
+ * @brief One step of a ZIP body: a record, a file chunk or the next entry
+ * @param written Receives the bytes sent (0 for a step that only prepares)
+ * @return false on a read, compression or socket error
  * 
- * Serves a styled 404 error page when clients request non-existent URLs.
- * Features include:
- * - User-friendly error message
- * - Navigation link back to home page
- * - Consistent styling with the main interface
- * - UTF-8 character encoding support
+ * Records (local header, data descriptor, central directory, end) are
+ * staged in the archive and sent before anything else, so one step never
+ * sends more than a record or CHUNK_BYTES of file data.
  */
-void FileServerManager::handleNotFound() {
-    String html = "<!DOCTYPE html><html><head>";
-    html += "<title>404 - Page Not Found</title>";
-    html += "<meta charset='UTF-8'>";
-    html += "</head><body>";
-    html += "<h1>❌ 404 - Page Not Found</h1>";
-    html += "<p>The requested page does not exist.</p>";
-    html += "<p><a href='/'>🏠 Return to Home</a></p>";
-    html += "</body></html>";
+bool FileServerManager::pumpZip(Transfer& transfer, size_t& written) {
+    ZipArchive& zip = *transfer.zip;
+    written = 0;
+    if (zip.headSent < zip.headLen) {
+        int sent = sendNow(transfer.client, zip.head + zip.headSent, zip.headLen - zip.headSent);
+        if (sent < 0) return false;
+        written = sent;
+        zip.headSent += written;
+        zip.offset += written;
+        return true;
+    }
+    
+    switch (zip.phase) {
+    case ZIP_ENTRY_START:
+        return startZipEntry(transfer);
+    case ZIP_ENTRY_DATA:
+        return pumpZipData(transfer, written);
+    case ZIP_CENTRAL:
+        break;
+    case ZIP_DONE:
+        return true;
+    }
     
-    webServer_->send(404, "text/html", html);
+    uint8_t* out = zip.head;
+    if (zip.index == zip.count) {
+        put32(out, ZIP_END_SIGNATURE);
+        put16(out + 4, 0);                      // This disk
+        put16(out + 6, 0);                      // Disk of the central directory
+        put16(out + 8, zip.count);
+        put16(out + 10, zip.count);
+        put32(out + 12, zip.offset - zip.centralStart);
+        put32(out + 16, zip.centralStart);
+        put16(out + 20, 0);                     // No comment
+        zip.headLen = ZIP_END_BYTES;
+        zip.phase = ZIP_DONE;
+    } else {
+        const ZipArchive::Entry& entry = zip.entries[zip.index++];
+        size_t nameLength = strlen(entry.name);
+        uint16_t time, date;
+        dosDateTime(entry.mtime, time, date);
+        put32(out, ZIP_CENTRAL_SIGNATURE);
+        put16(out + 4, ZIP_VERSION);            // Made by (MS-DOS attributes)
+        put16(out + 6, ZIP_VERSION);            // Needed
+        put16(out + 8, ZIP_FLAGS);
+        put16(out + 10, entry.deflate ? 8 : 0);
+        put16(out + 12, time);
+        put16(out + 14, date);
+        put32(out + 16, entry.crc);
+        put32(out + 20, entry.compressedSize);
+        put32(out + 24, entry.size);
+        put16(out + 28, nameLength);
+        memset(out + 30, 0, 12);                // Extra, comment, disk, attributes
+        put32(out + 42, entry.offset);
+        memcpy(out + ZIP_CENTRAL_BYTES, entry.name, nameLength);
+        zip.headLen = ZIP_CENTRAL_BYTES + nameLength;
+    }
+    zip.headSent = 0;
+    return true;
 }
 
 /**
- * @brief Load WiFi configuration from SD card
- * @return true if configuration loads successfully, false otherwise
- * 
- * Reads WiFi credentials from /wifi_config.json on the SD card.
- * The JSON file must contain "ssid" and "password" fields.
- * 
- * Expected file format:
- * {
- *   "ssid": "NetworkName",
- *   "password": "NetworkPassword"
- * }
+ * @brief Open the next file of the archive and stage its local header
  * 
- * The loaded configuration is stored in the wifiConfig_ member
- * and marked as valid for subsequent connection attempts.
+ * After the last file, the central directory starts. CRC and sizes are 0
+ * in the local header (flag bit 3): they follow the data, in the data
+ * descriptor.
  */
-bool FileServerManager::loadWiFiConfig() {
-    log("Loading WiFi configuration...");
-    
-    if (!SD.exists("/wifi_config.json")) {
-        log("Warning: wifi_config.json file not found on SD card");
-        log("Using hardcoded WiFi credentials as fallback");
-        
-        // Fallback avec des credentials par défaut
-        // TODO: Remplacer par vos vraies credentials WiFi
-        wifiConfig_.ssid = "iPhone de Philippe";  // Remplacez par votre WiFi
-        wifiConfig_.password = "motdepassewifi";  // Remplacez par votre mot de passe
-        wifiConfig_.isValid = true;
-        
-        log("Using fallback WiFi configuration: SSID=" + wifiConfig_.ssid);
+bool FileServerManager::startZipEntry(Transfer& transfer) {
+    ZipArchive& zip = *transfer.zip;
+    if (zip.index == zip.count) {
+        zip.centralStart = zip.offset;
+        zip.index = 0;
+        zip.phase = ZIP_CENTRAL;
         return true;
     }
     
-    File configFile = SD.open("/wifi_config.json", FILE_READ);
-    if (!configFile) {
-        log("Error: Unable to open wifi_config.json");
-        return false;
+    ZipArchive::Entry& entry = zip.entries[zip.index];
+    String path = listPath(zip.dir, entry.name);
+    {
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (!lock.isLocked()) return true;  // Bus busy: next round
+        transfer.file = SD.open(path, FILE_READ);
     }
-    
-    String content = configFile.readString();
-    configFile.close();
-    
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, content);
-    
-    if (error) {
-        log("Error: Invalid JSON in wifi_config.json");
+    if (!transfer.file) {
+        log("ZIP: unable to open " + path);
         return false;
     }
+    entry.offset = zip.offset;
+    entry.crc = 0;
+    entry.compressedSize = 0;
+    transfer.rangeRemaining = entry.size;  // Size when listed: bytes written since are left out
+    transfer.seekPending = false;
     
-    if (!doc["ssid"].is<String>() || !doc["password"].is<String>()) {
-        log("Error: Missing ssid or password keys in wifi_config.json");
-        return false;
+    if (entry.deflate) {
+        GzipStream& gz = *transfer.gzip;
+        tdefl_init(&gz.compressor, nullptr, nullptr, GZIP_PROBES | TDEFL_GREEDY_PARSING_FLAG);
+        gz.finished = false;
+        gz.crc = 0;
+        gz.inputBytes = gz.outputBytes = 0;
+        gz.inLen = gz.inPos = 0;
+        gz.outLen = gz.outSent = 0;
     }
     
-    wifiConfig_.ssid = doc["ssid"].as<String>();
-    wifiConfig_.password = doc["password"].as<String>();
-    wifiConfig_.isValid = true;
-    
-    log("WiFi configuration loaded: SSID=" + wifiConfig_.ssid);
+    uint8_t* out = zip.head;
+    size_t nameLength = strlen(entry.name);
+    uint16_t time, date;
+    dosDateTime(entry.mtime, time, date);
+    put32(out, ZIP_LOCAL_SIGNATURE);
+    put16(out + 4, ZIP_VERSION);
+    put16(out + 6, ZIP_FLAGS);
+    put16(out + 8, entry.deflate ? 8 : 0);
+    put16(out + 10, time);
+    put16(out + 12, date);
+    memset(out + 14, 0, 12);                    // CRC and sizes: in the data descriptor
+    put16(out + 26, nameLength);
+    put16(out + 28, 0);                         // No extra field
+    memcpy(out + ZIP_LOCAL_BYTES, entry.name, nameLength);
+    zip.headLen = ZIP_LOCAL_BYTES + nameLength;
+    zip.headSent = 0;
+    zip.phase = ZIP_ENTRY_DATA;
     return true;
 }
 
 /**
- * @brief Connect to WiFi network using loaded configuration
- * @return true if connection succeeds, false otherwise
- * 
- * Establishes WiFi connection using credentials from wifiConfig_.
- * If configuration is not loaded, attempts to load it first.
- * 
- * Connection process:
- * 1. Load WiFi config if not already loaded
- * 2. Set WiFi mode to Station (WIFI_STA)
- * 3. Begin connection with stored credentials
- * 4. Wait up to 10 seconds for connection (20 × 500ms attempts)
- * 5. Verify and log connection status
- * 
- * Note: This switches from ESPNow to WiFi mode.
+ * @brief Send file data of the current entry; stage its data descriptor at the end
  */
-bool FileServerManager::connectToWiFi() {
-    if (!wifiConfig_.isValid) {
-        if (!loadWiFiConfig()) {
-            return false;
+bool FileServerManager::pumpZipData(Transfer& transfer, size_t& written) {
+    ZipArchive& zip = *transfer.zip;
+    ZipArchive::Entry& entry = zip.entries[zip.index];
+    written = 0;
+    
+    if (entry.deflate) {
+        GzipStream& gz = *transfer.gzip;
+        if (!gz.finished || gz.outSent < gz.outLen) {
+            if (!pumpGzip(transfer, written)) return false;
+            zip.offset += written;
+            if (!gz.finished || gz.outSent < gz.outLen) return true;
+        }
+        entry.crc = gz.crc;
+        entry.compressedSize = gz.outputBytes;
+    } else if (transfer.rangeRemaining > 0) {
+        size_t length = transfer.rangeRemaining < CHUNK_BYTES ? transfer.rangeRemaining : CHUNK_BYTES;
+        int read;
+        {
+            BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+            if (!lock.isLocked()) return true;  // Bus busy: next round
+            read = -1;
+            if (!transfer.seekPending || transfer.file.seek(entry.size - transfer.rangeRemaining)) {
+                transfer.seekPending = false;
+                read = transfer.file.read(chunk_, length);
+            }
         }
+        if (read <= 0) return false;
+        int sent = sendNow(transfer.client, chunk_, read);
+        if (sent < 0) return false;
+        // Bytes not taken by the socket are read again next round
+        if (sent < read) transfer.seekPending = true;
+        written = sent;
+        entry.crc = crc32_le(entry.crc, chunk_, written);
+        transfer.rangeRemaining -= written;
+        entry.compressedSize += written;
+        zip.offset += written;
+        if (transfer.rangeRemaining > 0) return true;
     }
     
-    log("Connecting to WiFi: " + wifiConfig_.ssid);
-    
-    // Stop ESPNow if active and switch to WiFi mode
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(wifiConfig_.ssid.c_str(), wifiConfig_.password.c_str());
-    
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-        delay(500);
-        attempts++;
+    closeFile(transfer.file);
+    zip.inputBytes += entry.size;
+    uint8_t* out = zip.head;
+    put32(out, ZIP_DESCRIPTOR_SIGNATURE);
+    put32(out + 4, entry.crc);
+    put32(out + 8, entry.compressedSize);
+    put32(out + 12, entry.size);
+    zip.headLen = ZIP_DESCRIPTOR_BYTES;
+    zip.headSent = 0;
+    zip.index++;
+    zip.phase = ZIP_ENTRY_START;
+    return true;
+}
+
+/**
+ * @brief The archive table, allocated in PSRAM on first use
+ * @return nullptr if an archive is being sent or memory is short
+ */
+FileServerManager::ZipArchive* FileServerManager::acquireZip() {
+    if (!zip_) {
+        zip_ = static_cast<ZipArchive*>(largeMalloc(sizeof(ZipArchive)));
+        if (!zip_) {
+            log("Warning: no memory for a ZIP archive table");
+            return nullptr;
+        }
+        zip_->inUse = false;
     }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        wifiConnected_ = true;
-        log("WiFi connected! IP: " + WiFi.localIP().toString());
-        return true;
-    } else {
-        log("Error: Unable to connect to WiFi");
-        wifiConnected_ = false;
-        return false;
+    if (zip_->inUse) {
+        return nullptr;
     }
+    zip_->inUse = true;
+    return zip_;
 }
 
 /**
- * @brief Disconnect from WiFi and disable WiFi mode
- * 
- * Cleanly disconnects from the current WiFi network and disables
- * WiFi functionality to allow return to ESPNow mode.
- * 
- * Disconnection process:
- * 1. Check if currently connected to WiFi
- * 2. Call WiFi.disconnect() to end network connection
- * 3. Set WiFi mode to OFF to disable radio
- * 4. Update connection status flag
- * 5. Log disconnection status
- * 
- * After this call, the system can return to ESPNow operation.
+ * @brief Free compressor, allocated in PSRAM on first use
+ * @return nullptr if GZIP_STREAMS downloads are compressing or memory is short
  */
-void FileServerManager::disconnectWiFi() {
-    if (wifiConnected_) {
-        log("Disconnecting WiFi...");
-        WiFi.disconnect();
-        WiFi.mode(WIFI_OFF);
-        wifiConnected_ = false;
-        log("WiFi disconnected");
+FileServerManager::GzipStream* FileServerManager::acquireGzip() {
+    for (GzipStream*& stream : gzipStreams_) {
+        if (!stream) {
+            stream = static_cast<GzipStream*>(largeMalloc(sizeof(GzipStream)));
+            if (!stream) {
+                log("Warning: no memory for a gzip compressor, file sent uncompressed");
+                return nullptr;
+            }
+            stream->inUse = false;
+        }
+        if (!stream->inUse) {
+            stream->inUse = true;
+            return stream;
+        }
     }
-}
\ No newline at end of file
+    return nullptr;
+}
+
+/**
+ * @brief Start a gzip body in a transfer slot
+ * 
+ * The length is only known once compressed: the response has no
+ * Content-Length and ends when the connection closes (the gzip trailer
+ * lets the client check that it got everything). Its headers are written
+ * by the server task, before the body, instead of WebServer::send().
+ */
+void FileServerManager::queueGzipTransfer(Transfer& transfer, File& file, const char* contentType,
+                                          const String& etag, GzipStream* stream) {
+    transfer.file = file;
+    transfer.status = 200;
+    transfer.fileSize = file.size();
+    transfer.rangeCount = 0;
+    transfer.rangeIndex = 0;
+    transfer.rangeRemaining = transfer.fileSize;
+    transfer.seekPending = false;
+    transfer.multipart = false;
+    transfer.closed = false;
+    transfer.contentType = contentType;
+    transfer.pending = String("HTTP/1.1 200 OK\r\nContent-Type: ") + contentType +
+                       "\r\nContent-Encoding: gzip\r\nVary: Accept-Encoding\r\nETag: " + etag +
+                       "\r\nConnection: close\r\n\r\n";
+    transfer.pendingSent = 0;
+    transfer.sent = 0;
+    transfer.gzip = stream;
+    transfer.zip = nullptr;
+    transfer.track = nullptr;
+    
+    GzipStream& gz = *stream;
+    tdefl_init(&gz.compressor, nullptr, nullptr, GZIP_PROBES | TDEFL_GREEDY_PARSING_FLAG);
+    gz.finished = false;
+    gz.crc = 0;
+    gz.inputBytes = gz.outputBytes = gz.micros = 0;
+    gz.inLen = gz.inPos = 0;
+    static const uint8_t header[GZIP_HEADER_BYTES] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};  // Deflate, no name
+    memcpy(gz.out, header, GZIP_HEADER_BYTES);
+    gz.outLen = GZIP_HEADER_BYTES;
+    gz.outSent = 0;
+}
+
+/**
+ * @brief Hand a prepared transfer to the server task
+ */
+void FileServerManager::queueTransfer(Transfer& transfer, const String& label) {
+    transfer.active = true;
+    transfer.client = webServer_->client();
+    webServer_->detachClient();
+    transfer.label = label;
+    transfer.startMs = requestStart_;
+    transfer.lastProgressMs = millis();
+    transferQueued_ = true;
+    
+    if (statsMutex_) xSemaphoreTake(statsMutex_, portMAX_DELAY);
+    stats_.activeTransfers++;
+    if (stats_.activeTransfers > stats_.peakTransfers) stats_.peakTransfers = stats_.activeTransfers;
+    if (statsMutex_) xSemaphoreGive(statsMutex_);
+}
+
+/**
+ * @brief Close a transfer and record its timing
+ * @param complete false if the body was cut short (client gone, stall, read error)
+ */
+void FileServerManager::finishTransfer(Transfer& transfer, bool complete) {
+    closeFile(transfer.file);
+    transfer.client.stop();
+    transfer.active = false;
+    unsigned long durationMs = millis() - transfer.startMs;
+    
+    String label = transfer.label;
+    GzipStream* gz = transfer.gzip;
+    ZipArchive* zip = transfer.zip;
+    TrackScan* track = transfer.track;
+    if (track) {
+        char detail[96];
+        snprintf(detail, sizeof(detail), ", %d points from %lu lines, %lu of %lu bytes read", track->points,
+                 (unsigned long)track->lines, (unsigned long)track->bytesRead, (unsigned long)transfer.fileSize);
+        label += detail;
+    } else if (zip) {
+        char detail[64];
+        snprintf(detail, sizeof(detail), ", zip of %d files, %lu KB archived", zip->count,
+                 (unsigned long)(zip->inputBytes / 1024));
+        label += detail;
+    } else if (gz && gz->inputBytes > 0) {
+        char detail[96];
+        snprintf(detail, sizeof(detail), ", gzip %lu -> %lu KB (x%.1f), compression %lu KB/s",
+                 (unsigned long)(gz->inputBytes / 1024), (unsigned long)(gz->outputBytes / 1024),
+                 gz->outputBytes > 0 ? (float)gz->inputBytes / gz->outputBytes : 0.0f,
+                 (unsigned long)(gz->micros > 0 ? (uint64_t)gz->inputBytes * 1000 / gz->micros : 0));
+        label += detail;
+    }
+    
+    if (statsMutex_) xSemaphoreTake(statsMutex_, portMAX_DELAY);
+    stats_.activeTransfers--;
+    if (complete && zip) {
+        stats_.zipArchives++;
+        stats_.zipFiles += zip->count;
+        stats_.zipInputBytes += zip->inputBytes;
+        stats_.zipOutputBytes += zip->offset;
+    } else if (complete && gz) {
+        stats_.gzipDownloads++;
+        stats_.gzipInputBytes += gz->inputBytes;
+        stats_.gzipOutputBytes += gz->outputBytes;
+        stats_.gzipMicros += gz->micros;
+        stats_.gzipMs += durationMs;
+    } else if (complete && transfer.status == 200) {
+        stats_.plainDownloads++;
+        stats_.plainBytes += transfer.sent;
+        stats_.plainMs += durationMs;
+    }
+    if (statsMutex_) xSemaphoreGive(statsMutex_);
+    
+    if (gz) {
+        gz->inUse = false;
+        transfer.gzip = nullptr;
+    }
+    if (zip) {
+        zip->inUse = false;
+        transfer.zip = nullptr;
+    }
+    if (track) {
+        track->inUse = false;
+        transfer.track = nullptr;
+    }
+    
+    recordRequest(label + (complete ? "" : " (interrompu)"), complete ? transfer.status : 499,
+                  transfer.sent, durationMs);
+    transfer.label = String();
+    transfer.pending = String();
+}
+
+/**
+ * @brief Abort every transfer and live stream in progress (server stopping)
+ */
+void FileServerManager::abortTransfers() {
+    for (Transfer& transfer : transfers_) {
+        if (transfer.active) finishTransfer(transfer, false);
+    }
+    for (LiveClient& live : liveClients_) {
+        if (live.active) finishLive(live, false);
+    }
+}
+
+/**
+ * @brief Send each live stream its batch when due
+ * @return true if at least one stream wrote something
+ * 
+ * A batch is collected when the period of the client is due (or at once
+ * if the previous one stopped on a full buffer) and written as the socket
+ * takes it. While a batch is unsent, due periods are skipped: the states
+ * keep being replaced in the telemetry table, and the next batch carries
+ * only the latest one of each device.
+ */
+bool FileServerManager::pumpLive() {
+    bool progressed = false;
+    unsigned long now = millis();
+    
+    for (LiveClient& live : liveClients_) {
+        if (!live.active) continue;
+        
+        if (!live.client.connected()) {
+            finishLive(live, true);  // Closed by the client: normal end of a stream
+            continue;
+        }
+        
+        bool due = (long)(now - live.nextMs) >= 0;
+        if (live.written < live.length) {
+            if (due) {
+                live.nextMs = now + live.periodMs;
+                if (statsMutex_) xSemaphoreTake(statsMutex_, portMAX_DELAY);
+                stats_.liveSkipped++;
+                if (statsMutex_) xSemaphoreGive(statsMutex_);
+            }
+        } else if (due || live.cursor.more) {
+            if (due) live.nextMs = now + live.periodMs;
+            uint32_t records;
+            live.length = telemetry_->collect(live.cursor, live.format, live.buffer, LIVE_BUFFER_BYTES, records);
+            if (live.length == 0 && now - live.lastSendMs >= LIVE_KEEPALIVE_MS) {
+                live.length = LiveTelemetry::keepAlive(live.format, live.buffer);
+            }
+            live.written = 0;
+            live.lastProgressMs = now;
+            if (records > 0) {
+                live.records += records;
+                if (statsMutex_) xSemaphoreTake(statsMutex_, portMAX_DELAY);
+                stats_.liveRecords += records;
+                if (statsMutex_) xSemaphoreGive(statsMutex_);
+            }
+        }
+        if (live.written == live.length) continue;
+        
+        if (!socketWritable(live.client.fd())) {
+            if (now - live.lastProgressMs > STALL_TIMEOUT_MS) {
+                finishLive(live, false);
+            }
+            continue;
+        }
+        int sent = sendNow(live.client, (const uint8_t*)live.buffer + live.written, live.length - live.written);
+        if (sent < 0) {
+            finishLive(live, false);
+            continue;
+        }
+        if (sent == 0) continue;
+        live.written += sent;
+        live.sent += sent;
+        live.lastProgressMs = live.lastSendMs = now;
+        progressed = true;
+    }
+    return progressed;
+}
+
+/**
+ * @brief Close a live stream and record it as one request
+ * @param complete false if the stream stalled or the server is stopping
+ */
+void FileServerManager::finishLive(LiveClient& live, bool complete) {
+    live.client.stop();
+    live.active = false;
+    live.length = live.written = 0;
+    
+    if (statsMutex_) xSemaphoreTake(statsMutex_, portMAX_DELAY);
+    stats_.liveClients--;
+    if (statsMutex_) xSemaphoreGive(statsMutex_);
+    
+    String label = String("GET /api/live (") + (live.format == TELEMETRY_BINARY ? "bin" : "sse") + ", " +
+                   String((unsigned long)live.records) + " états)";
+    recordRequest(label + (complete ? "" : " (interrompu)"), complete ? 200 : 499, live.sent,
+                  millis() - live.startMs);
+}
+
+int FileServerManager::freeTransferSlot() const {
+    for (int i = 0; i < MAX_TRANSFERS; i++) {
+        if (!transfers_[i].active) return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Run a request handler and record its status, size and duration
+ * 
+ * Downloads are recorded when their transfer ends instead.
+ */
+void FileServerManager::timedHandler(void (FileServerManager::*handler)()) {
+    requestStart_ = millis();
+    responseStatus_ = 0;
+    responseBytes_ = 0;
+    transferQueued_ = false;
+    
+    (this->*handler)();
+    
+    if (!transferQueued_) {
+        HTTPMethod method = webServer_->method();
+        String label = String(method == HTTP_GET ? "GET " : method == HTTP_HEAD ? "HEAD " : "REQ ") + webServer_->uri();
+        recordRequest(label, responseStatus_, responseBytes_, millis() - requestStart_);
+    }
+}
+
+void FileServerManager::recordRequest(const String& label, int status, size_t bytes, unsigned long durationMs) {
+    if (statsMutex_) xSemaphoreTake(statsMutex_, portMAX_DELAY);
+    stats_.requests++;
+    if (status >= 400) stats_.errors++;
+    if (status == 503) stats_.rejected++;
+    stats_.bytesSent += bytes;
+    stats_.totalDurationMs += durationMs;
+    if (durationMs > stats_.maxDurationMs) stats_.maxDurationMs = durationMs;
+    if (statsMutex_) xSemaphoreGive(statsMutex_);
+    
+    unsigned long rate = durationMs > 0 ? (unsigned long)(bytes / durationMs) : 0;  // bytes/ms = KB/s
+    log("HTTP " + label + " -> " + String(status) + ", " + String((unsigned long)bytes) + " bytes in " +
+        String(durationMs) + " ms (" + String(rate) + " KB/s)");
+}
+
+/**
+ * @brief Send a complete response and remember its status for the request log
+ */
+void FileServerManager::reply(int code, const char* contentType, const String& content) {
+    responseStatus_ = code;
+    responseBytes_ = content.length();
+    webServer_->send(code, contentType, content);
+}
+
+void FileServerManager::reply(int code, const char* contentType, const char* content, size_t length) {
+    responseStatus_ = code;
+    responseBytes_ = length;
+    webServer_->send_P(code, contentType, content, length);
+}
+
+/**
+ * @brief Copy of the request counters and timings
+ */
+HttpServerStats FileServerManager::stats() const {
+    HttpServerStats copy;
+    if (statsMutex_) xSemaphoreTake(statsMutex_, portMAX_DELAY);
+    copy = stats_;
+    if (statsMutex_) xSemaphoreGive(statsMutex_);
+    return copy;
+}
+
+/**
+ * @brief One-line summary of the requests served
+ */
+String FileServerManager::describe() const {
+    HttpServerStats s = stats();
+    char line[200];
+    snprintf(line, sizeof(line),
+             "HTTP: %s, %lu requêtes (%lu erreurs, %lu refusées), %llu octets envoyés, durée moy %lu ms max %lu ms, "
+             "%u téléchargement(s) en cours (max %u)",
+             serverActive_ ? "actif" : "arrêté", (unsigned long)s.requests, (unsigned long)s.errors,
+             (unsigned long)s.rejected, (unsigned long long)s.bytesSent,
+             (unsigned long)(s.requests > 0 ? s.totalDurationMs / s.requests : 0), (unsigned long)s.maxDurationMs,
+             s.activeTransfers, s.peakTransfers);
+    String text(line);
+    
+    // Useful throughput: file bytes delivered per second, with and without gzip
+    if (s.gzipDownloads > 0) {
+        snprintf(line, sizeof(line),
+                 "; gzip: %lu fichier(s), x%.1f, compression %lu KB/s, débit utile %lu KB/s",
+                 (unsigned long)s.gzipDownloads,
+                 s.gzipOutputBytes > 0 ? (float)s.gzipInputBytes / s.gzipOutputBytes : 0.0f,
+                 (unsigned long)(s.gzipMicros > 0 ? s.gzipInputBytes * 1000 / s.gzipMicros : 0),
+                 (unsigned long)(s.gzipMs > 0 ? s.gzipInputBytes / s.gzipMs : 0));
+        text += line;
+        if (s.plainDownloads > 0 && s.plainMs > 0) {
+            snprintf(line, sizeof(line), " (sans gzip %lu KB/s)", (unsigned long)(s.plainBytes / s.plainMs));
+            text += line;
+        }
+    }
+    
+    if (s.zipArchives > 0) {
+        snprintf(line, sizeof(line), "; zip: %lu archive(s), %lu fichiers, %llu -> %llu Ko",
+                 (unsigned long)s.zipArchives, (unsigned long)s.zipFiles,
+                 (unsigned long long)(s.zipInputBytes / 1024), (unsigned long long)(s.zipOutputBytes / 1024));
+        text += line;
+    }
+    
+    if (s.liveClients > 0 || s.liveRecords > 0) {
+        snprintf(line, sizeof(line), "; direct: %u flux, %lu états envoyés, %lu fusionnés, %lu envois reportés",
+                 s.liveClients, (unsigned long)s.liveRecords,
+                 (unsigned long)(telemetry_ ? telemetry_->coalesced() : 0), (unsigned long)s.liveSkipped);
+        text += line;
+    }
+    return text;
+}
+
+/**
+ * @brief Get the server's current IP address
+ * @return IP address as string if connected, "Not connected" otherwise
+ * 
+ * Returns the soft-AP address, or the local IP address assigned by the
+ * WiFi network. This address is used by clients to access the web interface.
+ */
+String FileServerManager::getServerIP() {
+    if (linkMode_ == WIFI_LINK_SOFT_AP) {
+        return WiFi.softAPIP().toString();
+    }
+    if (WiFi.status() == WL_CONNECTED) {
+        return WiFi.localIP().toString();
+    }
+    return "Not connected";
+}
+
+/**
+ * @brief Find the embedded asset served at a URL
+ */
+static const WebAsset* findAsset(const char* url) {
+    for (size_t i = 0; i < kWebAssetCount; i++) {
+        if (strcmp(kWebAssets[i].url, url) == 0) {
+            return &kWebAssets[i];
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Handle HTTP requests for the web UI (/, /list, /app.js, /style.css...)
+ * 
+ * The pages are static: /list is the main page, which reads ?dir=, ?sort=
+ * and ?after= itself and loads the listing from /api/files.
+ */
+void FileServerManager::handleAsset() {
+    String uri = webServer_->uri();
+    const WebAsset* asset = findAsset(uri == "/list" ? "/" : uri.c_str());
+    if (!asset) {
+        handleNotFound();
+        return;
+    }
+    sendAsset(*asset, 200);
+}
+
+/**
+ * @brief Send an embedded asset as it is stored: gzipped, from flash
+ * @param asset Asset of WebAssets.h
+ * @param code HTTP status (200, or 404 for the error page)
+ * 
+ * The body is written from flash to the socket by send_P(): no copy, no
+ * compression on the device. Every browser accepts gzip, so Accept-Encoding
+ * is not checked. Versioned assets are cached for a year; the pages are
+ * revalidated and an unchanged page gets a 304 without a body.
+ */
+void FileServerManager::sendAsset(const WebAsset& asset, int code) {
+    webServer_->sendHeader("Cache-Control", asset.immutable ? "public, max-age=31536000, immutable" : "no-cache");
+    if (code == 200) {
+        webServer_->sendHeader("ETag", asset.etag);
+        if (webServer_->header("If-None-Match") == asset.etag) {
+            reply(304, asset.contentType, "", 0);
+            return;
+        }
+    }
+    webServer_->sendHeader("Content-Encoding", "gzip");
+    if (webServer_->method() == HTTP_HEAD) {
+        webServer_->setContentLength(asset.length);
+        reply(code, asset.contentType, "", 0);
+        return;
+    }
+    reply(code, asset.contentType, reinterpret_cast<const char*>(asset.data), asset.length);
+}
+
+/**
+ * @brief Handle HTTP requests to /api/files (JSON listing for scripts)
+ * 
+ * Same parameters and pages as /list. Response:
+ * {"dir":"/","sort":"date","total":120,"offset":0,
+ *  "files":[{"name":"a.json","path":"/a.json","size":1234,"mtime":1718000000,"dir":false}],
+ *  "next":"1718000000/a.json"}
+ * "next" is null on the last page; pass it back as ?after= for the next one.
+ */
+void FileServerManager::handleFileApi() {
+    ListQuery query;
+    parseListQuery(query);
+    ListPage page;
+    int status = scanDirectory(query, page);
+    if (status == 503) {
+        reply(503, "application/json", "{\"error\":\"SD card busy, retry later\"}");
+        return;
+    }
+    if (status != 200) {
+        reply(404, "application/json", "{\"error\":\"directory not found\"}");
+        return;
+    }
+    
+    beginChunked("application/json");
+    emitf("{\"dir\":\"%s\",\"sort\":\"%s\",\"total\":%d,\"offset\":%d,\"files\":[",
+          jsonEscape(query.dir.c_str()).c_str(), query.byName ? "name" : "date", page.total, page.offset);
+    for (int i = 0; i < page.count; i++) {
+        const ListEntry& entry = listEntries_[i];
+        emitf("%s{\"name\":\"%s\",\"path\":\"%s\",\"size\":%lu,\"mtime\":%lu,\"dir\":%s}", i > 0 ? "," : "",
+              jsonEscape(entry.name).c_str(), jsonEscape(listPath(query.dir, entry.name).c_str()).c_str(),
+              (unsigned long)entry.size, (unsigned long)entry.mtime, entry.isDirectory ? "true" : "false");
+    }
+    if (page.more) {
+        emit("],\"next\":\"" + jsonEscape(cursorOf(listEntries_[page.count - 1]).c_str()) + "\"}");
+    } else {
+        emit("],\"next\":null}");
+    }
+    endChunked();
+}
+
+/**
+ * @brief Read ?dir=, ?sort=, ?limit= and ?after= (cursor "mtime/name")
+ */
+void FileServerManager::parseListQuery(ListQuery& query) {
+    query.dir = webServer_->arg("dir");
+    if (query.dir == "") query.dir = "/";
+    query.byName = webServer_->arg("sort") == "name";
+    query.limit = webServer_->hasArg("limit") ? webServer_->arg("limit").toInt() : LIST_PAGE_DEFAULT;
+    query.limit = constrain(query.limit, 1, LIST_PAGE_MAX);
+    
+    String after = webServer_->arg("after");
+    int slash = after.indexOf('/');
+    query.hasCursor = slash > 0;
+    memset(&query.cursor, 0, sizeof(query.cursor));
+    if (query.hasCursor) {
+        query.cursor.mtime = strtoul(after.substring(0, slash).c_str(), nullptr, 10);
+        strlcpy(query.cursor.name, after.c_str() + slash + 1, LIST_NAME_MAX);
+    }
+}
+
+/**
+ * @brief Order of a listing: newest first (name on ties), or by name
+ * @return < 0 if a comes before b
+ */
+int FileServerManager::compareEntries(const ListEntry& a, const ListEntry& b, bool byName) {
+    if (!byName && a.mtime != b.mtime) {
+        return a.mtime > b.mtime ? -1 : 1;
+    }
+    return strcmp(a.name, b.name);
+}
+
+String FileServerManager::cursorOf(const ListEntry& entry) {
+    return String((unsigned long)entry.mtime) + "/" + entry.name;
+}
+
+String FileServerManager::listPath(const String& dir, const char* name) {
+    String path = dir;
+    if (!path.endsWith("/")) path += "/";
+    return path + name;
+}
+
+/**
+ * @brief One pass over the directory: the page after the cursor, in order
+ * @return 200, 404 if the directory cannot be opened, 503 if a storage
+ *         slot is refused (the page is then incomplete)
+ * 
+ * listEntries_ is kept sorted; an entry is only inserted if it beats the
+ * last one of a full page, so the pass costs LIST_PAGE_MAX entries of
+ * memory whatever the number of files. Each SD access takes its own bus
+ * slot: frames keep flowing during a long listing.
+ */
+int FileServerManager::scanDirectory(const ListQuery& query, ListPage& page) {
+    page.count = page.total = page.offset = 0;
+    page.more = false;
+    
+    File dir;
+    {
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (!lock.isLocked()) return 503;
+        dir = SD.open(query.dir);
+    }
+    if (!dir || !dir.isDirectory()) {
+        closeFile(dir);
+        return 404;
+    }
+    
+    File file;
+    {
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (!lock.isLocked()) {
+            closeFile(dir);
+            return 503;
+        }
+        file = dir.openNextFile();
+    }
+    while (file) {
+        ListEntry candidate;
+        {
+            BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+            if (!lock.isLocked()) {
+                closeFile(file);
+                closeFile(dir);
+                return 503;
+            }
+            // getLastWrite() is a stat() of the path: a card access too
+            strlcpy(candidate.name, file.name(), LIST_NAME_MAX);
+            candidate.isDirectory = file.isDirectory();
+            candidate.size = candidate.isDirectory ? 0 : file.size();
+            candidate.mtime = file.getLastWrite();
+            file.close();
+            file = dir.openNextFile();
+        }
+        
+        page.total++;
+        if (query.hasCursor && compareEntries(candidate, query.cursor, query.byName) <= 0) {
+            page.offset++;  // On a previous page
+            continue;
+        }
+        
+        int position = page.count;
+        while (position > 0 && compareEntries(candidate, listEntries_[position - 1], query.byName) < 0) {
+            position--;
+        }
+        if (position >= query.limit) {
+            page.more = true;  // After the page
+            continue;
+        }
+        if (page.count == query.limit) {
+            page.more = true;  // The last entry moves to the next page
+            page.count--;
+        }
+        memmove(&listEntries_[position + 1], &listEntries_[position], (page.count - position) * sizeof(ListEntry));
+        listEntries_[position] = candidate;
+        page.count++;
+    }
+    closeFile(dir);
+    return 200;
+}
+
+/**
+ * @brief Start a response of unknown length (chunked for HTTP/1.1 clients)
+ */
+void FileServerManager::beginChunked(const char* contentType) {
+    listLength_ = 0;
+    responseStatus_ = 200;
+    responseBytes_ = 0;
+    webServer_->setContentLength(CONTENT_LENGTH_UNKNOWN);
+    webServer_->send(200, contentType, "");
+}
+
+/**
+ * @brief Append text to the response; sent by LIST_BUFFER_BYTES chunks
+ */
+void FileServerManager::emit(const char* text) {
+    emit(reinterpret_cast<const uint8_t*>(text), strlen(text));
+}
+
+void FileServerManager::emit(const uint8_t* data, size_t length) {
+    while (length > 0) {
+        size_t room = LIST_BUFFER_BYTES - listLength_;
+        size_t count = length < room ? length : room;
+        memcpy(listBuffer_ + listLength_, data, count);
+        listLength_ += count;
+        data += count;
+        length -= count;
+        if (listLength_ == LIST_BUFFER_BYTES) {
+            webServer_->sendContent(listBuffer_, listLength_);
+            responseBytes_ += listLength_;
+            listLength_ = 0;
+        }
+    }
+}
+
+void FileServerManager::emitf(const char* format, ...) {
+    char line[384];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    emit(line);
+}
+
+/**
+ * @brief Send what is left and the final empty chunk
+ */
+void FileServerManager::endChunked() {
+    if (listLength_ > 0) {
+        webServer_->sendContent(listBuffer_, listLength_);
+        responseBytes_ += listLength_;
+        listLength_ = 0;
+    }
+    webServer_->sendContent("");
+}
+
+/**
+ * @brief Handle HTTP requests to /download for file downloads
+ * 
+ * Serves individual files from the SD card with proper MIME types.
+ * Features include:
+ * - MIME type detection based on file extension
+ * - Streaming by the server task in bounded chunks (transfer slot),
+ *   several downloads at once; 503 when all slots are busy
+ * - Error handling for missing or invalid files
+ * - Directory protection (prevents downloading directories)
+ * - Strong ETag, 304 for If-None-Match, HEAD (headers only)
+ * - Range: one range (206 + Content-Range) or several
+ *   (multipart/byteranges), honoured only if If-Range matches;
+ *   416 when no range is satisfiable
+ * - gzip Content-Encoding for whole .json/.txt/.csv downloads when the
+ *   client sends Accept-Encoding: gzip (?gzip=0 turns it off)
+ * 
+ * Supported MIME types:
+ * - .json → application/json
+ * - .txt → text/plain  
+ * - .csv → text/csv
+ * - others → application/octet-stream
+ * 
+ * Query parameter: ?file=/path/to/file
+ */
+void FileServerManager::handleFileDownload() {
+    String filename = webServer_->arg("file");
+    if (filename == "") {
+        reply(400, "text/plain", "Missing 'file' parameter");
+        return;
+    }
+    
+    File file;
+    String etag;
+    {
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (!lock.isLocked()) {
+            webServer_->sendHeader("Retry-After", "2");
+            reply(503, "text/plain", "SD card busy, retry later");
+            return;
+        }
+        file = SD.open(filename);
+        if (file && !file.isDirectory()) {
+            etag = makeETag(file);  // getLastWrite() stats the path on the card
+        }
+    }
+    if (!file) {
+        reply(404, "text/plain", "File not found");
+        return;
+    }
+    
+    if (file.isDirectory()) {
+        reply(400, "text/plain", "Cannot download a directory");
+        closeFile(file);
+        return;
+    }
+    
+    const char* contentType = "application/octet-stream";
+    if (filename.endsWith(".json")) {
+        contentType = "application/json";
+    } else if (filename.endsWith(".txt")) {
+        contentType = "text/plain";
+    } else if (filename.endsWith(".csv")) {
+        contentType = "text/csv";
+    }
+    
+    size_t size = file.size();
+    bool head = webServer_->method() == HTTP_HEAD;
+    
+    // gzip: whole text files, if the client accepts it and did not ask for ?gzip=0
+    bool compressible = isCompressible(filename);
+    String range = webServer_->header("Range");
+    bool gzip = compressible && range.length() == 0 && webServer_->arg("gzip") != "0" &&
+                acceptsGzip(webServer_->header("Accept-Encoding"));
+    
+    // Copy still valid: answered from the directory entry only, against the
+    // negotiated representation (another representation, another tag) and
+    // before a compressor is taken
+    String ifNoneMatch = webServer_->header("If-None-Match");
+    auto matches = [&ifNoneMatch](const String& tag) {
+        return ifNoneMatch.length() > 0 && (ifNoneMatch == "*" || ifNoneMatch.indexOf(tag) >= 0);
+    };
+    String identityTag = etag;
+    if (gzip) {
+        etag = etag.substring(0, etag.length() - 1) + "-gz\"";
+    }
+    bool notModified = matches(etag);
+    GzipStream* stream = nullptr;
+    if (gzip && !head && !notModified) {
+        stream = acquireGzip();
+        if (!stream) {
+            // No compressor free: sent as is, under the tag of the raw file
+            gzip = false;
+            etag = identityTag;
+            notModified = matches(etag);
+        }
+    }
+    
+    if (notModified) {
+        closeFile(file);
+        if (compressible) webServer_->sendHeader("Vary", "Accept-Encoding");
+        webServer_->sendHeader("ETag", etag);
+        reply(304, contentType, "");
+        return;
+    }
+    
+    if (stream) {
+        int slot = freeTransferSlot();
+        if (slot < 0) {
+            stream->inUse = false;
+            closeFile(file);
+            webServer_->sendHeader("Retry-After", "2");
+            reply(503, "text/plain", "Too many downloads in progress, retry later");
+            return;
+        }
+        queueGzipTransfer(transfers_[slot], file, contentType, etag, stream);
+        queueTransfer(transfers_[slot], "GET /download " + filename + " (gzip)");
+        return;
+    }
+    
+    if (compressible) webServer_->sendHeader("Vary", "Accept-Encoding");
+    webServer_->sendHeader("ETag", etag);
+    if (gzip) {
+        // HEAD of a gzip response: its length is unknown
+        closeFile(file);
+        webServer_->sendHeader("Content-Encoding", "gzip");
+        webServer_->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        webServer_->send(200, contentType, "");
+        responseStatus_ = 200;
+        return;
+    }
+    webServer_->sendHeader("Accept-Ranges", "bytes");
+    
+    // Range only applies to the version the client already has (If-Range)
+    ByteRange ranges[MAX_RANGES];
+    int rangeCount = 0;
+    String ifRange = webServer_->header("If-Range");
+    if (range.length() > 0 && (ifRange.length() == 0 || ifRange == etag)) {
+        rangeCount = parseRanges(range, size, ranges);
+    }
+    if (rangeCount < 0) {
+        closeFile(file);
+        webServer_->sendHeader("Content-Range", "bytes */" + String((unsigned long)size));
+        reply(416, "text/plain", "Range not satisfiable");
+        return;
+    }
+    
+    int slot = head ? -1 : freeTransferSlot();
+    if (!head && slot < 0) {
+        closeFile(file);
+        webServer_->sendHeader("Retry-After", "2");
+        reply(503, "text/plain", "Too many downloads in progress, retry later");
+        return;
+    }
+    
+    Transfer headOnly;
+    Transfer& transfer = head ? headOnly : transfers_[slot];
+    transfer.file = file;
+    transfer.status = rangeCount > 0 ? 206 : 200;
+    transfer.fileSize = size;
+    if (rangeCount > 0) {
+        memcpy(transfer.ranges, ranges, rangeCount * sizeof(ByteRange));
+        transfer.rangeCount = rangeCount;
+    } else {
+        transfer.ranges[0].start = 0;
+        transfer.ranges[0].length = size;
+        transfer.rangeCount = size > 0 ? 1 : 0;
+    }
+    transfer.rangeIndex = 0;
+    transfer.rangeRemaining = 0;
+    transfer.seekPending = false;
+    transfer.multipart = rangeCount > 1;
+    transfer.closed = false;
+    transfer.contentType = contentType;
+    transfer.pending = String();
+    transfer.pendingSent = 0;
+    transfer.sent = 0;
+    transfer.gzip = nullptr;
+    transfer.zip = nullptr;
+    transfer.track = nullptr;
+    
+    // Headers only; the body is streamed by the server task, chunk by chunk
+    if (transfer.multipart) {
+        size_t length = closingBoundary().length();
+        for (uint8_t i = 0; i < transfer.rangeCount; i++) {
+            length += partHeader(transfer, i).length() + transfer.ranges[i].length;
+        }
+        webServer_->setContentLength(length);
+        webServer_->send(206, String("multipart/byteranges; boundary=") + kRangeBoundary, "");
+    } else {
+        if (rangeCount == 1) {
+            char contentRange[64];
+            snprintf(contentRange, sizeof(contentRange), "bytes %lu-%lu/%lu", (unsigned long)ranges[0].start,
+                     (unsigned long)(ranges[0].start + ranges[0].length - 1), (unsigned long)size);
+            webServer_->sendHeader("Content-Range", contentRange);
+        }
+        webServer_->setContentLength(rangeCount == 1 ? ranges[0].length : size);
+        webServer_->send(transfer.status, contentType, "");
+    }
+    
+    // HEAD, or nothing to send: the headers are the whole response
+    if (head || !startRange(transfer)) {
+        closeFile(transfer.file);
+        responseStatus_ = transfer.status;
+        responseBytes_ = 0;
+        return;
+    }
+    
+    queueTransfer(transfer, "GET /download " + filename + (transfer.status == 206 ? " (partiel)" : ""));
+}
+
+/**
+ * @brief Handle HTTP requests to /zip (files of a directory in one archive)
+ * 
+ * Query parameters:
+ * - dir: directory, /replay by default (its files only, not sub-directories)
+ * - file: name of a file of dir to include; repeat it for a selection
+ *   (without it, every file of dir)
+ * - from, to: modification dates, YYYY-MM-DD (to is inclusive) or Unix time
+ * - deflate=0: store every file (otherwise .json, .txt and .csv are deflated
+ *   when a compressor is free)
+ * 
+ * The file list is taken in one pass over the directory, then the archive
+ * is streamed by the server task. A stored-only archive has a
+ * Content-Length; with deflated entries its end is the end of the
+ * connection.
+ */
+void FileServerManager::handleZip() {
+    String dirPath = webServer_->arg("dir");
+    if (dirPath == "") dirPath = "/replay";
+    if (dirPath.length() >= LIST_NAME_MAX) {
+        reply(400, "text/plain", "Directory name too long");
+        return;
+    }
+    bool allowDeflate = webServer_->arg("deflate") != "0";
+    uint32_t from = parseDay(webServer_->arg("from"), false);
+    uint32_t to = webServer_->hasArg("to") ? parseDay(webServer_->arg("to"), true) : UINT32_MAX;
+    int selected = 0;
+    for (int i = 0; i < webServer_->args(); i++) {
+        if (webServer_->argName(i) == "file") selected++;
+    }
+    
+    int slot = freeTransferSlot();
+    ZipArchive* zip = slot >= 0 ? acquireZip() : nullptr;
+    if (!zip) {
+        webServer_->sendHeader("Retry-After", "2");
+        reply(503, "text/plain", "An archive or too many downloads in progress, retry later");
+        return;
+    }
+    
+    File dir;
+    {
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (!lock.isLocked()) {
+            zip->inUse = false;
+            webServer_->sendHeader("Retry-After", "2");
+            reply(503, "text/plain", "SD card busy, retry later");
+            return;
+        }
+        dir = SD.open(dirPath);
+    }
+    if (!dir || !dir.isDirectory()) {
+        closeFile(dir);
+        zip->inUse = false;
+        reply(404, "text/plain", "Directory not found");
+        return;
+    }
+    
+    // One pass: names, sizes and dates of the files that match
+    zip->count = 0;
+    bool tooMany = false;
+    uint64_t archiveBytes = ZIP_END_BYTES;
+    bool anyDeflate = false;
+    bool busy = false;  // A storage slot was refused: the list is incomplete
+    File file;
+    {
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (lock.isLocked()) {
+            file = dir.openNextFile();
+        } else {
+            busy = true;
+        }
+    }
+    while (file && !tooMany) {
+        // Metadata is read in the slot that moves to the next entry:
+        // getLastWrite() stats the path on the card
+        char name[LIST_NAME_MAX];
+        bool isFile;
+        bool nameFits;
+        uint32_t mtime;
+        size_t size;
+        {
+            BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+            if (!lock.isLocked()) {
+                busy = true;
+                break;
+            }
+            isFile = !file.isDirectory();
+            nameFits = strlcpy(name, file.name(), LIST_NAME_MAX) < LIST_NAME_MAX;
+            mtime = file.getLastWrite();
+            size = isFile ? file.size() : 0;
+            file.close();
+            file = dir.openNextFile();
+        }
+        bool match = isFile && nameFits && mtime >= from && mtime <= to;
+        if (match && selected > 0) {
+            match = false;
+            for (int i = 0; i < webServer_->args() && !match; i++) {
+                match = webServer_->argName(i) == "file" && webServer_->arg(i) == name;
+            }
+        }
+        if (match && zip->count == ZIP_MAX_ENTRIES) {
+            tooMany = true;
+        } else if (match) {
+            ZipArchive::Entry& entry = zip->entries[zip->count++];
+            strlcpy(entry.name, name, LIST_NAME_MAX);
+            entry.size = size;
+            entry.mtime = mtime;
+            entry.deflate = allowDeflate && isCompressible(name);
+            anyDeflate |= entry.deflate;
+            size_t nameLength = strlen(name);
+            archiveBytes += ZIP_LOCAL_BYTES + nameLength + entry.size + ZIP_DESCRIPTOR_BYTES +
+                            ZIP_CENTRAL_BYTES + nameLength;
+        }
+    }
+    closeFile(file);
+    closeFile(dir);
+    
+    if (busy) {
+        zip->inUse = false;
+        webServer_->sendHeader("Retry-After", "2");
+        reply(503, "text/plain", "SD card busy, retry later");
+        return;
+    }
+    if (tooMany || archiveBytes > UINT32_MAX) {
+        zip->inUse = false;
+        reply(413, "text/plain", "More than " + String(ZIP_MAX_ENTRIES) +
+                                 " files or 4 GB: narrow the selection (file, from, to)");
+        return;
+    }
+    if (zip->count == 0) {
+        zip->inUse = false;
+        reply(404, "text/plain", "No file matches");
+        return;
+    }
+    
+    // Text files deflated if a compressor is free, stored otherwise
+    GzipStream* stream = anyDeflate ? acquireGzip() : nullptr;
+    if (!stream) {
+        for (int i = 0; i < zip->count; i++) zip->entries[i].deflate = false;
+        anyDeflate = false;
+    }
+    
+    String archiveName = dirPath.substring(dirPath.lastIndexOf('/') + 1);
+    archiveName.replace("\"", "");
+    if (archiveName == "") archiveName = "sd";
+    Transfer& transfer = transfers_[slot];
+    transfer.pending = "HTTP/1.1 200 OK\r\nContent-Type: application/zip\r\n"
+                       "Content-Disposition: attachment; filename=\"" + archiveName + ".zip\"\r\n";
+    if (!anyDeflate) {
+        transfer.pending += "Content-Length: " + String((unsigned long)archiveBytes) + "\r\n";
+    }
+    transfer.pending += "Connection: close\r\n\r\n";
+    transfer.pendingSent = 0;
+    transfer.status = 200;
+    transfer.fileSize = 0;
+    transfer.rangeCount = 0;
+    transfer.rangeIndex = 0;
+    transfer.rangeRemaining = 0;
+    transfer.seekPending = false;
+    transfer.multipart = false;
+    transfer.closed = false;
+    transfer.contentType = "application/zip";
+    transfer.sent = 0;
+    transfer.gzip = stream;
+    transfer.zip = zip;
+    transfer.track = nullptr;
+    
+    strlcpy(zip->dir, dirPath.c_str(), LIST_NAME_MAX);
+    zip->phase = ZIP_ENTRY_START;
+    zip->index = 0;
+    zip->offset = 0;
+    zip->centralStart = 0;
+    zip->inputBytes = 0;
+    zip->headLen = zip->headSent = 0;
+    if (stream) stream->micros = 0;
+    
+    queueTransfer(transfer, "GET /zip " + dirPath + (anyDeflate ? " (deflate)" : " (store)"));
+}
+
+/**
+ * @brief Date parameter: YYYY-MM-DD, YYYY-MM-DDTHH:MM[:SS] (UTC) or Unix time
+ * @param endOfDay true for the last second of a day given without time
+ *        (inclusive bound)
+ * @return Unix time, 0 if empty or malformed
+ */
+uint32_t FileServerManager::parseDay(const String& text, bool endOfDay) {
+    int year, month, day;
+    int hour = 0, minute = 0, second = 0;
+    int fields = sscanf(text.c_str(), "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour, &minute, &second);
+    if (fields >= 3 && month >= 1 && month <= 12) {
+        // Days since 1970-01-01 (civil calendar, years from March)
+        int y = year - (month <= 2);
+        int era = y / 400;
+        int yearOfEra = y - era * 400;
+        int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        long days = era * 146097L + dayOfEra - 719468;
+        if (days < 0) return 0;
+        if (fields >= 5) {
+            return (uint32_t)days * 86400 + hour * 3600 + minute * 60 + second;
+        }
+        return (uint32_t)days * 86400 + (endOfDay ? 86399 : 0);
+    }
+    return isDigits(text) ? strtoul(text.c_str(), nullptr, 10) : 0;
+}
+
+/**
+ * @brief Strong validator of a file: size and modification time
+ * 
+ * A recording in progress grows, so its ETag changes with every flush and
+ * a resumed download of it restarts from the beginning (If-Range).
+ * Call it while holding the storage slot: getLastWrite() reads the card.
+ */
+String FileServerManager::makeETag(File& file) {
+    char etag[32];
+    snprintf(etag, sizeof(etag), "\"%lx-%lx\"", (unsigned long)file.size(), (unsigned long)file.getLastWrite());
+    return String(etag);
+}
+
+/**
+ * @brief True if Accept-Encoding allows gzip ("gzip", "gzip;q=0.8", not "gzip;q=0")
+ */
+bool FileServerManager::acceptsGzip(const String& header) {
+    int pos = header.indexOf("gzip");
+    if (pos < 0) {
+        return false;
+    }
+    int end = header.indexOf(',', pos);
+    if (end < 0) end = header.length();
+    int quality = header.indexOf("q=", pos);
+    if (quality < 0 || quality > end) {
+        return true;
+    }
+    return header.substring(quality + 2, end).toFloat() > 0;
+}
+
+/**
+ * @brief Text files worth compressing (recordings, exports)
+ */
+bool FileServerManager::isCompressible(const String& filename) {
+    return filename.endsWith(".json") || filename.endsWith(".txt") || filename.endsWith(".csv");
+}
+
+/**
+ * @brief Parse a Range header ("bytes=0-499,1000-,-200")
+ * @param header Value of the Range header
+ * @param size File size
+ * @param ranges Receives at most MAX_RANGES ranges, in request order
+ * @return Number of ranges; 0 to ignore the header (malformed, or too many
+ *         ranges: the whole file is sent); -1 if no range is satisfiable (416)
+ */
+int FileServerManager::parseRanges(const String& header, size_t size, ByteRange* ranges) {
+    if (!header.startsWith("bytes=")) {
+        return 0;
+    }
+    
+    int count = 0;
+    int specs = 0;
+    unsigned int pos = 6;
+    while (pos <= header.length()) {
+        int comma = header.indexOf(',', pos);
+        if (comma < 0) comma = header.length();
+        String spec = header.substring(pos, comma);
+        spec.trim();
+        pos = comma + 1;
+        if (spec.length() == 0) continue;
+        specs++;
+        
+        int dash = spec.indexOf('-');
+        if (dash < 0) return 0;
+        String first = spec.substring(0, dash);
+        String last = spec.substring(dash + 1);
+        if ((first.length() == 0 && last.length() == 0) || !isDigits(first) || !isDigits(last)) {
+            return 0;
+        }
+        
+        size_t start, end;
+        if (first.length() == 0) {
+            // Suffix: the last N bytes
+            size_t suffix = strtoul(last.c_str(), nullptr, 10);
+            if (suffix == 0 || size == 0) continue;
+            start = suffix >= size ? 0 : size - suffix;
+            end = size - 1;
+        } else {
+            start = strtoul(first.c_str(), nullptr, 10);
+            if (start >= size) continue;  // Unsatisfiable, the others may be fine
+            end = last.length() == 0 ? size - 1 : strtoul(last.c_str(), nullptr, 10);
+            if (end < start) return 0;
+            if (end >= size) end = size - 1;
+        }
+        
+        if (count == MAX_RANGES) return 0;
+        ranges[count].start = start;
+        ranges[count].length = end - start + 1;
+        count++;
+    }
+    
+    if (specs == 0) return 0;
+    return count > 0 ? count : -1;
+}
+
+/**
+ * @brief Header of one part of a multipart/byteranges body
+ */
+String FileServerManager::partHeader(const Transfer& transfer, uint8_t index) {
+    const ByteRange& range = transfer.ranges[index];
+    char contentRange[64];
+    snprintf(contentRange, sizeof(contentRange), "bytes %lu-%lu/%lu", (unsigned long)range.start,
+             (unsigned long)(range.start + range.length - 1), (unsigned long)transfer.fileSize);
+    return String("\r\n--") + kRangeBoundary + "\r\nContent-Type: " + transfer.contentType +
+           "\r\nContent-Range: " + contentRange + "\r\n\r\n";
+}
+
+String FileServerManager::closingBoundary() {
+    return String("\r\n--") + kRangeBoundary + "--\r\n";
+}
+
+void FileServerManager::closeFile(File& file) {
+    if (!file) return;
+    // A close cannot be skipped or retried later: wait for the slot
+    BusLock lock(bus_, BusScheduler::CLIENT_STORAGE, portMAX_DELAY);
+    file.close();
+}
+
+/**
+ * @brief Value of a number field of a session line (Storage writes no spaces)
+ */
+static bool lineNumber(const char* line, const char* key, double& value) {
+    const char* field = strstr(line, key);
+    if (!field) return false;
+    value = strtod(field + strlen(key), nullptr);
+    return true;
+}
+
+static uint32_t lineTime(const char* line) {
+    double value;
+    return lineNumber(line, "\"datetime\":", value) && value > 0 ? (uint32_t)value : 0;
+}
+
+static bool lineDevice(const char* line, const char* device) {
+    const char* field = strstr(line, "\"device_name\":\"");
+    if (!field) return false;
+    field += 15;
+    size_t length = strlen(device);
+    return strncmp(field, device, length) == 0 && field[length] == '"';
+}
+
+/**
+ * @brief Time of the first (or last) dated line of the chunk at an offset
+ * @param offset Anywhere in the file: the partial line there is skipped
+ * @param time Set to 0 if the chunk holds no complete dated line
+ * @return false if the storage slot was refused (time is not set)
+ */
+bool FileServerManager::timeAt(File& file, size_t offset, bool last, uint32_t& time) {
+    int read;
+    {
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (!lock.isLocked()) return false;
+        time = 0;
+        if (!file.seek(offset)) return true;
+        read = file.read(chunk_, CHUNK_BYTES - 1);
+    }
+    if (read <= 0) return true;
+    chunk_[read] = '\0';
+    
+    char* line = reinterpret_cast<char*>(chunk_);
+    if (offset > 0) {
+        line = strchr(line, '\n');  // Partial line
+        if (!line) return true;
+        line++;
+    }
+    char* end;
+    while ((end = strchr(line, '\n')) != nullptr || (last && *line)) {
+        if (end) *end = '\0';
+        uint32_t lineAt = lineTime(line);
+        if (lineAt > 0) {
+            time = lineAt;
+            if (!last) break;
+        }
+        if (!end) break;
+        line = end + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Offset from which the lines of a window start
+ * @return false if a storage slot was refused (offset is not set)
+ * 
+ * Bisection on the offset: a few chunk reads, however long the session.
+ * The result is one chunk early, for the lines of a batch that are not
+ * in strict time order.
+ */
+bool FileServerManager::findTrackStart(File& file, size_t size, uint32_t from, size_t& offset) {
+    size_t low = 0;
+    size_t high = size;
+    while (high - low > CHUNK_BYTES) {
+        size_t middle = low + (high - low) / 2;
+        uint32_t time;
+        if (!timeAt(file, middle, false, time)) return false;
+        if (time == 0 || time >= from) {
+            high = middle;
+        } else {
+            low = middle;
+        }
+    }
+    offset = low > CHUNK_BYTES ? low - CHUNK_BYTES : 0;
+    return true;
+}
+
+/**
+ * @brief Handle HTTP requests to /api/track (track of one device of a session)
+ * 
+ * Query parameters:
+ * - file: session file (required)
+ * - device: device_name of a boat or buoy (required)
+ * - from, to: window, Unix time or YYYY-MM-DDTHH:MM:SS (UTC); the whole
+ *   session by default
+ * - max: points at most, 2 to TRACK_MAX_POINTS (default TRACK_DEFAULT_POINTS)
+ * - format: geojson (default) or bin
+ * 
+ * Decimation keeps the first point of each of max equal time slices of the
+ * window. GeoJSON: a Feature with a LineString and, in its properties, the
+ * time of each point ("times"). Binary: TRACK_RECORD_BYTES records, little
+ * endian: uint32 time, int32 latitude x 1e7, int32 longitude x 1e7,
+ * uint16 speed x 100 (knots), uint16 heading x 100.
+ * 
+ * The handler only locates the window (findTrackStart) and queues the
+ * track in a transfer slot; the server task then reads it one chunk per
+ * round, like a download, and the session is never loaded in memory. One
+ * track is sent at a time; the body ends when the connection closes.
+ */
+void FileServerManager::handleTrack() {
+    String filename = webServer_->arg("file");
+    String device = webServer_->arg("device");
+    if (filename == "" || device == "") {
+        reply(400, "application/json", "{\"error\":\"file and device are required\"}");
+        return;
+    }
+    if (filename.length() >= LIST_NAME_MAX || device.length() >= TRACK_DEVICE_MAX) {
+        reply(400, "application/json", "{\"error\":\"file or device name too long\"}");
+        return;
+    }
+    bool binary = webServer_->arg("format") == "bin";
+    int maxPoints = webServer_->hasArg("max") ? webServer_->arg("max").toInt() : TRACK_DEFAULT_POINTS;
+    maxPoints = constrain(maxPoints, 2, TRACK_MAX_POINTS);
+    
+    int slot = freeTransferSlot();
+    TrackScan* track = slot >= 0 ? acquireTrack() : nullptr;
+    if (!track) {
+        webServer_->sendHeader("Retry-After", "2");
+        reply(503, "application/json", "{\"error\":\"a track or too many downloads in progress, retry later\"}");
+        return;
+    }
+    
+    File file;
+    {
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (!lock.isLocked()) {
+            track->inUse = false;
+            webServer_->sendHeader("Retry-After", "2");
+            reply(503, "application/json", "{\"error\":\"SD card busy, retry later\"}");
+            return;
+        }
+        file = SD.open(filename, FILE_READ);
+    }
+    if (!file || file.isDirectory()) {
+        closeFile(file);
+        track->inUse = false;
+        reply(404, "application/json", "{\"error\":\"session not found\"}");
+        return;
+    }
+    size_t size = file.size();
+    
+    // Window, bounded by the session itself for the time slices
+    uint32_t first, lastTime;
+    uint32_t from = webServer_->hasArg("from") ? parseDay(webServer_->arg("from"), false) : 0;
+    uint32_t to = webServer_->hasArg("to") ? parseDay(webServer_->arg("to"), true) : UINT32_MAX;
+    size_t offset = 0;
+    bool located = timeAt(file, 0, false, first) &&
+                   timeAt(file, size > CHUNK_BYTES - 1 ? size - (CHUNK_BYTES - 1) : 0, true, lastTime);
+    if (located) {
+        if (from < first) from = first;
+        if (lastTime > 0 && to > lastTime) to = lastTime;
+        located = from <= first || findTrackStart(file, size, from, offset);
+    }
+    if (!located) {
+        closeFile(file);
+        track->inUse = false;
+        webServer_->sendHeader("Retry-After", "2");
+        reply(503, "application/json", "{\"error\":\"SD card busy, retry later\"}");
+        return;
+    }
+    
+    strlcpy(track->device, device.c_str(), TRACK_DEVICE_MAX);
+    strlcpy(track->file, filename.c_str(), LIST_NAME_MAX);
+    track->binary = binary;
+    track->phase = TRACK_SCAN;
+    track->from = from;
+    track->to = to;
+    track->span = (uint64_t)(to - from) + 1;
+    track->maxPoints = maxPoints;
+    track->points = 0;
+    track->timesSent = 0;
+    track->lastSlice = -1;
+    track->lines = 0;
+    track->bytesRead = 0;
+    track->offset = offset;
+    track->seekPending = true;
+    track->skipping = offset > 0;   // Partial line at the start offset
+    track->done = to < from;
+    track->lineLength = 0;
+    track->inLen = track->inPos = 0;
+    track->outLen = track->outSent = 0;
+    if (!binary) {
+        track->append("{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\",\"coordinates\":[");
+    }
+    
+    Transfer& transfer = transfers_[slot];
+    transfer.pending = String("HTTP/1.1 200 OK\r\nContent-Type: ") +
+                       (binary ? "application/octet-stream" : "application/geo+json") + "\r\n";
+    if (binary) {
+        transfer.pending += "X-Record-Size: " + String((unsigned)TRACK_RECORD_BYTES) + "\r\n";
+    }
+    transfer.pending += "Connection: close\r\n\r\n";
+    transfer.pendingSent = 0;
+    transfer.file = file;
+    transfer.status = 200;
+    transfer.fileSize = size;
+    transfer.rangeCount = 0;
+    transfer.rangeIndex = 0;
+    transfer.rangeRemaining = 0;
+    transfer.seekPending = false;
+    transfer.multipart = false;
+    transfer.closed = false;
+    transfer.contentType = binary ? "application/octet-stream" : "application/geo+json";
+    transfer.sent = 0;
+    transfer.gzip = nullptr;
+    transfer.zip = nullptr;
+    transfer.track = track;
+    
+    queueTransfer(transfer, "GET /api/track " + device + (binary ? " (bin)" : " (geojson)"));
+}
+
+/**
+ * @brief The track state, allocated in PSRAM on first use
+ * @return nullptr if a track is being sent or memory is short
+ */
+FileServerManager::TrackScan* FileServerManager::acquireTrack() {
+    if (!track_) {
+        track_ = static_cast<TrackScan*>(largeMalloc(sizeof(TrackScan)));
+        if (!track_) {
+            log("Warning: no memory for a track");
+            return nullptr;
+        }
+        track_->inUse = false;
+    }
+    if (track_->inUse) {
+        return nullptr;
+    }
+    track_->inUse = true;
+    return track_;
+}
+
+/**
+ * @brief One step of a track body: send staged bytes, or stage more
+ * @param written Receives the bytes sent (0 for a step that only stages)
+ * @return false on a read or socket error
+ */
+bool FileServerManager::pumpTrack(Transfer& transfer, size_t& written) {
+    TrackScan& track = *transfer.track;
+    written = 0;
+    if (track.outSent < track.outLen) {
+        int sent = sendNow(transfer.client, track.out + track.outSent, track.outLen - track.outSent);
+        if (sent < 0) return false;
+        written = sent;
+        track.outSent += written;
+        return true;
+    }
+    track.outLen = track.outSent = 0;
+    
+    switch (track.phase) {
+    case TRACK_SCAN:
+        return scanTrack(transfer);
+    case TRACK_TIMES:
+        // Properties: the point times, as many as fit in one round
+        while (track.timesSent < track.points && track.outLen + 16 < sizeof(track.out)) {
+            track.append("%s%lu", track.timesSent > 0 ? "," : "", (unsigned long)track.times[track.timesSent]);
+            track.timesSent++;
+        }
+        if (track.timesSent == track.points) {
+            track.append("]}}");
+            track.phase = TRACK_DONE;
+        }
+        return true;
+    case TRACK_DONE:
+        return true;
+    }
+    return true;
+}
+
+/**
+ * @brief Read one chunk of the window and stage its points
+ * 
+ * Lines are parsed from the chunk until it is used up or the staging
+ * buffer is nearly full; the rest of the chunk waits for the next round.
+ */
+bool FileServerManager::scanTrack(Transfer& transfer) {
+    TrackScan& track = *transfer.track;
+    
+    if (track.done) {
+        if (track.binary) {
+            track.phase = TRACK_DONE;
+        } else {
+            track.append("]},\"properties\":{\"device\":\"%s\",\"file\":\"%s\",\"from\":%lu,\"to\":%lu,"
+                         "\"points\":%d,\"scanned\":%lu,\"bytesRead\":%lu,\"times\":[",
+                         jsonEscape(track.device).c_str(), jsonEscape(track.file).c_str(),
+                         (unsigned long)track.from, (unsigned long)track.to, track.points,
+                         (unsigned long)track.lines, (unsigned long)track.bytesRead);
+            track.phase = TRACK_TIMES;
+        }
+        return true;
+    }
+    if (track.inPos == track.inLen) {
+        int read = -1;
+        {
+            BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+            if (!lock.isLocked()) return true;  // Bus busy: next round
+            if (!track.seekPending || transfer.file.seek(track.offset)) {
+                track.seekPending = false;
+                read = transfer.file.read(track.in, CHUNK_BYTES);
+            }
+        }
+        if (read < 0) return false;
+        if (read == 0) {
+            track.done = true;  // End of the session
+            return true;
+        }
+        track.bytesRead += read;
+        track.inLen = read;
+        track.inPos = 0;
+    }
+    
+    // Room left for one more point, whatever the format
+    while (track.inPos < track.inLen && !track.done && track.outLen + 64 < sizeof(track.out)) {
+        char c = (char)track.in[track.inPos++];
+        if (c != '\n') {
+            if (track.lineLength < TRACK_LINE_BYTES - 1) track.line[track.lineLength++] = c;
+            continue;
+        }
+        track.line[track.lineLength] = '\0';
+        bool complete = !track.skipping && track.lineLength < TRACK_LINE_BYTES - 1;
+        track.lineLength = 0;
+        track.skipping = false;
+        if (!complete) continue;
+        
+        const char* line = track.line;
+        uint32_t time = lineTime(line);
+        if (time == 0) continue;
+        track.lines++;
+        if (time > track.to) {
+            track.done = time > track.to + TRACK_TIME_SLACK_S;
+            continue;
+        }
+        double latitude, longitude;
+        if (time < track.from || !lineDevice(line, track.device) || !lineNumber(line, "\"latitude\":", latitude) ||
+            !lineNumber(line, "\"longitude\":", longitude)) {
+            continue;
+        }
+        long slice = (long)((uint64_t)(time - track.from) * track.maxPoints / track.span);
+        if (slice <= track.lastSlice) continue;  // Decimation: one point per time slice
+        track.lastSlice = slice;
+        
+        double speed = 0, heading = 0;
+        if (!lineNumber(line, "\"speed\":", speed)) speed = 0;
+        if (!lineNumber(line, "\"heading\":", heading) &&
+            !lineNumber(line, "\"autoPilotTrueHeadingCmde\":", heading)) {
+            heading = 0;
+        }
+        if (track.binary) {
+            uint8_t* record = track.out + track.outLen;
+            int32_t latitudeE7 = llround(latitude * 1e7);
+            int32_t longitudeE7 = llround(longitude * 1e7);
+            uint16_t speedCenti = (uint16_t)constrain(lround(speed * 100), 0L, 65535L);
+            uint16_t headingCenti = (uint16_t)(((lround(heading * 100) % 36000) + 36000) % 36000);
+            put32(record, time);
+            put32(record + 4, latitudeE7);
+            put32(record + 8, longitudeE7);
+            put16(record + 12, speedCenti);
+            put16(record + 14, headingCenti);
+            track.outLen += TRACK_RECORD_BYTES;
+        } else {
+            track.append("%s[%.7f,%.7f]", track.points > 0 ? "," : "", longitude, latitude);
+            track.times[track.points] = time;
+        }
+        track.points++;
+    }
+    return true;
+}
+
+/**
+ * @brief Handle HTTP requests to /api/live (fleet as it is received)
+ * 
+ * Query parameters: ?rate=1 (batches per second, 0.1 to 10) and
+ * ?format=sse (default) or ?format=bin.
+ * - sse: text/event-stream, events "boat", "buoy" and "wind" with one JSON
+ *   object each, e.g. {"id":305419896,"name":"FRA222","lat":43.5,"lon":3.9,
+ *   "speed":5.2,"heading":270.0,"sats":9,"age":120}; ": ping" comments
+ *   keep an idle stream open.
+ * - bin: LiveTelemetry::RECORD_BYTES records (layout in LiveTelemetry.h),
+ *   all-zero records as keep-alive.
+ * 
+ * The first batch carries every known device, the next ones only the
+ * devices updated since. The stream ends when the client closes it.
+ */
+void FileServerManager::handleLive() {
+    if (!telemetry_) {
+        reply(503, "text/plain", "Live telemetry not available");
+        return;
+    }
+    LiveClient* live = nullptr;
+    for (LiveClient& candidate : liveClients_) {
+        if (!candidate.active && candidate.buffer) {
+            live = &candidate;
+            break;
+        }
+    }
+    if (!live) {
+        reply(503, "text/plain", "Too many live streams, retry later");
+        return;
+    }
+    
+    float rate = webServer_->hasArg("rate") ? webServer_->arg("rate").toFloat() : 1.0f;
+    uint32_t periodMs = rate > 0 ? (uint32_t)(1000 / rate) : LIVE_MAX_PERIOD_MS;
+    live->periodMs = constrain(periodMs, LIVE_MIN_PERIOD_MS, LIVE_MAX_PERIOD_MS);
+    live->format = webServer_->arg("format") == "bin" ? TELEMETRY_BINARY : TELEMETRY_SSE;
+    
+    // Headers written by the server task, like the gzip downloads
+    int length;
+    if (live->format == TELEMETRY_BINARY) {
+        length = snprintf(live->buffer, LIVE_BUFFER_BYTES,
+                          "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nX-Record-Size: %u\r\n"
+                          "Cache-Control: no-cache\r\nAccess-Control-Allow-Origin: *\r\nConnection: close\r\n\r\n",
+                          (unsigned)LiveTelemetry::RECORD_BYTES);
+    } else {
+        length = snprintf(live->buffer, LIVE_BUFFER_BYTES,
+                          "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                          "Cache-Control: no-cache\r\nAccess-Control-Allow-Origin: *\r\nConnection: close\r\n\r\n"
+                          "retry: 3000\n\n");
+    }
+    live->length = length;
+    live->written = 0;
+    live->sent = 0;
+    live->records = 0;
+    telemetry_->resetCursor(live->cursor);
+    live->client = webServer_->client();
+    webServer_->detachClient();
+    live->startMs = requestStart_;
+    live->nextMs = live->lastSendMs = live->lastProgressMs = millis();
+    live->active = true;
+    transferQueued_ = true;  // Recorded when the stream ends
+    
+    if (statsMutex_) xSemaphoreTake(statsMutex_, portMAX_DELAY);
+    stats_.liveClients++;
+    if (statsMutex_) xSemaphoreGive(statsMutex_);
+    log("Live stream opened (" + String(live->format == TELEMETRY_BINARY ? "bin" : "sse") + ", " +
+        String(live->periodMs) + " ms)");
+}
+
+/**
+ * @brief Handle HTTP 404 errors for invalid URLs
+ * 
+ * Serves the embedded 404 page (web/404.html) with a link back to the
+ * home page.
+ */
+void FileServerManager::handleNotFound() {
+    const WebAsset* page = findAsset("/404.html");
+    if (page) {
+        sendAsset(*page, 404);
+    } else {
+        reply(404, "text/plain", "Not found");
+    }
+}
+
+/**
+ * @brief Soft-AP settings used when wifi_config.json does not give them
+ */
+static void setSoftAPDefaults(WiFiConfig& config) {
+    String mac = WiFi.macAddress();  // "AA:BB:CC:DD:EE:FF"
+    mac.replace(":", "");
+    config.mode = "auto";
+    config.apSsid = "OpenSailingRC-" + mac.substring(8);
+    config.apPassword = "opensailing";
+}
+
+/**
+ * @brief Load WiFi configuration from SD card
+ * @return true if configuration loads successfully, false otherwise
+ * 
+ * Reads WiFi credentials from /wifi_config.json on the SD card.
+ * The JSON file must contain "ssid" and "password" fields, except in "ap"
+ * mode. The other fields are optional.
+ * 
+ * Expected file format:
+ * {
+ *   "ssid": "NetworkName",
+ *   "password": "NetworkPassword",
+ *   "mode": "auto",                  // "auto", "ap" or "station"
+ *   "ap_ssid": "OpenSailingRC-1A2B",  // Soft-AP name (default: from the MAC address)
+ *   "ap_password": "opensailing"      // Soft-AP password, 8 characters or more
+ * }
+ * 
+ * The loaded configuration is stored in the wifiConfig_ member
+ * and marked as valid for subsequent connection attempts.
+ */
+bool FileServerManager::loadWiFiConfig() {
+    log("Loading WiFi configuration...");
+    
+    bool found;
+    bool opened = false;
+    String content;
+    {
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (!lock.isLocked()) {
+            log("Error: SD card busy, WiFi configuration not loaded (retry on next start)");
+            return false;
+        }
+        found = SD.exists("/wifi_config.json");
+        if (found) {
+            File configFile = SD.open("/wifi_config.json", FILE_READ);
+            if (configFile) {
+                opened = true;
+                content = configFile.readString();
+                configFile.close();
+            }
+        }
+    }
+    
+    if (!found) {
+        log("Warning: wifi_config.json file not found on SD card");
+        log("Using hardcoded WiFi credentials as fallback");
+        
+        // Fallback avec des credentials par défaut
+        // TODO: Remplacer par vos vraies credentials WiFi
+        wifiConfig_.ssid = "iPhone de Philippe";  // Remplacez par votre WiFi
+        wifiConfig_.password = "motdepassewifi";  // Remplacez par votre mot de passe
+        setSoftAPDefaults(wifiConfig_);
+        wifiConfig_.isValid = true;
+        
+        log("Using fallback WiFi configuration: SSID=" + wifiConfig_.ssid);
+        return true;
+    }
+    
+    if (!opened) {
+        log("Error: Unable to open wifi_config.json");
+        return false;
+    }
+    
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, content);
+    
+    if (error) {
+        log("Error: Invalid JSON in wifi_config.json");
+        return false;
+    }
+    
+    setSoftAPDefaults(wifiConfig_);
+    if (doc["mode"].is<String>()) {
+        wifiConfig_.mode = doc["mode"].as<String>();
+    }
+    if (doc["ap_ssid"].is<String>()) {
+        wifiConfig_.apSsid = doc["ap_ssid"].as<String>();
+    }
+    if (doc["ap_password"].is<String>()) {
+        String apPassword = doc["ap_password"].as<String>();
+        if (apPassword.length() >= 8) {
+            wifiConfig_.apPassword = apPassword;
+        } else {
+            log("Warning: ap_password shorter than 8 characters, default soft-AP password used");
+        }
+    }
+    
+    if (wifiConfig_.mode != "ap" && (!doc["ssid"].is<String>() || !doc["password"].is<String>())) {
+        log("Error: Missing ssid or password keys in wifi_config.json");
+        return false;
+    }
+    
+    wifiConfig_.ssid = doc["ssid"] | "";
+    wifiConfig_.password = doc["password"] | "";
+    wifiConfig_.isValid = true;
+    
+    log("WiFi configuration loaded: SSID=" + wifiConfig_.ssid + ", mode=" + wifiConfig_.mode +
+        ", soft-AP=" + wifiConfig_.apSsid);
+    return true;
+}
+
+/**
+ * @brief One step of the connection, run by the server task
+ * 
+ * Never waits: each call checks where the connection is and returns. The
+ * link depends on the "mode" of the configuration:
+ * - "auto": join the configured network if it answers on ESPNOW_CHANNEL
+ *   (cached link, or asynchronous scan of that channel only), otherwise
+ *   open the soft-AP on ESPNOW_CHANNEL. ESP-NOW keeps receiving in both
+ *   cases.
+ * - "ap": soft-AP only.
+ * - "station": join the network on whatever channel it uses (ESP-NOW is
+ *   deaf until the server stops, previous behaviour).
+ */
+void FileServerManager::connectStep() {
+    unsigned long now = millis();
+    switch (phase_) {
+        case CONNECT_START: {
+            phaseStartMs_ = now;
+            scanMs_ = associateMs_ = ipMs_ = 0;
+            linkMode_ = WIFI_LINK_NONE;
+            usingCache_ = false;
+            
+            if (wifiConfig_.mode == "ap" || wifiConfig_.ssid.length() == 0) {
+                if (startSoftAP()) {
+                    linkUp();
+                } else {
+                    connectState_ = WIFI_STATE_FAILED;
+                }
+                return;
+            }
+            
+            bool cached = loadCache() && wifiConfig_.ssid == cache_.ssid;
+            if (wifiConfig_.mode == "station") {
+                usingCache_ = cached;
+                beginJoin(false, cached ? cache_.bssid : nullptr, cached ? cache_.channel : 0);
+                return;
+            }
+            if (cached && cache_.channel == ESPNOW_CHANNEL) {
+                // Known access point on the ESP-NOW channel: no scan
+                usingCache_ = true;
+                beginJoin(true, cache_.bssid, ESPNOW_CHANNEL);
+                return;
+            }
+            
+            // Scanning the other channels would take the radio away from the
+            // fleet for about two seconds; a single channel costs SCAN_MS_PER_CHANNEL
+            WiFi.mode(WIFI_STA);
+            if (WiFi.scanNetworks(true, false, false, SCAN_MS_PER_CHANNEL, ESPNOW_CHANNEL) == WIFI_SCAN_FAILED) {
+                log("Error: WiFi scan failed, using the soft-AP");
+                if (startSoftAP()) {
+                    linkUp();
+                } else {
+                    connectState_ = WIFI_STATE_FAILED;
+                }
+                return;
+            }
+            phase_ = CONNECT_SCAN;
+            return;
+        }
+        
+        case CONNECT_SCAN: {
+            int16_t count = WiFi.scanComplete();
+            if (count == WIFI_SCAN_RUNNING) {
+                return;
+            }
+            scanMs_ = now - phaseStartMs_;
+            uint8_t bssid[6];
+            bool found = false;
+            for (int16_t i = 0; i < count && !found; i++) {
+                if (WiFi.SSID(i) == wifiConfig_.ssid) {
+                    memcpy(bssid, WiFi.BSSID(i), sizeof(bssid));
+                    found = true;
+                }
+            }
+            WiFi.scanDelete();
+            
+            if (found) {
+                beginJoin(true, bssid, ESPNOW_CHANNEL);
+                return;
+            }
+            log(wifiConfig_.ssid + " not found on channel " + String(ESPNOW_CHANNEL) +
+                ", using the soft-AP to keep ESP-NOW");
+            if (startSoftAP()) {
+                linkUp();
+            } else {
+                connectState_ = WIFI_STATE_FAILED;
+            }
+            return;
+        }
+        
+        case CONNECT_ASSOCIATE:
+        case CONNECT_IP: {
+            // The cache only saves the scan: DHCP gets the full timeout
+            bool cachedAssociation = usingCache_ && phase_ == CONNECT_ASSOCIATE;
+            if (now - phaseStartMs_ > (cachedAssociation ? CACHED_JOIN_TIMEOUT_MS : JOIN_TIMEOUT_MS)) {
+                joinFailed();
+                return;
+            }
+            if (phase_ == CONNECT_ASSOCIATE) {
+                wifi_ap_record_t ap;
+                if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+                    return;
+                }
+                associateMs_ = now - phaseStartMs_;
+                phase_ = CONNECT_IP;
+            }
+            if (WiFi.status() == WL_CONNECTED) {
+                ipMs_ = now - phaseStartMs_ - associateMs_;
+                linkUp();
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Start joining the configured network as a station
+ * @param shareChannel true: the network is on ESPNOW_CHANNEL, keep ESP-NOW
+ * @param bssid Access point to join (cache or scan), nullptr: any
+ * @param channel Channel of the access point, 0: unknown
+ * 
+ * Sharing the channel needs the 802.11 b/g/n rates on top of Long Range:
+ * the access point does not speak LR, the fleet only speaks LR. The
+ * address is always requested by DHCP, cached link or not.
+ */
+void FileServerManager::beginJoin(bool shareChannel, const uint8_t* bssid, uint8_t channel) {
+    log("Connecting to WiFi: " + wifiConfig_.ssid + (usingCache_ ? " (cached link)" : ""));
+    
+    WiFi.mode(WIFI_STA);
+    if (shareChannel) {
+        esp_wifi_set_protocol(WIFI_IF_STA, WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N |
+                                           WIFI_PROTOCOL_LR);
+    }
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);  // DHCP
+    WiFi.begin(wifiConfig_.ssid.c_str(), wifiConfig_.password.c_str(), channel, bssid);
+    
+    shareChannel_ = shareChannel;
+    linkMode_ = shareChannel ? WIFI_LINK_SHARED_STATION : WIFI_LINK_STATION;
+    phase_ = CONNECT_ASSOCIATE;
+    phaseStartMs_ = millis();
+}
+
+/**
+ * @brief The station did not get through in time
+ * 
+ * A cached link may be stale (access point replaced or moved to another
+ * channel): it is forgotten and the full connection starts at once. Without
+ * the cache, the soft-AP takes over when ESP-NOW must be kept.
+ */
+void FileServerManager::joinFailed() {
+    log(String("Error: Unable to connect to WiFi") +
+        (phase_ == CONNECT_ASSOCIATE ? " (no association)" : " (no IP address)"));
+    WiFi.disconnect();
+    linkMode_ = WIFI_LINK_NONE;
+    
+    if (usingCache_) {
+        log("Cached WiFi link dropped, full connection");
+        clearCache();
+        phase_ = CONNECT_START;  // Cache gone: scan and DHCP this time
+        return;
+    }
+    
+    restoreEspNowRadio();
+    if (shareChannel_) {
+        log("Falling back to the soft-AP");
+        if (startSoftAP()) {
+            linkUp();
+            return;
+        }
+    }
+    connectState_ = WIFI_STATE_FAILED;
+}
+
+/**
+ * @brief The link works: log the timings, update the cache, start HTTP
+ */
+void FileServerManager::linkUp() {
+    wifiConnected_ = true;
+    unsigned long total = millis() - connectStartMs_;
+    
+    if (linkMode_ == WIFI_LINK_SOFT_AP) {
+        log("WiFi connect: " + (scanMs_ ? "scan " + String(scanMs_) + " ms, " : String()) + "soft-AP, total " +
+            String(total) + " ms");
+    } else {
+        log("WiFi connect: scan " + (usingCache_ ? String("skipped (cache)") : String(scanMs_) + " ms") +
+            ", association " + String(associateMs_) + " ms, DHCP " + String(ipMs_) + " ms, total " +
+            String(total) + " ms");
+        String espNow = shareChannel_ ? String("ESP-NOW kept on channel ") + ESPNOW_CHANNEL
+                                      : String("ESP-NOW interrupted until the server stops");
+        log("WiFi connected! IP: " + WiFi.localIP().toString() + ", " + espNow);
+        saveCache();
+    }
+    
+    // Server task: begin() runs where the requests are handled
+    webServer_->begin();
+    serverActive_ = true;
+    connectState_ = WIFI_STATE_ACTIVE;
+    
+    log("File server active at: http://" + getServerIP());
+    log("Access files from your web browser");
+}
+
+/**
+ * @brief Connection cancelled by stopFileServer(): nothing left joined
+ */
+void FileServerManager::abortConnect() {
+    if (phase_ == CONNECT_SCAN) {
+        WiFi.scanDelete();
+    }
+    if (phase_ == CONNECT_ASSOCIATE || phase_ == CONNECT_IP) {
+        WiFi.disconnect();
+    }
+    restoreEspNowRadio();
+    linkMode_ = WIFI_LINK_NONE;
+    connectState_ = WIFI_STATE_IDLE;
+    log("WiFi connection cancelled");
+}
+
+/**
+ * @brief Long Range only, back on ESPNOW_CHANNEL
+ */
+void FileServerManager::restoreEspNowRadio() {
+    esp_wifi_set_protocol(WIFI_IF_STA, WIFI_PROTOCOL_LR);
+    esp_wifi_set_channel(ESPNOW_CHANNEL, WIFI_SECOND_CHAN_NONE);
+}
+
+/**
+ * @brief Read the last network joined from NVS
+ * @return true if a cache of the current version exists
+ */
+bool FileServerManager::loadCache() {
+    Preferences preferences;
+    cacheValid_ = false;
+    if (!preferences.begin(kCacheNamespace, true)) {
+        return false;
+    }
+    if (preferences.getBytesLength(kCacheKey) == sizeof(cache_)) {
+        preferences.getBytes(kCacheKey, &cache_, sizeof(cache_));
+        cacheValid_ = cache_.version == kCacheVersion;
+    }
+    preferences.end();
+    if (!cacheValid_) {
+        memset(&cache_, 0, sizeof(cache_));
+    }
+    return cacheValid_;
+}
+
+/**
+ * @brief Store the link just joined; NVS is only written when it changed
+ */
+void FileServerManager::saveCache() {
+    WiFiCache link;
+    memset(&link, 0, sizeof(link));
+    link.version = kCacheVersion;
+    strlcpy(link.ssid, wifiConfig_.ssid.c_str(), sizeof(link.ssid));
+    const uint8_t* bssid = WiFi.BSSID();
+    if (bssid) {
+        memcpy(link.bssid, bssid, sizeof(link.bssid));
+    }
+    link.channel = WiFi.channel();
+    
+    if (cacheValid_ && memcmp(&link, &cache_, sizeof(link)) == 0) {
+        return;
+    }
+    Preferences preferences;
+    if (!preferences.begin(kCacheNamespace, false)) {
+        log("Warning: WiFi cache not saved (NVS)");
+        return;
+    }
+    preferences.putBytes(kCacheKey, &link, sizeof(link));
+    preferences.end();
+    cache_ = link;
+    cacheValid_ = true;
+}
+
+/**
+ * @brief Forget the cached link (NVS and memory)
+ */
+void FileServerManager::clearCache() {
+    Preferences preferences;
+    if (preferences.begin(kCacheNamespace, false)) {
+        preferences.remove(kCacheKey);
+        preferences.end();
+    }
+    memset(&cache_, 0, sizeof(cache_));
+    cacheValid_ = false;
+}
+
+/**
+ * @brief Open the access point of the display on the ESP-NOW channel
+ * @return true if the soft-AP is up
+ * 
+ * The station interface is left unassociated, in Long Range only: ESP-NOW
+ * keeps using it, and nothing can move the radio off ESPNOW_CHANNEL. The
+ * access point uses the 802.11 b/g/n rates so that laptops can join it.
+ */
+bool FileServerManager::startSoftAP() {
+    log("Starting soft-AP " + wifiConfig_.apSsid + " on channel " + String(ESPNOW_CHANNEL));
+    
+    WiFi.mode(WIFI_AP_STA);
+    esp_wifi_set_protocol(WIFI_IF_AP, WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N);
+    if (!WiFi.softAP(wifiConfig_.apSsid.c_str(), wifiConfig_.apPassword.c_str(), ESPNOW_CHANNEL, 0,
+                     AP_MAX_CLIENTS)) {
+        log("Error: Unable to start the soft-AP");
+        WiFi.mode(WIFI_STA);
+        return false;
+    }
+    
+    wifiConnected_ = true;
+    linkMode_ = WIFI_LINK_SOFT_AP;
+    log("Soft-AP ready: join " + wifiConfig_.apSsid + ", then open http://" + WiFi.softAPIP().toString());
+    return true;
+}
+
+/**
+ * @brief Close the file server link and give the radio back to ESP-NOW
+ * 
+ * - Soft-AP: the access point is closed, the station interface stays up
+ *   (ESP-NOW never stopped).
+ * - Station on the ESP-NOW channel: the station leaves the network, Long
+ *   Range only is restored.
+ * - Station on another channel: WiFi is turned off; ESP-NOW must then be
+ *   reinitialized by the caller (keepsEspNow() was false).
+ * 
+ * In every case the radio is set back to ESPNOW_CHANNEL.
+ */
+void FileServerManager::disconnectWiFi() {
+    if (!wifiConnected_) {
+        return;
+    }
+    
+    log("Disconnecting WiFi...");
+    switch (linkMode_) {
+        case WIFI_LINK_SOFT_AP:
+            WiFi.softAPdisconnect(true);
+            WiFi.mode(WIFI_STA);
+            break;
+        case WIFI_LINK_SHARED_STATION:
+            WiFi.disconnect();
+            break;
+        default:
+            WiFi.disconnect();
+            WiFi.mode(WIFI_OFF);
+            break;
+    }
+    if (linkMode_ != WIFI_LINK_STATION) {
+        restoreEspNowRadio();
+    }
+    wifiConnected_ = false;
+    linkMode_ = WIFI_LINK_NONE;
+    log("WiFi disconnected");
+}
@@ -0,0 +1,190 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file FleetWidget.cpp
+ * @brief Implementation of the fleet overview table
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "FleetWidget.h"
+#include <algorithm>
+#include <string.h>
+
+// Cell positions in a column (text size 1: 6 px per character)
+const int16_t FleetWidget::kCellX[FleetWidget::CELLS] = {2, 42, 70, 94, 118};
+const int16_t FleetWidget::kCellW[FleetWidget::CELLS] = {36, 24, 18, 18, 30};
+static const char* const kHeaders[FleetWidget::CELLS] = {"NOM", "KMH", "CAP", "AGE", "PERTE"};
+
+FleetWidget::FleetWidget(int16_t x, int16_t y, int16_t w, int16_t h)
+    : Widget(x, y, w, h), rowCount_(0), selectedRow_(-1) {
+    memset(cells_, 0, sizeof(cells_));
+    memset(cellDirty_, 0, sizeof(cellDirty_));
+}
+
+void FleetWidget::setCell(int row, int cell, const char* text) {
+    char* current = cells_[row][cell];
+    if (strncmp(current, text, sizeof(cells_[0][0]) - 1) != 0) {
+        strncpy(current, text, sizeof(cells_[0][0]) - 1);
+        current[sizeof(cells_[0][0]) - 1] = '\0';
+        cellDirty_[row] |= 1 << cell;
+    }
+}
+
+void FleetWidget::set(const FleetEntry* entries, int count, int selected, unsigned long now) {
+    if (count > MAX_ROWS) count = MAX_ROWS;
+
+    // Stable sort by name: equal names keep the detection order
+    uint8_t order[MAX_ROWS];
+    for (int i = 0; i < count; i++) order[i] = i;
+    std::stable_sort(order, order + count, [entries](uint8_t a, uint8_t b) {
+        return strcmp(entries[a].name, entries[b].name) < 0;
+    });
+
+    int newSelectedRow = -1;
+    char text[8];
+    for (int row = 0; row < count; row++) {
+        const FleetEntry& e = entries[order[row]];
+        if (order[row] == selected) newSelectedRow = row;
+
+        bool fresh = now - e.lastUpdate < STALE_MS;
+        setCell(row, 0, e.name);
+
+        if (fresh) snprintf(text, sizeof(text), "%.1f", e.speed * 1.852f);  // knots → km/h
+        else strcpy(text, "--");
+        setCell(row, 1, text);
+
+        if (fresh) snprintf(text, sizeof(text), "%.0f", e.heading);
+        else strcpy(text, "--");
+        setCell(row, 2, text);
+
+        unsigned long age = (now - e.lastUpdate) / 1000;
+        if (age < 60) snprintf(text, sizeof(text), "%lus", age);
+        else if (age < 3600) snprintf(text, sizeof(text), "%lum", age / 60);
+        else strcpy(text, ">1h");
+        setCell(row, 3, text);
+
+        uint32_t total = e.receivedPackets + e.lostPackets;
+        if (total > 0) snprintf(text, sizeof(text), "%lu%%", (unsigned long)(100ULL * e.lostPackets / total));
+        else strcpy(text, "--");
+        setCell(row, 4, text);
+    }
+
+    // Rows that disappeared are emptied
+    for (int row = count; row < rowCount_; row++) {
+        for (int cell = 0; cell < CELLS; cell++) setCell(row, cell, "");
+    }
+    rowCount_ = count;
+
+    if (newSelectedRow != selectedRow_) {
+        if (selectedRow_ >= 0) cellDirty_[selectedRow_] |= 1;
+        if (newSelectedRow >= 0) cellDirty_[newSelectedRow] |= 1;
+        selectedRow_ = newSelectedRow;
+    }
+
+    for (int row = 0; row < MAX_ROWS; row++) {
+        if (cellDirty_[row]) {
+            markPartialDirty();
+            break;
+        }
+    }
+}
+
+int FleetWidget::dirtyRegion(WidgetRect* rects) const {
+    if (fullDirty_) {
+        return Widget::dirtyRegion(rects);
+    }
+
+    // One band per run of consecutive dirty rows, spanning their dirty cells
+    int count = 0;
+    for (int column = 0; column < COLUMNS; column++) {
+        int first = column * ROWS_PER_COLUMN;
+        int last = first + ROWS_PER_COLUMN;
+        for (int row = first; row < last; row++) {
+            if (!cellDirty_[row]) continue;
+            int bandStart = row;
+            uint8_t cells = 0;
+            while (row < last && cellDirty_[row]) cells |= cellDirty_[row++];
+
+            int lo = 0;
+            int hi = CELLS - 1;
+            while (!(cells & (1 << lo))) lo++;
+            while (!(cells & (1 << hi))) hi--;
+            WidgetRect band = {
+                (int16_t)(columnX(column) + kCellX[lo]), rowY(bandStart),
+                (int16_t)(kCellX[hi] + kCellW[hi] - kCellX[lo]), (int16_t)(ROW_HEIGHT * (row - bandStart))
+            };
+
+            if (count < MAX_DIRTY_RECTS) {
+                rects[count++] = band;
+            } else {
+                // Out of slots: grow the last band
+                WidgetRect& a = rects[count - 1];
+                int16_t x1 = max(a.x + a.w, band.x + band.w);
+                int16_t y1 = max(a.y + a.h, band.y + band.h);
+                a.x = min(a.x, band.x);
+                a.y = min(a.y, band.y);
+                a.w = x1 - a.x;
+                a.h = y1 - a.y;
+            }
+        }
+    }
+    return count > 0 ? count : Widget::dirtyRegion(rects);
+}
+
+void FleetWidget::clearDirty() {
+    Widget::clearDirty();
+    memset(cellDirty_, 0, sizeof(cellDirty_));
+}
+
+void FleetWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    int16_t canvasTop = originY;
+    int16_t canvasBottom = originY + gfx.height();
+    gfx.setTextSize(1);
+
+    // Headers (only when the first line is in the canvas)
+    if (bounds_.y + ROW_HEIGHT > canvasTop && bounds_.y < canvasBottom) {
+        gfx.setTextColor(TFT_DARKGREY);
+        for (int column = 0; column < COLUMNS; column++) {
+            for (int cell = 0; cell < CELLS; cell++) {
+                gfx.setTextDatum(cell == 0 ? TL_DATUM : TR_DATUM);
+                int16_t x = columnX(column) + kCellX[cell] + (cell == 0 ? 0 : kCellW[cell]);
+                gfx.drawString(kHeaders[cell], x - originX, bounds_.y - originY);
+            }
+        }
+    }
+
+    // Rows: only those crossing the canvas
+    for (int row = 0; row < rowCount_; row++) {
+        int16_t y = rowY(row);
+        if (y + ROW_HEIGHT <= canvasTop || y >= canvasBottom) continue;
+        int16_t x0 = columnX(row / ROWS_PER_COLUMN);
+
+        for (int cell = 0; cell < CELLS; cell++) {
+            int16_t x = x0 + kCellX[cell];
+            if (x + kCellW[cell] <= originX || x >= originX + gfx.width()) continue;
+            if (cell == 0) {
+                gfx.setTextDatum(TL_DATUM);
+                gfx.setTextColor(row == selectedRow_ ? YELLOW : WHITE);
+            } else {
+                gfx.setTextDatum(TR_DATUM);
+                gfx.setTextColor(WHITE);
+                x += kCellW[cell];
+            }
+            gfx.drawString(cells_[row][cell], x - originX, y + 1 - originY);
+        }
+    }
+}
@@ -0,0 +1,76 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file GlyphAtlas.cpp
+ * @brief Implementation of the numeric glyph atlas
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "GlyphAtlas.h"
+#include "PsramAllocator.h"
+#include <esp_heap_caps.h>
+
+static const char kGlyphs[GlyphAtlas::GLYPH_COUNT + 1] = "0123456789-.";
+
+GlyphAtlas::GlyphAtlas(uint8_t textSize, uint16_t color)
+    : textSize_(textSize), color_(color), width_(FONT_WIDTH * textSize), height_(FONT_HEIGHT * textSize),
+      pixels_(nullptr) {
+}
+
+GlyphAtlas::~GlyphAtlas() {
+    largeFree(pixels_);
+}
+
+int GlyphAtlas::indexOf(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c == '-') return 10;
+    if (c == '.') return 11;
+    return -1;
+}
+
+bool GlyphAtlas::begin() {
+    if (pixels_) return true;
+
+    // ~10 KB at size 3: internal RAM for the fastest copies, PSRAM otherwise
+    size_t cellPixels = (size_t)width_ * height_;
+    size_t bytes = cellPixels * GLYPH_COUNT * sizeof(uint16_t);
+    pixels_ = (uint16_t*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!pixels_) {
+        pixels_ = (uint16_t*)largeMalloc(bytes);
+    }
+    if (!pixels_) return false;
+
+    LGFX_Sprite cell;
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        cell.setBuffer(pixels_ + i * cellPixels, width_, height_);
+        cell.fillScreen(BLACK);
+        cell.setTextDatum(TL_DATUM);
+        cell.setTextColor(color_);
+        cell.setTextSize(textSize_);
+        cell.setCursor(0, 0);
+        cell.print(kGlyphs[i]);
+    }
+    return true;
+}
+
+bool GlyphAtlas::drawGlyph(LovyanGFX& gfx, int32_t x, int32_t y, char c) const {
+    int index = indexOf(c);
+    if (!pixels_ || index < 0) return false;
+    const uint16_t* glyph = pixels_ + (size_t)index * width_ * height_;
+    gfx.pushImage(x, y, width_, height_, (const lgfx::swap565_t*)glyph);
+    return true;
+}
@@ -0,0 +1,234 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file HistoryBuffer.cpp
+ * @brief Implementation of the pre-trigger history ring
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "HistoryBuffer.h"
+#include "PsramAllocator.h"
+
+// Budget used when no PSRAM is available (internal heap is shared with WiFi)
+#define HISTORY_INTERNAL_BUDGET_BYTES (32 * 1024)
+
+HistoryBuffer::HistoryBuffer()
+    : records_(nullptr), capacity_(0), writeCount_(0), windowMs_(0),
+      minutes_(0), rateHz_(0), maxDevices_(0), inPsram_(false), nameCount_(0),
+      drainCursor_(0), drainEnd_(0), drainCutoff_(0), overwritten_(0) {
+    lock_ = portMUX_INITIALIZER_UNLOCKED;
+    memset(names_, 0, sizeof(names_));
+}
+
+HistoryBuffer::~HistoryBuffer() {
+    if (records_) {
+        largeFree(records_);
+    }
+}
+
+bool HistoryBuffer::begin(uint16_t minutes, uint8_t rateHz, uint8_t maxDevices) {
+    minutes_ = minutes;
+    rateHz_ = rateHz;
+    maxDevices_ = maxDevices;
+    windowMs_ = (uint32_t)minutes * 60000UL;
+
+    uint32_t wanted = (uint32_t)minutes * 60 * rateHz * maxDevices;
+    if (wanted == 0) {
+        return false;
+    }
+
+    // PSRAM first: the ring is written at most a few hundred times per second
+    HistoryRecord* ring = (HistoryRecord*)psramMalloc(wanted * sizeof(HistoryRecord));
+    if (ring) {
+        capacity_ = wanted;
+        inPsram_ = true;
+        records_ = ring; // Published last: push() tests records_ only
+        return true;
+    }
+
+    // Fallback: reduced ring in internal RAM
+    uint32_t reduced = HISTORY_INTERNAL_BUDGET_BYTES / sizeof(HistoryRecord);
+    if (reduced > wanted) reduced = wanted;
+    ring = (HistoryRecord*)largeMalloc(reduced * sizeof(HistoryRecord));
+    if (!ring) {
+        return false;
+    }
+    capacity_ = reduced;
+    inPsram_ = false;
+    records_ = ring;
+    return true;
+}
+
+uint8_t HistoryBuffer::findOrAddName(const char* name) {
+    for (uint8_t i = 0; i < nameCount_; i++) {
+        if (strncmp(names_[i], name, sizeof(names_[i])) == 0) {
+            return i;
+        }
+    }
+    if (nameCount_ >= NAME_SLOTS) {
+        return NO_SLOT;
+    }
+    strncpy(names_[nameCount_], name, sizeof(names_[nameCount_]) - 1);
+    names_[nameCount_][sizeof(names_[nameCount_]) - 1] = '\0';
+    return nameCount_++;
+}
+
+/** @brief Degrees to the fixed point of HistoryRecord (1e-7 degree) */
+static int32_t toE7(double degrees) {
+    return (int32_t)llround(degrees * 1e7);
+}
+
+void HistoryBuffer::encode(const StorageData& data, HistoryRecord& record) {
+    memset(&record, 0, sizeof(record));
+    record.timestamp = (uint32_t)data.timestamp;
+    record.dataType = (uint8_t)data.dataType;
+
+    if (data.dataType == DATA_TYPE_BOAT) {
+        record.sequenceNumber = data.boatData.sequenceNumber;
+        record.latitude = toE7(data.boatData.latitude);
+        record.longitude = toE7(data.boatData.longitude);
+        record.value1 = (int16_t)lroundf(data.boatData.speed * 100.0f);
+        record.value2 = (int16_t)lroundf(data.boatData.heading * 10.0f);
+        record.satellites = data.boatData.satellites;
+        record.deviceSlot = findOrAddName(data.boatData.name);
+    } else if (data.dataType == DATA_TYPE_ANEMOMETER) {
+        record.sequenceNumber = data.anemometerData.sequenceNumber;
+        record.value1 = (int16_t)lroundf(data.anemometerData.windSpeed * 100.0f);
+        record.value2 = (int16_t)lroundf(data.windDirection * 10.0f);
+        record.deviceSlot = findOrAddName(data.anemometerData.anemometerId);
+    } else if (data.dataType == DATA_TYPE_BUOY) {
+        record.sequenceNumber = data.buoyData.sequenceNumber;
+        record.latitude = toE7(data.buoyData.latitude);
+        record.longitude = toE7(data.buoyData.longitude);
+        record.value2 = (int16_t)lroundf(data.buoyData.autoPilotTrueHeadingCmde * 10.0f);
+        record.throttle = data.buoyData.autoPilotThrottleCmde;
+        record.deviceSlot = data.buoyData.buoyId;
+    }
+}
+
+void HistoryBuffer::decode(const HistoryRecord& record, StorageData& data) {
+    memset(&data, 0, sizeof(data));
+    data.timestamp = record.timestamp;
+    data.dataType = (DataType)record.dataType;
+
+    const char* name = (record.deviceSlot < nameCount_) ? names_[record.deviceSlot] : "";
+
+    if (data.dataType == DATA_TYPE_BOAT) {
+        data.boatData.messageType = MSG_TYPE_BOAT_GPS;
+        strncpy(data.boatData.name, name, sizeof(data.boatData.name) - 1);
+        data.boatData.sequenceNumber = record.sequenceNumber;
+        data.boatData.latitude = (float)(record.latitude * 1e-7);
+        data.boatData.longitude = (float)(record.longitude * 1e-7);
+        data.boatData.speed = record.value1 / 100.0f;
+        data.boatData.heading = record.value2 / 10.0f;
+        data.boatData.satellites = record.satellites;
+    } else if (data.dataType == DATA_TYPE_ANEMOMETER) {
+        data.anemometerData.messageType = MSG_TYPE_ANEMOMETER;
+        strncpy(data.anemometerData.anemometerId, name, sizeof(data.anemometerData.anemometerId) - 1);
+        data.anemometerData.sequenceNumber = record.sequenceNumber;
+        data.anemometerData.windSpeed = record.value1 / 100.0f;
+        data.windDirection = record.value2 / 10.0f;
+    } else if (data.dataType == DATA_TYPE_BUOY) {
+        data.buoyData.buoyId = record.deviceSlot;
+        data.buoyData.sequenceNumber = (uint16_t)record.sequenceNumber;
+        data.buoyData.latitude = record.latitude * 1e-7;
+        data.buoyData.longitude = record.longitude * 1e-7;
+        data.buoyData.autoPilotTrueHeadingCmde = record.value2 / 10.0f;
+        data.buoyData.autoPilotThrottleCmde = record.throttle;
+    }
+}
+
+void HistoryBuffer::push(const StorageData& data) {
+    if (!records_) return;
+
+    portENTER_CRITICAL(&lock_);
+    encode(data, records_[writeCount_ % capacity_]);
+    writeCount_++;
+    portEXIT_CRITICAL(&lock_);
+}
+
+HistoryTrigger HistoryBuffer::captureTrigger() {
+    HistoryTrigger trigger;
+    uint32_t now = millis();
+    trigger.cutoff = (now > windowMs_) ? now - windowMs_ : 0;
+    portENTER_CRITICAL(&lock_);
+    trigger.end = writeCount_;
+    portEXIT_CRITICAL(&lock_);
+    return trigger;
+}
+
+void HistoryBuffer::markTrigger(const HistoryTrigger& trigger) {
+    if (!records_) return;
+
+    portENTER_CRITICAL(&lock_);
+    // Records overwritten since the capture are counted by drainPreTrigger()
+    drainCursor_ = (trigger.end > capacity_) ? trigger.end - capacity_ : 0;
+    drainEnd_ = trigger.end;
+    drainCutoff_ = trigger.cutoff;
+    portEXIT_CRITICAL(&lock_);
+}
+
+bool HistoryBuffer::hasPendingPreTrigger() {
+    portENTER_CRITICAL(&lock_);
+    bool pending = drainCursor_ < drainEnd_;
+    portEXIT_CRITICAL(&lock_);
+    return pending;
+}
+
+size_t HistoryBuffer::drainPreTrigger(StorageBatch& out, size_t maxRecords) {
+    if (!records_) return 0;
+
+    size_t appended = 0;
+    while (appended < maxRecords) {
+        HistoryRecord record;
+        bool haveRecord = false;
+
+        portENTER_CRITICAL(&lock_);
+        // Records overwritten by live data since the trigger are lost
+        uint32_t oldest = (writeCount_ > capacity_) ? writeCount_ - capacity_ : 0;
+        if (drainCursor_ < oldest) {
+            overwritten_ += oldest - drainCursor_;
+            drainCursor_ = oldest;
+        }
+        if (drainCursor_ < drainEnd_) {
+            record = records_[drainCursor_ % capacity_];
+            drainCursor_++;
+            haveRecord = true;
+        }
+        portEXIT_CRITICAL(&lock_);
+
+        if (!haveRecord) break;
+
+        // Older than the configured window: skip (ring sized for peak load)
+        if ((int32_t)(record.timestamp - drainCutoff_) < 0) continue;
+
+        StorageData data;
+        decode(record, data);
+        out.push_back(data);
+        appended++;
+    }
+    return appended;
+}
+
+String HistoryBuffer::describe() const {
+    String text = "Pre-trigger history: " + String(minutes_) + " min x " +
+                  String(maxDevices_) + " devices @ " + String(rateHz_) + " Hz, " +
+                  String(bytesPerMinutePerDevice()) + " bytes/min/device, ";
+    text += String(capacityBytes() / 1024) + " KB ";
+    text += inPsram_ ? "(PSRAM)" : "(internal RAM, reduced)";
+    return text;
+}
@@ -0,0 +1,181 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file LiveTelemetry.cpp
+ * @brief Implementation of the live device table
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "LiveTelemetry.h"
+
+static const char* const kEventNames[] = {"ping", "boat", "buoy", "wind"};
+
+LiveTelemetry::LiveTelemetry() : mutex_(nullptr), published_(0), coalesced_(0) {
+    memset(slots_, 0, sizeof(slots_));
+}
+
+bool LiveTelemetry::begin() {
+    if (!mutex_) {
+        mutex_ = xSemaphoreCreateMutex();
+    }
+    return mutex_ != nullptr;
+}
+
+void LiveTelemetry::publish(const TelemetryState& state) {
+    if (!mutex_) return;
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    int found = -1;
+    int oldest = 0;
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        const TelemetryState& slot = slots_[i].state;
+        if (slot.kind == state.kind && slot.deviceId == state.deviceId && slot.kind != TELEMETRY_KEEPALIVE) {
+            found = i;
+            break;
+        }
+        // Free slots first, then the device heard from the longest time ago
+        if (slots_[oldest].state.kind != TELEMETRY_KEEPALIVE &&
+            (slot.kind == TELEMETRY_KEEPALIVE || slot.receivedMs - slots_[oldest].state.receivedMs > 0x80000000UL)) {
+            oldest = i;
+        }
+    }
+    if (found < 0 || slots_[found].state.sequence != state.sequence) {
+        Slot& slot = slots_[found < 0 ? oldest : found];
+        slot.state = state;
+        slot.updates++;
+        published_++;
+    }
+    xSemaphoreGive(mutex_);
+}
+
+void LiveTelemetry::remove(TelemetryKind kind, uint32_t deviceId) {
+    if (!mutex_) return;
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    for (Slot& slot : slots_) {
+        if (slot.state.kind == kind && slot.state.deviceId == deviceId && kind != TELEMETRY_KEEPALIVE) {
+            // updates is kept: a device that takes the slot later is new to every cursor
+            memset(&slot.state, 0, sizeof(slot.state));
+        }
+    }
+    xSemaphoreGive(mutex_);
+}
+
+void LiveTelemetry::resetCursor(Cursor& cursor) const {
+    memset(&cursor, 0, sizeof(cursor));
+}
+
+/**
+ * @brief JSON string body: quotes, backslashes and control characters dropped
+ *
+ * Names come from the radio; they are short and never need more than
+ * removing what would break the event.
+ */
+static void copyJsonName(const char* name, char* out, size_t size) {
+    size_t length = 0;
+    for (size_t i = 0; name[i] && i < sizeof(TelemetryState::name) && length + 1 < size; i++) {
+        char c = name[i];
+        if (c == '"' || c == '\\' || (uint8_t)c < 0x20) continue;
+        out[length++] = c;
+    }
+    out[length] = '\0';
+}
+
+size_t LiveTelemetry::format(const TelemetryState& state, TelemetryFormat format, unsigned long now,
+                             char* out) const {
+    unsigned long age = now - state.receivedMs;
+    if (format == TELEMETRY_BINARY) {
+        uint8_t* record = reinterpret_cast<uint8_t*>(out);
+        memset(record, 0, RECORD_BYTES);
+        int32_t latitude = lroundf(state.latitude * 1e7f);
+        int32_t longitude = lroundf(state.longitude * 1e7f);
+        int16_t speed = (int16_t)constrain(lroundf(state.speed * 100), -32768L, 32767L);
+        uint16_t heading = state.heading < 0 ? 0xFFFF : (uint16_t)(lroundf(state.heading * 100) % 36000);
+        uint16_t ageTenths = age / 100 > 0xFFFF ? 0xFFFF : age / 100;
+        record[0] = state.kind;
+        record[1] = state.detail;
+        memcpy(record + 2, &ageTenths, 2);    // ESP32: little endian
+        memcpy(record + 4, &state.deviceId, 4);
+        memcpy(record + 8, &latitude, 4);
+        memcpy(record + 12, &longitude, 4);
+        memcpy(record + 16, &speed, 2);
+        memcpy(record + 18, &heading, 2);
+        strncpy(reinterpret_cast<char*>(record + 20), state.name, RECORD_BYTES - 20);
+        return RECORD_BYTES;
+    }
+
+    char name[sizeof(TelemetryState::name) + 1];
+    copyJsonName(state.name, name, sizeof(name));
+    int length;
+    if (state.kind == TELEMETRY_WIND) {
+        length = snprintf(out, EVENT_BYTES,
+                          "event: wind\ndata: {\"id\":%lu,\"name\":\"%s\",\"speed\":%.2f,\"direction\":%.1f,"
+                          "\"age\":%lu}\n\n",
+                          (unsigned long)state.deviceId, name, state.speed, state.heading, age);
+    } else {
+        length = snprintf(out, EVENT_BYTES,
+                          "event: %s\ndata: {\"id\":%lu,\"name\":\"%s\",\"lat\":%.7f,\"lon\":%.7f,\"speed\":%.2f,"
+                          "\"heading\":%.1f,\"%s\":%u,\"age\":%lu}\n\n",
+                          kEventNames[state.kind], (unsigned long)state.deviceId, name, state.latitude,
+                          state.longitude, state.speed, state.heading,
+                          state.kind == TELEMETRY_BOAT ? "sats" : "mode", state.detail, age);
+    }
+    return length > 0 && (size_t)length < EVENT_BYTES ? length : 0;
+}
+
+size_t LiveTelemetry::collect(Cursor& cursor, TelemetryFormat format, char* buffer, size_t capacity,
+                              uint32_t& records) {
+    size_t length = 0;
+    size_t largest = format == TELEMETRY_BINARY ? RECORD_BYTES : EVENT_BYTES;
+    unsigned long now = millis();
+    records = 0;
+    cursor.more = false;
+    if (!mutex_) return 0;
+
+    // Round robin from where the previous call stopped: a full buffer
+    // never starves the devices at the end of the table
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    for (int n = 0; n < MAX_DEVICES; n++) {
+        int i = (cursor.next + n) % MAX_DEVICES;
+        const Slot& slot = slots_[i];
+        if (slot.state.kind == TELEMETRY_KEEPALIVE || slot.updates == cursor.seen[i]) continue;
+        if (length + largest > capacity) {
+            cursor.next = i;
+            cursor.more = true;
+            break;
+        }
+        size_t written = this->format(slot.state, format, now, buffer + length);
+        if (written == 0) continue;
+        length += written;
+        records++;
+        // Updates this client never got: replaced by the latest state
+        if (cursor.seen[i] != 0 && slot.updates - cursor.seen[i] > 1) {
+            coalesced_ += slot.updates - cursor.seen[i] - 1;
+        }
+        cursor.seen[i] = slot.updates;
+    }
+    xSemaphoreGive(mutex_);
+    return length;
+}
+
+size_t LiveTelemetry::keepAlive(TelemetryFormat format, char* buffer) {
+    if (format == TELEMETRY_BINARY) {
+        memset(buffer, 0, RECORD_BYTES);
+        return RECORD_BYTES;
+    }
+    static const char kPing[] = ": ping\n\n";
+    memcpy(buffer, kPing, sizeof(kPing) - 1);
+    return sizeof(kPing) - 1;
+}
@@ -18,9 +18,12 @@
  * 
  * This file contains the implementation of a versatile logging system that supports
  * simultaneous output to serial console, M5Stack display, and SD card storage.
+ * Serial output goes through a lock-free ring drained by a low-priority task.
  */
 #include "Logger.h"
 
+static const char* const kLevelPrefixes[] = {"[D] ", "", "[W] ", "[E] "};
+
 /**
  * @brief Constructs a Logger instance with specified output options
  * 
@@ -33,12 +36,18 @@
  * @param serialLogging Enable logging to serial console
  * @param screenLogging Enable logging to M5Stack display
  */
-Logger::Logger(bool enableSDLogging, bool serialLogging, bool screenLogging) {
+Logger::Logger(bool enableSDLogging, bool serialLogging, bool screenLogging)
+    : minimumLevel(LOG_DEBUG), drainTask(nullptr), reportedDrops(0), head(0), tail(0), written(0), dropped(0), truncated(0),
+      highWater(0) {
     this->sdLogging = enableSDLogging;
     this->serialLogging = serialLogging;
     this->screenLogging = screenLogging;
     this->screenLine = 0;
 
+    for (size_t i = 0; i < SLOTS; i++) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
     // Initialize screen if screen logging is enabled
     if (this->screenLogging) {
         M5.Display.fillScreen(WHITE);
@@ -59,6 +68,29 @@ Logger::Logger(bool enableSDLogging, bool serialLogging, bool screenLogging) {
     }
 }
 
+/**
+ * @brief Starts the task that prints the ring on the serial port
+ *
+ * Idle priority on the core of loop(): the serial port only gets the time
+ * nothing else wants. If it falls behind, the ring fills and new messages
+ * are dropped (and counted) instead of slowing their callers down.
+ */
+bool Logger::begin() {
+    if (drainTask) {
+        return true;
+    }
+    return xTaskCreatePinnedToCore(drainEntry, "Logger", 4096, this, tskIDLE_PRIORITY, &drainTask, 1) == pdPASS;
+}
+
+void Logger::drainEntry(void* parameter) {
+    Logger* logger = static_cast<Logger*>(parameter);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DRAIN_POLL_MS));
+        while (logger->drainOne()) {
+        }
+    }
+}
+
 /**
  * @brief Logs a message to all enabled output destinations
  * 
@@ -69,20 +101,38 @@ Logger::Logger(bool enableSDLogging, bool serialLogging, bool screenLogging) {
  * @param message The string message to be logged
  */
 void Logger::log(const String& message) {
+    log(LOG_INFO, message.c_str());
+}
+
+void Logger::log(LogLevel level, const String& message) {
+    log(level, message.c_str());
+}
+
+void Logger::log(LogLevel level, const char* message) {
+    if (level < minimumLevel || level >= LOG_OFF) {
+        return;
+    }
+
     // Serial logging
     if (serialLogging) {
-        Serial.println(message);
+        size_t length = strlen(message);
+        if (drainTask) {
+            if (enqueue(level, message, length)) {
+                // Idle priority: the notification never preempts the caller
+                if (xPortInIsrContext()) {
+                    vTaskNotifyGiveFromISR(drainTask, nullptr);
+                } else {
+                    xTaskNotifyGive(drainTask);
+                }
+            }
+        } else {
+            writeSerial(level, message, length);  // Before begin(): boot messages
+        }
     }
 
     // Screen logging
     if (screenLogging) {
-        if (screenLine >= MAX_LINES) {
-            M5.Display.fillScreen(WHITE);
-            screenLine = 0;
-        }
-        M5.Display.setCursor(0, screenLine * LINE_HEIGHT);
-        M5.Display.println(message);
-        screenLine++;
+        writeScreen(message);
     }
 
     // SD logging
@@ -91,6 +141,146 @@ void Logger::log(const String& message) {
     }
 }
 
+void Logger::logf(LogLevel level, const char* format, ...) {
+    if (level < minimumLevel || level >= LOG_OFF) {
+        return;
+    }
+    char buffer[FORMAT_BYTES];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length >= (int)sizeof(buffer)) {
+        truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (length >= 0) {
+        log(level, buffer);
+    }
+}
+
+/**
+ * @brief Copy a message into the ring without waiting
+ * @return false if the ring is full (message dropped)
+ *
+ * The producer claims all the slots of the message with one compare-and-swap
+ * on head, once the last of them is free. Slots are freed in order, so the
+ * others are free too. The message is then copied and each slot published.
+ */
+bool Logger::enqueue(LogLevel level, const char* message, size_t length) {
+    if (length > MAX_PARTS * SLOT_TEXT_BYTES) {
+        length = MAX_PARTS * SLOT_TEXT_BYTES;
+        truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+    uint32_t parts = length == 0 ? 1 : (length + SLOT_TEXT_BYTES - 1) / SLOT_TEXT_BYTES;
+
+    uint32_t position = head.load(std::memory_order_relaxed);
+    for (;;) {
+        uint32_t last = position + parts - 1;
+        uint32_t sequence = ring[last % SLOTS].sequence.load(std::memory_order_acquire);
+        int32_t lag = (int32_t)(sequence - last);
+        if (lag == 0) {
+            if (head.compare_exchange_weak(position, position + parts, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (lag < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = head.load(std::memory_order_relaxed);  // Another producer got there first
+        }
+    }
+
+    uint32_t used = position + parts - tail.load(std::memory_order_relaxed);
+    uint32_t peak = highWater.load(std::memory_order_relaxed);
+    while (used > peak && !highWater.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+    }
+
+    for (uint32_t part = 0; part < parts; part++) {
+        Slot& slot = ring[(position + part) % SLOTS];
+        size_t offset = part * SLOT_TEXT_BYTES;
+        size_t count = min(length - offset, SLOT_TEXT_BYTES);
+        slot.level = level;
+        slot.parts = parts;
+        slot.length = count;
+        memcpy(slot.text, message + offset, count);
+        slot.sequence.store(position + part + 1, std::memory_order_release);
+    }
+    return true;
+}
+
+/**
+ * @brief Print the oldest message of the ring, if it is complete
+ * @return false if the ring is empty or its oldest message is still being written
+ */
+bool Logger::drainOne() {
+    uint32_t position = tail.load(std::memory_order_relaxed);
+    Slot& first = ring[position % SLOTS];
+    if (first.sequence.load(std::memory_order_acquire) != position + 1) {
+        return false;
+    }
+    uint32_t parts = first.parts;
+    for (uint32_t part = 1; part < parts; part++) {
+        if (ring[(position + part) % SLOTS].sequence.load(std::memory_order_acquire) != position + part + 1) {
+            return false;  // Producer preempted while copying: next round
+        }
+    }
+
+    // Copy out and free the slots before printing: producers get them back at once
+    char text[MAX_PARTS * SLOT_TEXT_BYTES];
+    size_t length = 0;
+    LogLevel level = (LogLevel)first.level;
+    for (uint32_t part = 0; part < parts; part++) {
+        Slot& slot = ring[(position + part) % SLOTS];
+        memcpy(text + length, slot.text, slot.length);
+        length += slot.length;
+        slot.sequence.store(position + part + SLOTS, std::memory_order_release);
+    }
+    tail.store(position + parts, std::memory_order_relaxed);
+
+    uint32_t drops = dropped.load(std::memory_order_relaxed);
+    if (drops != reportedDrops) {
+        Serial.printf("[W] Logger: %lu messages dropped (ring full)\n", (unsigned long)(drops - reportedDrops));
+        reportedDrops = drops;
+    }
+    writeSerial(level, text, length);
+    written.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void Logger::writeSerial(LogLevel level, const char* text, size_t length) {
+    Serial.print(kLevelPrefixes[level]);
+    Serial.write(reinterpret_cast<const uint8_t*>(text), length);
+    Serial.println();
+}
+
+void Logger::writeScreen(const char* message) {
+    if (screenLine >= MAX_LINES) {
+        M5.Display.fillScreen(WHITE);
+        screenLine = 0;
+    }
+    M5.Display.setCursor(0, screenLine * LINE_HEIGHT);
+    M5.Display.println(message);
+    screenLine++;
+}
+
+Logger::Stats Logger::stats() const {
+    Stats result;
+    result.written = written.load(std::memory_order_relaxed);
+    result.dropped = dropped.load(std::memory_order_relaxed);
+    result.truncated = truncated.load(std::memory_order_relaxed);
+    result.highWater = highWater.load(std::memory_order_relaxed);
+    return result;
+}
+
+String Logger::describe() const {
+    Stats current = stats();
+    char line[128];
+    snprintf(line, sizeof(line), "Journal: %lu messages, %lu perdus (file pleine), %lu tronqués, file max %lu/%u%s",
+             (unsigned long)current.written, (unsigned long)current.dropped, (unsigned long)current.truncated,
+             (unsigned long)current.highWater, (unsigned)SLOTS, drainTask ? "" : " (synchrone)");
+    return String(line);
+}
+
 /**
  * @brief Enables or disables serial console logging
  * 
@@ -0,0 +1,430 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file MapWidget.cpp
+ * @brief Implementation of the minimap
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "MapWidget.h"
+#include "FixedTrig.h"
+#include "PsramAllocator.h"
+#include <string.h>
+
+static const float kMetersPerUnit = 0.0111320f;  // 1e-7 degree of latitude, in meters
+static const int16_t kMarkerRadius = 5;           // Boat marker area (half size)
+static const uint16_t kTrailColor = TFT_DARKCYAN;
+
+MapWidget::MapWidget(int16_t x, int16_t y, int16_t w, int16_t h)
+    : Widget(x, y, w, h), pool_(nullptr), buoyCount_(0), viewValid_(false), originLat_(0), originLon_(0),
+      scaleX_(0), scaleY_(0), metersPerPixel_(0), zoomInSince_(0), layerReady_(false), rebuildPending_(false),
+      lastTrim_(0), dirtyRectCount_(0) {
+    memset(tracks_, 0, sizeof(tracks_));
+    memset(buoys_, 0, sizeof(buoys_));
+    memset(buoyX_, 0, sizeof(buoyX_));
+    memset(buoyY_, 0, sizeof(buoyY_));
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+bool MapWidget::begin() {
+    if (pool_) return true;
+
+    pool_ = (TrackPoint*)largeMalloc(sizeof(TrackPoint) * TAIL_POINTS * MAX_TRACKS);
+    if (!pool_) return false;
+    for (int i = 0; i < MAX_TRACKS; i++) {
+        tracks_[i].points = pool_ + i * TAIL_POINTS;
+    }
+
+    layer_.setColorDepth(16);
+    layer_.setPsram(true);
+    layerReady_ = layer_.createSprite(bounds_.w, bounds_.h) != nullptr;
+    if (layerReady_) layer_.fillScreen(BLACK);
+    return true;
+}
+
+void MapWidget::project(int32_t lat, int32_t lon, int16_t& x, int16_t& y) const {
+    int64_t dx = ((int64_t)(lon - originLon_) * scaleX_) >> 24;
+    int64_t dy = ((int64_t)(lat - originLat_) * scaleY_) >> 24;
+    dx = constrain(dx, -16000, 16000);
+    dy = constrain(dy, -16000, 16000);
+    x = (int16_t)(bounds_.w / 2 + dx);
+    y = (int16_t)(bounds_.h / 2 - dy);
+}
+
+void MapWidget::fit(int32_t minLat, int32_t maxLat, int32_t minLon, int32_t maxLon) {
+    originLat_ = minLat + (maxLat - minLat) / 2;
+    originLon_ = minLon + (maxLon - minLon) / 2;
+
+    // East-west meters shrink with cos(latitude): one table lookup per fit
+    float cosLat = FixedTrig::cos(FixedTrig::fromDegrees(originLat_ * 1e-7f)) / (float)FixedTrig::ONE;
+    float metersPerUnitLon = kMetersPerUnit * cosLat;
+
+    // Fit with 50% headroom so that a moving fleet does not refit at every frame
+    float spanX = (maxLon - minLon) * metersPerUnitLon * 1.5f;
+    float spanY = (maxLat - minLat) * kMetersPerUnit * 1.5f;
+    float usableW = bounds_.w - 2 * MARGIN;
+    float usableH = bounds_.h - 2 * MARGIN;
+    float mpp = max(spanX / usableW, spanY / usableH);
+    float minMpp = (float)MIN_SPAN_M / usableH;
+    metersPerPixel_ = max(mpp, minMpp);
+
+    scaleX_ = (int64_t)(metersPerUnitLon / metersPerPixel_ * 16777216.0f);
+    scaleY_ = (int64_t)(kMetersPerUnit / metersPerPixel_ * 16777216.0f);
+    viewValid_ = true;
+    zoomInSince_ = 0;
+    stats_.refits++;
+
+    reprojectAll();
+}
+
+void MapWidget::reprojectAll() {
+    for (int i = 0; i < MAX_TRACKS; i++) {
+        Track& track = tracks_[i];
+        if (!track.used) continue;
+        // Live points only: once trimmed, the ring no longer starts at 0
+        int first = (track.head + TAIL_POINTS - track.count) % TAIL_POINTS;
+        for (int k = 0; k < track.count; k++) {
+            TrackPoint& p = track.points[(first + k) % TAIL_POINTS];
+            project(p.latitude, p.longitude, p.x, p.y);
+        }
+    }
+    for (int i = 0; i < buoyCount_; i++) {
+        project(buoys_[i].latitude, buoys_[i].longitude, buoyX_[i], buoyY_[i]);
+    }
+    rebuildPending_ = true;
+}
+
+void MapWidget::drawSegment(LovyanGFX& gfx, const TrackPoint& a, const TrackPoint& b, uint16_t color, int16_t x, int16_t y) {
+    gfx.drawLine(x + a.x, y + a.y, x + b.x, y + b.y, color);
+}
+
+void MapWidget::drawTrack(LovyanGFX& gfx, const Track& track, int16_t x, int16_t y) {
+    if (track.count < 2) return;
+    uint16_t color = track.selected ? YELLOW : kTrailColor;
+    int first = (track.head + TAIL_POINTS - track.count) % TAIL_POINTS;
+    for (int k = 1; k < track.count; k++) {
+        const TrackPoint& a = track.points[(first + k - 1) % TAIL_POINTS];
+        const TrackPoint& b = track.points[(first + k) % TAIL_POINTS];
+        drawSegment(gfx, a, b, color, x, y);
+    }
+}
+
+void MapWidget::rebuildLayer() {
+    rebuildPending_ = false;
+    if (!layerReady_) return;  // Without a layer, the tails are redrawn at each composition
+
+    unsigned long start = micros();
+    layer_.fillScreen(BLACK);
+    for (int i = 0; i < MAX_TRACKS; i++) {
+        if (tracks_[i].used) drawTrack(layer_, tracks_[i], 0, 0);
+    }
+    stats_.rebuilds++;
+    stats_.lastRebuildMicros = micros() - start;
+}
+
+MapWidget::Track* MapWidget::findTrack(uint32_t deviceId, bool create) {
+    Track* freeSlot = nullptr;
+    for (int i = 0; i < MAX_TRACKS; i++) {
+        Track& track = tracks_[i];
+        if (track.used && track.deviceId == deviceId) return &track;
+        if (!track.used && !freeSlot) freeSlot = &track;
+    }
+    if (!create || !freeSlot) return nullptr;
+
+    TrackPoint* points = freeSlot->points;
+    memset(freeSlot, 0, sizeof(Track));
+    freeSlot->points = points;
+    freeSlot->used = true;
+    freeSlot->deviceId = deviceId;
+    return freeSlot;
+}
+
+void MapWidget::append(Track& track, int32_t lat, int32_t lon, unsigned long now) {
+    TrackPoint p;
+    p.latitude = lat;
+    p.longitude = lon;
+    p.time = now;
+    project(lat, lon, p.x, p.y);
+
+    if (track.count > 0) {
+        const TrackPoint& last = track.points[(track.head + TAIL_POINTS - 1) % TAIL_POINTS];
+        // At most one point per second, and only if the boat moved on screen
+        if (now - last.time < MIN_APPEND_MS) return;
+        if (abs(p.x - last.x) < 2 && abs(p.y - last.y) < 2) return;
+
+        // Only the new segment is drawn into the layer
+        if (layerReady_ && !rebuildPending_) {
+            drawSegment(layer_, last, p, track.selected ? YELLOW : kTrailColor, 0, 0);
+        }
+        addDirty(min(last.x, p.x) - 1, min(last.y, p.y) - 1, abs(p.x - last.x) + 3, abs(p.y - last.y) + 3);
+        stats_.segments++;
+    }
+
+    track.points[track.head] = p;
+    track.head = (track.head + 1) % TAIL_POINTS;
+    if (track.count < TAIL_POINTS) {
+        track.count++;
+    }
+}
+
+// The ring holds more than one tail: points age out (trim) before being overwritten
+static_assert(MapWidget::TAIL_POINTS * MapWidget::MIN_APPEND_MS > MapWidget::TAIL_MS, "tail ring too small");
+
+void MapWidget::trim(unsigned long now) {
+    bool removed = false;
+    for (int i = 0; i < MAX_TRACKS; i++) {
+        Track& track = tracks_[i];
+        if (!track.used) continue;
+        int first = (track.head + TAIL_POINTS - track.count) % TAIL_POINTS;
+        while (track.count > 0 && now - track.points[first].time > TAIL_MS) {
+            first = (first + 1) % TAIL_POINTS;
+            track.count--;
+            removed = true;
+        }
+    }
+    if (removed) rebuildPending_ = true;
+}
+
+void MapWidget::addDirty(int16_t x, int16_t y, int16_t w, int16_t h) {
+    WidgetRect r = {(int16_t)(bounds_.x + x), (int16_t)(bounds_.y + y), w, h};
+    WidgetRect b = bounds_;
+    int16_t x0 = max(r.x, b.x);
+    int16_t y0 = max(r.y, b.y);
+    int16_t x1 = min<int16_t>(r.x + r.w, b.x + b.w);
+    int16_t y1 = min<int16_t>(r.y + r.h, b.y + b.h);
+    if (x1 <= x0 || y1 <= y0) return;
+    r = {x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+    markPartialDirty();
+
+    if (dirtyRectCount_ < MAX_DIRTY_RECTS) {
+        dirtyRects_[dirtyRectCount_++] = r;
+        return;
+    }
+
+    // List full: merge into the rectangle whose area grows the least
+    int best = 0;
+    int32_t bestGrowth = INT32_MAX;
+    for (int i = 0; i < dirtyRectCount_; i++) {
+        const WidgetRect& a = dirtyRects_[i];
+        int32_t w2 = max(a.x + a.w, r.x + r.w) - min(a.x, r.x);
+        int32_t h2 = max(a.y + a.h, r.y + r.h) - min(a.y, r.y);
+        int32_t growth = w2 * h2 - a.area();
+        if (growth < bestGrowth) {
+            bestGrowth = growth;
+            best = i;
+        }
+    }
+    WidgetRect& a = dirtyRects_[best];
+    int16_t ux1 = max(a.x + a.w, r.x + r.w);
+    int16_t uy1 = max(a.y + a.h, r.y + r.h);
+    a.x = min(a.x, r.x);
+    a.y = min(a.y, r.y);
+    a.w = ux1 - a.x;
+    a.h = uy1 - a.y;
+}
+
+void MapWidget::set(const FleetEntry* boats, int boatCount, int selected, const MapMark* buoys, int buoyCount,
+                    unsigned long now) {
+    if (!pool_) return;
+    unsigned long start = micros();
+
+    // Extent of the current positions (boats with a GPS fix, buoys)
+    bool any = false;
+    int32_t minLat = INT32_MAX, maxLat = INT32_MIN, minLon = INT32_MAX, maxLon = INT32_MIN;
+    auto extend = [&](int32_t lat, int32_t lon) {
+        minLat = min(minLat, lat);
+        maxLat = max(maxLat, lat);
+        minLon = min(minLon, lon);
+        maxLon = max(maxLon, lon);
+        any = true;
+    };
+    for (int i = 0; i < boatCount; i++) {
+        if (boats[i].latitude != 0 || boats[i].longitude != 0) extend(boats[i].latitude, boats[i].longitude);
+    }
+    if (buoyCount > MAX_BUOYS) buoyCount = MAX_BUOYS;
+    for (int i = 0; i < buoyCount; i++) {
+        extend(buoys[i].latitude, buoys[i].longitude);
+    }
+
+    // Re-project only when the view changes (position out of frame, or fleet small for a while)
+    if (any) {
+        if (!viewValid_) {
+            fit(minLat, maxLat, minLon, maxLon);
+        } else {
+            int16_t x0, y0, x1, y1;
+            project(minLat, minLon, x0, y0);
+            project(maxLat, maxLon, x1, y1);
+            bool outside = x0 < MARGIN || x1 > bounds_.w - MARGIN || y1 < MARGIN || y0 > bounds_.h - MARGIN;
+            bool small = (x1 - x0) < bounds_.w / 4 && (y0 - y1) < bounds_.h / 4 &&
+                         metersPerPixel_ > (float)MIN_SPAN_M / (bounds_.h - 2 * MARGIN) * 1.01f;
+            if (small && zoomInSince_ == 0) zoomInSince_ = now;
+            if (!small) zoomInSince_ = 0;
+            if (outside || (small && now - zoomInSince_ > ZOOM_IN_DELAY_MS)) {
+                fit(minLat, maxLat, minLon, maxLon);
+            }
+        }
+    }
+
+    // Buoys: marks, redrawn only when they move
+    bool buoysChanged = buoyCount != buoyCount_;
+    for (int i = 0; i < buoyCount && !buoysChanged; i++) {
+        buoysChanged = memcmp(&buoys[i], &buoys_[i], sizeof(MapMark)) != 0;
+    }
+    if (buoysChanged) {
+        for (int i = 0; i < buoyCount_; i++) addDirty(buoyX_[i] - 6, buoyY_[i] - 6, 22, 13);
+        memcpy(buoys_, buoys, buoyCount * sizeof(MapMark));
+        buoyCount_ = buoyCount;
+        for (int i = 0; i < buoyCount_; i++) {
+            project(buoys_[i].latitude, buoys_[i].longitude, buoyX_[i], buoyY_[i]);
+            addDirty(buoyX_[i] - 6, buoyY_[i] - 6, 22, 13);
+        }
+    }
+
+    // Boats: tail and marker
+    for (int i = 0; i < MAX_TRACKS; i++) tracks_[i].seen = false;
+    for (int i = 0; i < boatCount; i++) {
+        const FleetEntry& boat = boats[i];
+        if (boat.latitude == 0 && boat.longitude == 0) continue;
+        Track* track = findTrack(boat.deviceId, true);
+        if (!track) continue;
+        track->seen = true;
+
+        bool isSelected = (i == selected);
+        if (isSelected != track->selected) {
+            track->selected = isSelected;
+            rebuildPending_ = true;  // Tail color
+        }
+        if (viewValid_) append(*track, boat.latitude, boat.longitude, now);
+
+        int16_t x, y;
+        project(boat.latitude, boat.longitude, x, y);
+        if (!track->markerShown || x != track->markerX || y != track->markerY) {
+            if (track->markerShown) addDirty(track->markerX - kMarkerRadius, track->markerY - kMarkerRadius, 2 * kMarkerRadius + 1, 2 * kMarkerRadius + 1);
+            addDirty(x - kMarkerRadius, y - kMarkerRadius, 2 * kMarkerRadius + 1, 2 * kMarkerRadius + 1);
+            track->markerX = x;
+            track->markerY = y;
+            track->markerShown = true;
+        }
+    }
+
+    // Boats gone: marker and tail removed
+    for (int i = 0; i < MAX_TRACKS; i++) {
+        Track& track = tracks_[i];
+        if (track.used && !track.seen) {
+            track.used = false;
+            rebuildPending_ = true;
+        }
+    }
+
+    if (now - lastTrim_ >= TRIM_INTERVAL_MS) {
+        lastTrim_ = now;
+        trim(now);
+    }
+    if (rebuildPending_) {
+        rebuildLayer();
+        invalidate();
+    }
+
+    uint32_t elapsed = micros() - start;
+    stats_.updates++;
+    stats_.lastUpdateMicros = elapsed;
+    if (elapsed > stats_.maxUpdateMicros) stats_.maxUpdateMicros = elapsed;
+}
+
+int MapWidget::dirtyRegion(WidgetRect* rects) const {
+    if (fullDirty_ || dirtyRectCount_ == 0) {
+        return Widget::dirtyRegion(rects);
+    }
+    memcpy(rects, dirtyRects_, dirtyRectCount_ * sizeof(WidgetRect));
+    return dirtyRectCount_;
+}
+
+void MapWidget::clearDirty() {
+    Widget::clearDirty();
+    dirtyRectCount_ = 0;
+}
+
+void MapWidget::drawScale(LovyanGFX& gfx, int16_t x, int16_t y) {
+    // 40 px bar and the distance it covers
+    int16_t bx = x + 4;
+    int16_t by = y + bounds_.h - 4;
+    gfx.drawFastHLine(bx, by, 40, TFT_DARKGREY);
+    gfx.drawFastVLine(bx, by - 3, 4, TFT_DARKGREY);
+    gfx.drawFastVLine(bx + 39, by - 3, 4, TFT_DARKGREY);
+    gfx.setTextSize(1);
+    gfx.setTextColor(TFT_DARKGREY);
+    gfx.setTextDatum(BL_DATUM);
+    gfx.drawString(String((int)(metersPerPixel_ * 40 + 0.5f)) + " m", bx + 44, by + 1);
+}
+
+void MapWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    int16_t x = bounds_.x - originX;
+    int16_t y = bounds_.y - originY;
+
+    if (!viewValid_) {
+        gfx.setTextSize(1);
+        gfx.setTextColor(TFT_DARKGREY);
+        gfx.setTextDatum(MC_DATUM);
+        gfx.drawString("Aucune position GPS", x + bounds_.w / 2, y + bounds_.h / 2);
+        return;
+    }
+
+    // Tails: cached layer, or redrawn when the layer could not be allocated
+    if (layerReady_) {
+        layer_.pushSprite(&gfx, x, y);
+    } else {
+        for (int i = 0; i < MAX_TRACKS; i++) {
+            if (tracks_[i].used) drawTrack(gfx, tracks_[i], x, y);
+        }
+    }
+
+    // Buoys: orange triangle and number
+    gfx.setTextSize(1);
+    gfx.setTextDatum(ML_DATUM);
+    for (int i = 0; i < buoyCount_; i++) {
+        int16_t bx = x + buoyX_[i];
+        int16_t by = y + buoyY_[i];
+        gfx.fillTriangle(bx, by - 5, bx - 5, by + 4, bx + 5, by + 4, TFT_ORANGE);
+        gfx.setTextColor(TFT_ORANGE);
+        gfx.drawString(String(buoys_[i].id), bx + 8, by);
+    }
+
+    // Boats: white dot, larger and yellow for the selected boat
+    for (int i = 0; i < MAX_TRACKS; i++) {
+        const Track& track = tracks_[i];
+        if (!track.used || !track.markerShown) continue;
+        if (track.selected) {
+            gfx.fillCircle(x + track.markerX, y + track.markerY, 4, YELLOW);
+        } else {
+            gfx.fillCircle(x + track.markerX, y + track.markerY, 3, WHITE);
+        }
+    }
+
+    drawScale(gfx, x, y);
+}
+
+String MapWidget::describe() const {
+    char line[200];
+    snprintf(line, sizeof(line),
+             "Carte: %lu mises à jour, dernière %lu us (max %lu us), %lu segments ajoutés, "
+             "%lu recadrages, %lu reconstructions du calque (dernière %lu us), %.1f m/px",
+             (unsigned long)stats_.updates, (unsigned long)stats_.lastUpdateMicros,
+             (unsigned long)stats_.maxUpdateMicros, (unsigned long)stats_.segments,
+             (unsigned long)stats_.refits, (unsigned long)stats_.rebuilds,
+             (unsigned long)stats_.lastRebuildMicros, metersPerPixel_);
+    return String(line);
+}
@@ -0,0 +1,202 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file PowerGovernor.cpp
+ * @brief Implementation of the power state governor
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "PowerGovernor.h"
+#include "Logger.h"
+#include <M5Unified.h>
+
+// 80 MHz is the lowest clock that keeps WiFi / ESP-NOW running
+const PowerProfile PowerGovernor::kProfiles[POWER_STATE_COUNT] = {
+    {240, RenderTask::DEFAULT_FRAME_RATE, 50},  // POWER_ACTIVE
+    {160, 5, 50},                               // POWER_IDLE
+    {80, 2, 100},                               // POWER_DEEP_IDLE
+};
+
+static const char* const kStateNames[POWER_STATE_COUNT] = {"actif", "veille", "veille profonde"};
+
+PowerGovernor::PowerGovernor()
+    : logger_(nullptr), render_(nullptr), state_(POWER_ACTIVE), started_(false), clockLocked_(false), packets_(0),
+      lastInteraction_(0), lastBusy_(0), lastChange_(0), lastUpdate_(0), windowStart_(0), lastCurrentSample_(0),
+      windowFrames_(0), lastFrames_(0), lastPackets_(0), lastLost_(0) {
+    memset(stats_, 0, sizeof(stats_));
+}
+
+void PowerGovernor::begin(RenderTask& render) {
+    render_ = &render;
+    unsigned long now = millis();
+    lastInteraction_ = lastBusy_ = lastChange_ = lastUpdate_ = windowStart_ = lastCurrentSample_ = now;
+    lastFrames_ = render.stats().frames;
+    lastPackets_ = packets_;
+    started_ = true;
+    apply(POWER_ACTIVE, "démarrage");
+}
+
+void PowerGovernor::apply(PowerState state, const char* reason) {
+    const PowerProfile& profile = kProfiles[state];
+    uint32_t mhz = clockLocked_ ? kProfiles[POWER_ACTIVE].cpuMhz : profile.cpuMhz;
+    if (getCpuFrequencyMhz() != mhz) {
+        setCpuFrequencyMhz(mhz);
+    }
+    render_->setFrameRate(profile.frameRate);  // Wakes the render task: the next frame uses the new rate
+    state_ = state;
+    stats_[state].entries++;
+    if (logger_) {
+        LOGI(*logger_, "Énergie: %s (%lu MHz, %lu img/s) - %s", kStateNames[state], (unsigned long)mhz,
+             (unsigned long)profile.frameRate, reason);
+    }
+}
+
+void PowerGovernor::noteInteraction() {
+    unsigned long now = millis();
+    lastInteraction_ = now;
+    if (!started_ || state_ == POWER_ACTIVE) return;
+
+    stats_[state_].timeMs += now - lastUpdate_;
+    lastUpdate_ = now;
+    apply(POWER_ACTIVE, "interaction");
+}
+
+void PowerGovernor::checkLossGuard() {
+    if (clockLocked_) return;
+    const PowerStateStats& active = stats_[POWER_ACTIVE];
+    if (active.packets < LOSS_GUARD_MIN_PACKETS) return;
+    float activeLoss = (float)active.lostPackets / (active.packets + active.lostPackets);
+
+    for (int s = POWER_IDLE; s < POWER_STATE_COUNT; s++) {
+        const PowerStateStats& reduced = stats_[s];
+        if (reduced.packets < LOSS_GUARD_MIN_PACKETS) continue;
+        float reducedLoss = (float)reduced.lostPackets / (reduced.packets + reduced.lostPackets);
+        if (reducedLoss > activeLoss + 0.01f) {
+            clockLocked_ = true;
+            setCpuFrequencyMhz(kProfiles[POWER_ACTIVE].cpuMhz);
+            if (logger_) {
+                LOGW(*logger_, "Énergie: pertes en %s (%.1f%%) supérieures à l'état actif (%.1f%%), horloge maintenue à %lu MHz",
+                     kStateNames[s], reducedLoss * 100, activeLoss * 100,
+                     (unsigned long)kProfiles[POWER_ACTIVE].cpuMhz);
+            }
+            return;
+        }
+    }
+}
+
+void PowerGovernor::update(uint32_t lostPackets, bool keepActive) {
+    if (!started_) return;
+    unsigned long now = millis();
+    PowerStateStats& inState = stats_[state_];
+    inState.timeMs += now - lastUpdate_;
+    lastUpdate_ = now;
+
+    // Incoming data (the boat list can shrink: the loss total restarts lower)
+    uint32_t packets = packets_;
+    uint32_t newPackets = packets - lastPackets_;
+    lastPackets_ = packets;
+    if (lostPackets < lastLost_) lastLost_ = lostPackets;
+    inState.packets += newPackets;
+    inState.lostPackets += lostPackets - lastLost_;
+    lastLost_ = lostPackets;
+    if (newPackets > 0) lastChange_ = now;
+
+    // Screen changes: frames actually pushed by the render task
+    uint32_t frames = render_->stats().frames;
+    uint32_t newFrames = frames - lastFrames_;
+    lastFrames_ = frames;
+    if (newFrames > 0) lastChange_ = now;
+    windowFrames_ += newFrames;
+    if (now - windowStart_ >= 1000) {
+        if (windowFrames_ * 1000 >= BUSY_FRAMES_PER_SECOND * (now - windowStart_)) lastBusy_ = now;
+        windowFrames_ = 0;
+        windowStart_ = now;
+    }
+
+    // Battery draw once per second (negative current: discharging)
+    if (now - lastCurrentSample_ >= 1000) {
+        lastCurrentSample_ = now;
+        int32_t milliamps = M5.Power.getBatteryCurrent();
+        if (milliamps < 0) {
+            inState.currentSum += -milliamps;
+            inState.currentSamples++;
+        }
+    }
+
+    PowerState wanted;
+    const char* reason;
+    if (keepActive || now - lastInteraction_ < INTERACTION_HOLD_MS) {
+        wanted = POWER_ACTIVE;
+        reason = "interaction";
+    } else if (now - lastBusy_ < IDLE_AFTER_MS) {
+        wanted = POWER_ACTIVE;
+        reason = "écran actif";
+    } else if (now - lastChange_ < DEEP_AFTER_MS) {
+        wanted = POWER_IDLE;
+        reason = "données reçues";
+    } else {
+        wanted = POWER_DEEP_IDLE;
+        reason = "inactivité";
+    }
+    if (wanted != state_) {
+        apply(wanted, reason);
+    }
+
+    checkLossGuard();
+}
+
+static String formatDuration(uint64_t ms) {
+    unsigned long seconds = ms / 1000;
+    char text[16];
+    if (seconds >= 3600) {
+        snprintf(text, sizeof(text), "%luh%02lum", seconds / 3600, (seconds / 60) % 60);
+    } else {
+        snprintf(text, sizeof(text), "%lum%02lus", seconds / 60, seconds % 60);
+    }
+    return String(text);
+}
+
+String PowerGovernor::describe() const {
+    if (!started_) {
+        return "Énergie: gouverneur non démarré";
+    }
+
+    String line = String("Énergie: ") + kStateNames[state_] + " (" + getCpuFrequencyMhz() + " MHz";
+    if (clockLocked_) line += ", horloge maintenue";
+    line += ");";
+
+    float average[POWER_STATE_COUNT];
+    for (int s = 0; s < POWER_STATE_COUNT; s++) {
+        const PowerStateStats& st = stats_[s];
+        average[s] = st.currentSamples > 0 ? (float)st.currentSum / st.currentSamples : -1;
+        line += String(s == 0 ? " " : ", ") + kStateNames[s] + " " + formatDuration(st.timeMs);
+        if (average[s] >= 0) line += " " + String(average[s], 0) + " mA";
+    }
+
+    // Saving: each reduced state against the draw measured in ACTIVE
+    if (average[POWER_ACTIVE] < 0) {
+        line += "; économie estimée n/d (pas de mesure en actif)";
+    } else {
+        float savedmAh = 0;
+        for (int s = POWER_IDLE; s < POWER_STATE_COUNT; s++) {
+            if (average[s] < 0) continue;
+            savedmAh += (average[POWER_ACTIVE] - average[s]) * stats_[s].timeMs / 3600000.0f;
+        }
+        line += "; économie estimée " + String(savedmAh, 1) + " mAh";
+    }
+    return line;
+}
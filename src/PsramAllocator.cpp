@@ -0,0 +1,147 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file PsramAllocator.cpp
+ * @brief Implementation of the PSRAM-aware allocation layer
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "PsramAllocator.h"
+#include <soc/soc_memory_layout.h>
+
+// Capabilities of each region
+#define CAPS_PSRAM    (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#define CAPS_INTERNAL (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+
+void* psramMalloc(size_t size) {
+    return heap_caps_malloc(size, CAPS_PSRAM);
+}
+
+void* largeMalloc(size_t size) {
+    void* ptr = heap_caps_malloc(size, CAPS_PSRAM);
+    if (!ptr) {
+        ptr = heap_caps_malloc(size, CAPS_INTERNAL);
+    }
+    return ptr;
+}
+
+void* largeRealloc(void* ptr, size_t size) {
+    if (!ptr) {
+        return largeMalloc(size);
+    }
+    // Stay in the region of the original block when possible
+    void* resized = heap_caps_realloc(ptr, size, isPsramPointer(ptr) ? CAPS_PSRAM : CAPS_INTERNAL);
+    if (!resized) {
+        resized = heap_caps_realloc(ptr, size, isPsramPointer(ptr) ? CAPS_INTERNAL : CAPS_PSRAM);
+    }
+    return resized;
+}
+
+void largeFree(void* ptr) {
+    if (ptr) {
+        heap_caps_free(ptr);
+    }
+}
+
+bool isPsramPointer(const void* ptr) {
+    // Address range of the target's external RAM, as mapped by ESP-IDF
+    return esp_ptr_external_ram(ptr);
+}
+
+static MemoryRegionStats getRegionStats(uint32_t caps) {
+    MemoryRegionStats stats = {};
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+
+    stats.totalBytes = heap_caps_get_total_size(caps);
+    stats.freeBytes = info.total_free_bytes;
+    stats.largestFreeBlock = info.largest_free_block;
+    stats.minimumFreeBytes = info.minimum_free_bytes;
+    if (stats.freeBytes > 0) {
+        stats.fragmentation = (uint8_t)(100 - (stats.largestFreeBlock * 100) / stats.freeBytes);
+    }
+    return stats;
+}
+
+MemoryRegionStats getInternalMemoryStats() {
+    return getRegionStats(CAPS_INTERNAL);
+}
+
+MemoryRegionStats getPsramMemoryStats() {
+    return getRegionStats(CAPS_PSRAM);
+}
+
+static String describeRegion(const char* name, const MemoryRegionStats& stats) {
+    if (stats.totalBytes == 0) {
+        return String(name) + ": absent";
+    }
+    return String(name) + ": " + String((stats.totalBytes - stats.freeBytes) / 1024) + "/" +
+           String(stats.totalBytes / 1024) + " KB used, min free " +
+           String(stats.minimumFreeBytes / 1024) + " KB, largest " +
+           String(stats.largestFreeBlock / 1024) + " KB, frag " +
+           String(stats.fragmentation) + "%";
+}
+
+String describeMemoryUsage() {
+    return describeRegion("Internal", getInternalMemoryStats()) + " | " +
+           describeRegion("PSRAM", getPsramMemoryStats());
+}
+
+LargeBuffer::LargeBuffer(size_t initialCapacity) : data_(nullptr), length_(0), capacity_(0) {
+    grow(initialCapacity);
+}
+
+LargeBuffer::~LargeBuffer() {
+    largeFree(data_);
+}
+
+bool LargeBuffer::grow(size_t needed) {
+    if (needed <= capacity_) {
+        return true;
+    }
+    size_t newCapacity = capacity_ ? capacity_ : 256;
+    while (newCapacity < needed) {
+        newCapacity *= 2;
+    }
+    char* resized = (char*)largeRealloc(data_, newCapacity);
+    if (!resized) {
+        return false;
+    }
+    if (!data_) {
+        resized[0] = '\0';
+    }
+    data_ = resized;
+    capacity_ = newCapacity;
+    return true;
+}
+
+bool LargeBuffer::append(const char* text, size_t len) {
+    if (!grow(length_ + len + 1)) {
+        return false;
+    }
+    memcpy(data_ + length_, text, len);
+    length_ += len;
+    data_[length_] = '\0';
+    return true;
+}
+
+void LargeBuffer::clear() {
+    length_ = 0;
+    if (data_) {
+        data_[0] = '\0';
+    }
+}
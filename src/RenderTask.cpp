@@ -0,0 +1,165 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file RenderTask.cpp
+ * @brief Implementation of the fixed-rate render task
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "RenderTask.h"
+#include <algorithm>
+
+RenderTask::RenderTask()
+    : display_(nullptr), task_(nullptr), mutex_(nullptr), periodMs_(1000 / DEFAULT_FRAME_RATE),
+      budgetUs_(1000000 / DEFAULT_FRAME_RATE), sampleCount_(0), sampleIndex_(0) {
+    memset(&shared_, 0, sizeof(shared_));
+    memset(&stats_, 0, sizeof(stats_));
+    memset(samples_, 0, sizeof(samples_));
+}
+
+bool RenderTask::begin(Display& display, uint32_t frameRate, uint32_t budgetMs) {
+    if (task_) return true;
+    if (frameRate == 0) frameRate = DEFAULT_FRAME_RATE;
+
+    display_ = &display;
+    periodMs_ = 1000 / frameRate;
+    budgetUs_ = (budgetMs > 0 ? budgetMs : periodMs_) * 1000;
+
+    mutex_ = xSemaphoreCreateMutex();
+    if (!mutex_) return false;
+
+    // Core 0: the main loop (touch, file server) keeps core 1 to itself
+    BaseType_t created = xTaskCreatePinnedToCore(taskEntry, "RenderTask", 6144, this, 1, &task_, 0);
+    return created == pdPASS;
+}
+
+void RenderTask::taskEntry(void* parameter) {
+    static_cast<RenderTask*>(parameter)->run();
+}
+
+void RenderTask::publish(const DisplaySnapshot& snapshot) {
+    if (!mutex_) return;
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    if (memcmp(&shared_, &snapshot, sizeof(shared_)) != 0) {
+        memcpy(&shared_, &snapshot, sizeof(shared_));
+        stats_.snapshots++;
+    }
+    xSemaphoreGive(mutex_);
+}
+
+void RenderTask::setFrameRate(uint32_t frameRate) {
+    if (frameRate == 0 || 1000 / frameRate == periodMs_) return;
+    periodMs_ = 1000 / frameRate;
+    if (task_) xTaskNotifyGive(task_);
+}
+
+void RenderTask::run() {
+    TickType_t nextWake = xTaskGetTickCount();
+    DisplaySnapshot snapshot;
+
+    for (;;) {
+        // Wait for the next tick, or for a rate change (drawn at once)
+        TickType_t period = pdMS_TO_TICKS(periodMs_);
+        nextWake += period;
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(nextWake - now) > 0 && ulTaskNotifyTake(pdTRUE, nextWake - now) > 0) {
+            nextWake = xTaskGetTickCount();
+        }
+
+        xSemaphoreTake(mutex_, portMAX_DELAY);
+        memcpy(&snapshot, &shared_, sizeof(snapshot));
+        xSemaphoreGive(mutex_);
+
+        // The compositor counters tell whether the frame pushed or was postponed
+        const DisplayFrameStats& frameStats = display_->getFrameStats();
+        uint32_t framesBefore = frameStats.frames;
+        uint32_t postponedBefore = frameStats.postponedFrames;
+
+        unsigned long start = micros();
+        display_->drawDisplay(snapshot);
+        uint32_t elapsed = micros() - start;
+
+        recordFrame(elapsed, frameStats.frames != framesBefore, frameStats.postponedFrames != postponedBefore);
+
+        // Drop the ticks that elapsed during an overrun instead of catching up;
+        // an over-budget frame also gives up the next tick to the other tasks
+        TickType_t late = xTaskGetTickCount() - nextWake;
+        uint32_t drop = late / period;
+        if (elapsed > budgetUs_ && drop == 0) drop = 1;
+        if (drop > 0) {
+            nextWake += drop * period;
+            xSemaphoreTake(mutex_, portMAX_DELAY);
+            stats_.skipped += drop;
+            xSemaphoreGive(mutex_);
+        }
+    }
+}
+
+void RenderTask::recordFrame(uint32_t elapsedUs, bool pushed, bool postponed) {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    stats_.ticks++;
+    if (postponed) stats_.postponed++;
+    if (elapsedUs > budgetUs_) stats_.overBudget++;
+    if (pushed) {
+        stats_.frames++;
+        samples_[sampleIndex_] = elapsedUs;
+        sampleIndex_ = (sampleIndex_ + 1) % FRAME_SAMPLES;
+        if (sampleCount_ < FRAME_SAMPLES) sampleCount_++;
+    }
+    xSemaphoreGive(mutex_);
+}
+
+RenderStats RenderTask::stats() const {
+    RenderStats copy;
+    if (!mutex_) {
+        memset(&copy, 0, sizeof(copy));
+        return copy;
+    }
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    copy = stats_;
+    xSemaphoreGive(mutex_);
+    return copy;
+}
+
+String RenderTask::describe() const {
+    if (!mutex_) {
+        return "Rendu: tâche non démarrée";
+    }
+
+    uint32_t sorted[FRAME_SAMPLES];
+    RenderStats s;
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    int count = sampleCount_;
+    memcpy(sorted, samples_, count * sizeof(uint32_t));
+    s = stats_;
+    xSemaphoreGive(mutex_);
+
+    std::sort(sorted, sorted + count);
+    auto percentile = [&](int p) -> unsigned long {
+        return count > 0 ? sorted[(count - 1) * p / 100] : 0;
+    };
+
+    char line[240];
+    snprintf(line, sizeof(line),
+             "Rendu: %lu Hz cible, %lu ticks, %lu images, %lu sautées, %lu hors budget (%lu us), "
+             "%lu reportées (bus), %lu instantanés; temps image p50 %lu us p90 %lu us p99 %lu us max %lu us (%d dernières)",
+             (unsigned long)(1000 / periodMs_), (unsigned long)s.ticks, (unsigned long)s.frames,
+             (unsigned long)s.skipped, (unsigned long)s.overBudget, (unsigned long)budgetUs_,
+             (unsigned long)s.postponed, (unsigned long)s.snapshots,
+             percentile(50), percentile(90), percentile(99), percentile(100), count);
+    return String(line);
+}
@@ -0,0 +1,104 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file SdStorageBackend.cpp
+ * @brief SD card implementation of the StorageBackend interface
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "SdStorageBackend.h"
+
+FileLookup SdStorageBackend::lookup(const char* path) {
+    BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+    if (!lock.isLocked()) return FILE_UNAVAILABLE;
+    return SD.exists(path) ? FILE_FOUND : FILE_MISSING;
+}
+
+bool SdStorageBackend::open(const char* path, bool truncate) {
+    BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+    if (!lock.isLocked()) return false;
+    unsigned long start = micros();
+    file_ = SD.open(path, truncate ? FILE_WRITE : "r+");
+    position_ = 0;
+    stats_.opens++;
+    stats_.ioMicros += micros() - start;
+    return (bool)file_;
+}
+
+size_t SdStorageBackend::size() {
+    return file_ ? file_.size() : 0;
+}
+
+bool SdStorageBackend::seek(uint32_t position) {
+    if (!file_) return false;
+    BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+    if (!lock.isLocked()) return false;
+    unsigned long start = micros();
+    bool ok = file_.seek(position);
+    if (ok) {
+        // Updating a partially written sector requires reading it back
+        if (position % SECTOR_SIZE != 0) {
+            stats_.sectorReads++;
+        }
+        position_ = position;
+    }
+    stats_.ioMicros += micros() - start;
+    return ok;
+}
+
+size_t SdStorageBackend::write(const uint8_t* data, size_t len) {
+    if (!file_ || len == 0) return 0;
+
+    // One bus slot per bounded block: a frame can be pushed between two blocks
+    size_t written = 0;
+    while (written < len) {
+        size_t chunk = len - written;
+        if (bus_ && chunk > BusScheduler::STORAGE_SLOT_BYTES) {
+            chunk = BusScheduler::STORAGE_SLOT_BYTES;
+        }
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (!lock.isLocked()) break;
+        unsigned long start = micros();
+        size_t n = file_.write(data + written, chunk);
+        stats_.ioMicros += micros() - start;
+        written += n;
+        if (n < chunk) break;
+    }
+    if (written == 0) return 0;
+
+    uint32_t firstSector = position_ / SECTOR_SIZE;
+    uint32_t lastSector = (position_ + written - 1) / SECTOR_SIZE;
+    stats_.sectorWrites += lastSector - firstSector + 1;
+    stats_.physicalBytes += (uint64_t)(lastSector - firstSector + 1) * SECTOR_SIZE;
+    stats_.logicalBytes += written;
+    stats_.writeCalls++;
+    position_ += written;
+    return written;
+}
+
+void SdStorageBackend::close() {
+    if (!file_) return;
+    BusLock lock(bus_, BusScheduler::CLIENT_STORAGE, portMAX_DELAY);
+    unsigned long start = micros();
+    file_.close();
+    stats_.ioMicros += micros() - start;
+}
+
+bool SdStorageBackend::remove(const char* path) {
+    BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+    return lock.isLocked() && SD.remove(path);
+}
@@ -0,0 +1,169 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file SimulatedSdBackend.cpp
+ * @brief Implementation of the simulated SD card
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "SimulatedSdBackend.h"
+
+SimulatedSdBackend::SimulatedSdBackend(const SimulatedSdConfig& config)
+    : config_(config), openFile_(nullptr), position_(0), cachedSector_(-1),
+      cacheDirty_(false), fatDirty_(false), dirDirty_(false) {
+}
+
+void SimulatedSdBackend::writeSector() {
+    stats_.sectorWrites++;
+    stats_.physicalBytes += config_.sectorSize;
+    addTime(config_.sectorWriteUs);
+}
+
+void SimulatedSdBackend::flushCache() {
+    if (cacheDirty_) {
+        writeSector();
+        cacheDirty_ = false;
+    }
+}
+
+FileLookup SimulatedSdBackend::lookup(const char* path) {
+    return files_.find(path) != files_.end() ? FILE_FOUND : FILE_MISSING;
+}
+
+bool SimulatedSdBackend::open(const char* path, bool truncate) {
+    if (openFile_) {
+        close();
+    }
+    stats_.opens++;
+    addTime(config_.openUs);
+
+    auto it = files_.find(path);
+    if (it == files_.end()) {
+        if (!truncate) {
+            return false;
+        }
+        it = files_.insert(std::make_pair(std::string(path), SimFile{0, 0})).first;
+        dirDirty_ = true;
+    } else if (truncate) {
+        if (it->second.clusters > 0) {
+            fatDirty_ = true;  // Cluster chain released
+        }
+        it->second.size = 0;
+        it->second.clusters = 0;
+        dirDirty_ = true;
+    }
+
+    openFile_ = &it->second;
+    position_ = 0;
+    cachedSector_ = -1;
+    cacheDirty_ = false;
+    return true;
+}
+
+size_t SimulatedSdBackend::size() {
+    return openFile_ ? openFile_->size : 0;
+}
+
+bool SimulatedSdBackend::seek(uint32_t position) {
+    if (!openFile_ || position > openFile_->size) {
+        return false;
+    }
+    position_ = position;
+    return true;
+}
+
+size_t SimulatedSdBackend::write(const uint8_t* data, size_t len) {
+    (void)data;
+    if (!openFile_ || len == 0) {
+        return 0;
+    }
+    stats_.writeCalls++;
+    stats_.logicalBytes += len;
+
+    size_t remaining = len;
+    while (remaining > 0) {
+        uint32_t sector = position_ / config_.sectorSize;
+        uint32_t offsetInSector = position_ % config_.sectorSize;
+        uint32_t chunk = config_.sectorSize - offsetInSector;
+        if (chunk > remaining) chunk = remaining;
+
+        if ((int64_t)sector != cachedSector_) {
+            flushCache();
+            // Partial update of a sector holding data: read it first
+            bool sectorHasData = (uint64_t)sector * config_.sectorSize < openFile_->size;
+            if (sectorHasData && chunk < config_.sectorSize) {
+                stats_.sectorReads++;
+                addTime(config_.sectorReadUs);
+            }
+            cachedSector_ = sector;
+        }
+        cacheDirty_ = true;
+
+        position_ += chunk;
+        remaining -= chunk;
+
+        // Full sector: FatFs writes it directly
+        if (position_ % config_.sectorSize == 0) {
+            flushCache();
+            cachedSector_ = -1;
+        }
+
+        if (position_ > openFile_->size) {
+            openFile_->size = position_;
+            dirDirty_ = true;
+            uint32_t neededClusters = (openFile_->size + config_.clusterSize - 1) / config_.clusterSize;
+            while (openFile_->clusters < neededClusters) {
+                openFile_->clusters++;
+                stats_.clusterAllocs++;
+                addTime(config_.clusterAllocUs);
+                fatDirty_ = true;
+            }
+        }
+    }
+    return len;
+}
+
+void SimulatedSdBackend::close() {
+    if (!openFile_) {
+        return;
+    }
+    flushCache();
+    if (fatDirty_) {
+        writeSector();  // FAT1
+        writeSector();  // FAT2 (mirror)
+        fatDirty_ = false;
+    }
+    if (dirDirty_) {
+        writeSector();  // Directory entry (size, date)
+        dirDirty_ = false;
+    }
+    addTime(config_.closeUs);
+    openFile_ = nullptr;
+    cachedSector_ = -1;
+}
+
+bool SimulatedSdBackend::remove(const char* path) {
+    auto it = files_.find(path);
+    if (it == files_.end()) {
+        return false;
+    }
+    if (openFile_ == &it->second) {
+        openFile_ = nullptr;
+    }
+    files_.erase(it);
+    return true;
+}
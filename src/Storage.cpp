@@ -25,6 +25,7 @@
 
 #include "Storage.h"
 #include "Logger.h"
+#include "HistoryBuffer.h"
 #include <SPI.h>
 #include <M5Unified.h>
 #include <WiFi.h>
@@ -36,15 +37,36 @@
 #define SPI_MOSI 23  ///< Master Out Slave In pin (outgoing data)  
 #define SPI_CS   4   ///< Chip Select pin (SD card selection)
 
-Storage::Storage() : logger_(nullptr), sdInitialized_(false) {
+Storage::Storage() : logger_(nullptr), history_(nullptr), backend_(&sdBackend_), bus_(nullptr), sdInitialized_(false), lastWriteBusy_(false), preTriggerWritten_(0), ntpPending_(false), ntpStartMs_(0), recordingRequested_(false) {
     // Filename will be generated later when RTC is initialized
     currentFileName_ = "";
+    requestLock_ = portMUX_INITIALIZER_UNLOCKED;
+    requestedFileName_[0] = '\0';
+    memset(&requestedTrigger_, 0, sizeof(requestedTrigger_));
 }
 
 void Storage::setLogger(Logger& logger) {
     logger_ = &logger;
 }
 
+void Storage::setHistory(HistoryBuffer& history) {
+    history_ = &history;
+}
+
+void Storage::setBus(BusScheduler& bus) {
+    bus_ = &bus;
+    sdBackend_.setBus(&bus);
+}
+
+void Storage::setBackend(StorageBackend& backend) {
+    backend_ = &backend;
+    sdInitialized_ = true;
+}
+
+void Storage::setFileName(const String& fileName) {
+    currentFileName_ = fileName;
+}
+
 void Storage::log(const String& message) {
     if (logger_) {
         logger_->log(message);
@@ -52,6 +74,10 @@ void Storage::log(const String& message) {
 }
 
 bool Storage::initSD() {
+    // SPI.begin() and SD.begin() reconfigure the bus shared with the LCD:
+    // the whole sequence runs in one storage slot, frames wait for it
+    BusLock lock(bus_, BusScheduler::CLIENT_STORAGE, portMAX_DELAY);
+    
     // Initialize SPI pins for SD card with Core2 configuration
     SPI.begin(SPI_SCK, SPI_MISO, SPI_MOSI, SPI_CS);
     
@@ -95,8 +121,80 @@ bool Storage::initializeFileName() {
 }
 
 void Storage::startNewRecording() {
-    currentFileName_ = generateFileName();
+    String fileName = generateFileName();
+    
+    // The window ends now: entries received from here on are live data
+    HistoryTrigger trigger = {0, 0};
+    if (history_) {
+        trigger = history_->captureTrigger();
+    }
+    
+    portENTER_CRITICAL(&requestLock_);
+    strncpy(requestedFileName_, fileName.c_str(), sizeof(requestedFileName_) - 1);
+    requestedFileName_[sizeof(requestedFileName_) - 1] = '\0';
+    requestedTrigger_ = trigger;
+    recordingRequested_ = true;
+    portEXIT_CRITICAL(&requestLock_);
+}
+
+void Storage::applyNewRecording() {
+    char fileName[sizeof(requestedFileName_)];
+    HistoryTrigger trigger;
+    
+    portENTER_CRITICAL(&requestLock_);
+    bool requested = recordingRequested_;
+    if (requested) {
+        memcpy(fileName, requestedFileName_, sizeof(fileName));
+        trigger = requestedTrigger_;
+        recordingRequested_ = false;
+    }
+    portEXIT_CRITICAL(&requestLock_);
+    if (!requested) {
+        return;
+    }
+    
+    currentFileName_ = fileName;
     log("New recording file: " + currentFileName_);
+    
+    // Entries of the previous window not written yet are dropped with it
+    preTriggerBatch_.clear();
+    preTriggerWritten_ = 0;
+    if (history_) {
+        history_->markTrigger(trigger);
+    }
+}
+
+bool Storage::flushPreTrigger(size_t maxBatch, size_t maxBatches) {
+    applyNewRecording();
+    if (!history_) {
+        return true;
+    }
+    
+    // A batch refused because the SD was busy is written again first
+    for (size_t batches = 0; batches < maxBatches && hasPendingPreTrigger(); batches++) {
+        if (preTriggerBatch_.empty() &&
+            history_->drainPreTrigger(preTriggerBatch_, maxBatch) == 0) {
+            break;
+        }
+        if (!writeDataBatch(preTriggerBatch_)) {
+            if (!lastWriteBusy_) {
+                preTriggerBatch_.clear();
+                log("Error writing pre-trigger history");
+            }
+            return false;
+        }
+        preTriggerWritten_ += preTriggerBatch_.size();
+        preTriggerBatch_.clear();
+        
+        if (!hasPendingPreTrigger()) {
+            log("Pre-trigger history written: " + String(preTriggerWritten_) + " entries");
+        }
+    }
+    return true;
+}
+
+bool Storage::hasPendingPreTrigger() const {
+    return !preTriggerBatch_.empty() || (history_ && history_->hasPendingPreTrigger());
 }
 
 String Storage::generateFileName() {
@@ -120,6 +218,12 @@ String Storage::generateFileName() {
         String baseName = "/replay/session_" + macSuffix + "_";
         
         // Check for existing files and increment session number
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (!lock.isLocked()) {
+            // Card unreachable: a name that cannot match an earlier session
+            log("SD busy: session number not checked");
+            return baseName + "t" + String(millis()) + ".json";
+        }
         while (sessionNumber < 1000) {
             String testName = baseName + String(sessionNumber) + ".json";
             if (!SD.exists(testName)) {
@@ -142,12 +246,14 @@ String Storage::generateFileName() {
 
 bool Storage::writeData(const StorageData& data) {
     // Delegate to writeDataBatch for consistent Kepler-compatible format
-    std::vector<StorageData> batch;
+    StorageBatch batch;
     batch.push_back(data);
     return writeDataBatch(batch);
 }
 
-bool Storage::writeDataBatch(const std::vector<StorageData>& dataList) {
+bool Storage::writeDataBatch(const StorageBatch& dataList) {
+    lastWriteBusy_ = false;
+    
     // Preliminary checks
     if (!sdInitialized_ || dataList.empty()) {
         if (!sdInitialized_) {
@@ -179,43 +285,66 @@ bool Storage::writeDataBatch(const std::vector<StorageData>& dataList) {
     rtcTm.tm_isdst = -1;
     time_t rtcEpoch = mktime(&rtcTm);
     
+    // Serialize the whole batch in RAM first (PSRAM), so the card sees a
+    // few large writes instead of one small write per JSON token
+    LargeBuffer payload(dataList.size() * 180 + 8);
+    
     // Open file as proper JSON array: [{...},{...},...]
     // First batch creates file with "[", subsequent batches
     // seek before closing "]" and append with ","
-    File file;
-    bool isNewFile = true;
-    
-    if (SD.exists(currentFileName_)) {
-        // Try opening in read+write mode to update existing array
-        file = SD.open(currentFileName_, "r+");
-        if (file && file.size() >= 3) {
-            isNewFile = false;
+    const char* fileName = currentFileName_.c_str();
+    bool opened = false;
+    
+    FileLookup lookup = backend_->lookup(fileName);
+    if (lookup == FILE_UNAVAILABLE) {
+        // The file may hold a recording: never fall through to the create
+        // path, the caller keeps the batch and retries
+        lastWriteBusy_ = true;
+        log("SD busy: batch kept for retry");
+        return false;
+    }
+    uint32_t base = 0;  // Where this batch starts in the file
+    if (lookup == FILE_FOUND) {
+        // Open in read+write mode to update the existing array. A failure
+        // here is not a reason to recreate the file either
+        if (!backend_->open(fileName, false)) {
+            lastWriteBusy_ = true;
+            log("Error opening " + currentFileName_ + ": batch kept for retry");
+            return false;
+        }
+        size_t fileSize = backend_->size();
+        if (fileSize >= 3) {
             // Seek before closing "\n]" (2 bytes from end)
-            file.seek(file.size() - 2);
-            file.print(",\n");
-        } else {
-            // File exists but is too small/corrupt - recreate
-            if (file) file.close();
-            file = SD.open(currentFileName_, FILE_WRITE);
-            if (!file) {
-                log("Error creating file: " + currentFileName_);
+            base = fileSize - 2;
+            if (!backend_->seek(base)) {
+                backend_->close();
+                lastWriteBusy_ = true;
+                log("Error seeking in " + currentFileName_ + ": batch kept for retry");
                 return false;
             }
-            file.print("[\n");
+            opened = true;
+        } else {
+            // File exists but is too small/corrupt - recreate
+            backend_->close();
         }
-    } else {
+    }
+    if (!opened) {
         // New file - start JSON array
-        file = SD.open(currentFileName_, FILE_WRITE);
-        if (!file) {
+        if (!backend_->open(fileName, true)) {
             log("Error creating file: " + currentFileName_);
             return false;
         }
-        file.print("[\n");
     }
     
-    // Write all entries as flat Kepler-compatible JSON objects
-    for (size_t i = 0; i < dataList.size(); i++) {
-        if (i > 0) file.print(",\n");
+    // Write all entries as flat Kepler-compatible JSON objects. The payload
+    // grows in PSRAM: an entry that does not fit fails the whole batch
+    bool serialized = payload.append(opened ? ",\n" : "[\n");
+    char line[320];
+    for (size_t i = 0; serialized && i < dataList.size(); i++) {
+        if (i > 0 && !payload.append(",\n")) {
+            serialized = false;
+            break;
+        }
         
         const auto& data = dataList[i];
         
@@ -253,17 +382,67 @@ bool Storage::writeDataBatch(const std::vector<StorageData>& dataList) {
             doc["sequenceNumber"] = data.buoyData.sequenceNumber;
         }
         
-        serializeJson(doc, file);
+        size_t len = serializeJson(doc, line, sizeof(line));
+        serialized = payload.append(line, len);
     }
     
     // Close the JSON array - file is always a valid JSON
-    file.print("\n]");
-    file.close();
+    if (!serialized || !payload.append("\n]")) {
+        // Nothing written yet: the file is left as it was
+        log("Error: no memory to serialize the batch for " + currentFileName_);
+        backend_->close();
+        if (!opened) {
+            backend_->remove(fileName);
+        }
+        return false;
+    }
+    
+    size_t written = backend_->write((const uint8_t*)payload.c_str(), payload.length());
+    if (written != payload.length()) {
+        // Blank the partial batch so the file stays a valid array, then
+        // let the caller write the whole batch again
+        log("Error: short write on " + currentFileName_);
+        if (!opened) {
+            backend_->close();
+            lastWriteBusy_ = backend_->remove(fileName);
+        } else {
+            lastWriteBusy_ = restoreTail(base, written);
+            backend_->close();
+        }
+        if (!lastWriteBusy_) {
+            log("Error: " + currentFileName_ + " left without its closing bracket");
+        }
+        return false;
+    }
+    backend_->close();
     log("Batch of " + String(dataList.size()) + " Kepler entries written to SD");
     return true;
 }
 
-bool Storage::syncRTCFromNTP(const char* ntpServer, long gmtOffset, int daylightOffset) {
+bool Storage::restoreTail(uint32_t base, size_t written) {
+    // The bytes after base become whitespace followed by "\n]": the array
+    // is closed again and still ends with the 2 bytes the next batch seeks to
+    static const char blanks[64] = {
+        ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',
+        ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',
+        ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',
+        ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',
+    };
+    if (!backend_->seek(base)) {
+        return false;
+    }
+    size_t padding = (written > 2) ? written - 2 : 0;
+    while (padding > 0) {
+        size_t chunk = padding < sizeof(blanks) ? padding : sizeof(blanks);
+        if (backend_->write((const uint8_t*)blanks, chunk) != chunk) {
+            return false;
+        }
+        padding -= chunk;
+    }
+    return backend_->write((const uint8_t*)"\n]", 2) == 2;
+}
+
+bool Storage::beginNTPSync(const char* ntpServer, long gmtOffset, int daylightOffset) {
     // Check if WiFi is connected
     if (WiFi.status() != WL_CONNECTED) {
         log("WiFi not connected - cannot sync RTC");
@@ -272,28 +451,36 @@ bool Storage::syncRTCFromNTP(const char* ntpServer, long gmtOffset, int daylight
     
     log("Synchronizing RTC with NTP server: " + String(ntpServer));
     
-    // Configure time server
+    // Configure time server; the answer is picked up by pollNTPSync()
     configTime(gmtOffset, daylightOffset, ntpServer);
-    
-    // Wait for time synchronization (timeout after 10 seconds)
-    unsigned long startTime = millis();
-    time_t now = 0;
-    
-    while (now < 1000000000 && (millis() - startTime) < 10000) {
-        time(&now);
-        delay(100);
+    ntpPending_ = true;
+    ntpStartMs_ = millis();
+    return true;
+}
+
+NtpSyncState Storage::pollNTPSync() {
+    if (!ntpPending_) {
+        return NTP_SYNC_IDLE;
     }
     
+    // Not synchronized while the clock is still near the epoch
+    time_t now = 0;
+    time(&now);
     if (now < 1000000000) {
+        if (millis() - ntpStartMs_ < NTP_TIMEOUT_MS) {
+            return NTP_SYNC_PENDING;
+        }
+        ntpPending_ = false;
         log("Failed to synchronize with NTP server");
-        return false;
+        return NTP_SYNC_FAILED;
     }
+    ntpPending_ = false;
     
-    // Convert to local time structure
+    // Convert to local time structure (no wait: the time is already set)
     struct tm timeinfo;
-    if (!getLocalTime(&timeinfo)) {
+    if (!getLocalTime(&timeinfo, 0)) {
         log("Failed to get local time structure");
-        return false;
+        return NTP_SYNC_FAILED;
     }
     
     // Set RTC with NTP time
@@ -315,7 +502,7 @@ bool Storage::syncRTCFromNTP(const char* ntpServer, long gmtOffset, int daylight
         String(datetime.time.minutes) + ":" + 
         String(datetime.time.seconds));
     
-    return true;
+    return NTP_SYNC_DONE;
 }
 
 time_t Storage::getCurrentTimestamp() {
@@ -0,0 +1,226 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file StorageBenchmark.cpp
+ * @brief Implementation of the Storage benchmark
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "StorageBenchmark.h"
+#include "Storage.h"
+#include "SdStorageBackend.h"
+#include "SimulatedSdBackend.h"
+#include "Logger.h"
+#include <algorithm>
+
+// Fleet mixes seen on the water: a single boat, a club race, a regatta
+static const BenchmarkScenario kScenarios[] = {
+    // name                         boats Hz buoys anemo  sec  flush
+    { "1 boat",                         1, 10,  0,    0,   120, 5000 },
+    { "5 boats + 2 buoys + 1 anemo",    5, 10,  2,    1,   120, 5000 },
+    { "15 boats + 6 buoys + 1 anemo",  15, 10,  6,    1,   120, 5000 },
+    { "20 boats + 6 buoys + 2 anemo",  20, 10,  6,    2,   120, 5000 },
+    { "20 boats, 1 s flush",           20, 10,  6,    2,   120, 1000 },
+};
+
+StorageBenchmark::StorageBenchmark() : logger_(nullptr), bus_(nullptr) {
+}
+
+void StorageBenchmark::setLogger(Logger& logger) {
+    logger_ = &logger;
+}
+
+void StorageBenchmark::log(const String& message) {
+    if (logger_) {
+        logger_->log(message);
+    }
+}
+
+const BenchmarkScenario* StorageBenchmark::scenarios(size_t& count) {
+    count = sizeof(kScenarios) / sizeof(kScenarios[0]);
+    return kScenarios;
+}
+
+/**
+ * @brief Fill a batch with the entries produced by the fleet during one flush interval
+ */
+static void generateBatch(const BenchmarkScenario& scenario, uint32_t tick, StorageBatch& batch) {
+    unsigned long now = millis();
+    uint32_t boatPackets = (uint32_t)scenario.boatRateHz * scenario.flushIntervalMs / 1000;
+    uint32_t slowPackets = scenario.flushIntervalMs / 1000;  // 1 Hz devices
+    if (slowPackets == 0) slowPackets = 1;
+
+    for (uint32_t p = 0; p < boatPackets; p++) {
+        for (uint8_t b = 0; b < scenario.boats; b++) {
+            StorageData data;
+            memset(&data, 0, sizeof(data));
+            data.timestamp = now;
+            data.dataType = DATA_TYPE_BOAT;
+            data.boatData.messageType = MSG_TYPE_BOAT_GPS;
+            snprintf(data.boatData.name, sizeof(data.boatData.name), "SIM-BOAT-%02u", b + 1);
+            data.boatData.sequenceNumber = tick * boatPackets + p;
+            data.boatData.latitude = 43.5f + b * 0.0001f + p * 0.000001f;
+            data.boatData.longitude = 3.9f + tick * 0.00001f;
+            data.boatData.speed = 2.0f + (p % 30) * 0.1f;
+            data.boatData.heading = (float)((tick * 7 + p) % 360);
+            data.boatData.satellites = 9;
+            batch.push_back(data);
+        }
+    }
+    for (uint32_t p = 0; p < slowPackets; p++) {
+        for (uint8_t i = 0; i < scenario.buoys; i++) {
+            StorageData data;
+            memset(&data, 0, sizeof(data));
+            data.timestamp = now;
+            data.dataType = DATA_TYPE_BUOY;
+            data.buoyData.buoyId = i;
+            data.buoyData.sequenceNumber = (uint16_t)(tick * slowPackets + p);
+            data.buoyData.latitude = 43.51 + i * 0.001;
+            data.buoyData.longitude = 3.91;
+            data.buoyData.autoPilotTrueHeadingCmde = 270.0f;
+            batch.push_back(data);
+        }
+        for (uint8_t i = 0; i < scenario.anemometers; i++) {
+            StorageData data;
+            memset(&data, 0, sizeof(data));
+            data.timestamp = now;
+            data.dataType = DATA_TYPE_ANEMOMETER;
+            data.anemometerData.messageType = MSG_TYPE_ANEMOMETER;
+            snprintf(data.anemometerData.anemometerId, sizeof(data.anemometerData.anemometerId),
+                     "AA:BB:CC:DD:EE:%02X", i);
+            data.anemometerData.sequenceNumber = tick * slowPackets + p;
+            data.anemometerData.windSpeed = 4.5f;
+            data.windDirection = 265.0f;
+            batch.push_back(data);
+        }
+    }
+}
+
+bool StorageBenchmark::runScenario(const BenchmarkScenario& scenario, StorageBackend& backend, bool simulated,
+                                   const char* fileName, BenchmarkResult& result) {
+    memset(&result, 0, sizeof(result));
+
+    Storage writer;
+    writer.setBackend(backend);
+    writer.setFileName(fileName);
+    backend.resetStats();
+
+    uint32_t flushes = (uint32_t)scenario.durationSec * 1000 / scenario.flushIntervalMs;
+    std::vector<uint32_t> latencies;
+    latencies.reserve(flushes);
+
+    StorageBatch batch;
+    uint64_t totalUs = 0;
+    bool ok = true;
+
+    for (uint32_t tick = 0; tick < flushes; tick++) {
+        batch.clear();
+        generateBatch(scenario, tick, batch);
+
+        uint64_t ioBefore = backend.stats().ioMicros;
+        unsigned long start = micros();
+        if (!writer.writeDataBatch(batch)) {
+            ok = false;
+            break;
+        }
+        uint32_t latency = micros() - start;
+        if (simulated) {
+            // Simulated I/O does not wait: add it to the writer CPU time
+            latency += (uint32_t)(backend.stats().ioMicros - ioBefore);
+        }
+
+        latencies.push_back(latency);
+        totalUs += latency;
+        result.records += batch.size();
+
+        // Keep the UI and other tasks alive during long runs
+        vTaskDelay(1);
+    }
+
+    const StorageBackendStats& stats = backend.stats();
+    result.flushes = latencies.size();
+    if (totalUs > 0) {
+        result.recordsPerSec = result.records * 1000000.0f / totalUs;
+    }
+    if (result.records > 0) {
+        result.logicalBytesPerRecord = (float)stats.logicalBytes / result.records;
+        result.physicalBytesPerRecord = (float)stats.physicalBytes / result.records;
+    }
+    if (stats.logicalBytes > 0) {
+        result.writeAmplification = (float)stats.physicalBytes / stats.logicalBytes;
+    }
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        size_t n = latencies.size();
+        result.p50Us = latencies[(n - 1) * 50 / 100];
+        result.p95Us = latencies[(n - 1) * 95 / 100];
+        result.p99Us = latencies[(n - 1) * 99 / 100];
+        result.maxUs = latencies[n - 1];
+    }
+
+    backend.remove(fileName);
+    return ok;
+}
+
+void StorageBenchmark::report(const char* target, const BenchmarkScenario& scenario, const BenchmarkResult& result) {
+    char line[200];
+    snprintf(line, sizeof(line),
+             "[%s] %s: %lu rec, %.0f rec/s, %.1f B/rec JSON, %.1f B/rec card, WA %.2f, "
+             "flush p50 %.1f p95 %.1f p99 %.1f max %.1f ms",
+             target, scenario.name, (unsigned long)result.records, result.recordsPerSec,
+             result.logicalBytesPerRecord, result.physicalBytesPerRecord, result.writeAmplification,
+             result.p50Us / 1000.0f, result.p95Us / 1000.0f, result.p99Us / 1000.0f, result.maxUs / 1000.0f);
+    log(line);
+}
+
+void StorageBenchmark::runAll(bool onCard) {
+    size_t count = 0;
+    const BenchmarkScenario* list = scenarios(count);
+    const char* target = onCard ? "sd" : "sim";
+
+    log(String("=== Storage benchmark (") + target + ") ===");
+    if (onCard) {
+        BusLock lock(bus_, BusScheduler::CLIENT_STORAGE);
+        if (!lock.isLocked()) {
+            log("[sd] SD card busy, benchmark skipped");
+            log("=== End of storage benchmark ===");
+            return;
+        }
+        if (!SD.exists("/bench")) {
+            SD.mkdir("/bench");
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        BenchmarkResult result;
+        bool ok;
+        if (onCard) {
+            SdStorageBackend card;
+            card.setBus(bus_);
+            ok = runScenario(list[i], card, false, "/bench/storage_bench.json", result);
+        } else {
+            SimulatedSdBackend simulated;
+            ok = runScenario(list[i], simulated, true, "/bench/storage_bench.json", result);
+        }
+        if (!ok) {
+            log(String("[") + target + "] " + list[i].name + ": write error");
+            continue;
+        }
+        report(target, list[i], result);
+    }
+    log("=== End of storage benchmark ===");
+}
@@ -0,0 +1,363 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file StripChartWidget.cpp
+ * @brief Implementation of the scrolling strip chart
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "StripChartWidget.h"
+#include "PsramAllocator.h"
+#include <math.h>
+#include <string.h>
+
+// Vertical scales: the smallest one holding the window maximum with 10% headroom
+static const float kScaleSteps[] = {5, 10, 20, 30, 50, 80, 120, 200};
+static const int kScaleStepCount = sizeof(kScaleSteps) / sizeof(kScaleSteps[0]);
+
+StripChartWidget::StripChartWidget(int16_t x, int16_t y, int16_t w, int16_t h, const char* title, uint16_t color)
+    : Widget(x, y, w, h), title_(title), color_(color), history_(nullptr), second_(0), secondEnd_(0),
+      secondSum_(0), secondCount_(0), windowMinutes_(5), windowSum_(0), windowCount_(0), minHead_(0), minSize_(0),
+      maxHead_(0), maxSize_(0), columnHead_(0), columnMs_(0), columnEnd_(0), lastDataAge_(-1), lastDataValue_(0),
+      scaleTop_(kScaleSteps[0]), started_(false), plotReady_(false), plotDirty_(false), headerDirty_(false) {
+    memset(&current_, 0, sizeof(current_));
+    header_[0] = '\0';
+    columnMs_ = (uint32_t)windowMinutes_ * 60000UL / plotWidth();
+}
+
+bool StripChartWidget::begin() {
+    if (history_) return true;
+
+    history_ = (History*)largeMalloc(sizeof(History));
+    if (!history_) return false;
+
+    plot_.setColorDepth(16);
+    plot_.setPsram(true);
+    plotReady_ = plot_.createSprite(plotWidth(), plotHeight()) != nullptr;
+    clear();
+    return true;
+}
+
+void StripChartWidget::clear() {
+    if (!history_) return;
+
+    for (int i = 0; i < HISTORY_SECONDS; i++) history_->seconds[i] = NAN;
+    memset(history_->columns, 0, sizeof(history_->columns));
+    memset(&current_, 0, sizeof(current_));
+    second_ = 0;
+    secondSum_ = 0;
+    secondCount_ = 0;
+    windowSum_ = 0;
+    windowCount_ = 0;
+    minHead_ = minSize_ = 0;
+    maxHead_ = maxSize_ = 0;
+    columnHead_ = 0;
+    started_ = false;
+    scaleTop_ = kScaleSteps[0];
+
+    if (plotReady_) redrawPlot(plot_, 0, 0);
+    updateHeader();
+    invalidate();
+}
+
+int16_t StripChartWidget::valueY(float value) const {
+    int16_t h = plotHeight();
+    int y = h - 1 - (int)(value / scaleTop_ * (h - 1) + 0.5f);
+    return constrain(y, 0, h - 1);
+}
+
+void StripChartWidget::pushSecond(float value) {
+    uint32_t s = second_++;
+    uint32_t window = windowSeconds();
+
+    // Second leaving the window (read before its slot is reused)
+    if (s >= window) {
+        uint32_t leaving = s - window;
+        float old = secondAt(leaving);
+        if (!isnan(old)) {
+            windowSum_ -= old;
+            windowCount_--;
+        }
+        while (minSize_ > 0 && history_->minQueue[minHead_] <= leaving) {
+            minHead_ = (minHead_ + 1) % HISTORY_SECONDS;
+            minSize_--;
+        }
+        while (maxSize_ > 0 && history_->maxQueue[maxHead_] <= leaving) {
+            maxHead_ = (maxHead_ + 1) % HISTORY_SECONDS;
+            maxSize_--;
+        }
+    }
+
+    history_->seconds[s % HISTORY_SECONDS] = value;
+    if (isnan(value)) {
+        if (windowCount_ == 0) windowSum_ = 0;  // No drift carried over an empty window
+        return;
+    }
+    windowSum_ += value;
+    windowCount_++;
+
+    // Monotonic queues: drop the entries that can no longer be the min (max)
+    while (minSize_ > 0 && secondAt(history_->minQueue[(minHead_ + minSize_ - 1) % HISTORY_SECONDS]) >= value) {
+        minSize_--;
+    }
+    history_->minQueue[(minHead_ + minSize_++) % HISTORY_SECONDS] = s;
+    while (maxSize_ > 0 && secondAt(history_->maxQueue[(maxHead_ + maxSize_ - 1) % HISTORY_SECONDS]) <= value) {
+        maxSize_--;
+    }
+    history_->maxQueue[(maxHead_ + maxSize_++) % HISTORY_SECONDS] = s;
+}
+
+void StripChartWidget::rebuildWindow() {
+    windowSum_ = 0;
+    windowCount_ = 0;
+    minHead_ = minSize_ = 0;
+    maxHead_ = maxSize_ = 0;
+
+    // Replay the seconds of the new window through the queues
+    uint32_t window = windowSeconds();
+    uint32_t first = second_ > window ? second_ - window : 0;
+    for (uint32_t s = first; s < second_; s++) {
+        float value = secondAt(s);
+        if (isnan(value)) continue;
+        windowSum_ += value;
+        windowCount_++;
+        while (minSize_ > 0 && secondAt(history_->minQueue[(minHead_ + minSize_ - 1) % HISTORY_SECONDS]) >= value) {
+            minSize_--;
+        }
+        history_->minQueue[(minHead_ + minSize_++) % HISTORY_SECONDS] = s;
+        while (maxSize_ > 0 && secondAt(history_->maxQueue[(maxHead_ + maxSize_ - 1) % HISTORY_SECONDS]) <= value) {
+            maxSize_--;
+        }
+        history_->maxQueue[(maxHead_ + maxSize_++) % HISTORY_SECONDS] = s;
+    }
+}
+
+void StripChartWidget::updateScale(bool force) {
+    float top = maxSize_ > 0 ? secondAt(history_->maxQueue[maxHead_]) : 0;
+    float wanted = kScaleSteps[kScaleStepCount - 1];
+    for (int i = 0; i < kScaleStepCount; i++) {
+        if (kScaleSteps[i] >= top * 1.1f) {
+            wanted = kScaleSteps[i];
+            break;
+        }
+    }
+
+    // Up at once, down only when the data uses less than 40% of the plot
+    if (force || wanted > scaleTop_ || (wanted < scaleTop_ && top < scaleTop_ * 0.4f)) {
+        scaleTop_ = wanted;
+        if (plotReady_) redrawPlot(plot_, 0, 0);
+        plotDirty_ = true;
+        markPartialDirty();
+    }
+}
+
+void StripChartWidget::drawColumn(LovyanGFX& gfx, int16_t ox, int16_t oy, int16_t x, const Column& column,
+                                  unsigned long columnStart) {
+    int16_t h = plotHeight();
+    gfx.drawFastVLine(ox + x, oy, h, BLACK);
+
+    // Grid in absolute time, so that it scrolls with the data: half scale, one tick per minute
+    if ((columnStart / columnMs_) % 4 == 0) {
+        gfx.drawPixel(ox + x, oy + valueY(scaleTop_ / 2), TFT_DARKGREY);
+    }
+    if (columnStart % 60000UL < columnMs_) {
+        for (int16_t y = 0; y < h; y += 3) gfx.drawPixel(ox + x, oy + y, TFT_DARKGREY);
+    }
+
+    if (column.valid) {
+        // Joined to the previous data unless the gap is too long
+        if (lastDataAge_ >= 0 && (uint32_t)(lastDataAge_ + 1) * columnMs_ <= MAX_GAP_MS) {
+            gfx.drawLine(ox + x - 1 - lastDataAge_, oy + valueY(lastDataValue_), ox + x, oy + valueY(column.last), color_);
+        }
+        gfx.drawFastVLine(ox + x, oy + valueY(column.max), valueY(column.min) - valueY(column.max) + 1, color_);
+        lastDataAge_ = 0;
+        lastDataValue_ = column.last;
+    } else if (lastDataAge_ >= 0) {
+        lastDataAge_++;
+    }
+}
+
+void StripChartWidget::redrawPlot(LovyanGFX& gfx, int16_t ox, int16_t oy) {
+    int16_t w = plotWidth();
+    unsigned long newestStart = columnEnd_ - 2 * columnMs_;
+    lastDataAge_ = -1;
+    for (int16_t x = 0; x < w; x++) {
+        const Column& column = history_->columns[(columnHead_ + x) % w];
+        drawColumn(gfx, ox, oy, x, column, newestStart - (unsigned long)(w - 1 - x) * columnMs_);
+    }
+}
+
+void StripChartWidget::commitColumns(unsigned long now) {
+    if ((long)(now - columnEnd_) < 0) return;
+
+    // Columns ended since the last frame: the accumulated one, then empty ones
+    int16_t w = plotWidth();
+    uint32_t ended = (now - columnEnd_) / columnMs_ + 1;
+    int16_t n = ended < (uint32_t)w ? (int16_t)ended : w;
+    columnEnd_ += ended * columnMs_;
+    unsigned long newestStart = columnEnd_ - 2 * columnMs_;
+
+    if (plotReady_) plot_.scroll(-n, 0);
+    for (int16_t k = 0; k < n; k++) {
+        uint32_t index = ended - n + k;
+        Column column = index == 0 ? current_ : Column{0, 0, 0, false};
+        history_->columns[columnHead_] = column;
+        columnHead_ = (columnHead_ + 1) % w;
+        if (plotReady_) {
+            int16_t x = w - n + k;
+            drawColumn(plot_, 0, 0, x, column, newestStart - (unsigned long)(w - 1 - x) * columnMs_);
+        }
+    }
+    memset(&current_, 0, sizeof(current_));
+
+    plotDirty_ = true;
+    markPartialDirty();
+}
+
+void StripChartWidget::updateHeader() {
+    char text[sizeof(header_)];
+    if (windowCount_ > 0) {
+        float low = secondAt(history_->minQueue[minHead_]);
+        float high = secondAt(history_->maxQueue[maxHead_]);
+        snprintf(text, sizeof(text), "%dmin  min %.1f moy %.1f max %.1f /%.0f", windowMinutes_, low,
+                 windowSum_ / windowCount_, high, scaleTop_);
+    } else {
+        snprintf(text, sizeof(text), "%dmin  --", windowMinutes_);
+    }
+    if (strcmp(text, header_) != 0) {
+        strcpy(header_, text);
+        headerDirty_ = true;
+        markPartialDirty();
+    }
+}
+
+void StripChartWidget::set(float value, bool valid, unsigned long now) {
+    if (!history_) return;
+    if (!started_) {
+        started_ = true;
+        secondEnd_ = now + 1000;
+        columnEnd_ = now + columnMs_;
+    }
+
+    // Seconds ended since the last frame (empty ones after a pause)
+    bool pushed = false;
+    int count = 0;
+    while ((long)(now - secondEnd_) >= 0) {
+        pushSecond(secondCount_ > 0 ? secondSum_ / secondCount_ : NAN);
+        secondSum_ = 0;
+        secondCount_ = 0;
+        secondEnd_ += 1000;
+        pushed = true;
+        if (++count >= HISTORY_SECONDS) {
+            secondEnd_ = now + 1000;
+            break;
+        }
+    }
+    if (pushed) {
+        updateScale(false);
+        updateHeader();
+    }
+    commitColumns(now);
+
+    if (valid && !isnan(value)) {
+        secondSum_ += value;
+        secondCount_++;
+        if (!current_.valid) {
+            current_.min = current_.max = value;
+            current_.valid = true;
+        }
+        current_.min = min(current_.min, value);
+        current_.max = max(current_.max, value);
+        current_.last = value;
+    }
+}
+
+void StripChartWidget::setWindowMinutes(int minutes) {
+    minutes = constrain(minutes, MIN_WINDOW_MINUTES, MAX_WINDOW_MINUTES);
+    if (minutes == windowMinutes_) return;
+    windowMinutes_ = minutes;
+
+    int16_t w = plotWidth();
+    columnMs_ = (uint32_t)minutes * 60000UL / w;
+    if (!history_) return;
+
+    rebuildWindow();
+
+    // Columns resampled from the seconds; the current column ends with the current second
+    memset(history_->columns, 0, sizeof(history_->columns));
+    memset(&current_, 0, sizeof(current_));
+    columnHead_ = 0;
+    columnEnd_ = secondEnd_;
+    for (uint32_t back = 1; back <= (uint32_t)windowSeconds() && back <= second_; back++) {
+        float value = secondAt(second_ - back);
+        if (isnan(value)) continue;
+        uint32_t offset = (back + 1) * 1000 - columnMs_;   // Start of the second before the current column
+        int16_t x = w - (int16_t)((offset + columnMs_ - 1) / columnMs_);
+        if (x < 0) continue;
+        Column& column = x == w ? current_ : history_->columns[x];
+        if (!column.valid) {
+            column.min = column.max = column.last = value;  // Newest second first: it is the last value
+            column.valid = true;
+        }
+        column.min = min(column.min, value);
+        column.max = max(column.max, value);
+    }
+
+    updateScale(true);
+    updateHeader();
+    invalidate();
+}
+
+int StripChartWidget::dirtyRegion(WidgetRect* rects) const {
+    if (fullDirty_) {
+        return Widget::dirtyRegion(rects);
+    }
+    int count = 0;
+    if (headerDirty_) {
+        rects[count++] = {bounds_.x, bounds_.y, bounds_.w, HEADER_HEIGHT};
+    }
+    if (plotDirty_) {
+        rects[count++] = {bounds_.x, (int16_t)(bounds_.y + HEADER_HEIGHT), bounds_.w, plotHeight()};
+    }
+    return count > 0 ? count : Widget::dirtyRegion(rects);
+}
+
+void StripChartWidget::clearDirty() {
+    Widget::clearDirty();
+    headerDirty_ = false;
+    plotDirty_ = false;
+}
+
+void StripChartWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    int16_t x = bounds_.x - originX;
+    int16_t y = bounds_.y - originY;
+
+    gfx.setTextSize(1);
+    gfx.setTextDatum(TL_DATUM);
+    gfx.setTextColor(color_);
+    gfx.drawString(title_, x + 2, y + 1);
+    gfx.setTextDatum(TR_DATUM);
+    gfx.setTextColor(WHITE);
+    gfx.drawString(header_, x + bounds_.w - 2, y + 1);
+
+    // Plot: cached sprite, or redrawn from the column ring without one
+    if (plotReady_) {
+        plot_.pushSprite(&gfx, x, y + HEADER_HEIGHT);
+    } else if (history_) {
+        redrawPlot(gfx, x, y + HEADER_HEIGHT);
+    }
+}
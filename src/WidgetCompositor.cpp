@@ -0,0 +1,309 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file WidgetCompositor.cpp
+ * @brief Implementation of the dirty-region compositor
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "WidgetCompositor.h"
+#include "PsramAllocator.h"
+#include <esp_heap_caps.h>
+
+WidgetCompositor::WidgetCompositor()
+    : lcd_(nullptr), bus_(nullptr), widgetCount_(0), forcedCount_(0), poolCount_(0), poolDma_(false) {
+    pool_[0] = nullptr;
+    pool_[1] = nullptr;
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+bool WidgetCompositor::begin(M5GFX& lcd) {
+    lcd_ = &lcd;
+
+    for (int i = 0; i < 2; i++) {
+        pool_[i] = (uint16_t*)heap_caps_malloc(POOL_PIXELS * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+        if (!pool_[i]) break;
+        poolCount_++;
+    }
+    poolDma_ = poolCount_ > 0;
+
+    // Dernier recours : un seul buffer en PSRAM, envoyé sans DMA
+    if (poolCount_ == 0) {
+        pool_[0] = (uint16_t*)largeMalloc(POOL_PIXELS * sizeof(uint16_t));
+        if (pool_[0]) poolCount_ = 1;
+    }
+    return poolCount_ > 0;
+}
+
+bool WidgetCompositor::add(Widget& widget) {
+    if (widgetCount_ >= MAX_WIDGETS) {
+        return false;
+    }
+    widgets_[widgetCount_++] = &widget;
+    widget.invalidate();
+    return true;
+}
+
+void WidgetCompositor::invalidateAll() {
+    for (int i = 0; i < widgetCount_; i++) {
+        widgets_[i]->invalidate();
+    }
+}
+
+/**
+ * @brief Grow a to the bounding box of a and b
+ */
+static void growRect(WidgetRect& a, const WidgetRect& b) {
+    int16_t x1 = max(a.x + a.w, b.x + b.w);
+    int16_t y1 = max(a.y + a.h, b.y + b.h);
+    a.x = min(a.x, b.x);
+    a.y = min(a.y, b.y);
+    a.w = x1 - a.x;
+    a.h = y1 - a.y;
+}
+
+void WidgetCompositor::invalidateArea(int16_t x, int16_t y, int16_t w, int16_t h) {
+    WidgetRect area = {x, y, w, h};
+    if (forcedCount_ < 4) {
+        forced_[forcedCount_++] = area;
+        return;
+    }
+    // Plus de place : agrandir la dernière zone pour couvrir la nouvelle
+    growRect(forced_[3], area);
+}
+
+/**
+ * @brief Clip a rectangle to the screen
+ */
+static WidgetRect clipRect(const WidgetRect& r, int16_t screenW, int16_t screenH) {
+    int16_t x0 = max<int16_t>(r.x, 0);
+    int16_t y0 = max<int16_t>(r.y, 0);
+    int16_t x1 = min<int16_t>(r.x + r.w, screenW);
+    int16_t y1 = min<int16_t>(r.y + r.h, screenH);
+    WidgetRect c = {x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+    return c;
+}
+
+int WidgetCompositor::collectDirtyRects(WidgetRect* rects, uint32_t& dirtyWidgets) {
+    int count = 0;
+    int16_t screenW = lcd_->width();
+    int16_t screenH = lcd_->height();
+    dirtyWidgets = 0;
+
+    // Un widget masqué efface sa zone une seule fois ; ensuite ses
+    // changements de valeur ne coûtent rien tant qu'il reste masqué
+    for (int i = 0; i < widgetCount_; i++) {
+        if (!widgets_[i]->needsCompose()) continue;
+        dirtyWidgets++;
+        WidgetRect parts[Widget::MAX_DIRTY_RECTS];
+        int n = widgets_[i]->dirtyRegion(parts);
+        for (int k = 0; k < n; k++) {
+            WidgetRect r = clipRect(parts[k], screenW, screenH);
+            if (r.isEmpty()) continue;
+            if (count < MAX_RECTS - 4) {
+                rects[count++] = r;
+            } else {
+                growRect(rects[count - 1], r);  // Liste pleine : englober plutôt que perdre une zone
+            }
+        }
+    }
+    for (int i = 0; i < forcedCount_; i++) {
+        WidgetRect r = clipRect(forced_[i], screenW, screenH);
+        if (!r.isEmpty()) rects[count++] = r;
+    }
+    return count;
+}
+
+/**
+ * @brief True if a contains b
+ */
+static bool containsRect(const WidgetRect& a, const WidgetRect& b) {
+    return b.x >= a.x && b.y >= a.y && b.x + b.w <= a.x + a.w && b.y + b.h <= a.y + a.h;
+}
+
+/**
+ * @brief Merge b into a if their union is exactly a ∪ b (no extra pixel)
+ */
+static bool mergeExact(WidgetRect& a, const WidgetRect& b) {
+    if (a.x == b.x && a.w == b.w && b.y <= a.y + a.h && a.y <= b.y + b.h) {
+        int16_t y1 = max(a.y + a.h, b.y + b.h);
+        a.y = min(a.y, b.y);
+        a.h = y1 - a.y;
+        return true;
+    }
+    if (a.y == b.y && a.h == b.h && b.x <= a.x + a.w && a.x <= b.x + b.w) {
+        int16_t x1 = max(a.x + a.w, b.x + b.w);
+        a.x = min(a.x, b.x);
+        a.w = x1 - a.x;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Reduce a list of rectangles to disjoint rectangles covering exactly their union
+ *
+ * Contained and exactly adjacent rectangles are merged; remaining overlaps
+ * are removed by cutting the overlapped rectangle into up to four pieces.
+ * If the list is full, the two rectangles are merged into their bounding
+ * box instead (a few extra pixels, never a missed area).
+ *
+ * @return New number of rectangles
+ */
+int WidgetCompositor::coalesce(WidgetRect* rects, int count) {
+    bool changed = true;
+    int guard = 0;
+    while (changed && guard++ < 64) {
+        changed = false;
+        for (int i = 0; i < count && !changed; i++) {
+            for (int j = 0; j < count && !changed; j++) {
+                if (i == j) continue;
+                WidgetRect& a = rects[i];
+                WidgetRect b = rects[j];
+
+                if (containsRect(a, b) || mergeExact(a, b)) {
+                    rects[j] = rects[--count];
+                    changed = true;
+                } else if (j > i && a.intersects(b)) {
+                    // Découper b autour de a : bandes haute, basse, gauche, droite
+                    WidgetRect pieces[4];
+                    int n = 0;
+                    int16_t top = max(a.y, b.y);
+                    int16_t bottom = min(a.y + a.h, b.y + b.h);
+                    if (b.y < a.y) pieces[n++] = {b.x, b.y, b.w, (int16_t)(a.y - b.y)};
+                    if (b.y + b.h > a.y + a.h) pieces[n++] = {b.x, (int16_t)(a.y + a.h), b.w, (int16_t)(b.y + b.h - a.y - a.h)};
+                    if (b.x < a.x) pieces[n++] = {b.x, top, (int16_t)(a.x - b.x), (int16_t)(bottom - top)};
+                    if (b.x + b.w > a.x + a.w) pieces[n++] = {(int16_t)(a.x + a.w), top, (int16_t)(b.x + b.w - a.x - a.w), (int16_t)(bottom - top)};
+
+                    if (count - 1 + n <= MAX_RECTS) {
+                        rects[j] = rects[--count];
+                        for (int k = 0; k < n; k++) rects[count++] = pieces[k];
+                    } else {
+                        int16_t x1 = max(a.x + a.w, b.x + b.w);
+                        int16_t y1 = max(a.y + a.h, b.y + b.h);
+                        a.x = min(a.x, b.x);
+                        a.y = min(a.y, b.y);
+                        a.w = x1 - a.x;
+                        a.h = y1 - a.y;
+                        rects[j] = rects[--count];
+                    }
+                    changed = true;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+void WidgetCompositor::renderRect(const WidgetRect& rect, int& flip, uint32_t& transfers) {
+    int16_t stripHeight = POOL_PIXELS / rect.w;
+    if (stripHeight > rect.h) stripHeight = rect.h;
+
+    for (int16_t y = rect.y; y < rect.y + rect.h; y += stripHeight) {
+        int16_t h = min<int16_t>(stripHeight, rect.y + rect.h - y);
+        WidgetRect strip = {rect.x, y, rect.w, h};
+
+        if (poolCount_ == 1) {
+            lcd_->waitDMA(); // Buffer unique : attendre la fin de l'envoi précédent
+        }
+        LGFX_Sprite& canvas = canvas_[flip];
+        canvas.setBuffer(pool_[flip], strip.w, strip.h);
+        canvas.fillScreen(BLACK);
+        for (int i = 0; i < widgetCount_; i++) {
+            Widget* widget = widgets_[i];
+            if (widget->isVisible() && widget->bounds().intersects(strip)) {
+                widget->draw(canvas, strip.x, strip.y);
+            }
+        }
+
+        const lgfx::swap565_t* pixels = (const lgfx::swap565_t*)pool_[flip];
+        if (poolDma_) {
+            lcd_->pushImageDMA(strip.x, strip.y, strip.w, strip.h, pixels);
+        } else {
+            lcd_->pushImage(strip.x, strip.y, strip.w, strip.h, pixels);
+        }
+        transfers++;
+        if (poolCount_ > 1) flip ^= 1;
+    }
+}
+
+bool WidgetCompositor::compose() {
+    if (!lcd_ || poolCount_ == 0) return false;
+
+    WidgetRect rects[MAX_RECTS];
+    uint32_t dirtyWidgets = 0;
+    int count = collectDirtyRects(rects, dirtyWidgets);
+    if (count == 0) {
+        forcedCount_ = 0;
+        return false;
+    }
+    count = coalesce(rects, count);
+
+    BusLock lock(bus_, BusScheduler::CLIENT_DISPLAY, FRAME_BUS_TIMEOUT_MS);
+    if (!lock.isLocked()) {
+        stats_.postponedFrames++;
+        return false;  // Bus busy: the widgets stay dirty and are pushed next frame
+    }
+
+    unsigned long start = micros();
+    uint32_t pixels = 0;
+    uint32_t transfers = 0;
+    int flip = 0;
+
+    lcd_->startWrite();
+    for (int i = 0; i < count; i++) {
+        renderRect(rects[i], flip, transfers);
+        pixels += rects[i].area();
+    }
+    lcd_->waitDMA();
+    lcd_->endWrite();
+
+    for (int i = 0; i < widgetCount_; i++) {
+        widgets_[i]->clearDirty();
+    }
+    forcedCount_ = 0;
+
+    uint32_t elapsed = micros() - start;
+    stats_.frames++;
+    stats_.lastDirtyWidgets = dirtyWidgets;
+    stats_.lastDirtyRects = count;
+    stats_.lastPixels = pixels;
+    stats_.lastTransfers = transfers;
+    stats_.lastTransactions = 1;
+    stats_.lastRenderMicros = elapsed;
+    stats_.totalPixels += pixels;
+    stats_.totalTransfers += transfers;
+    stats_.totalTransactions += 1;
+    stats_.totalRenderMicros += elapsed;
+    return true;
+}
+
+String WidgetCompositor::describeStats() const {
+    const DisplayFrameStats& s = stats_;
+    if (s.frames == 0) {
+        return "Affichage: aucune image";
+    }
+    char line[220];
+    snprintf(line, sizeof(line),
+             "Affichage: %lu images, dernière %lu widgets / %lu zones / %lu px sales / %lu DMA / %lu transaction(s) en %lu us, "
+             "moyenne %lu px / %.1f DMA / %lu us par image",
+             (unsigned long)s.frames, (unsigned long)s.lastDirtyWidgets, (unsigned long)s.lastDirtyRects,
+             (unsigned long)s.lastPixels, (unsigned long)s.lastTransfers, (unsigned long)s.lastTransactions,
+             (unsigned long)s.lastRenderMicros, (unsigned long)(s.totalPixels / s.frames),
+             (float)s.totalTransfers / s.frames, (unsigned long)(s.totalRenderMicros / s.frames));
+    return String(line);
+}
@@ -0,0 +1,399 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file Widgets.cpp
+ * @brief Implementation of the dashboard widgets
+ *
+ * The drawing code reproduces the original dashboard layout; coordinates
+ * are relative to the widget bounding box.
+ *
+ * @author Philippe Hubert
+ * @date 2025
+ */
+
+#include "Widgets.h"
+#include "DisplayTypes.h"
+#include <string.h>
+
+Widget::Widget(int16_t x, int16_t y, int16_t w, int16_t h)
+    : bounds_{x, y, w, h}, dirty_(true), fullDirty_(true), visible_(true), shown_(false) {
+}
+
+void Widget::setVisible(bool visible) {
+    markDirtyIf(visible != visible_);
+    visible_ = visible;
+}
+
+// ----------------------------------------------------------------------------
+
+LabelWidget::LabelWidget(int16_t x, int16_t y, int16_t w, int16_t h, const char* text, uint16_t color, uint8_t size)
+    : Widget(x, y, w, h), text_(text), color_(color), size_(size) {
+}
+
+void LabelWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    gfx.setTextDatum(TL_DATUM);
+    gfx.setTextColor(color_);
+    gfx.setTextSize(size_);
+    gfx.setCursor(bounds_.x - originX, bounds_.y - originY);
+    gfx.print(text_);
+}
+
+// ----------------------------------------------------------------------------
+
+NumberWidget::NumberWidget(int16_t x, int16_t y, int16_t w, int16_t h, const char* format, float threshold)
+    : Widget(x, y, w, h), format_(format), threshold_(threshold), value_(0), valid_(false), dirtyCells_(0),
+      atlas_(nullptr) {
+    memset(text_, 0, sizeof(text_));
+}
+
+void NumberWidget::setAtlas(const GlyphAtlas* atlas) {
+    atlas_ = (atlas && atlas->textSize() == TEXT_SIZE) ? atlas : nullptr;
+    invalidate();
+}
+
+void NumberWidget::setValue(float value, bool valid) {
+    if (valid == valid_ && (!valid || fabsf(value - value_) <= threshold_)) {
+        return;
+    }
+    value_ = value;
+    valid_ = valid;
+
+    char next[MAX_CHARS + 1];
+    memset(next, 0, sizeof(next));
+    if (valid) {
+        snprintf(next, sizeof(next), format_, value);
+    } else {
+        strcpy(next, "---");
+    }
+
+    // Cellules dont le caractère change (y compris celles qui se vident)
+    for (int i = 0; i < MAX_CHARS; i++) {
+        if (next[i] != text_[i]) dirtyCells_ |= 1 << i;
+    }
+    memcpy(text_, next, sizeof(text_));
+    if (dirtyCells_) markPartialDirty();
+}
+
+int NumberWidget::dirtyRegion(WidgetRect* rects) const {
+    if (fullDirty_ || dirtyCells_ == 0) {
+        return Widget::dirtyRegion(rects);
+    }
+
+    // Une zone par suite de cellules modifiées consécutives
+    int count = 0;
+    int16_t cw = cellWidth();
+    for (int i = 0; i < MAX_CHARS && count < MAX_DIRTY_RECTS; i++) {
+        if (!(dirtyCells_ & (1 << i))) continue;
+        int first = i;
+        while (i + 1 < MAX_CHARS && (dirtyCells_ & (1 << (i + 1)))) i++;
+        int16_t x = bounds_.x + first * cw;
+        int16_t w = min<int16_t>((i - first + 1) * cw, bounds_.x + bounds_.w - x);
+        if (w > 0) {
+            rects[count++] = {x, bounds_.y, w, bounds_.h};
+        }
+    }
+    return count > 0 ? count : Widget::dirtyRegion(rects);
+}
+
+void NumberWidget::clearDirty() {
+    Widget::clearDirty();
+    dirtyCells_ = 0;
+}
+
+void NumberWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    int16_t x = bounds_.x - originX;
+    int16_t y = bounds_.y - originY;
+    int16_t cw = cellWidth();
+
+    for (int i = 0; i < MAX_CHARS && text_[i]; i++) {
+        int16_t cx = x + i * cw;
+        if (cx + cw <= 0 || cx >= gfx.width()) continue;  // Hors du canevas
+        if (atlas_ && atlas_->drawGlyph(gfx, cx, y, text_[i])) continue;
+
+        gfx.setTextDatum(TL_DATUM);
+        gfx.setTextColor(WHITE);
+        gfx.setTextSize(TEXT_SIZE);
+        gfx.setCursor(cx, y);
+        gfx.print(text_[i]);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+BoatNameWidget::BoatNameWidget(int16_t x, int16_t y, int16_t w, int16_t h)
+    : Widget(x, y, w, h), index_(-1), total_(-1) {
+}
+
+void BoatNameWidget::set(const String& name, int index, int total) {
+    if (name != name_ || index != index_ || total != total_) {
+        name_ = name;
+        index_ = index;
+        total_ = total;
+        invalidate();
+    }
+}
+
+void BoatNameWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    gfx.setTextDatum(TL_DATUM);
+    gfx.setTextSize(2);
+    gfx.setCursor(bounds_.x - originX + 5, bounds_.y - originY + 5);
+    if (name_.length() > 0 && total_ > 0) {
+        gfx.setTextColor(YELLOW);
+        gfx.print(name_);
+        gfx.setTextColor(WHITE);
+        gfx.printf(" %d/%d", index_, total_);
+    } else {
+        gfx.setTextColor(RED);
+        gfx.print("NO BOAT");
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+HubWidget::HubWidget(int16_t x, int16_t y, int16_t w, int16_t h)
+    : Widget(x, y, w, h), active_(false), relayed_(0) {
+}
+
+void HubWidget::set(bool active, uint32_t relayed) {
+    markDirtyIf(active != active_ || relayed != relayed_);
+    active_ = active;
+    relayed_ = relayed;
+}
+
+void HubWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    gfx.setTextDatum(TL_DATUM);
+    gfx.setTextSize(1);
+    gfx.setCursor(bounds_.x - originX + 2, bounds_.y - originY + 2);
+    if (active_) {
+        gfx.setTextColor(GREEN);
+        gfx.printf("HUB OK  relayed:%lu", relayed_);
+    } else {
+        gfx.setTextColor(DARKGREY);
+        gfx.print("HUB --");
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+BatteryWidget::BatteryWidget(int16_t x, int16_t y, int16_t w, int16_t h)
+    : Widget(x, y, w, h), percent_(-1), charging_(false) {
+}
+
+void BatteryWidget::set(int percent, bool charging) {
+    markDirtyIf(percent != percent_ || charging != charging_);
+    percent_ = percent;
+    charging_ = charging;
+}
+
+void BatteryWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    if (percent_ < 0) return;
+
+    int batteryX = bounds_.x - originX + 15;
+    int batteryY = bounds_.y - originY + 2;
+
+    // Corps et borne + de la batterie
+    gfx.drawRect(batteryX, batteryY, 24, 12, WHITE);
+    gfx.fillRect(batteryX + 24, batteryY + 3, 2, 6, WHITE);
+
+    // Remplissage proportionnel avec couleur selon le niveau
+    int fillWidth = (percent_ * 20) / 100;
+    if (fillWidth > 20) fillWidth = 20;
+    uint16_t levelColor = RED;
+    if (percent_ > 50) {
+        levelColor = GREEN;
+    } else if (percent_ > 20) {
+        levelColor = ORANGE;
+    }
+    gfx.fillRect(batteryX + 2, batteryY + 2, fillWidth, 8, levelColor);
+
+    // Éclair jaune si en charge
+    if (charging_) {
+        gfx.fillTriangle(batteryX + 14, batteryY + 2,
+                         batteryX + 10, batteryY + 7,
+                         batteryX + 12, batteryY + 7, YELLOW);
+        gfx.fillTriangle(batteryX + 10, batteryY + 7,
+                         batteryX + 14, batteryY + 12,
+                         batteryX + 12, batteryY + 7, YELLOW);
+    }
+
+    gfx.setTextDatum(TL_DATUM);
+    gfx.setCursor(batteryX + 32, batteryY);
+    gfx.setTextSize(2);
+    gfx.setTextColor(levelColor);
+    gfx.printf("%d%%", percent_);
+}
+
+// ----------------------------------------------------------------------------
+
+SatelliteWidget::SatelliteWidget(int16_t x, int16_t y, int16_t w, int16_t h)
+    : Widget(x, y, w, h), count_(-1) {
+}
+
+void SatelliteWidget::setCount(uint8_t count) {
+    markDirtyIf(count != count_);
+    count_ = count;
+}
+
+void SatelliteWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    if (count_ < 0) return;
+
+    int satX = bounds_.x - originX + 5;
+    int satY = bounds_.y - originY + 3;
+
+    // Panneaux solaires (lignes horizontales bleues) et corps blanc
+    gfx.drawRect(satX, satY, 4, 12, WHITE);
+    gfx.drawRect(satX + 10, satY, 4, 12, WHITE);
+    for (int i = 2; i <= 10; i += 2) {
+        gfx.drawLine(satX + 1, satY + i, satX + 2, satY + i, BLUE);
+        gfx.drawLine(satX + 11, satY + i, satX + 12, satY + i, BLUE);
+    }
+    gfx.fillRect(satX + 5, satY + 3, 4, 6, WHITE);
+
+    gfx.setTextDatum(TL_DATUM);
+    gfx.setCursor(satX + 20, satY - 1);
+    gfx.setTextColor(WHITE);
+    gfx.setTextSize(2);
+    gfx.printf("%d", count_);
+}
+
+// ----------------------------------------------------------------------------
+
+ButtonWidget::ButtonWidget(int16_t x, int16_t y, int16_t w, int16_t h)
+    : Widget(x, y, w, h), text_(nullptr), fillColor_(NAVY), borderColor_(WHITE), textColor_(WHITE) {
+}
+
+void ButtonWidget::set(const char* text, uint16_t fillColor, uint16_t borderColor, uint16_t textColor) {
+    bool sameText = (text == text_) || (text && text_ && strcmp(text, text_) == 0);
+    markDirtyIf(!sameText || fillColor != fillColor_ || borderColor != borderColor_ || textColor != textColor_);
+    text_ = text;
+    fillColor_ = fillColor;
+    borderColor_ = borderColor;
+    textColor_ = textColor;
+}
+
+void ButtonWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    int x = bounds_.x - originX;
+    int y = bounds_.y - originY;
+    gfx.fillRect(x, y, bounds_.w, bounds_.h, fillColor_);
+    gfx.drawRect(x, y, bounds_.w, bounds_.h, borderColor_);
+    if (text_) {
+        gfx.setTextColor(textColor_);
+        gfx.setTextDatum(MC_DATUM);
+        gfx.setTextSize(2);
+        gfx.drawString(text_, x + bounds_.w / 2, y + bounds_.h / 2);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+SpeedBarWidget::SpeedBarWidget(int16_t x, int16_t y, int16_t w, int16_t h)
+    : Widget(x, y, w, h), barHeight_(0), barColor_(GREEN) {
+}
+
+void SpeedBarWidget::setSpeed(float speedKmh) {
+    const float maxSpeed = 12.0;
+    int barHeight = (int)((speedKmh / maxSpeed) * bounds_.h);
+    if (barHeight > bounds_.h) barHeight = bounds_.h;
+    if (barHeight < 0) barHeight = 0;
+    uint16_t barColor = GREEN;
+    if (speedKmh > 4.0 && speedKmh <= 8.0) {
+        barColor = ORANGE;
+    } else if (speedKmh > 8.0) {
+        barColor = RED;
+    }
+    markDirtyIf(barHeight != barHeight_ || barColor != barColor_);
+    barHeight_ = barHeight;
+    barColor_ = barColor;
+}
+
+void SpeedBarWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    int x = bounds_.x - originX;
+    int y = bounds_.y - originY;
+    gfx.fillRect(x, y + bounds_.h - barHeight_, bounds_.w, barHeight_, barColor_);
+    gfx.drawRect(x, y, bounds_.w, bounds_.h, WHITE);
+}
+
+// ----------------------------------------------------------------------------
+
+MessageWidget::MessageWidget(int16_t x, int16_t y, int16_t w, int16_t h)
+    : Widget(x, y, w, h), active_(false) {
+}
+
+void MessageWidget::set(bool active, const String& detail) {
+    markDirtyIf(active != active_ || detail != detail_);
+    active_ = active;
+    detail_ = detail;
+}
+
+void MessageWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    int x = bounds_.x - originX;
+    int y = bounds_.y - originY;
+    int cx = x + bounds_.w / 2;
+    int cy = y + bounds_.h / 2;
+
+    gfx.setTextDatum(MC_DATUM);
+    if (active_) {
+        gfx.fillRect(x, y, bounds_.w, bounds_.h, RED);
+        gfx.setTextColor(BLACK);
+        gfx.setTextSize(3);
+        gfx.drawString("SERVEUR ACTIF", cx, cy - 10);
+        gfx.setTextSize(2);
+        gfx.drawString("http://" + detail_, cx, cy + 15);
+    } else {
+        gfx.fillRect(x, y, bounds_.w, bounds_.h, NAVY);
+        gfx.setTextColor(WHITE);
+        gfx.setTextSize(3);
+        gfx.drawString("SERVEUR ARRETE", cx, cy - 10);
+        gfx.setTextSize(2);
+        gfx.drawString(detail_ != "" ? detail_ : String("Mode normal restaure"), cx, cy + 15);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+SdErrorWidget::SdErrorWidget(int16_t x, int16_t y, int16_t w, int16_t h)
+    : Widget(x, y, w, h), message_("") {
+}
+
+void SdErrorWidget::set(const char* message) {
+    if (!message) message = "";
+    markDirtyIf(strcmp(message, message_) != 0);
+    message_ = message;
+}
+
+void SdErrorWidget::draw(LovyanGFX& gfx, int16_t originX, int16_t originY) {
+    int x = bounds_.x - originX;
+    int y = bounds_.y - originY;
+    int cx = x + bounds_.w / 2;
+
+    // Le panneau masque entièrement la zone principale
+    gfx.fillRect(x, y, bounds_.w, bounds_.h, BLACK);
+
+    // Fond rouge pour l'erreur
+    gfx.fillRect(x + 10, y + 20, bounds_.w - 20, 60, RED);
+    gfx.drawRect(x + 10, y + 20, bounds_.w - 20, 60, WHITE);
+
+    gfx.setTextColor(WHITE);
+    gfx.setTextDatum(MC_DATUM);
+    gfx.setTextSize(2);
+    gfx.drawString("ERREUR SD", cx, y + 35);
+    gfx.setTextSize(1);
+    gfx.drawString(message_, cx, y + 55);
+
+    // Message d'instruction
+    gfx.setTextColor(YELLOW);
+    gfx.setTextSize(2);
+    gfx.drawString("Insérer carte SD", cx, y + 100);
+}
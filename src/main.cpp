@@ -43,6 +43,11 @@
  * 
  * @note L'aiguille de la boussole se déplace instantanément vers la nouvelle position (animation fluide désactivée)
  */
+// Seuil du journal de ce fichier : -DLOG_LEVEL_MAIN=LOG_DEBUG dans build_flags (LOG_LEVEL sinon)
+#ifdef LOG_LEVEL_MAIN
+#define LOG_MODULE_LEVEL LOG_LEVEL_MAIN
+#endif
+
 #include <M5Unified.h>
 #include <WiFi.h>
 #include <esp_now.h>
@@ -58,7 +63,15 @@
 #include "Display.h"
 #include "DisplayTypes.h"
 #include "Storage.h"
+#include "HistoryBuffer.h"
+#include "PsramAllocator.h"
 #include "FileServerManager.h"
+#include "StorageBenchmark.h"
+#include "DownloadBenchmark.h"
+#include "BusScheduler.h"
+#include "RenderTask.h"
+#include "PowerGovernor.h"
+#include "LiveTelemetry.h"
 
 
 // Instances globales
@@ -105,25 +118,49 @@ unsigned long lastBuoyUpdateTimestamp = 0; // Timestamp de la dernière mise à
 volatile float lastComputedWindDirection = -1; // Dernière direction du vent calculée (pour stockage anémomètre)
 volatile bool sdWriteError = false; // Flag d'erreur d'écriture SD (mis par storageTask)
 
+// Historique pré-déclenchement ("boîte noire") : les dernières minutes sont
+// gardées en RAM (PSRAM) et écrites au début de chaque nouvel enregistrement
+const uint16_t HISTORY_MINUTES = 5;      // Durée d'historique conservée
+const uint8_t HISTORY_RATE_HZ = 10;      // Fréquence max par appareil (empreinte/min/appareil)
+const uint8_t HISTORY_MAX_DEVICES = 16;  // Nombre d'appareils (bateaux + bouées + anémomètres)
+
 // Instances des gestionnaires
 Logger logger;
 Display display;
 Storage storage;
+BusScheduler spiBus; // Bus SPI partagé entre l'écran et la carte SD
+RenderTask renderTask; // Tâche d'affichage à cadence fixe
+PowerGovernor powerGovernor; // Cadence d'affichage et fréquence CPU selon l'activité
+HistoryBuffer history;
 FileServerManager fileServer;
+StorageBenchmark storageBenchmark;
+DownloadBenchmark downloadBenchmark;
+LiveTelemetry liveTelemetry; // Dernier état de chaque appareil pour /api/live
 
-// Queue pour les données à stocker
+// Queue pour les données à stocker (en PSRAM, voir StorageBatch)
 QueueHandle_t storageQueue;
-std::vector<StorageData> pendingStorageData;
+StorageBatch pendingStorageData;
 SemaphoreHandle_t storageDataMutex;
+const unsigned long STORAGE_FLUSH_INTERVAL_MS = 5000; // Intervalle d'écriture SD
+const unsigned long STORAGE_HISTORY_INTERVAL_MS = 50; // Entre deux tranches d'historique pré-déclenchement
+const size_t STORAGE_QUEUE_RESERVE = 2048;            // Entrées pré-allouées (~150 KB en PSRAM)
+volatile uint32_t storageQueued = 0;      // Entrées mises en file depuis le démarrage
+volatile uint32_t storageQueueDrops = 0;  // Entrées abandonnées (file occupée dans le callback)
+
+// Banc "bench download" : les trames radio sont comptées, pas traitées
+volatile bool simulationActive = false;
+volatile uint32_t simulationRadioFrames = 0;
+volatile bool simulationPurgePending = false; // Fin du banc : bateaux simulés à retirer (boucle principale)
 
-bool newData = false;
 bool sdInitialized = false; // État de la carte SD
+const char* sdErrorText = nullptr; // Détail affiché tant que la SD n'est pas initialisée
 bool isRecording = false;
 
 // Variables pour le debouncing des boutons tactiles (un timer par bouton)
 unsigned long lastTouchTimeButton1 = 0; // Bouton GPS (gauche)
 unsigned long lastTouchTimeButton2 = 0; // Bouton central
 unsigned long lastTouchTimeButton3 = 0; // Bouton WiFi (droite)
+unsigned long lastTouchTimePage = 0;    // Zone principale (changement de page)
 const unsigned long TOUCH_DEBOUNCE_MS = 500; // 500ms entre les appuis
 
 uint8_t boatAddress[] = {0x24, 0xA1, 0x60, 0x45, 0xE7, 0xF8};  //Boat2
@@ -131,56 +168,67 @@ uint8_t anemometerAddress[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};  //Anemomete
 
 /**
  * @brief Affiche des informations de diagnostic sur la structure des données
+ * 
+ * Niveau LOG_DEBUG : la fonction est vide dans les versions de production.
  */
 void printStructureInfo() {
-    logger.log("=== DIAGNOSTIC STRUCTURE ===");
-    logger.log("--- BATEAU ---");
-    logger.log(String("Taille struct_message_Boat: ") + String(sizeof(struct_message_Boat)) + " bytes");
-    logger.log("Offsets struct_message_Boat:");
-    logger.log(String("  messageType: ") + String(offsetof(struct_message_Boat, messageType)));
-    logger.log(String("  sequenceNumber: ") + String(offsetof(struct_message_Boat, sequenceNumber)));
-    logger.log(String("  gpsTimestamp: ") + String(offsetof(struct_message_Boat, gpsTimestamp)));
-    logger.log(String("  latitude: ") + String(offsetof(struct_message_Boat, latitude)));
-    logger.log(String("  longitude: ") + String(offsetof(struct_message_Boat, longitude)));
-    logger.log(String("  speed: ") + String(offsetof(struct_message_Boat, speed)));
-    logger.log(String("  heading: ") + String(offsetof(struct_message_Boat, heading)));
-    logger.log(String("  satellites: ") + String(offsetof(struct_message_Boat, satellites)));
-    logger.log("--- ANÉMOMÈTRE ---");
-    logger.log(String("Taille struct_message_Anemometer: ") + String(sizeof(struct_message_Anemometer)) + " bytes");
-    logger.log("Offsets struct_message_Anemometer:");
-    logger.log(String("  messageType: ") + String(offsetof(struct_message_Anemometer, messageType)));
-    logger.log(String("  anemometerId: ") + String(offsetof(struct_message_Anemometer, anemometerId)));
-    logger.log(String("  macAddress: ") + String(offsetof(struct_message_Anemometer, macAddress)));
-    logger.log(String("  sequenceNumber: ") + String(offsetof(struct_message_Anemometer, sequenceNumber)));
-    logger.log(String("  windSpeed: ") + String(offsetof(struct_message_Anemometer, windSpeed)));
-    logger.log(String("  timestamp: ") + String(offsetof(struct_message_Anemometer, timestamp)));
-    logger.log("--- BOUÉE GPS ---");
-    logger.log(String("Taille struct_message_Buoy: ") + String(sizeof(struct_message_Buoy)) + " bytes");
-    logger.log("Offsets struct_message_Buoy:");
-    logger.log(String("  buoyId: ") + String(offsetof(struct_message_Buoy, buoyId)));
-    logger.log(String("  timestamp: ") + String(offsetof(struct_message_Buoy, timestamp)));
-    logger.log(String("  generalMode: ") + String(offsetof(struct_message_Buoy, generalMode)));
-    logger.log(String("  navigationMode: ") + String(offsetof(struct_message_Buoy, navigationMode)));
-    logger.log(String("  gpsOk: ") + String(offsetof(struct_message_Buoy, gpsOk)));
-    logger.log(String("  temperature: ") + String(offsetof(struct_message_Buoy, temperature)));
-    logger.log(String("  remainingCapacity: ") + String(offsetof(struct_message_Buoy, remainingCapacity)));
-    logger.log("===============================");
+    LOGD(logger, "=== DIAGNOSTIC STRUCTURE ===");
+    LOGD(logger, "--- BATEAU ---");
+    LOGD(logger, "Taille struct_message_Boat: %u bytes", (unsigned)sizeof(struct_message_Boat));
+    LOGD(logger, "Offsets struct_message_Boat:");
+    LOGD(logger, "  messageType: %u", (unsigned)offsetof(struct_message_Boat, messageType));
+    LOGD(logger, "  sequenceNumber: %u", (unsigned)offsetof(struct_message_Boat, sequenceNumber));
+    LOGD(logger, "  gpsTimestamp: %u", (unsigned)offsetof(struct_message_Boat, gpsTimestamp));
+    LOGD(logger, "  latitude: %u", (unsigned)offsetof(struct_message_Boat, latitude));
+    LOGD(logger, "  longitude: %u", (unsigned)offsetof(struct_message_Boat, longitude));
+    LOGD(logger, "  speed: %u", (unsigned)offsetof(struct_message_Boat, speed));
+    LOGD(logger, "  heading: %u", (unsigned)offsetof(struct_message_Boat, heading));
+    LOGD(logger, "  satellites: %u", (unsigned)offsetof(struct_message_Boat, satellites));
+    LOGD(logger, "--- ANÉMOMÈTRE ---");
+    LOGD(logger, "Taille struct_message_Anemometer: %u bytes", (unsigned)sizeof(struct_message_Anemometer));
+    LOGD(logger, "Offsets struct_message_Anemometer:");
+    LOGD(logger, "  messageType: %u", (unsigned)offsetof(struct_message_Anemometer, messageType));
+    LOGD(logger, "  anemometerId: %u", (unsigned)offsetof(struct_message_Anemometer, anemometerId));
+    LOGD(logger, "  macAddress: %u", (unsigned)offsetof(struct_message_Anemometer, macAddress));
+    LOGD(logger, "  sequenceNumber: %u", (unsigned)offsetof(struct_message_Anemometer, sequenceNumber));
+    LOGD(logger, "  windSpeed: %u", (unsigned)offsetof(struct_message_Anemometer, windSpeed));
+    LOGD(logger, "  timestamp: %u", (unsigned)offsetof(struct_message_Anemometer, timestamp));
+    LOGD(logger, "--- BOUÉE GPS ---");
+    LOGD(logger, "Taille struct_message_Buoy: %u bytes", (unsigned)sizeof(struct_message_Buoy));
+    LOGD(logger, "Offsets struct_message_Buoy:");
+    LOGD(logger, "  buoyId: %u", (unsigned)offsetof(struct_message_Buoy, buoyId));
+    LOGD(logger, "  timestamp: %u", (unsigned)offsetof(struct_message_Buoy, timestamp));
+    LOGD(logger, "  generalMode: %u", (unsigned)offsetof(struct_message_Buoy, generalMode));
+    LOGD(logger, "  navigationMode: %u", (unsigned)offsetof(struct_message_Buoy, navigationMode));
+    LOGD(logger, "  gpsOk: %u", (unsigned)offsetof(struct_message_Buoy, gpsOk));
+    LOGD(logger, "  temperature: %u", (unsigned)offsetof(struct_message_Buoy, temperature));
+    LOGD(logger, "  remainingCapacity: %u", (unsigned)offsetof(struct_message_Buoy, remainingCapacity));
+    LOGD(logger, "===============================");
 }
 
 /**
  * @brief Synchronize RTC with NTP when WiFi becomes available
  * 
- * This function attempts to synchronize the M5Stack Core2 RTC with an NTP server
- * to ensure accurate timestamps for file naming and data logging.
+ * This function starts synchronizing the M5Stack Core2 RTC with an NTP server
+ * to ensure accurate timestamps for file naming and data logging. It returns
+ * at once: pollRTCSync() finishes the job from the following loop() calls.
  */
 void syncRTCIfWiFiConnected() {
     if (WiFi.status() == WL_CONNECTED) {
         logger.log("WiFi connected - attempting RTC synchronization");
-        if (storage.syncRTCFromNTP("pool.ntp.org", 3600, 3600)) { // GMT+1 + DST
-            logger.log("RTC synchronized successfully with NTP");
-        } else {
-            logger.log("RTC synchronization failed");
-        }
+        storage.beginNTPSync("pool.ntp.org", 3600, 3600); // GMT+1 + DST
+    }
+}
+
+/**
+ * @brief Report the end of the synchronization started by syncRTCIfWiFiConnected()
+ */
+void pollRTCSync() {
+    NtpSyncState state = storage.pollNTPSync();
+    if (state == NTP_SYNC_DONE) {
+        logger.log("RTC synchronized successfully with NTP");
+    } else if (state == NTP_SYNC_FAILED) {
+        logger.log("RTC synchronization failed");
     }
 }
 
@@ -230,19 +278,37 @@ float computeAverageWindDirection() {
     return avgDeg;
 }
 
+/**
+ * @brief Identifiant d'un appareil pour /api/live : fin de son adresse MAC
+ */
+uint32_t telemetryDeviceId(const uint8_t* mac) {
+    return ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+}
+
 /**
  * @brief Nettoie les bateaux qui n'ont pas envoyé de données depuis BOAT_TIMEOUT_MS
+ *
+ * Après "bench download", retire aussi la flotte simulée (liste, flotte
+ * affichée et /api/live) sans attendre son timeout.
  */
 void cleanupTimedOutBoats() {
     unsigned long currentTime = millis();
     std::vector<String> toRemove;
+    bool purgeSimulated = simulationPurgePending;
+    simulationPurgePending = false;
     
     for (auto& pair : detectedBoats) {
-        if (currentTime - pair.second.lastUpdate > BOAT_TIMEOUT_MS) {
+        if (purgeSimulated && DownloadBenchmark::isSimulated(pair.second.macAddress)) {
+            toRemove.push_back(pair.first);
+            liveTelemetry.remove(TELEMETRY_BOAT, telemetryDeviceId(pair.second.macAddress));
+        } else if (currentTime - pair.second.lastUpdate > BOAT_TIMEOUT_MS) {
             toRemove.push_back(pair.first);
             logger.log("Bateau timeout: " + pair.second.boatId + " (" + pair.first + ")");
         }
     }
+    if (purgeSimulated) {
+        logger.log("Flotte simulée retirée");
+    }
     
     for (const String& mac : toRemove) {
         detectedBoats.erase(mac);
@@ -292,7 +358,6 @@ void selectNextBoat() {
     if (boat) {
         logger.log("Bateau sélectionné: " + boat->boatId + " (" + macToString(boat->macAddress) + ")");
         display.forceFullRefresh(); // Force un rafraîchissement complet pour le nouveau bateau
-        newData = true; // Force le rafraîchissement de l'affichage
     }
 }
 
@@ -309,24 +374,40 @@ void selectNextBoat() {
  *               - ESP_NOW_SEND_FAIL : L'envoi du message a échoué.
  */
 void onSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
-  logger.log(String("Envoi: ") + (status == ESP_NOW_SEND_SUCCESS ? "Succès" : "Échec"));
+  LOGD(logger, "Envoi: %s", status == ESP_NOW_SEND_SUCCESS ? "Succès" : "Échec");
 }
 
 /**
- * @brief Fonction de rappel pour la réception des messages ESP-NOW
+ * @brief Met une entrée en file pour la carte SD sans jamais attendre
+ * @return false si la file était occupée (entrée abandonnée et comptée)
+ */
+static bool queueForStorage(const StorageData& data) {
+  if (xSemaphoreTake(storageDataMutex, 0) != pdTRUE) { // Non-bloquant !
+    storageQueueDrops++;
+    return false;
+  }
+  pendingStorageData.push_back(data);
+  xSemaphoreGive(storageDataMutex);
+  storageQueued++;
+  return true;
+}
+
+/**
+ * @brief Traite un message ESP-NOW (trame radio ou trame simulée du banc)
  * @param mac Adresse MAC de l'émetteur
  * @param incomingDataPtr Pointeur vers les données reçues
  * @param len Longueur des données reçues
  * 
- * Cette fonction est appelée lorsque des données ESP-NOW sont reçues. Elle copie les données 
+ * Cette fonction est appelée pour chaque donnée ESP-NOW reçue. Elle copie les données 
  * dans la structure incomingData et met à jour le cap cible pour la boussole.
  * Affiche également la latitude et la longitude sur le port série pour le débogage.
  */
-void onReceive(const uint8_t *mac, const uint8_t *incomingDataPtr, int len)
+void handleEspNowPacket(const uint8_t *mac, const uint8_t *incomingDataPtr, int len)
 {
   // CALLBACK CRITIQUE : Doit être ULTRA-RAPIDE (< 1ms)
   // Logs de debug désactivés pour éviter de bloquer le callback
   // et manquer des paquets suivants
+  powerGovernor.notePacket();
   
   // FIX: Vérifier la taille bouée EN PREMIER, avant d'interpréter le premier
   // byte comme messageType. Les bouées n'ont pas de champ messageType : leur
@@ -348,18 +429,18 @@ void onReceive(const uint8_t *mac, const uint8_t *incomingDataPtr, int len)
     buoyInfo.data = incomingBuoyData;
     buoyInfo.lastUpdate = millis();
     lastBuoyUpdateTimestamp = millis();
-    newData = true;
+    
+    StorageData storageData;
+    storageData.timestamp = millis();
+    storageData.dataType = DATA_TYPE_BUOY;
+    storageData.buoyData = incomingBuoyData;
+    
+    // Historique pré-déclenchement (RAM uniquement, aucun accès SD)
+    history.push(storageData);
     
     // Stockage sur SD (non-bloquant)
     if (isRecording && sdInitialized) {
-      if (xSemaphoreTake(storageDataMutex, 0) == pdTRUE) {
-        StorageData storageData;
-        storageData.timestamp = millis();
-        storageData.dataType = DATA_TYPE_BUOY;
-        storageData.buoyData = incomingBuoyData;
-        pendingStorageData.push_back(storageData);
-        xSemaphoreGive(storageDataMutex);
-      }
+      queueForStorage(storageData);
     }
     return;
   }
@@ -372,7 +453,6 @@ void onReceive(const uint8_t *mac, const uint8_t *incomingDataPtr, int len)
     if (len == sizeof(struct_message_HubStatus)) {
         memcpy(&incomingHubStatus, incomingDataPtr, sizeof(incomingHubStatus));
         hubStatusTimestamp = millis();
-        newData = true;
     }
     break;
   }
@@ -437,23 +517,28 @@ void onReceive(const uint8_t *mac, const uint8_t *incomingDataPtr, int len)
                    std::find(boatMacList.begin(), boatMacList.end(), boatKey) - boatMacList.begin() + 1 : 
                    1);
     
-    newData = true;
+
+    StorageData storageData;
+    storageData.timestamp = millis(); // Display clock for Kepler consistency
+    storageData.dataType = DATA_TYPE_BOAT;
+    storageData.boatData = incomingBoatData;
+    
+    // La flotte simulée de "bench download" n'est jamais enregistrée
+    if (DownloadBenchmark::isSimulated(mac)) {
+      break;
+    }
+    
+    // Historique pré-déclenchement (RAM uniquement, aucun accès SD)
+    history.push(storageData);
 
     // Stockage ultra-rapide (sans logs verbeux)
     if (isRecording && sdInitialized && 
         incomingBoatData.sequenceNumber != boat.lastStoredSequence) {
       
-      if (xSemaphoreTake(storageDataMutex, 0) == pdTRUE) { // Non-bloquant !
-        StorageData storageData;
-        storageData.timestamp = millis(); // Display clock for Kepler consistency
-        storageData.dataType = DATA_TYPE_BOAT;
-        storageData.boatData = incomingBoatData;
-        pendingStorageData.push_back(storageData);
-        xSemaphoreGive(storageDataMutex);
-        
+      // Si mutex occupé, on abandonne ce paquet (mieux que bloquer le callback)
+      if (queueForStorage(storageData)) {
         boat.lastStoredSequence = incomingBoatData.sequenceNumber;
       }
-      // Si mutex occupé, on abandonne ce paquet (mieux que bloquer le callback)
     }
     break;
   } // Fin case 1
@@ -486,19 +571,19 @@ void onReceive(const uint8_t *mac, const uint8_t *incomingDataPtr, int len)
     
     anemometerDataTimestamp = millis(); // Timestamp de réception
     
-    newData = true;
+    
+    StorageData storageData;
+    storageData.timestamp = millis(); // Display clock for Kepler consistency
+    storageData.windDirection = lastComputedWindDirection;
+    storageData.dataType = DATA_TYPE_ANEMOMETER;
+    storageData.anemometerData = incomingAnemometerData;
+    
+    // Historique pré-déclenchement (RAM uniquement, aucun accès SD)
+    history.push(storageData);
     
     // Stockage ultra-rapide (sans logs)
     if (isRecording && sdInitialized) {
-      if (xSemaphoreTake(storageDataMutex, 0) == pdTRUE) { // Non-bloquant !
-        StorageData storageData;
-        storageData.timestamp = millis(); // Display clock for Kepler consistency
-        storageData.windDirection = lastComputedWindDirection;
-        storageData.dataType = DATA_TYPE_ANEMOMETER;
-        storageData.anemometerData = incomingAnemometerData;
-        pendingStorageData.push_back(storageData);
-        xSemaphoreGive(storageDataMutex);
-      }
+      queueForStorage(storageData);
     }
     
     break;
@@ -507,12 +592,76 @@ void onReceive(const uint8_t *mac, const uint8_t *incomingDataPtr, int len)
   default: {
     // Les bouées sont déjà traitées avant le switch (check par taille)
     // Ici ne restent que les messages vraiment inconnus
-    logger.log("Message ESP-NOW inconnu (type: " + String(incomingDataPtr[0]) + ", taille: " + String(len) + " bytes)");
+    LOGW(logger, "Message ESP-NOW inconnu (type: %u, taille: %d bytes)", incomingDataPtr[0], len);
     break;
   }
   } // Fin switch
 }
 
+/**
+ * @brief Fonction de rappel pour la réception des messages ESP-NOW
+ * 
+ * Pendant "bench download", les trames radio sont seulement comptées : la
+ * flotte simulée du banc dispose seule du chemin de réception.
+ */
+void onReceive(const uint8_t *mac, const uint8_t *incomingDataPtr, int len)
+{
+  if (simulationActive) {
+    simulationRadioFrames++;
+    return;
+  }
+  handleEspNowPacket(mac, incomingDataPtr, len);
+}
+
+/**
+ * @class BenchReceiveTarget
+ * @brief Chemin de réception vu par le banc "bench download"
+ */
+class BenchReceiveTarget : public DownloadBenchTarget {
+private:
+  uint32_t receivedStart_ = 0;
+  uint32_t lostStart_ = 0;
+  uint32_t queuedStart_ = 0;
+  uint32_t dropsStart_ = 0;
+
+  static void simulatedTotals(uint32_t& received, uint32_t& lost) {
+    received = lost = 0;
+    for (auto& pair : detectedBoats) {
+      if (DownloadBenchmark::isSimulated(pair.second.macAddress)) {
+        received += pair.second.receivedPackets;
+        lost += pair.second.lostPackets;
+      }
+    }
+  }
+
+public:
+  void beginSimulation() override {
+    simulationRadioFrames = 0;
+    simulationActive = true;
+    simulatedTotals(receivedStart_, lostStart_);
+    queuedStart_ = storageQueued;
+    dropsStart_ = storageQueueDrops;
+  }
+
+  void inject(const uint8_t* mac, const uint8_t* data, int len) override {
+    handleEspNowPacket(mac, data, len);
+  }
+
+  void endSimulation(DownloadBenchProbe& probe) override {
+    simulationActive = false;
+    uint32_t received, lost;
+    simulatedTotals(received, lost);
+    probe.received = received - receivedStart_;
+    probe.lost = lost - lostStart_;
+    probe.queued = storageQueued - queuedStart_;
+    probe.queueDrops = storageQueueDrops - dropsStart_;
+    probe.radioFrames = simulationRadioFrames;
+    simulationPurgePending = true; // Retirés par la boucle principale, seule à modifier la flotte
+  }
+};
+
+BenchReceiveTarget benchReceiveTarget;
+
 
 
 /**
@@ -535,32 +684,71 @@ void onReceive(const uint8_t *mac, const uint8_t *incomingDataPtr, int len)
 void storageTask(void* parameter) {
     storage.setLogger(logger);
     
-    
+    // Les deux files sont échangées à chaque cycle : aucune allocation
+    // une fois la capacité atteinte
+    StorageBatch dataToWrite;
+    dataToWrite.reserve(STORAGE_QUEUE_RESERVE);
+    bool retryBatch = false; // Lot refusé car la SD était occupée : gardé tel quel
     
     while (true) {
-        std::vector<StorageData> dataToWrite;
+        if (!retryBatch) {
+            dataToWrite.clear();
+        }
         
         // Récupérer les données en attente de manière thread-safe
         if (xSemaphoreTake(storageDataMutex, portMAX_DELAY) == pdTRUE) {
             if (!pendingStorageData.empty()) {
-                dataToWrite = pendingStorageData;
-                pendingStorageData.clear();
+                if (dataToWrite.empty()) {
+                    dataToWrite.swap(pendingStorageData);
+                } else {
+                    // Les nouvelles données passent derrière le lot en attente
+                    dataToWrite.insert(dataToWrite.end(), pendingStorageData.begin(), pendingStorageData.end());
+                    pendingStorageData.clear();
+                }
             }
             xSemaphoreGive(storageDataMutex);
         }
+        retryBatch = false;
+        
+        // Écrire d'abord l'historique pré-déclenchement (après un appui RECORD)
+        // pour qu'il précède les données live dans le fichier de session.
+        // Quelques lots par cycle seulement : le bus SPI revient à l'écran
+        // entre deux tranches
+        bool historyWritten = true;
+        bool historyPending = false;
+        if (sdInitialized) {
+            if (!storage.flushPreTrigger()) {
+                if (storage.lastWriteBusy()) {
+                    historyWritten = false;
+                } else {
+                    sdWriteError = true;
+                }
+            } else if (storage.hasPendingPreTrigger()) {
+                historyWritten = false;
+                historyPending = true;
+            }
+        }
         
         // Écrire les données sur la carte SD
         if (!dataToWrite.empty()) {
-            if (!storage.writeDataBatch(dataToWrite)) {
-                logger.log("Erreur d'écriture sur SD");
-                sdWriteError = true;
+            if (!historyWritten) {
+                // SD occupée : les données live attendent la fin de l'historique
+                retryBatch = true;
+            } else if (!storage.writeDataBatch(dataToWrite)) {
+                if (storage.lastWriteBusy()) {
+                    retryBatch = true;
+                } else {
+                    logger.log("Erreur d'écriture sur SD");
+                    sdWriteError = true;
+                }
             } else {
                 sdWriteError = false;
             }
         }
         
-        // Attendre 5 secondes avant la prochaine écriture
-        vTaskDelay(pdMS_TO_TICKS(5000));
+        // Attendre avant la prochaine écriture (tranche suivante de l'historique
+        // sans attendre le cycle complet)
+        vTaskDelay(pdMS_TO_TICKS(historyPending ? STORAGE_HISTORY_INTERVAL_MS : STORAGE_FLUSH_INTERVAL_MS));
     }
 }
 
@@ -622,6 +810,140 @@ void reinitializeESPNow() {
   logger.log("ESPNow réinitialisé avec succès");
 }
 
+/**
+ * @brief Publie le dernier état de chaque appareil pour le flux /api/live
+ * 
+ * @param avgWindDir Direction moyenne du vent des bouées (-1 si aucune)
+ * 
+ * Seulement quand le serveur tourne. Un état déjà publié (même numéro de
+ * séquence) est ignoré par la table : rien n'est envoyé aux clients.
+ */
+void publishTelemetry(float avgWindDir) {
+  if (!fileServer.isServerActive()) return;
+
+  TelemetryState state;
+  for (auto& pair : detectedBoats) {
+    const BoatInfo& boat = pair.second;
+    memset(&state, 0, sizeof(state));
+    state.kind = TELEMETRY_BOAT;
+    state.deviceId = telemetryDeviceId(boat.macAddress);
+    state.sequence = boat.lastSequenceNumber;
+    strncpy(state.name, boat.data.name, sizeof(state.name) - 1);
+    state.latitude = boat.data.latitude;
+    state.longitude = boat.data.longitude;
+    state.speed = boat.data.speed;
+    state.heading = boat.data.heading;
+    state.detail = boat.data.satellites;
+    state.receivedMs = boat.lastUpdate;
+    liveTelemetry.publish(state);
+  }
+
+  for (auto& pair : detectedBuoys) {
+    const BuoyInfo& buoy = pair.second;
+    if (!buoy.data.gpsOk) continue;
+    memset(&state, 0, sizeof(state));
+    state.kind = TELEMETRY_BUOY;
+    state.deviceId = buoy.data.buoyId;
+    state.sequence = buoy.lastUpdate; // Les bouées v1 n'envoient pas de séquence
+    snprintf(state.name, sizeof(state.name), "BOUEE %u", buoy.data.buoyId);
+    state.latitude = buoy.data.latitude;
+    state.longitude = buoy.data.longitude;
+    state.heading = buoy.data.autoPilotTrueHeadingCmde;
+    state.detail = buoy.data.navigationMode;
+    state.receivedMs = buoy.lastUpdate;
+    liveTelemetry.publish(state);
+  }
+
+  if (anemometerDataTimestamp > 0) {
+    memset(&state, 0, sizeof(state));
+    state.kind = TELEMETRY_WIND;
+    state.deviceId = telemetryDeviceId(incomingAnemometerData.macAddress);
+    state.sequence = incomingAnemometerData.sequenceNumber;
+    strncpy(state.name, incomingAnemometerData.anemometerId, sizeof(state.name) - 1);
+    state.speed = incomingAnemometerData.windSpeed;
+    state.heading = avgWindDir;
+    state.receivedMs = anemometerDataTimestamp;
+    liveTelemetry.publish(state);
+  }
+}
+
+/**
+ * @brief Capture l'état affiché et le publie pour la tâche d'affichage
+ * 
+ * @param avgWindDir Direction moyenne du vent des bouées (-1 si aucune)
+ * @param windDirTs Horodatage de la direction du vent
+ * 
+ * Un seul instantané par itération de la boucle : l'image suivante montre
+ * des valeurs cohérentes entre elles. La batterie (I2C) est lue une fois
+ * par seconde ici, jamais depuis la tâche d'affichage.
+ */
+void publishDisplaySnapshot(float avgWindDir, unsigned long windDirTs) {
+  static int batteryLevel = 0;
+  static bool batteryCharging = false;
+  static unsigned long lastBatteryRead = 0;
+  if (lastBatteryRead == 0 || millis() - lastBatteryRead > 1000) {
+    lastBatteryRead = millis();
+    batteryLevel = M5.Power.getBatteryLevel();
+    batteryCharging = M5.Power.isCharging();
+  }
+
+  // Copier les données du bateau sélectionné dans incomingBoatData pour compatibilité
+  BoatInfo* selectedBoat = getSelectedBoat();
+  if (selectedBoat != nullptr) {
+    incomingBoatData = selectedBoat->data;
+  }
+
+  DisplaySnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot)); // Octets de remplissage à zéro : comparaison par memcmp
+  snapshot.boatData = incomingBoatData;
+  snapshot.anemometerData = incomingAnemometerData;
+  snapshot.boatDataTimestamp = boatDataTimestamp;
+  snapshot.anemometerDataTimestamp = anemometerDataTimestamp;
+  snapshot.windDirection = avgWindDir;
+  snapshot.windDirTimestamp = windDirTs;
+  snapshot.boatCount = boatMacList.size();
+  snapshot.selectedBoatIndex = selectedBoatIndex;
+  snapshot.hubActive = (hubStatusTimestamp > 0) && (millis() - hubStatusTimestamp < HUB_TIMEOUT_MS);
+  snapshot.hubTotalRelayed = incomingHubStatus.relayedCommands + incomingHubStatus.relayedStates + incomingHubStatus.relayedGPS + incomingHubStatus.relayedAnemometer;
+  snapshot.batteryLevel = batteryLevel;
+  snapshot.batteryCharging = batteryCharging;
+  snapshot.isRecording = isRecording;
+  snapshot.isServerActive = fileServer.isServerActive() || fileServer.isConnecting();  // STOP annule aussi la connexion
+  snapshot.hasSDError = sdWriteError;
+  snapshot.sdErrorMessage = sdInitialized ? nullptr : sdErrorText;
+
+  // Flotte dans l'ordre de détection (l'affichage trie par nom, tri stable)
+  for (const String& mac : boatMacList) {
+    if (snapshot.fleetCount >= FleetWidget::MAX_ROWS) break;
+    auto it = detectedBoats.find(mac);
+    if (it == detectedBoats.end()) continue;
+    const BoatInfo& boat = it->second;
+    FleetEntry& entry = snapshot.fleet[snapshot.fleetCount++];
+    strncpy(entry.name, boat.data.name, 6);  // Déjà à zéro (memset)
+    entry.deviceId = ((uint32_t)boat.macAddress[2] << 24) | ((uint32_t)boat.macAddress[3] << 16) |
+                     ((uint32_t)boat.macAddress[4] << 8) | boat.macAddress[5];
+    entry.latitude = lroundf(boat.data.latitude * 1e7f);
+    entry.longitude = lroundf(boat.data.longitude * 1e7f);
+    entry.speed = boat.data.speed;
+    entry.heading = boat.data.heading;
+    entry.lastUpdate = boat.lastUpdate;
+    entry.receivedPackets = boat.receivedPackets;
+    entry.lostPackets = boat.lostPackets;
+  }
+
+  // Bouées actives avec fix GPS (repères de la carte)
+  for (auto& pair : detectedBuoys) {
+    if (snapshot.buoyCount >= MapWidget::MAX_BUOYS) break;
+    const BuoyInfo& buoy = pair.second;
+    if (millis() - buoy.lastUpdate >= BUOY_TIMEOUT_MS || !buoy.data.gpsOk) continue;
+    MapMark& mark = snapshot.buoys[snapshot.buoyCount++];
+    mark.id = buoy.data.buoyId;
+    mark.latitude = (int32_t)llround(buoy.data.latitude * 1e7);
+    mark.longitude = (int32_t)llround(buoy.data.longitude * 1e7);
+  }
+  renderTask.publish(snapshot);
+}
+
 /**
  * @brief Initializes the M5 device and sets up ESP-NOW communication with boat and anemometer peers.
  * 
@@ -647,6 +969,11 @@ void setup() {
 
   M5.begin(cfg);
   
+  // Journal asynchrone : les messages passent par une file vidée par une tâche de basse priorité
+  if (!logger.begin()) {
+    logger.log(LOG_WARN, "Journal asynchrone indisponible, écriture série directe");
+  }
+  
   // Initialize RTC if not already set
   // Check if RTC has a valid date (after 2023)
   auto dt = M5.Rtc.getDateTime();
@@ -691,7 +1018,17 @@ void setup() {
     logger.log("Erreur de création du mutex");
     ESP.restart();
   }
+  pendingStorageData.reserve(STORAGE_QUEUE_RESERVE);
 
+  // Historique pré-déclenchement, écrit au début de chaque enregistrement
+  if (history.begin(HISTORY_MINUTES, HISTORY_RATE_HZ, HISTORY_MAX_DEVICES)) {
+    storage.setHistory(history);
+  } else {
+    logger.log("Erreur d'allocation de l'historique pré-déclenchement");
+  }
+  logger.log(history.describe());
+  logger.log(describeMemoryUsage());
+  
   String macAddress = WiFi.macAddress();
   logger.log("Adresse MAC :");
   logger.log(macAddress);
@@ -728,6 +1065,13 @@ void setup() {
   // Afficher les informations de diagnostic des structures
   printStructureInfo();
 
+  spiBus.begin();
+  display.setBus(spiBus);
+  storage.setBus(spiBus);
+  storageBenchmark.setBus(spiBus);
+  downloadBenchmark.setBus(spiBus);
+  fileServer.setBus(spiBus);
+  display.begin();
   display.showSplashScreen();
   logger.log("Setup started");
   
@@ -737,7 +1081,7 @@ void setup() {
 
   if (!storage.initSD()) {
         logger.log("Erreur d'initialisation du stockage SD");
-        display.showSDError("Carte SD non détectée");
+        sdErrorText = "Carte SD non détectée";
         sdInitialized = false;
         // Continuer le setup au lieu de faire planter le système
     } else {
@@ -765,28 +1109,153 @@ void setup() {
   
   // Initialiser le gestionnaire de serveur de fichiers
   fileServer.setLogger(logger);
+  if (liveTelemetry.begin()) {
+    fileServer.setTelemetry(liveTelemetry);
+  }
+  storageBenchmark.setLogger(logger);
+  downloadBenchmark.setLogger(logger);
+  powerGovernor.setLogger(logger);
   if (fileServer.initFileServer()) {
     logger.log("Serveur de fichiers initialisé - Prêt pour connexion WiFi");
   } else {
     logger.log("Échec initialisation serveur de fichiers");
   }
   
+  // Tâche d'affichage à cadence fixe, alimentée par les instantanés de loop()
+  if (renderTask.begin(display)) {
+    publishDisplaySnapshot(-1, 0);
+    powerGovernor.begin(renderTask);
+  } else {
+    logger.log("Erreur: création de la tâche d'affichage impossible");
+  }
+  
   logger.log("Setup complete");
 }
 
+/**
+ * @brief Mesure le coût d'une instruction de journal sur le chemin critique
+ * 
+ * Cycles CPU par appel, pour un message de niveau LOG_DEBUG :
+ * - LOGD : rien si le seuil de compilation l'exclut, sinon un appel filtré à l'exécution
+ * - ancienne forme (String concaténées) filtrée à l'exécution : la chaîne est construite quand même
+ * - logf() filtré à l'exécution : ni formatage ni allocation
+ * La taille du programme en flash permet de comparer deux compilations.
+ */
+void benchmarkLogging() {
+  const int kCalls = 1000;
+  LogLevel previous = logger.level();
+  logger.setLevel(LOG_INFO);  // Les trois formes sont filtrées : aucune sortie
+
+  uint32_t start = ESP.getCycleCount();
+  for (int i = 0; i < kCalls; i++) {
+    LOGD(logger, "Touch PRESSED à x=%d, y=%d", i, i);
+  }
+  uint32_t macroCycles = ESP.getCycleCount() - start;
+
+  start = ESP.getCycleCount();
+  for (int i = 0; i < kCalls; i++) {
+    logger.log(LOG_DEBUG, String("Touch PRESSED à x=") + String(i) + ", y=" + String(i));
+  }
+  uint32_t stringCycles = ESP.getCycleCount() - start;
+
+  start = ESP.getCycleCount();
+  for (int i = 0; i < kCalls; i++) {
+    logger.logf(LOG_DEBUG, "Touch PRESSED à x=%d, y=%d", i, i);
+  }
+  uint32_t formatCycles = ESP.getCycleCount() - start;
+
+  logger.setLevel(previous);
+  LOGI(logger, "Journal, cycles par appel : LOGD %s %lu, String filtrée %lu, logf filtré %lu ; programme %lu octets",
+       LOG_ENABLED(LOG_DEBUG) ? "(compilé)" : "(supprimé)", (unsigned long)(macroCycles / kCalls),
+       (unsigned long)(stringCycles / kCalls), (unsigned long)(formatCycles / kCalls),
+       (unsigned long)ESP.getSketchSize());
+}
+
+/**
+ * @brief Exécute une commande reçue sur le port série
+ * 
+ * Commandes disponibles :
+ * - bench    : benchmark du stockage sur carte SD simulée
+ * - bench sd : benchmark du stockage sur la vraie carte (fichier /bench/, hors enregistrement)
+ * - bench download [secondes] : flotte simulée pendant des téléchargements (serveur actif, hors enregistrement)
+ * - bench log : coût des instructions de journal (cycles) et taille du programme
+ * - chart <minutes> : durée des courbes de vitesse et de vent (1 à 10 minutes)
+ */
+void processSerialCommand(const String& command) {
+  if (command.length() > 0) powerGovernor.noteInteraction();
+  if (command == "bench" || command == "bench sim") {
+    storageBenchmark.runAll(false);
+  } else if (command == "bench sd") {
+    if (!sdInitialized) {
+      logger.log("Benchmark SD impossible : carte SD non initialisée");
+    } else if (isRecording) {
+      logger.log("Benchmark SD impossible pendant un enregistrement");
+    } else {
+      storageBenchmark.runAll(true);
+    }
+  } else if (command == "bench download" || command.startsWith("bench download ")) {
+    int seconds = command.length() > 15 ? command.substring(15).toInt() : DownloadBenchmark::DEFAULT_SECONDS;
+    if (!fileServer.isServerActive()) {
+      logger.log("Benchmark téléchargement impossible : serveur de fichiers arrêté");
+    } else if (isRecording) {
+      logger.log("Benchmark téléchargement impossible pendant un enregistrement");
+    } else if (seconds <= 0) {
+      logger.log("Durée invalide : " + command.substring(15));
+    } else if (!downloadBenchmark.start(benchReceiveTarget, seconds)) {
+      logger.log("Benchmark téléchargement déjà en cours");
+    }
+  } else if (command == "bench log") {
+    benchmarkLogging();
+  } else if (command == "bench display") {
+    logger.log(display.benchmarkReadouts());
+  } else if (command.startsWith("chart ")) {
+    int minutes = command.substring(6).toInt();
+    if (minutes < StripChartWidget::MIN_WINDOW_MINUTES || minutes > StripChartWidget::MAX_WINDOW_MINUTES) {
+      logger.log("Durée des courbes invalide : " + command.substring(6) + " (1 à 10 minutes)");
+    } else {
+      display.setChartWindow(minutes);
+      logger.log("Durée des courbes : " + String(minutes) + " min");
+    }
+  } else if (command.length() > 0) {
+    logger.log("Commande inconnue : " + command + " (bench, bench sd, bench download, bench log, bench display, chart <minutes>)");
+  }
+}
+
+/**
+ * @brief Lit les caractères reçus sur le port série et exécute chaque ligne complète
+ */
+void pollSerialCommands() {
+  static String line;
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == '\n' || c == '\r') {
+      line.trim();
+      processSerialCommand(line);
+      line = "";
+    } else if (line.length() < 64) {
+      line += c;
+    }
+  }
+}
+
 /**
  * @brief Boucle principale du programme
  * 
  * En continu :
  * - Met à jour l'état du M5Stack
- * - Rafraîchit l'affichage quand de nouvelles données sont reçues
- * - Met à jour le cap de la boussole
- * - Gère le débordement du cap (0-360 degrés) 
- * S'exécute avec un délai de 50ms entre les itérations
+ * - Publie l'état affiché (instantané) pour la tâche d'affichage
+ * S'exécute avec un délai de 50ms entre les itérations (100ms en veille profonde)
  */
 void loop() {
 
   M5.update(); // Met à jour l'état des boutons et autres périphériques M5
+  if (M5.Touch.getCount()) powerGovernor.noteInteraction(); // Retour immédiat à l'état actif
+  pollSerialCommands();
+  
+  // Gouverneur d'énergie : données reçues, pertes et changements d'écran
+  uint32_t totalLostPackets = 0;
+  for (auto& pair : detectedBoats) totalLostPackets += pair.second.lostPackets;
+  powerGovernor.update(totalLostPackets, fileServer.isServerActive());
   
   // Calculer la direction moyenne du vent à partir des bouées actives
   float avgWindDir = computeAverageWindDirection();
@@ -810,6 +1279,22 @@ void loop() {
     if (pendingStorageData.size() > 0) {
       Serial.printf("💾 File d'attente stockage: %d entrées\n", pendingStorageData.size());
     }
+    if (storageQueueDrops > 0) {
+      Serial.printf("💾 Entrées abandonnées (file occupée): %lu\n", (unsigned long)storageQueueDrops);
+    }
+  }
+  
+  // Rapport mémoire (internal / PSRAM, fragmentation) toutes les minutes
+  static unsigned long lastMemoryLog = 0;
+  if (millis() - lastMemoryLog > 60000) {
+    lastMemoryLog = millis();
+    logger.log(describeMemoryUsage());
+    logger.log(display.describeFrameStats());
+    logger.log(renderTask.describe());
+    logger.log(spiBus.describe());
+    logger.log(powerGovernor.describe());
+    logger.log(fileServer.describe());
+    logger.log(logger.describe());
   }
   
   // Si la SD n'est pas initialisée, vérifier si l'utilisateur touche l'écran pour réessayer
@@ -824,19 +1309,15 @@ void loop() {
         }
       } else {
         logger.log("Échec de la réinitialisation SD");
-        display.showSDError("Réinitialisation échouée");
+        sdErrorText = "Réinitialisation échouée";
+        publishDisplaySnapshot(avgWindDir, windDirTs);
         delay(2000); // Attendre 2 secondes avant de permettre un nouveau test
       }
     }
-    // Afficher les données malgré l'erreur SD si on a des données
-    if (millis() % 5000 < 100) { // Toutes les 5 secondes pendant 100ms
-      bool hubActive = (hubStatusTimestamp > 0) && (millis() - hubStatusTimestamp < HUB_TIMEOUT_MS);
-      uint32_t hubRelayed = incomingHubStatus.relayedCommands + incomingHubStatus.relayedStates + incomingHubStatus.relayedGPS + incomingHubStatus.relayedAnemometer;
-      display.drawDisplay(incomingBoatData, incomingAnemometerData, isRecording, fileServer.isServerActive(), boatMacList.size(), avgWindDir, windDirTs, sdWriteError, selectedBoatIndex, hubActive, hubRelayed);
-      delay(100);
-      display.showSDError("Toucher écran pour réessayer");
-    }
-    delay(50);
+    // Les données restent affichées, le panneau d'erreur SD par-dessus
+    sdErrorText = "Toucher écran pour réessayer";
+    publishDisplaySnapshot(avgWindDir, windDirTs);
+    delay(powerGovernor.loopDelayMs());
     return;
   }
   
@@ -850,23 +1331,28 @@ void loop() {
     if (t.wasPressed() && t.y > 200) {  // Zone des boutons en bas de l'écran
       
       unsigned long currentTime = millis();
-      logger.log(String("Touch PRESSED à x=") + String(t.x) + ", y=" + String(t.y));
+      LOGD(logger, "Touch PRESSED à x=%d, y=%d", t.x, t.y);
       
       // Bouton 1 (gauche) - Gestion enregistrement GPS
       if (t.x < 107) {  // Premier tiers de l'écran (0-106px)
         // Vérifier le debouncing pour ce bouton spécifique
         if (currentTime - lastTouchTimeButton1 < TOUCH_DEBOUNCE_MS) {
-          logger.log("Appui ignoré sur bouton GPS - debouncing actif");
+          LOGD(logger, "Appui ignoré sur bouton GPS - debouncing actif");
           return;
         }
         lastTouchTimeButton1 = currentTime;
         
         // Toggle de l'enregistrement GPS
-        isRecording = !isRecording;
-        if (isRecording) {
+        // La fin de la fenêtre pré-déclenchement est prise avant que le callback
+        // ESP-NOW ne voie isRecording ; la tâche de stockage bascule ensuite
+        // sur le nouveau fichier avant d'écrire les données live reçues depuis
+        if (!isRecording) {
           storage.startNewRecording();
+          isRecording = true;
+        } else {
+          isRecording = false;
         }
-        logger.log(String("Enregistrement GPS ") + (isRecording ? "activé" : "désactivé"));
+        LOGI(logger, "Enregistrement GPS %s", isRecording ? "activé" : "désactivé");
         // L'affichage sera rafraîchi automatiquement dans la boucle principale
       }
       
@@ -874,12 +1360,12 @@ void loop() {
       else if (t.x >= 107 && t.x <= 213) {  // Deuxième tiers (107-213px)
         // Vérifier le debouncing pour ce bouton spécifique
         if (currentTime - lastTouchTimeButton2 < TOUCH_DEBOUNCE_MS) {
-          logger.log("Appui ignoré sur bouton central - debouncing actif");
+          LOGD(logger, "Appui ignoré sur bouton central - debouncing actif");
           return;
         }
         lastTouchTimeButton2 = currentTime;
         
-        logger.log("Bouton sélection bateau pressé");
+        LOGD(logger, "Bouton sélection bateau pressé");
         selectNextBoat();
       }
       
@@ -887,75 +1373,63 @@ void loop() {
       else if (t.x > 213) {  // Dernier tiers de l'écran (214-320px)
         // Vérifier le debouncing pour ce bouton spécifique
         if (currentTime - lastTouchTimeButton3 < TOUCH_DEBOUNCE_MS) {
-          logger.log("Appui ignoré sur bouton WiFi - debouncing actif");
+          LOGD(logger, "Appui ignoré sur bouton WiFi - debouncing actif");
           return;
         }
         lastTouchTimeButton3 = currentTime;
         
-        logger.log("Bouton serveur de fichiers détecté");
-        logger.log(String("État serveur AVANT: ") + (fileServer.isServerActive() ? "ACTIF" : "INACTIF"));
+        LOGD(logger, "Bouton serveur de fichiers détecté");
+        LOGD(logger, "État serveur AVANT: %s", fileServer.isServerActive() ? "ACTIF" : "INACTIF");
         
-        if (!fileServer.isServerActive()) {
+        if (!fileServer.isServerActive() && !fileServer.isConnecting()) {
           logger.log("Démarrage du serveur de fichiers HTTP...");
           bool startResult = fileServer.startFileServer();
-          logger.log(String("Résultat startFileServer(): ") + (startResult ? "SUCCÈS" : "ÉCHEC"));
-          logger.log(String("État serveur APRÈS start: ") + (fileServer.isServerActive() ? "ACTIF" : "INACTIF"));
+          LOGD(logger, "Résultat startFileServer(): %s", startResult ? "SUCCÈS" : "ÉCHEC");
           
           if (startResult) {
-            display.showFileServerStatus(true, fileServer.getServerIP());
-            logger.log("Serveur de fichiers actif sur: http://" + fileServer.getServerIP());
-            
-            // Synchronize RTC with NTP now that WiFi is connected
-            syncRTCIfWiFiConnected();
-            
-            // Redessiner les boutons pour afficher le bouton WiFi en VERT
-            display.drawButtonLabels(isRecording, true, boatMacList.size(), sdWriteError);
-            
-            // L'affichage sera rafraîchi automatiquement après le message
+            // La connexion se poursuit dans la tâche serveur : l'écran reste réactif,
+            // la fin de la connexion est suivie dans loop()
+            display.showFileServerStatus(false, "Connexion WiFi...");
           } else {
             logger.log("Erreur: Impossible de démarrer le serveur de fichiers");
             display.showFileServerStatus(false, "Erreur config WiFi");
           }
         } else {
           logger.log("Arrêt du serveur de fichiers HTTP...");
+          bool espNowKept = fileServer.keepsEspNow();
           bool stopResult = fileServer.stopFileServer();
-          logger.log(String("Résultat stopFileServer(): ") + (stopResult ? "SUCCÈS" : "ÉCHEC"));
-          logger.log(String("État serveur APRÈS stop: ") + (fileServer.isServerActive() ? "ACTIF" : "INACTIF"));
+          LOGD(logger, "Résultat stopFileServer(): %s", stopResult ? "SUCCÈS" : "ÉCHEC");
+          LOGD(logger, "État serveur APRÈS stop: %s", fileServer.isServerActive() ? "ACTIF" : "INACTIF");
           
           if (stopResult) {
             display.showFileServerStatus(false, "");
-            logger.log("Serveur de fichiers désactivé, retour en mode ESPNow");
+            logger.log(espNowKept ? "Serveur de fichiers désactivé, ESPNow toujours actif"
+                                  : "Serveur de fichiers désactivé, retour en mode ESPNow");
             
-            // Réinitialiser ESPNow après la déconnexion WiFi
-            reinitializeESPNow();
-            
-            // Redessiner les boutons pour afficher le bouton WiFi en ROUGE
-            display.drawButtonLabels(isRecording, false, boatMacList.size(), sdWriteError);
+            // ESP-NOW n'est à réinitialiser que si le WiFi l'a interrompu
+            if (!espNowKept) {
+              reinitializeESPNow();
+            }
             
-            // L'affichage sera rafraîchi automatiquement après le message
+            // Le bouton WiFi repasse au rouge avec le prochain instantané
           }
         }
         
-        logger.log("Fin traitement bouton serveur de fichiers");
+        LOGD(logger, "Fin traitement bouton serveur de fichiers");
+      }
+    }
+    
+    // Zone principale : changement de page (tableau de bord, boussole)
+    else if (t.wasPressed() && t.y < 180) {
+      unsigned long currentTime = millis();
+      if (currentTime - lastTouchTimePage >= TOUCH_DEBOUNCE_MS) {
+        lastTouchTimePage = currentTime;
+        display.nextPage();
+        logger.log("Changement de page demandé");
       }
     }
   }
   
-  // Gérer les requêtes du serveur de fichiers
-  fileServer.handleClient();
-  
-  // Mettre à jour l'affichage temporaire du serveur (non-bloquant)
-  display.updateServerMessageDisplay();
-  
-  // Vérifier si un refresh est nécessaire après un message serveur
-  // MAIS ne pas rafraîchir si le serveur est actif (on veut garder l'URL affichée)
-  if (display.needsRefresh() && !fileServer.isServerActive()) {
-    logger.log("Refresh automatique après message serveur");
-    bool hubActive = (hubStatusTimestamp > 0) && (millis() - hubStatusTimestamp < HUB_TIMEOUT_MS);
-    uint32_t hubRelayed = incomingHubStatus.relayedCommands + incomingHubStatus.relayedStates + incomingHubStatus.relayedGPS + incomingHubStatus.relayedAnemometer;
-    display.drawDisplay(incomingBoatData, incomingAnemometerData, isRecording, fileServer.isServerActive(), boatMacList.size(), avgWindDir, windDirTs, sdWriteError, selectedBoatIndex, hubActive, hubRelayed);
-  }
- 
   // Nettoyer les bateaux avec timeout
   static unsigned long lastCleanup = 0;
   if (millis() - lastCleanup > 5000) { // Vérifier toutes les 5 secondes
@@ -963,48 +1437,38 @@ void loop() {
     lastCleanup = millis();
   }
   
-  // Obtenir le bateau actuellement sélectionné
-  BoatInfo* selectedBoat = getSelectedBoat();
-  
-  // Copier les données du bateau sélectionné dans incomingBoatData pour compatibilité
-  if (selectedBoat != nullptr) {
-    incomingBoatData = selectedBoat->data;
-  }
-  
-  // Ne pas rafraîchir l'affichage si le serveur de fichiers est actif
-  // pour garder l'URL visible à l'écran
-  if (!fileServer.isServerActive()) {
-    bool hubActive = (hubStatusTimestamp > 0) && (millis() - hubStatusTimestamp < HUB_TIMEOUT_MS);
-    uint32_t hubRelayed = incomingHubStatus.relayedCommands + incomingHubStatus.relayedStates + incomingHubStatus.relayedGPS + incomingHubStatus.relayedAnemometer;
-    if (newData) {
-      display.drawDisplay(incomingBoatData, incomingAnemometerData, isRecording, fileServer.isServerActive(), boatMacList.size(), avgWindDir, windDirTs, sdWriteError, selectedBoatIndex, hubActive, hubRelayed);
+  // Fin de la connexion WiFi lancée par le bouton 3
+  static WiFiConnectState lastConnectState = WIFI_STATE_IDLE;
+  WiFiConnectState connectState = fileServer.connectState();
+  if (connectState != lastConnectState) {
+    if (lastConnectState == WIFI_STATE_CONNECTING && connectState == WIFI_STATE_ACTIVE) {
+      display.showFileServerStatus(true, fileServer.getServerIP());
+      logger.log("Serveur de fichiers actif sur: http://" + fileServer.getServerIP());
       
-      newData = false;
-    }
-    
-    // Refresh périodique pour s'assurer que l'état des boutons est correct
-    static unsigned long lastPeriodicRefresh = 0;
-    if (millis() - lastPeriodicRefresh > 1000) { // Toutes les secondes
-      lastPeriodicRefresh = millis();
-      
-      // Debug: Afficher l'état du serveur périodiquement
-      static bool lastServerState = false;
-      bool currentServerState = fileServer.isServerActive();
-      if (currentServerState != lastServerState) {
-        logger.log(String("CHANGEMENT État serveur: ") + (currentServerState ? "ACTIF" : "INACTIF"));
-        lastServerState = currentServerState;
-      }
-      
-      display.drawDisplay(incomingBoatData, incomingAnemometerData, isRecording, fileServer.isServerActive(), boatMacList.size(), avgWindDir, windDirTs, sdWriteError, selectedBoatIndex, hubActive, hubRelayed);
-    }
-  } else {
-    // Serveur actif : consommer le flag newData mais ne pas rafraîchir l'écran
-    if (newData) {
-      newData = false;
-      logger.log("Données reçues mais affichage suspendu (serveur actif)");
+      // Synchronize RTC with NTP now that WiFi is connected
+      syncRTCIfWiFiConnected();
+    } else if (lastConnectState == WIFI_STATE_CONNECTING && connectState == WIFI_STATE_FAILED) {
+      logger.log("Erreur: Impossible de démarrer le serveur de fichiers");
+      display.showFileServerStatus(false, "Échec connexion WiFi");
     }
+    lastConnectState = connectState;
   }
+  // Fin de la synchronisation NTP lancée ci-dessus, sans attente
+  pollRTCSync();
+  
+  // Debug: Afficher l'état du serveur quand il change
+  static bool lastServerState = false;
+  bool currentServerState = fileServer.isServerActive();
+  if (currentServerState != lastServerState) {
+    LOGD(logger, "CHANGEMENT État serveur: %s", currentServerState ? "ACTIF" : "INACTIF");
+    lastServerState = currentServerState;
+  }
+  
+  // Un seul point d'entrée : la tâche d'affichage dessine le dernier instantané
+  // à cadence fixe (le bandeau serveur reste au-dessus des valeurs)
+  publishDisplaySnapshot(avgWindDir, windDirTs);
+  publishTelemetry(avgWindDir);
 
-  delay(50);
+  delay(powerGovernor.loopDelayMs());
 }
 
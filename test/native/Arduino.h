@@ -0,0 +1,168 @@
+/**
+ * @file Arduino.h
+ * @brief Host replacement of the Arduino core for the native test build
+ *
+ * Only what the storage modules use: String, Serial, millis()/micros()
+ * and delay(), plus the FreeRTOS headers the ESP32 core pulls in. Nothing
+ * here is compiled into the firmware.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdarg.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef uint8_t byte;
+using std::min;
+using std::max;
+#define PROGMEM
+#define PGM_P const char*
+
+inline unsigned long micros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+inline unsigned long millis() {
+    return micros() / 1000;
+}
+
+inline void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void yield() {
+    std::this_thread::yield();
+}
+
+/**
+ * @class String
+ * @brief Arduino String over std::string
+ */
+class String {
+private:
+    std::string text_;
+
+    static std::string format(const char* fmt, ...) {
+        char buffer[40];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(buffer, sizeof(buffer), fmt, args);
+        va_end(args);
+        return buffer;
+    }
+
+public:
+    String() {}
+    String(const char* text) : text_(text ? text : "") {}
+    String(const std::string& text) : text_(text) {}
+    explicit String(char c) : text_(1, c) {}
+    explicit String(int value) : text_(format("%d", value)) {}
+    explicit String(unsigned int value) : text_(format("%u", value)) {}
+    explicit String(long value) : text_(format("%ld", value)) {}
+    explicit String(unsigned long value) : text_(format("%lu", value)) {}
+    explicit String(long long value) : text_(format("%lld", value)) {}
+    explicit String(unsigned long long value) : text_(format("%llu", value)) {}
+    explicit String(float value, unsigned int decimals = 2) : text_(format("%.*f", decimals, value)) {}
+    explicit String(double value, unsigned int decimals = 2) : text_(format("%.*f", decimals, value)) {}
+
+    const char* c_str() const { return text_.c_str(); }
+    unsigned int length() const { return text_.length(); }
+    bool isEmpty() const { return text_.empty(); }
+    bool reserve(unsigned int size) { text_.reserve(size); return true; }
+    char operator[](unsigned int index) const { return index < text_.size() ? text_[index] : 0; }
+    char charAt(unsigned int index) const { return (*this)[index]; }
+
+    String& operator+=(const String& other) { text_ += other.text_; return *this; }
+    String& operator+=(const char* other) { text_ += other ? other : ""; return *this; }
+    String& operator+=(char c) { text_ += c; return *this; }
+    bool concat(const String& other) { text_ += other.text_; return true; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.text_ + b.text_); }
+    friend String operator+(const String& a, const char* b) { return String(a.text_ + (b ? b : "")); }
+    friend String operator+(const char* a, const String& b) { return String((a ? a : "") + b.text_); }
+    friend String operator+(const String& a, char b) { return String(a.text_ + b); }
+
+    bool operator==(const String& other) const { return text_ == other.text_; }
+    bool operator==(const char* other) const { return text_ == (other ? other : ""); }
+    bool operator!=(const String& other) const { return text_ != other.text_; }
+    bool operator!=(const char* other) const { return !(*this == other); }
+
+    bool startsWith(const String& prefix) const { return text_.compare(0, prefix.text_.size(), prefix.text_) == 0; }
+    bool endsWith(const String& suffix) const {
+        return text_.size() >= suffix.text_.size() &&
+               text_.compare(text_.size() - suffix.text_.size(), suffix.text_.size(), suffix.text_) == 0;
+    }
+    int indexOf(const String& needle, unsigned int from = 0) const {
+        size_t found = text_.find(needle.text_, from);
+        return found == std::string::npos ? -1 : (int)found;
+    }
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t found = text_.find(c, from);
+        return found == std::string::npos ? -1 : (int)found;
+    }
+    String substring(unsigned int from) const { return from < text_.size() ? String(text_.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        if (from >= text_.size()) return String();
+        return String(text_.substr(from, to - from));
+    }
+    void replace(const String& find, const String& with) {
+        if (find.text_.empty()) return;
+        size_t at = 0;
+        while ((at = text_.find(find.text_, at)) != std::string::npos) {
+            text_.replace(at, find.text_.size(), with.text_);
+            at += with.text_.size();
+        }
+    }
+    void trim() {
+        size_t first = text_.find_first_not_of(" \t\r\n");
+        size_t last = text_.find_last_not_of(" \t\r\n");
+        text_ = first == std::string::npos ? std::string() : text_.substr(first, last - first + 1);
+    }
+    long toInt() const { return strtol(text_.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(text_.c_str(), nullptr); }
+};
+
+/**
+ * @class Print
+ * @brief Output side of Serial, written to stdout
+ */
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) { return fwrite(&c, 1, 1, stdout); }
+    virtual size_t write(const uint8_t* data, size_t length) { return fwrite(data, 1, length, stdout); }
+    size_t print(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    size_t print(const String& text) { return print(text.c_str()); }
+    size_t println() { return print("\n"); }
+    size_t println(const char* text) { return print(text) + println(); }
+    size_t println(const String& text) { return println(text.c_str()); }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, fmt);
+        int length = vprintf(fmt, args);
+        va_end(args);
+        return length > 0 ? length : 0;
+    }
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    void flush() { fflush(stdout); }
+    operator bool() const { return true; }
+};
+
+inline HardwareSerial Serial;
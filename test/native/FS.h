@@ -0,0 +1,41 @@
+/**
+ * @file FS.h
+ * @brief Host replacement of the Arduino file system API
+ *
+ * No card on the host: every file fails to open. The native build writes
+ * through SimulatedSdBackend only.
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+
+namespace fs {
+class File {
+public:
+    operator bool() const { return false; }
+    size_t write(const uint8_t*, size_t) { return 0; }
+    int read(uint8_t*, size_t) { return -1; }
+    bool seek(uint32_t) { return false; }
+    size_t position() const { return 0; }
+    size_t size() const { return 0; }
+    void flush() {}
+    void close() {}
+};
+
+class FS {
+public:
+    File open(const char*, const char* = FILE_READ) { return File(); }
+    File open(const String& path, const char* mode = FILE_READ) { return open(path.c_str(), mode); }
+    bool exists(const char*) { return false; }
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool mkdir(const char*) { return false; }
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+    bool remove(const char*) { return false; }
+    bool remove(const String& path) { return remove(path.c_str()); }
+};
+}  // namespace fs
+
+using fs::File;
@@ -0,0 +1,58 @@
+/**
+ * @file M5Unified.h
+ * @brief Host replacement of M5Unified for the native test build
+ *
+ * The RTC holds a fixed date (it only dates the Kepler entries) and the
+ * display draws nothing.
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#define BLACK 0x0000u
+#define WHITE 0xFFFFu
+
+namespace m5 {
+struct rtc_date_t {
+    int16_t year = 2025;
+    int8_t month = 6;
+    int8_t date = 1;
+    int8_t weekDay = 0;
+};
+struct rtc_time_t {
+    int8_t hours = 12;
+    int8_t minutes = 0;
+    int8_t seconds = 0;
+};
+struct rtc_datetime_t {
+    rtc_date_t date;
+    rtc_time_t time;
+};
+
+class RTC_Class {
+private:
+    rtc_datetime_t now_;
+
+public:
+    rtc_datetime_t getDateTime() const { return now_; }
+    void setDateTime(const rtc_datetime_t& datetime) { now_ = datetime; }
+};
+
+class Display_Class : public Print {
+public:
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t*, size_t length) override { return length; }
+    void fillScreen(uint32_t) {}
+    void setTextColor(uint32_t) {}
+    void setTextSize(float) {}
+    void setCursor(int32_t, int32_t) {}
+};
+
+class M5Unified {
+public:
+    RTC_Class Rtc;
+    Display_Class Display;
+};
+}  // namespace m5
+
+inline m5::M5Unified M5;
@@ -0,0 +1,15 @@
+/**
+ * @file SD.h
+ * @brief Host replacement of the Arduino SD library (no card)
+ */
+
+#pragma once
+#include <FS.h>
+#include <SPI.h>
+
+class SDFS : public fs::FS {
+public:
+    bool begin(uint8_t = 4, SPIClass& = SPI, uint32_t = 4000000) { return false; }
+};
+
+inline SDFS SD;
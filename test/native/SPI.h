@@ -0,0 +1,14 @@
+/**
+ * @file SPI.h
+ * @brief Host replacement of the Arduino SPI class
+ */
+
+#pragma once
+#include <Arduino.h>
+
+class SPIClass {
+public:
+    void begin(int8_t = -1, int8_t = -1, int8_t = -1, int8_t = -1) {}
+};
+
+inline SPIClass SPI;
@@ -0,0 +1,21 @@
+/**
+ * @file WiFi.h
+ * @brief Host replacement of the Arduino WiFi class (never connected)
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <time.h>
+
+enum wl_status_t { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 };
+
+class WiFiClass {
+public:
+    wl_status_t status() const { return WL_DISCONNECTED; }
+    String macAddress() const { return "02:00:00:00:00:01"; }
+};
+
+inline WiFiClass WiFi;
+
+inline void configTime(long, int, const char*) {}
+inline bool getLocalTime(struct tm*, uint32_t = 5000) { return false; }
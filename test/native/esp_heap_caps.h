@@ -0,0 +1,31 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Host replacement of the ESP-IDF capability heap (plain malloc)
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+typedef struct {
+    size_t total_free_bytes;
+    size_t total_allocated_bytes;
+    size_t largest_free_block;
+    size_t minimum_free_bytes;
+    size_t allocated_blocks;
+    size_t free_blocks;
+    size_t total_blocks;
+} multi_heap_info_t;
+
+inline void* heap_caps_malloc(size_t size, uint32_t) { return malloc(size); }
+inline void* heap_caps_realloc(void* ptr, size_t size, uint32_t) { return realloc(ptr, size); }
+inline void heap_caps_free(void* ptr) { free(ptr); }
+inline void heap_caps_get_info(multi_heap_info_t* info, uint32_t) { memset(info, 0, sizeof(*info)); }
+inline size_t heap_caps_get_total_size(uint32_t) { return 0; }
+inline size_t heap_caps_get_free_size(uint32_t) { return 0; }
+inline size_t heap_caps_get_largest_free_block(uint32_t) { return 0; }
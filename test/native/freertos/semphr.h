@@ -0,0 +1,25 @@
+/**
+ * @file semphr.h
+ * @brief Host replacement of the FreeRTOS mutex (single thread: never contended)
+ */
+
+#pragma once
+#include "FreeRTOS.h"
+
+struct HostSemaphore {
+    UBaseType_t count;
+};
+typedef HostSemaphore* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new HostSemaphore{1}; }
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore) { delete semaphore; }
+inline UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore) { return semaphore->count; }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t) {
+    if (semaphore->count == 0) return pdFALSE;
+    semaphore->count--;
+    return pdTRUE;
+}
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    semaphore->count++;
+    return pdTRUE;
+}
@@ -0,0 +1,25 @@
+/**
+ * @file task.h
+ * @brief Host replacement of the FreeRTOS task API (no task is ever created)
+ */
+
+#pragma once
+#include <chrono>
+#include <thread>
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define tskIDLE_PRIORITY 0
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*, UBaseType_t,
+                                          TaskHandle_t*, BaseType_t) {
+    return pdFAIL;
+}
+inline void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+}
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+inline BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdPASS; }
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t*) {}
@@ -0,0 +1,8 @@
+/**
+ * @file soc_memory_layout.h
+ * @brief Host replacement of the ESP-IDF memory map (no external RAM)
+ */
+
+#pragma once
+
+inline bool esp_ptr_external_ram(const void*) { return false; }
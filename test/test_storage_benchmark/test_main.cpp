@@ -0,0 +1,76 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file test_main.cpp
+ * @brief Storage benchmark scenarios on the host (pio test -e native)
+ *
+ * Replays every built-in StorageBenchmark scenario through the real
+ * Storage::writeDataBatch() against SimulatedSdBackend, checks that each
+ * run writes all its entries, then prints the same report as "bench" on
+ * the serial port.
+ */
+
+#include <unity.h>
+#include "StorageBenchmark.h"
+#include "SimulatedSdBackend.h"
+#include "Logger.h"
+
+static Logger logger(false, true, false);
+static StorageBenchmark benchmark;
+
+void setUp() {}
+void tearDown() {}
+
+/**
+ * @brief Entries generated by a scenario (see generateBatch())
+ */
+static uint32_t expectedRecords(const BenchmarkScenario& scenario) {
+    uint32_t flushes = (uint32_t)scenario.durationSec * 1000 / scenario.flushIntervalMs;
+    uint32_t boatPackets = (uint32_t)scenario.boatRateHz * scenario.flushIntervalMs / 1000;
+    uint32_t slowPackets = scenario.flushIntervalMs / 1000;
+    if (slowPackets == 0) slowPackets = 1;
+    return flushes * (boatPackets * scenario.boats + slowPackets * (scenario.buoys + scenario.anemometers));
+}
+
+static void test_scenarios_write_every_entry() {
+    size_t count = 0;
+    const BenchmarkScenario* list = StorageBenchmark::scenarios(count);
+    TEST_ASSERT_TRUE(count > 0);
+
+    for (size_t i = 0; i < count; i++) {
+        SimulatedSdBackend card;
+        BenchmarkResult result;
+        TEST_ASSERT_TRUE_MESSAGE(benchmark.runScenario(list[i], card, true, "/bench/storage_bench.json", result),
+                                 list[i].name);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(expectedRecords(list[i]), result.records, list[i].name);
+        TEST_ASSERT_TRUE_MESSAGE(result.writeAmplification >= 1.0f, list[i].name);
+        TEST_ASSERT_TRUE_MESSAGE(result.p50Us <= result.p95Us && result.p95Us <= result.p99Us &&
+                                 result.p99Us <= result.maxUs, list[i].name);
+    }
+}
+
+static void test_report_on_simulated_card() {
+    benchmark.runAll(false);
+}
+
+int main() {
+    logger.setLevel(LOG_INFO);
+    benchmark.setLogger(logger);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_scenarios_write_every_entry);
+    RUN_TEST(test_report_on_simulated_card);
+    return UNITY_END();
+}
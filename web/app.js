@@ -0,0 +1,78 @@
+// Directory browser: the page is static (served gzipped from flash), the
+// listing comes from /api/files one page at a time.
+(function () {
+  'use strict';
+  var params = new URLSearchParams(location.search);
+  var dir = params.get('dir') || '/';
+  var sort = params.get('sort') === 'name' ? 'name' : 'date';
+  var limit = params.get('limit') || '25';
+  var after = params.get('after');
+
+  function $(id) { return document.getElementById(id); }
+  function enc(s) { return encodeURIComponent(s); }
+  function el(tag, text, href) {
+    var node = document.createElement(href ? 'a' : tag);
+    if (href) node.href = href;
+    if (text !== undefined) node.textContent = text;
+    return node;
+  }
+  function listUrl(extra) {
+    return '/list?dir=' + enc(dir) + '&limit=' + enc(limit) + extra;
+  }
+  function date(mtime) {
+    if (!mtime) return '-';
+    return new Date(mtime * 1000).toISOString().slice(0, 16).replace('T', ' ');
+  }
+  function size(bytes) {
+    if (bytes < 1024) return bytes + ' o';
+    if (bytes < 1048576) return (bytes / 1024).toFixed(1) + ' Ko';
+    return (bytes / 1048576).toFixed(1) + ' Mo';
+  }
+
+  $('title').textContent = '📁 ' + dir;
+  document.title = 'Fichiers - ' + dir;
+
+  var tools = $('tools');
+  tools.append('Tri : ');
+  tools.append(sort === 'date' ? el('b', 'date') : el('a', 'date', listUrl('&sort=date')));
+  tools.append(' | ');
+  tools.append(sort === 'name' ? el('b', 'nom') : el('a', 'nom', listUrl('&sort=name')));
+  tools.append(' · ');
+  tools.append(el('a', '🗜️ Tout télécharger (ZIP)', '/zip?dir=' + enc(dir)));
+
+  var api = '/api/files?dir=' + enc(dir) + '&sort=' + sort + '&limit=' + enc(limit) +
+            (after ? '&after=' + enc(after) : '');
+  fetch(api).then(function (response) {
+    if (!response.ok) throw new Error(response.status);
+    return response.json();
+  }).then(function (page) {
+    var body = $('files');
+    page.files.forEach(function (file) {
+      var row = body.insertRow();
+      row.insertCell().textContent = (file.dir ? '📂 ' : '📄 ') + file.name;
+      var cell = row.insertCell();
+      cell.className = 'size';
+      cell.textContent = file.dir ? '-' : size(file.size);
+      row.insertCell().textContent = date(file.mtime);
+      row.insertCell().append(file.dir
+        ? el('a', '📂 Ouvrir', '/list?dir=' + enc(file.path) + '&sort=' + sort)
+        : el('a', '⬇️ Télécharger', '/download?file=' + enc(file.path)));
+    });
+
+    var pages = $('pages');
+    var count = page.files.length;
+    pages.append((count ? page.offset + 1 : 0) + '-' + (page.offset + count) + ' sur ' + page.total);
+    if (page.offset > 0) {
+      pages.append(' | ');
+      pages.append(el('a', '⏮ Début', listUrl('&sort=' + sort)));
+    }
+    if (page.next) {
+      pages.append(' | ');
+      pages.append(el('a', 'Suivant ⏭', listUrl('&sort=' + sort + '&after=' + enc(page.next))));
+    }
+  }).catch(function () {
+    var error = el('p', '❌ Erreur: Impossible d\'ouvrir le répertoire');
+    error.className = 'error';
+    $('pages').replaceWith(error);
+  });
+})();